@@ -0,0 +1,224 @@
+//
+// Created by JAYAN on 25/07/2025.
+//
+// Accuracy and speed of the VectorMath float kernels. The accuracy sweep
+// compares every kernel with the libm double reference over a dense grid and
+// fails (exit code 1) if any error exceeds the bound documented in
+// vector_math.h. The timing table compares a plain std:: loop per element
+// with the kernel picked for this CPU (override with VIT_ISA).
+// Usage: ./bench_activations
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+#include "../include/matrix/vector_math.h"
+#include "../include/utils/cpu_features.h"
+#include "bench_common.h"
+
+namespace {
+
+using FloatKernel = void (*)(const float*, float*, size_t);
+using DoubleKernel = void (*)(const double*, double*, size_t);
+
+std::vector<float> grid(float lo, float hi, size_t n) {
+    std::vector<float> x(n);
+    for (size_t i = 0; i < n; ++i) {
+        x[i] = lo + (hi - lo) * static_cast<float>(i) / static_cast<float>(n - 1);
+    }
+    return x;
+}
+
+struct AccuracyCase {
+    const char* name;
+    FloatKernel kernel;
+    DoubleKernel reference;
+    float lo;
+    float hi;
+    // Allowed error for input x given the reference value
+    std::function<double(double x, double ref)> bound;
+    // The error reported for a value (absolute or relative)
+    bool relative;
+};
+
+// Returns false if any point is outside its bound
+bool check_accuracy(const AccuracyCase& c) {
+    std::vector<float> x = grid(c.lo, c.hi, 1 << 21);
+    std::vector<float> out(x.size());
+    std::vector<double> xd(x.begin(), x.end());
+    std::vector<double> ref(x.size());
+    c.kernel(x.data(), out.data(), x.size());
+    c.reference(xd.data(), ref.data(), x.size());
+
+    double max_error = 0.0;
+    double worst_x = 0.0;
+    size_t failures = 0;
+    for (size_t i = 0; i < x.size(); ++i) {
+        double abs_error = std::fabs(static_cast<double>(out[i]) - ref[i]);
+        double error = c.relative ? abs_error / std::fabs(ref[i]) : abs_error;
+        if (error > max_error) {
+            max_error = error;
+            worst_x = xd[i];
+        }
+        if (!(abs_error <= c.bound(xd[i], ref[i]))) {
+            ++failures;
+        }
+    }
+    std::printf("%-10s [%7.2f, %6.2f] max %s error %.3e at x = %-10.5g %s\n", c.name, c.lo, c.hi,
+                c.relative ? "rel" : "abs", max_error, worst_x, failures == 0 ? "✓" : "✗");
+    return failures == 0;
+}
+
+bool check_softmax() {
+    std::mt19937 gen(7);
+    std::normal_distribution<float> dist(0.0f, 4.0f);
+    bool ok = true;
+    double max_error = 0.0;
+    for (size_t n : {1, 7, 16, 17, 49, 197, 1000}) {
+        std::vector<float> x(n);
+        for (float& v : x) {
+            v = dist(gen);
+        }
+        std::vector<double> xd(x.begin(), x.end());
+        std::vector<float> out(n);
+        std::vector<double> ref(n);
+        const float scale = 0.125f;
+        VectorMath::softmax(x.data(), out.data(), n, scale);
+        VectorMath::softmax(xd.data(), ref.data(), n, static_cast<double>(scale));
+        // In place must give the same result
+        VectorMath::softmax(x.data(), x.data(), n, scale);
+        for (size_t i = 0; i < n; ++i) {
+            double error = std::fabs(out[i] - ref[i]);
+            max_error = std::max(max_error, error);
+            ok = ok && error <= 1e-6 && x[i] == out[i];
+        }
+    }
+    std::printf("%-10s %-17s max abs error %.3e %s\n", "softmax", "rows 1..1000", max_error, ok ? "✓" : "✗");
+    return ok;
+}
+
+void std_exp(const float* in, float* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) out[i] = std::exp(in[i]);
+}
+
+void std_tanh(const float* in, float* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) out[i] = std::tanh(in[i]);
+}
+
+void std_sigmoid(const float* in, float* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) out[i] = 1.0f / (1.0f + std::exp(-in[i]));
+}
+
+// What ActivationFunctions::gelu computed before: the tanh formula in double
+void std_gelu_tanh(const float* in, float* out, size_t n) {
+    const double sqrt_2_pi = 0.7978845608028654;
+    for (size_t i = 0; i < n; ++i) {
+        double x = in[i];
+        out[i] = static_cast<float>(0.5 * x * (1.0 + std::tanh(sqrt_2_pi * (x + 0.044715 * x * x * x))));
+    }
+}
+
+void std_gelu_erf(const float* in, float* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) out[i] = 0.5f * in[i] * (1.0f + std::erf(in[i] * 0.70710678f));
+}
+
+// Softmax of each row with a scratch vector, as the old row loop did
+void std_softmax_rows(const float* in, float* out, size_t rows, size_t cols) {
+    for (size_t r = 0; r < rows; ++r) {
+        const float* x = in + r * cols;
+        std::vector<float> exp_vals(cols);
+        float max_val = *std::max_element(x, x + cols);
+        double sum = 0.0;
+        for (size_t j = 0; j < cols; ++j) {
+            exp_vals[j] = std::exp(x[j] - max_val);
+            sum += exp_vals[j];
+        }
+        for (size_t j = 0; j < cols; ++j) {
+            out[r * cols + j] = static_cast<float>(exp_vals[j] / sum);
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    std::printf("ISA: %s\n\n", CpuFeatures::isa_name(CpuFeatures::active_isa()));
+
+    const std::vector<AccuracyCase> cases = {
+        {"exp", VectorMath::exp<float>, VectorMath::exp<double>, -87.0f, 88.0f,
+         [](double, double ref) { return 1.5e-7 * ref; }, true},
+        {"tanh", VectorMath::tanh<float>, VectorMath::tanh<double>, -10.0f, 10.0f,
+         [](double, double) { return 1e-7; }, false},
+        {"tanh", VectorMath::tanh<float>, VectorMath::tanh<double>, -0.01f, 0.01f,
+         [](double, double ref) { return 1e-7 * std::fabs(ref); }, true},
+        {"sigmoid", VectorMath::sigmoid<float>, VectorMath::sigmoid<double>, -90.0f, 90.0f,
+         [](double, double) { return 1e-7; }, false},
+        {"gelu_tanh", VectorMath::gelu_tanh<float>, VectorMath::gelu_tanh<double>, -12.0f, 12.0f,
+         [](double x, double) { return 1.5e-7 * std::fabs(x) + 1e-7; }, false},
+        {"gelu_erf", VectorMath::gelu_erf<float>, VectorMath::gelu_erf<double>, -12.0f, 12.0f,
+         [](double x, double) { return 1.5e-7 * std::fabs(x) + 3e-7; }, false},
+    };
+
+    bool ok = true;
+    for (const AccuracyCase& c : cases) {
+        ok = check_accuracy(c) && ok;
+    }
+    ok = check_softmax() && ok;
+
+    // Timing: one MLP hidden activation (197 tokens x 1024) and attention
+    // rows (8 heads x 197 x 197)
+    const size_t n = 197 * 1024;
+    std::mt19937 gen(1);
+    std::normal_distribution<float> dist(0.0f, 2.0f);
+    std::vector<float> x(n);
+    for (float& v : x) {
+        v = dist(gen);
+    }
+    std::vector<float> out(n);
+
+    struct SpeedCase {
+        const char* name;
+        FloatKernel baseline;
+        FloatKernel kernel;
+    };
+    const std::vector<SpeedCase> speed_cases = {
+        {"exp", std_exp, VectorMath::exp<float>},
+        {"tanh", std_tanh, VectorMath::tanh<float>},
+        {"sigmoid", std_sigmoid, VectorMath::sigmoid<float>},
+        {"gelu_tanh", std_gelu_tanh, VectorMath::gelu_tanh<float>},
+        {"gelu_erf", std_gelu_erf, VectorMath::gelu_erf<float>},
+    };
+
+    std::printf("\n%-18s %14s %14s %9s\n", "kernel", "std ns/elem", "simd ns/elem", "speedup");
+    for (const SpeedCase& c : speed_cases) {
+        double base = Bench::time_per_call([&] { c.baseline(x.data(), out.data(), n); }) / n * 1e9;
+        double fast = Bench::time_per_call([&] { c.kernel(x.data(), out.data(), n); }) / n * 1e9;
+        std::printf("%-18s %14.3f %14.3f %8.1fx\n", c.name, base, fast, base / fast);
+    }
+
+    const size_t rows = 8 * 197;
+    const size_t cols = 197;
+    std::vector<float> scores(rows * cols);
+    for (float& v : scores) {
+        v = dist(gen);
+    }
+    std::vector<float> probs(rows * cols);
+    double base = Bench::time_per_call([&] { std_softmax_rows(scores.data(), probs.data(), rows, cols); }) /
+                  (rows * cols) * 1e9;
+    double fast = Bench::time_per_call([&] {
+        for (size_t r = 0; r < rows; ++r) {
+            VectorMath::softmax(scores.data() + r * cols, probs.data() + r * cols, cols);
+        }
+    }) / (rows * cols) * 1e9;
+    std::printf("%-18s %14.3f %14.3f %8.1fx\n", "softmax 197-wide", base, fast, base / fast);
+
+    if (!ok) {
+        std::printf("\n✗ accuracy check failed\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,122 @@
+//
+// Created by JAYAN on 26/07/2025.
+//
+// MultiHeadAttention (Standard and Tiled kernels) against a straightforward
+// per-head implementation (copy Q/K/V slices, matmul_nt, softmax, matmul,
+// concatenate) for the patch grids we care about. d_model = 256, 8 heads.
+// All three must agree to 1e-4; exit code 1 otherwise.
+// Usage: ./bench_attention
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "../include/matrix/matrix_ops.h"
+#include "../include/matrix/activation_functions.h"
+#include "../include/transformer/attention.h"
+#include "../include/utils/weight_file.h"
+#include "bench_common.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+MatrixF add_bias(MatrixF x, const MatrixF& bias) {
+    for (size_t i = 0; i < x.getRows(); ++i) {
+        for (size_t j = 0; j < x.getCols(); ++j) {
+            x(i, j) += bias(0, j);
+        }
+    }
+    return x;
+}
+
+// One head at a time with a copy of every slice
+MatrixF reference_attention(const MultiHeadAttention& mha, const MatrixF& input, size_t seq_len) {
+    const size_t dm = mha.get_d_model();
+    const size_t dk = mha.get_head_dim();
+    MatrixF qkv = add_bias(MatrixOps::matmul_nt(input, mha.get_in_proj_weight()), mha.get_in_proj_bias());
+    MatrixF context(input.getRows(), dm);
+    for (size_t s = 0; s < input.getRows() / seq_len; ++s) {
+        for (size_t h = 0; h < static_cast<size_t>(mha.get_num_heads()); ++h) {
+            MatrixF q(seq_len, dk), k(seq_len, dk), v(seq_len, dk);
+            q.view().assign(qkv.block(s * seq_len, h * dk, seq_len, dk));
+            k.view().assign(qkv.block(s * seq_len, dm + h * dk, seq_len, dk));
+            v.view().assign(qkv.block(s * seq_len, 2 * dm + h * dk, seq_len, dk));
+            MatrixF scores = MatrixOps::matmul_nt(q, k);
+            for (size_t i = 0; i < scores.size(); ++i) {
+                scores.data()[i] /= std::sqrt(static_cast<float>(dk));
+            }
+            MatrixF head = MatrixOps::matmul(ActivationFunctions::softmax(scores), v);
+            context.block(s * seq_len, h * dk, seq_len, dk).assign(head.view());
+        }
+    }
+    return add_bias(MatrixOps::matmul_nt(context, mha.get_out_proj_weight()), mha.get_out_proj_bias());
+}
+
+} // namespace
+
+int main() {
+    const size_t d_model = 256;
+    const fs::path weights_path = fs::temp_directory_path() / "vit_bench_attention.vitw";
+    WeightFile::write<float>(weights_path.string(), {
+        {"transformer_layers/transformer_0_attn_in_proj_weight", MatrixF::random(3 * d_model, d_model, -0.1f, 0.1f)},
+        {"transformer_layers/transformer_0_attn_in_proj_bias", MatrixF::random(3 * d_model, 1, -0.1f, 0.1f)},
+        {"transformer_layers/transformer_0_attn_out_proj_weight", MatrixF::random(d_model, d_model, -0.1f, 0.1f)},
+        {"transformer_layers/transformer_0_attn_out_proj_bias", MatrixF::random(d_model, 1, -0.1f, 0.1f)},
+    });
+    MultiHeadAttention mha;
+    mha.load_weights(*WeightFile::open(weights_path.string()), 0);
+    fs::remove(weights_path);
+
+    struct Case {
+        const char* grid;
+        size_t seq_len;
+        size_t sequences;
+    };
+    const std::vector<Case> cases = {
+        {"4x4 (7px)", 17, 64},
+        {"7x7 (4px)", 50, 16},
+        {"14x14", 197, 2},
+        {"28x28", 785, 1},
+        {"56x56", 3137, 1},
+    };
+
+    MultiHeadAttention tiled_mha = mha;
+    tiled_mha.set_kernel(AttentionKernel::Tiled);
+
+    bool ok = true;
+    std::printf("%-10s %8s %6s %13s %11s %11s %10s %10s\n", "grid", "seq_len", "batch", "reference ms",
+                "fused ms", "tiled ms", "max diff", "tiled diff");
+    for (const Case& c : cases) {
+        MatrixF input = MatrixF::random(c.sequences * c.seq_len, d_model, -1.0f, 1.0f);
+        MatrixF expected = reference_attention(mha, input, c.seq_len);
+        MatrixF output = mha.forward(input, c.seq_len);
+        MatrixF tiled_output = tiled_mha.forward(input, c.seq_len);
+
+        double max_diff = 0.0;
+        double tiled_diff = 0.0;
+        for (size_t i = 0; i < output.size(); ++i) {
+            max_diff = std::max(max_diff, static_cast<double>(std::fabs(output.data()[i] - expected.data()[i])));
+            tiled_diff = std::max(tiled_diff,
+                                  static_cast<double>(std::fabs(tiled_output.data()[i] - output.data()[i])));
+        }
+        ok = ok && max_diff < 1e-4 && tiled_diff < 1e-4;
+
+        double reference = Bench::time_per_call([&] { reference_attention(mha, input, c.seq_len); });
+        double fused = Bench::time_per_call([&] { mha.forward(ConstMatrixViewT<float>(input), c.seq_len, output.view()); });
+        double tiled = Bench::time_per_call([&] {
+            tiled_mha.forward(ConstMatrixViewT<float>(input), c.seq_len, tiled_output.view());
+        });
+        std::printf("%-10s %8zu %6zu %13.3f %11.3f %11.3f %10.2e %10.2e\n", c.grid, c.seq_len, c.sequences,
+                    reference * 1e3, fused * 1e3, tiled * 1e3, max_diff, tiled_diff);
+    }
+
+    if (!ok) {
+        std::printf("✗ attention kernels differ from the reference\n");
+        return 1;
+    }
+    return 0;
+}
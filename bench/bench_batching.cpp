@@ -0,0 +1,143 @@
+//
+// Created by JAYAN on 31/07/2025.
+//
+// Dynamic micro-batching against single-image inference. CLIENTS caller
+// threads each run a closed loop of single-image requests on a 6-layer
+// VisionTransformer (d_model 256, 8 heads, 28x28 images in 7x7 patches):
+// first straight into the model, one forward per image behind a mutex,
+// then through BatchedInference at several max_batch / max_delay settings.
+// Prints throughput, latency and the batch-size histogram of the last
+// setting. Batched logits must match a direct forward to 1e-4; exit code 1
+// otherwise.
+// Usage: ./bench_batching
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "../include/transformer/batched_inference.h"
+#include "../include/utils/weight_file.h"
+#include "bench_common.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr size_t CLIENTS = 16;
+constexpr size_t REQUESTS_PER_CLIENT = 40;
+constexpr size_t PATCHES = 16;
+constexpr size_t PATCH_DIM = 49;
+
+ConstMatrixViewF image(const MatrixF& images, size_t index) {
+    return images.block(index * PATCHES, 0, PATCHES, PATCH_DIM);
+}
+
+// Runs CLIENTS threads of REQUESTS_PER_CLIENT requests each; returns
+// seconds and fills per-request latencies (ms)
+template <typename Request>
+double run_clients(const Request& request, std::vector<double>& latencies) {
+    latencies.assign(CLIENTS * REQUESTS_PER_CLIENT, 0.0);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> clients;
+    for (size_t c = 0; c < CLIENTS; ++c) {
+        clients.emplace_back([&, c] {
+            for (size_t r = 0; r < REQUESTS_PER_CLIENT; ++r) {
+                const size_t index = c * REQUESTS_PER_CLIENT + r;
+                auto begin = std::chrono::steady_clock::now();
+                request(index);
+                latencies[index] =
+                    std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+            }
+        });
+    }
+    for (std::thread& client : clients) {
+        client.join();
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+double percentile(std::vector<double> values, double p) {
+    std::sort(values.begin(), values.end());
+    const size_t index = std::min(values.size() - 1, static_cast<size_t>(p / 100.0 * values.size()));
+    return values[index];
+}
+
+void print_row(const char* name, size_t max_batch, double delay_ms, double seconds, const std::vector<double>& latencies,
+               double mean_batch) {
+    std::printf("%-10s %9zu %9.1f %10.1f %9.2f %9.2f %9.2f %10.1f\n", name, max_batch, delay_ms,
+                latencies.size() / seconds, percentile(latencies, 50), percentile(latencies, 95),
+                percentile(latencies, 99), mean_batch);
+}
+
+} // namespace
+
+int main() {
+    const fs::path weights_path = fs::temp_directory_path() / "vit_bench_batching.vitw";
+    WeightFile::write<float>(weights_path.string(), Bench::random_weights(6, 256, 512, PATCH_DIM, PATCHES + 1, 10));
+    std::shared_ptr<WeightFile> weights = WeightFile::open(weights_path.string());
+
+    const size_t total = CLIENTS * REQUESTS_PER_CLIENT;
+    MatrixF images = MatrixF::random(total * PATCHES, PATCH_DIM, -1.0f, 1.0f);
+    VisionTransformer reference(total);
+    reference.load_weights(*weights);
+    MatrixF expected = reference.forward(images);
+
+    std::printf("%zu clients x %zu single-image requests, %u hardware thread(s)\n", CLIENTS, REQUESTS_PER_CLIENT,
+                std::thread::hardware_concurrency());
+    std::printf("%-10s %9s %9s %10s %9s %9s %9s %10s\n", "mode", "max_batch", "delay ms", "images/s", "p50 ms",
+                "p95 ms", "p99 ms", "mean batch");
+
+    // Baseline: every image is its own forward
+    VisionTransformer single(1);
+    single.load_weights(*weights);
+    std::mutex model_mutex;
+    MatrixF single_logits(1, 10);
+    std::vector<double> latencies;
+    double seconds = run_clients([&](size_t index) {
+        std::lock_guard<std::mutex> lock(model_mutex);
+        single.forward(image(images, index), single_logits.view());
+    }, latencies);
+    print_row("single", 1, 0.0, seconds, latencies, 1.0);
+
+    bool ok = true;
+    const std::vector<std::pair<size_t, double>> settings = {{8, 0.5}, {8, 2.0}, {16, 2.0}, {16, 5.0}};
+    BatchedInference::Stats last_stats;
+    for (const auto& [max_batch, delay_ms] : settings) {
+        VisionTransformer model(max_batch);
+        model.load_weights(*weights);
+        BatchingOptions options;
+        options.max_batch = max_batch;
+        options.max_delay_ms = delay_ms;
+        BatchedInference server(model, options);
+
+        std::vector<float> worst(total, 0.0f);
+        seconds = run_clients([&](size_t index) {
+            BatchedInference::Result result = server.infer(image(images, index));
+            for (size_t c = 0; c < result.logits.getCols(); ++c) {
+                worst[index] = std::max(worst[index], std::abs(result.logits(0, c) - expected(index, c)));
+            }
+        }, latencies);
+        ok = ok && *std::max_element(worst.begin(), worst.end()) < 1e-4f;
+
+        last_stats = server.get_stats();
+        print_row("batched", max_batch, delay_ms, seconds, latencies, last_stats.mean_batch_size());
+    }
+    fs::remove(weights_path);
+
+    std::printf("\nlast setting:\n");
+    last_stats.print(std::cout);
+
+    if (!ok) {
+        std::printf("✗ batched logits differ from a direct forward\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,69 @@
+//
+// Created by JAYAN on 09/08/2025.
+//
+// Helpers shared by the benchmarks in bench/.
+//
+
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../include/matrix/matrix.h"
+
+namespace Bench {
+
+// Runs fn once as a warm-up, then repeatedly for at least min_seconds, and
+// returns seconds per call.
+inline double time_per_call(const std::function<void()>& fn, double min_seconds = 0.3) {
+    fn(); // warm-up
+    size_t iterations = 0;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0.0;
+    do {
+        fn();
+        ++iterations;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < min_seconds);
+    return elapsed / iterations;
+}
+
+// Random VisionTransformer weights under the exported tensor names, for
+// WeightFile::write. seq_len counts the class token.
+inline std::vector<std::pair<std::string, MatrixF>> random_weights(size_t layers, size_t d_model, size_t hidden,
+                                                                   size_t patch_dim, size_t seq_len,
+                                                                   size_t classes) {
+    std::vector<std::pair<std::string, MatrixF>> tensors = {
+        {"other/input_layer_weight", MatrixF::random(d_model, patch_dim, -0.1f, 0.1f)},
+        {"other/input_layer_bias", MatrixF::random(d_model, 1, -0.1f, 0.1f)},
+        {"position_embedding/pos_embedding", MatrixF::random(seq_len, d_model, -0.1f, 0.1f)},
+        {"class_token/cls_token", MatrixF::random(1, d_model, -0.1f, 0.1f)},
+        {"classifier/mlp_head_0_weight", MatrixF::random(d_model, 1, 0.9f, 1.1f)},
+        {"classifier/mlp_head_0_bias", MatrixF::random(d_model, 1, -0.1f, 0.1f)},
+        {"classifier/mlp_head_1_weight", MatrixF::random(classes, d_model, -0.1f, 0.1f)},
+        {"classifier/mlp_head_1_bias", MatrixF::random(classes, 1, -0.1f, 0.1f)},
+    };
+    for (size_t i = 0; i < layers; ++i) {
+        const std::string prefix = "transformer_layers/transformer_" + std::to_string(i) + "_";
+        for (const char* norm : {"layer_norm_1", "layer_norm_2"}) {
+            tensors.emplace_back(prefix + norm + "_weight", MatrixF::random(d_model, 1, 0.9f, 1.1f));
+            tensors.emplace_back(prefix + norm + "_bias", MatrixF::random(d_model, 1, -0.1f, 0.1f));
+        }
+        tensors.emplace_back(prefix + "attn_in_proj_weight", MatrixF::random(3 * d_model, d_model, -0.1f, 0.1f));
+        tensors.emplace_back(prefix + "attn_in_proj_bias", MatrixF::random(3 * d_model, 1, -0.1f, 0.1f));
+        tensors.emplace_back(prefix + "attn_out_proj_weight", MatrixF::random(d_model, d_model, -0.1f, 0.1f));
+        tensors.emplace_back(prefix + "attn_out_proj_bias", MatrixF::random(d_model, 1, -0.1f, 0.1f));
+        tensors.emplace_back(prefix + "linear_0_weight", MatrixF::random(hidden, d_model, -0.1f, 0.1f));
+        tensors.emplace_back(prefix + "linear_0_bias", MatrixF::random(hidden, 1, -0.1f, 0.1f));
+        tensors.emplace_back(prefix + "linear_3_weight", MatrixF::random(d_model, hidden, -0.1f, 0.1f));
+        tensors.emplace_back(prefix + "linear_3_bias", MatrixF::random(d_model, 1, -0.1f, 0.1f));
+    }
+    return tensors;
+}
+
+} // namespace Bench
+
+#endif //BENCH_COMMON_H
@@ -0,0 +1,121 @@
+//
+// Created by JAYAN on 22/07/2025.
+//
+// CSV ingest speed on weight-shaped files (256x49 input projection and a
+// 256x1024 MLP weight): the previous getline/split_string/stod loader against
+// FileIO::load_matrix_from_csv, and the binary weight file for reference.
+// Usage: ./bench_csv [max_threads]
+//
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../include/matrix/matrix.h"
+#include "../include/utils/file_io.h"
+#include "../include/utils/thread_pool.h"
+#include "../include/utils/weight_file.h"
+#include "bench_common.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// The loader this replaced: one getline, stringstream split and stod per value
+MatrixF legacy_load(const std::string& filename) {
+    std::ifstream file(filename);
+    std::vector<std::vector<double>> data;
+    std::string line;
+    std::getline(file, line); // header
+    while (std::getline(file, line)) {
+        std::vector<std::string> tokens = FileIO::split_string(line, ',');
+        if (tokens.empty()) {
+            continue;
+        }
+        std::vector<double> row;
+        for (const std::string& token : tokens) {
+            row.push_back(std::stod(token));
+        }
+        data.push_back(row);
+    }
+    MatrixF result(data.size(), data[0].size());
+    for (size_t i = 0; i < data.size(); ++i) {
+        for (size_t j = 0; j < data[i].size(); ++j) {
+            result(i, j) = static_cast<float>(data[i][j]);
+        }
+    }
+    return result;
+}
+
+// Same layout as the exported weights: a header row, then full-precision values
+void write_weight_csv(const std::string& filename, const MatrixF& matrix) {
+    std::FILE* file = std::fopen(filename.c_str(), "w");
+    for (size_t j = 0; j < matrix.getCols(); ++j) {
+        std::fprintf(file, "%zu%s", j, j + 1 < matrix.getCols() ? "," : "\n");
+    }
+    for (size_t i = 0; i < matrix.getRows(); ++i) {
+        const float* row = matrix.row_ptr(i);
+        for (size_t j = 0; j < matrix.getCols(); ++j) {
+            std::fprintf(file, "%.9g%s", row[j], j + 1 < matrix.getCols() ? "," : "\n");
+        }
+    }
+    std::fclose(file);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+    if (argc > 1) {
+        max_threads = std::max(1, std::atoi(argv[1]));
+    }
+
+    fs::path dir = fs::temp_directory_path() / "vit_bench_csv";
+    fs::create_directories(dir);
+
+    struct Shape { size_t rows, cols; };
+    const std::vector<Shape> shapes = {{256, 49}, {256, 1024}};
+
+    std::printf("%-22s %-24s %8s %10s %10s %8s\n", "file", "loader", "threads", "ms/load", "MB/s", "speedup");
+    for (const Shape& shape : shapes) {
+        std::string name = std::to_string(shape.rows) + "x" + std::to_string(shape.cols);
+        std::string csv_path = (dir / (name + ".csv")).string();
+        std::string bin_path = (dir / (name + ".vitw")).string();
+
+        MatrixF reference = MatrixF::random(shape.rows, shape.cols, -1.0f, 1.0f);
+        write_weight_csv(csv_path, reference);
+        WeightFile::write<float>(bin_path, {{"weight", reference}});
+        double megabytes = fs::file_size(csv_path) / 1e6;
+
+        MatrixF parsed = FileIO::load_matrix_from_csv<float>(csv_path, true);
+        if (parsed != reference || legacy_load(csv_path) != reference) {
+            std::printf("✗ %s: parsed values differ from the written matrix\n", name.c_str());
+            return 1;
+        }
+
+        double legacy = Bench::time_per_call([&] { legacy_load(csv_path); });
+        std::printf("%-22s %-24s %8d %10.3f %10.1f %7.2fx\n", (name + ".csv").c_str(), "getline+stod", 1,
+                    legacy * 1e3, megabytes / legacy, 1.0);
+
+        for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+            ThreadPool::set_num_threads(threads);
+            double seconds = Bench::time_per_call([&] { FileIO::load_matrix_from_csv<float>(csv_path, true); });
+            std::printf("%-22s %-24s %8zu %10.3f %10.1f %7.2fx\n", (name + ".csv").c_str(), "load_matrix_from_csv",
+                        threads, seconds * 1e3, megabytes / seconds, legacy / seconds);
+            if (threads < max_threads && threads * 2 > max_threads) {
+                threads = max_threads / 2; // always finish on max_threads
+            }
+        }
+
+        double mapped = Bench::time_per_call([&] { WeightFile::open(bin_path)->get<float>("weight"); });
+        std::printf("%-22s %-24s %8d %10.3f %10s %7.2fx\n", (name + ".vitw").c_str(), "WeightFile (mmap)", 1,
+                    mapped * 1e3, "-", legacy / mapped);
+    }
+
+    fs::remove_all(dir);
+    return 0;
+}
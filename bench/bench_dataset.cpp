@@ -0,0 +1,103 @@
+//
+// Created by JAYAN on 23/07/2025.
+//
+// Streaming throughput of DatasetReader, alone and feeding the patch
+// projection GEMM (patches x proj_weight^T, d_model = 256).
+// Usage: ./bench_dataset [images-idx3-ubyte labels-idx1-ubyte]
+//   without arguments a synthetic 100k-image IDX file is generated.
+//
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include "../include/utils/dataset.h"
+#include "../include/matrix/matrix_ops.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+void write_big_endian(std::ofstream& file, uint32_t value) {
+    unsigned char bytes[4] = {static_cast<unsigned char>(value >> 24), static_cast<unsigned char>(value >> 16),
+                              static_cast<unsigned char>(value >> 8), static_cast<unsigned char>(value)};
+    file.write(reinterpret_cast<const char*>(bytes), 4);
+}
+
+void write_synthetic_idx(const std::string& images_path, const std::string& labels_path, size_t count) {
+    std::mt19937 gen(42);
+    std::ofstream images(images_path, std::ios::binary);
+    write_big_endian(images, 0x00000803);
+    write_big_endian(images, static_cast<uint32_t>(count));
+    write_big_endian(images, 28);
+    write_big_endian(images, 28);
+    std::vector<char> pixels(28 * 28);
+    for (size_t i = 0; i < count; ++i) {
+        for (char& p : pixels) {
+            p = static_cast<char>(gen() & 0xff);
+        }
+        images.write(pixels.data(), static_cast<std::streamsize>(pixels.size()));
+    }
+
+    std::ofstream labels(labels_path, std::ios::binary);
+    write_big_endian(labels, 0x00000801);
+    write_big_endian(labels, static_cast<uint32_t>(count));
+    for (size_t i = 0; i < count; ++i) {
+        labels.put(static_cast<char>(i % 10));
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string images_path;
+    std::string labels_path;
+    fs::path dir;
+    if (argc > 2) {
+        images_path = argv[1];
+        labels_path = argv[2];
+    } else {
+        dir = fs::temp_directory_path() / "vit_bench_dataset";
+        fs::create_directories(dir);
+        images_path = (dir / "images-idx3-ubyte").string();
+        labels_path = (dir / "labels-idx1-ubyte").string();
+        write_synthetic_idx(images_path, labels_path, 100000);
+    }
+
+    DatasetOptions options;
+    options.batch_size = 256;
+    auto reader = DatasetReader::open_idx(images_path, labels_path, options);
+    MatrixF proj_weight = MatrixF::random(256, reader->patch_dim(), -0.1f, 0.1f);
+
+    std::printf("%-26s %10s %12s %12s\n", "stage", "images", "seconds", "images/s");
+
+    // Reader alone, then reader feeding the patch projection
+    for (int with_projection = 0; with_projection < 2; ++with_projection) {
+        auto stream = DatasetReader::open_idx(images_path, labels_path, options);
+        ImageBatch batch;
+        size_t label_sum = 0;
+        auto start = std::chrono::steady_clock::now();
+        while (stream->next(batch)) {
+            if (with_projection) {
+                MatrixOps::matmul_nt(batch.patches, proj_weight);
+            }
+            for (int label : batch.labels) {
+                label_sum += label;
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::printf("%-26s %10zu %12.3f %12.0f\n", with_projection ? "read + patch projection" : "read + patchify",
+                    stream->images_read(), seconds, stream->images_read() / seconds);
+        if (label_sum == 0 && stream->images_read() > 10) {
+            std::printf("✗ labels were not read\n");
+            return 1;
+        }
+    }
+
+    if (!dir.empty()) {
+        fs::remove_all(dir);
+    }
+    return 0;
+}
@@ -0,0 +1,124 @@
+//
+// Created by JAYAN on 30/07/2025.
+//
+// Element-wise chains from the encoder (residual + bias, residual + bias
+// then scale, (a + b) * 0.5, gamma * x + beta) on (batch * 17) x width
+// token matrices: eager evaluation, one materialised matrix per operator as
+// Matrix::operator+ / operator* and MatrixOps::addBroadcast did, against the
+// lazy expressions evaluated in a single pass. The "eager"/"fused" columns
+// are the float traffic per output element (reads + writes, vectors
+// ignored); GB/s is the traffic the fused pass moves per second. Both must
+// agree to 1e-6; exit code 1 otherwise.
+// Usage: ./bench_expr
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <vector>
+#include "../include/matrix/matrix_ops.h"
+#include "../include/matrix/matrix_expr.h"
+#include "bench_common.h"
+
+namespace {
+
+float max_abs_diff(const MatrixF& a, const MatrixF& b) {
+    float diff = 0.0f;
+    for (size_t k = 0; k < a.size(); ++k) {
+        diff = std::max(diff, std::abs(a.data()[k] - b.data()[k]));
+    }
+    return diff;
+}
+
+struct Operands {
+    MatrixF x, y, bias, gamma, beta;
+    Operands(size_t rows, size_t cols)
+        : x(MatrixF::random(rows, cols, -1.0f, 1.0f)), y(MatrixF::random(rows, cols, -1.0f, 1.0f)),
+          bias(MatrixF::random(cols, 1, -0.1f, 0.1f)), gamma(MatrixF::random(cols, 1, 0.9f, 1.1f)),
+          beta(MatrixF::random(cols, 1, -0.1f, 0.1f)) {}
+};
+
+// One named chain: eager writes every intermediate, fused evaluates the
+// expression straight into out. Traffic counts floats per output element.
+struct Chain {
+    const char* name;
+    int eager_traffic;
+    int fused_traffic;
+    std::function<void(const Operands&, MatrixF&)> eager;
+    std::function<void(const Operands&, MatrixF&)> fused;
+};
+
+MatrixF row_vector(const MatrixF& column) {
+    MatrixF row(1, column.size());
+    std::copy(column.data(), column.data() + column.size(), row.data());
+    return row;
+}
+
+} // namespace
+
+int main() {
+    using MatrixExpr::addBroadcast;
+    using MatrixExpr::multiplyBroadcast;
+
+    const std::vector<Chain> chains = {
+        {"x + y + bias", 5, 3,
+         [](const Operands& o, MatrixF& out) {
+             MatrixF sum = (o.x + o.y).eval();
+             out = MatrixOps::addBroadcast(sum, row_vector(o.bias));
+         },
+         [](const Operands& o, MatrixF& out) { out = addBroadcast(o.x + o.y, o.bias); }},
+        {"(x + y + bias) * s", 7, 3,
+         [](const Operands& o, MatrixF& out) {
+             MatrixF sum = (o.x + o.y).eval();
+             MatrixF biased = MatrixOps::addBroadcast(sum, row_vector(o.bias));
+             out = (biased * 0.5f).eval();
+         },
+         [](const Operands& o, MatrixF& out) { out = addBroadcast(o.x + o.y, o.bias) * 0.5f; }},
+        {"(x + y) * 0.5", 5, 3,
+         [](const Operands& o, MatrixF& out) {
+             MatrixF sum = (o.x + o.y).eval();
+             out = (sum * 0.5f).eval();
+         },
+         [](const Operands& o, MatrixF& out) { out = (o.x + o.y) * 0.5f; }},
+        {"gamma * x + beta", 4, 2,
+         [](const Operands& o, MatrixF& out) {
+             MatrixF scaled = MatrixOps::multiplyBroadcast(o.x, row_vector(o.gamma));
+             out = MatrixOps::addBroadcast(scaled, row_vector(o.beta));
+         },
+         [](const Operands& o, MatrixF& out) { out = addBroadcast(multiplyBroadcast(o.x, o.gamma), o.beta); }},
+    };
+
+    const size_t seq_len = 17;
+    const std::vector<size_t> batches = {1, 8, 64, 256};
+    const std::vector<size_t> widths = {256, 512};
+    bool ok = true;
+
+    std::printf("%-20s %6s %5s %6s %6s %10s %10s %8s %8s\n", "chain", "batch", "width", "eager", "fused",
+                "eager ms", "fused ms", "speedup", "GB/s");
+    for (const Chain& chain : chains) {
+        for (size_t width : widths) {
+            for (size_t batch : batches) {
+                Operands operands(batch * seq_len, width);
+                MatrixF eager_out;
+                MatrixF fused_out;
+                chain.eager(operands, eager_out);
+                chain.fused(operands, fused_out);
+                ok = ok && max_abs_diff(eager_out, fused_out) <= 1e-6f;
+
+                double eager_s = Bench::time_per_call([&] { chain.eager(operands, eager_out); }, 0.2);
+                double fused_s = Bench::time_per_call([&] { chain.fused(operands, fused_out); }, 0.2);
+                const double bytes = double(chain.fused_traffic) * fused_out.size() * sizeof(float);
+                std::printf("%-20s %6zu %5zu %6d %6d %10.4f %10.4f %7.2fx %8.1f\n", chain.name, batch, width,
+                            chain.eager_traffic, chain.fused_traffic, eager_s * 1e3, fused_s * 1e3,
+                            eager_s / fused_s, bytes / fused_s / 1e9);
+            }
+        }
+    }
+
+    if (!ok) {
+        std::printf("✗ fused and eager results differ\n");
+        return 1;
+    }
+    return 0;
+}
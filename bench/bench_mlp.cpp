@@ -0,0 +1,95 @@
+//
+// Created by JAYAN on 27/07/2025.
+//
+// Transformer MLP block with the residual add: the unfused path (matmul_nt,
+// bias, GELU, matmul_nt, bias, residual add, each a full pass) against
+// MLP::forward_residual, where bias and GELU run in the first GEMM's epilogue
+// and the second GEMM accumulates into the residual in place. d_model = 256.
+// Both must agree to 1e-4; exit code 1 otherwise.
+// Usage: ./bench_mlp
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "../include/matrix/matrix_ops.h"
+#include "../include/matrix/activation_functions.h"
+#include "../include/transformer/mlp.h"
+#include "../include/utils/weight_file.h"
+#include "bench_common.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+MatrixF add_bias(MatrixF x, const MatrixF& bias) {
+    for (size_t i = 0; i < x.getRows(); ++i) {
+        for (size_t j = 0; j < x.getCols(); ++j) {
+            x(i, j) += bias(0, j);
+        }
+    }
+    return x;
+}
+
+// x + Linear(GELU(Linear(x))), one pass per step
+MatrixF reference_mlp(const MLP& mlp, const MatrixF& x) {
+    MatrixF hidden = add_bias(MatrixOps::matmul_nt(x, mlp.get_fc1_weight()), mlp.get_fc1_bias());
+    hidden = ActivationFunctions::gelu(hidden, mlp.get_gelu_mode());
+    MatrixF out = add_bias(MatrixOps::matmul_nt(hidden, mlp.get_fc2_weight()), mlp.get_fc2_bias());
+    return x + out;
+}
+
+} // namespace
+
+int main() {
+    const size_t d_model = 256;
+    const std::vector<size_t> hidden_dims = {512, 1024};
+    const std::vector<size_t> token_counts = {17, 1088, 3137};
+
+    bool ok = true;
+    std::printf("%8s %8s %13s %11s %9s %10s\n", "tokens", "hidden", "unfused ms", "fused ms", "speedup",
+                "max diff");
+    for (size_t hidden_dim : hidden_dims) {
+        const fs::path weights_path = fs::temp_directory_path() / "vit_bench_mlp.vitw";
+        WeightFile::write<float>(weights_path.string(), {
+            {"transformer_layers/transformer_0_linear_0_weight", MatrixF::random(hidden_dim, d_model, -0.1f, 0.1f)},
+            {"transformer_layers/transformer_0_linear_0_bias", MatrixF::random(hidden_dim, 1, -0.1f, 0.1f)},
+            {"transformer_layers/transformer_0_linear_3_weight", MatrixF::random(d_model, hidden_dim, -0.1f, 0.1f)},
+            {"transformer_layers/transformer_0_linear_3_bias", MatrixF::random(d_model, 1, -0.1f, 0.1f)},
+        });
+        MLP mlp;
+        mlp.load_weights(*WeightFile::open(weights_path.string()), 0);
+        fs::remove(weights_path);
+
+        for (size_t tokens : token_counts) {
+            MatrixF input = MatrixF::random(tokens, d_model, -1.0f, 1.0f);
+            MatrixF expected = reference_mlp(mlp, input);
+            MatrixF residual = input;
+            mlp.forward_residual(ConstMatrixViewT<float>(input), residual.view());
+
+            double max_diff = 0.0;
+            for (size_t i = 0; i < residual.size(); ++i) {
+                max_diff = std::max(max_diff,
+                                    static_cast<double>(std::fabs(residual.data()[i] - expected.data()[i])));
+            }
+            ok = ok && max_diff < 1e-4;
+
+            double unfused = Bench::time_per_call([&] { reference_mlp(mlp, input); });
+            // The residual keeps accumulating across calls; only the timing matters here
+            double fused = Bench::time_per_call([&] {
+                mlp.forward_residual(ConstMatrixViewT<float>(input), residual.view());
+            });
+            std::printf("%8zu %8zu %13.3f %11.3f %8.2fx %10.2e\n", tokens, hidden_dim, unfused * 1e3, fused * 1e3,
+                        unfused / fused, max_diff);
+        }
+    }
+
+    if (!ok) {
+        std::printf("✗ fused MLP differs from the reference\n");
+        return 1;
+    }
+    return 0;
+}
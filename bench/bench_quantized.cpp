@@ -0,0 +1,191 @@
+//
+// Created by JAYAN on 01/08/2025.
+//
+// int8 post-training quantisation against the float path, on a 6-layer
+// VisionTransformer (d_model 256, 8 heads, 28x28 images in 7x7 patches).
+//
+// GEMM: each Linear shape of the model (tokens = images * 17) through the
+// float packed GEMM and through activation quantisation + QGemm. The int8
+// result must match a reference computed from the same int8 operands to 1e-4
+// (relative).
+//
+// Model: float and int8 forwards (calibrated on CALIBRATION images, measured
+// on EVAL others) at several batch sizes, then the accuracy delta: top-1
+// agreement and logit error. Agreement must be at least 85% (random weights
+// give near-tied logits, so some flips are expected); exit code 1 otherwise.
+// Usage: ./bench_quantized
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../include/matrix/matrix_ops.h"
+#include "../include/matrix/qgemm.h"
+#include "../include/transformer/vision_transformer.h"
+#include "../include/utils/weight_file.h"
+#include "bench_common.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr size_t PATCHES = 16;
+constexpr size_t PATCH_DIM = 49;
+constexpr size_t SEQ_LEN = PATCHES + 1;
+constexpr size_t CALIBRATION = 128;
+constexpr size_t EVAL = 512;
+
+// One Linear shape: float GEMM vs int8; returns false on a mismatch
+bool bench_linear(const char* name, size_t tokens, size_t k, size_t n) {
+    MatrixF input = MatrixF::random(tokens, k, -1.0f, 1.0f);
+    MatrixF weight = MatrixF::random(n, k, -0.1f, 0.1f);
+    MatrixF bias = MatrixF::random(1, n, -0.1f, 0.1f);
+    Gemm::Epilogue<float> epilogue;
+    epilogue.bias = bias.data();
+
+    Gemm::PackedMatrix<float> packed = MatrixOps::pack_rhs_transposed(weight);
+    MatrixF float_out(tokens, n);
+    const double float_s = Bench::time_per_call([&] {
+        Gemm::gemm_packed(tokens, input.data(), k, 1, packed, float_out.data(), n, epilogue);
+    }, 0.2);
+
+    std::vector<int8_t> q;
+    std::vector<float> scales;
+    QGemm::quantize_weights(weight.data(), n, k, q, scales);
+    QGemm::PackedWeights qweights(n, k, q.data(), scales.data());
+    const QGemm::ActivationParams params = QGemm::choose_activation_params(-1.0f, 1.0f);
+    const size_t ldq = QGemm::padded_depth(k);
+    std::vector<uint8_t> qinput(tokens * ldq);
+    MatrixF int8_out(tokens, n);
+    const double int8_s = Bench::time_per_call([&] {
+        QGemm::quantize_activations(tokens, k, input.data(), k, params, qinput.data(), ldq);
+        QGemm::gemm(tokens, qinput.data(), ldq, params, qweights, int8_out.data(), n, epilogue);
+    }, 0.2);
+
+    // Reference from the same int8 operands, in double
+    double worst = 0.0;
+    for (size_t i = 0; i < tokens; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            long long acc = 0;
+            for (size_t p = 0; p < k; ++p) {
+                acc += (long long)(qinput[i * ldq + p] - params.zero_point) * q[j * k + p];
+            }
+            const double expected = double(params.scale) * scales[j] * double(acc) + bias.data()[j];
+            worst = std::max(worst, std::abs(int8_out(i, j) - expected) / (1.0 + std::abs(expected)));
+        }
+    }
+
+    const double ops = 2.0 * tokens * k * n;
+    std::printf("%-12s %6zu %5zu %5zu %10.4f %10.4f %8.2fx %9.1f %9.1f\n", name, tokens, k, n, float_s * 1e3,
+                int8_s * 1e3, float_s / int8_s, ops / float_s / 1e9, ops / int8_s / 1e9);
+    return worst <= 1e-4;
+}
+
+size_t argmax_row(const MatrixF& logits, size_t row) {
+    const float* begin = logits.row_ptr(row);
+    return static_cast<size_t>(std::max_element(begin, begin + logits.getCols()) - begin);
+}
+
+// The model's weights with every Linear row given its own range (0.02 to
+// 0.2), as output channels of trained layers have: a single per-tensor scale
+// would waste most of the int8 range on the narrow rows, so this exercises
+// the per-channel weight scales
+std::vector<std::pair<std::string, MatrixF>> model_weights() {
+    std::vector<std::pair<std::string, MatrixF>> tensors = Bench::random_weights(6, 256, 512, PATCH_DIM, SEQ_LEN, 10);
+    for (auto& [name, tensor] : tensors) {
+        const bool linear = name.find("proj_weight") != std::string::npos ||
+                            name.find("linear_") != std::string::npos || name == "classifier/mlp_head_1_weight";
+        if (!linear || name.find("_weight") == std::string::npos) {
+            continue;
+        }
+        const MatrixF row_range = MatrixF::random(tensor.getRows(), 1, 0.02f, 0.2f);
+        for (size_t r = 0; r < tensor.getRows(); ++r) {
+            float* row = tensor.data() + r * tensor.getCols();
+            for (size_t c = 0; c < tensor.getCols(); ++c) {
+                row[c] *= row_range(r, 0) / 0.1f;
+            }
+        }
+    }
+    return tensors;
+}
+
+} // namespace
+
+int main() {
+    std::printf("QGemm kernel: %s\n\n", QGemm::kernel_name());
+    std::printf("%-12s %6s %5s %5s %10s %10s %9s %9s %9s\n", "linear", "tokens", "k", "n", "float ms", "int8 ms",
+                "speedup", "f GFLOP/s", "i GOP/s");
+    bool ok = true;
+    for (size_t images : {1, 8, 64}) {
+        const size_t tokens = images * SEQ_LEN;
+        ok = bench_linear("qkv", tokens, 256, 768) && ok;
+        ok = bench_linear("out_proj", tokens, 256, 256) && ok;
+        ok = bench_linear("mlp fc1", tokens, 256, 512) && ok;
+        ok = bench_linear("mlp fc2", tokens, 512, 256) && ok;
+    }
+    if (!ok) {
+        std::printf("✗ int8 GEMM differs from its reference\n");
+    }
+
+    const fs::path weights_path = fs::temp_directory_path() / "vit_bench_quantized.vitw";
+    WeightFile::write<float>(weights_path.string(), model_weights());
+    std::shared_ptr<WeightFile> weights = WeightFile::open(weights_path.string());
+
+    const size_t max_batch = 64;
+    VisionTransformer float_model(max_batch);
+    float_model.load_weights(*weights);
+    VisionTransformer int8_model(max_batch);
+    int8_model.load_weights(*weights);
+    fs::remove(weights_path);
+
+    MatrixF calibration = MatrixF::random(CALIBRATION * PATCHES, PATCH_DIM, 0.0f, 1.0f);
+    MatrixF images = MatrixF::random(EVAL * PATCHES, PATCH_DIM, 0.0f, 1.0f);
+    int8_model.start_calibration();
+    int8_model.calibrate(calibration);
+    int8_model.quantize();
+
+    std::printf("\n%-8s %10s %10s %9s\n", "images", "float/s", "int8/s", "speedup");
+    for (size_t batch : {1, 8, 64}) {
+        ConstMatrixViewF input = images.block(0, 0, batch * PATCHES, PATCH_DIM);
+        MatrixF logits(batch, 10);
+        const double float_s = Bench::time_per_call([&] { float_model.forward(input, logits.view()); }, 0.2);
+        const double int8_s = Bench::time_per_call([&] { int8_model.forward(input, logits.view()); }, 0.2);
+        std::printf("%-8zu %10.1f %10.1f %8.2fx\n", batch, batch / float_s, batch / int8_s, float_s / int8_s);
+    }
+
+    // Accuracy delta on the evaluation images
+    MatrixF float_logits(EVAL, 10);
+    MatrixF int8_logits(EVAL, 10);
+    for (size_t first = 0; first < EVAL; first += max_batch) {
+        ConstMatrixViewF input = images.block(first * PATCHES, 0, max_batch * PATCHES, PATCH_DIM);
+        float_model.forward(input, float_logits.block(first, 0, max_batch, 10));
+        int8_model.forward(input, int8_logits.block(first, 0, max_batch, 10));
+    }
+    size_t agree = 0;
+    double max_delta = 0.0;
+    double sum_delta = 0.0;
+    double max_logit = 0.0;
+    for (size_t i = 0; i < EVAL; ++i) {
+        agree += argmax_row(float_logits, i) == argmax_row(int8_logits, i) ? 1 : 0;
+        for (size_t c = 0; c < 10; ++c) {
+            const double delta = std::abs(double(float_logits(i, c)) - int8_logits(i, c));
+            max_delta = std::max(max_delta, delta);
+            sum_delta += delta;
+            max_logit = std::max(max_logit, std::abs(double(float_logits(i, c))));
+        }
+    }
+    const double agreement = double(agree) / EVAL;
+    std::printf("\naccuracy delta over %zu images (calibrated on %zu): top-1 agreement %.1f%%, "
+                "logit error mean %.4f max %.4f (largest |logit| %.3f)\n",
+                EVAL, CALIBRATION, 100.0 * agreement, sum_delta / (EVAL * 10), max_delta, max_logit);
+
+    if (agreement < 0.85) {
+        std::printf("✗ int8 predictions agree with float on fewer than 85%% of the images\n");
+        ok = false;
+    }
+    return ok ? 0 : 1;
+}
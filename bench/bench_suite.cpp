@@ -0,0 +1,813 @@
+//
+// Created by JAYAN on 05/08/2025.
+//
+// Benchmark suite in the style of Google Benchmark, for tracking across
+// commits:
+//
+//   micro  every MatrixOps and ActivationFunctions entry point (returning and
+//          _into forms) at ViT shapes: element-wise ops on 1x49, 50x256,
+//          50x1024 and 256x256; products on the Linear shapes built from them
+//   access element-wise multiply through operator() with the Checked and
+//          Unchecked policies (MatrixAccess) against row-pointer iteration
+//   profiler  cost of one Profiler scope, disabled and enabled
+//   macro  LayerNorm::forward, PatchEmbedding::forward and the weight-load
+//          path (CSV tree and binary weight file, parse + pack) of a random
+//          6-layer model
+//
+// Each benchmark is run for a growing number of iterations until one run
+// lasts at least the minimum time; that run is reported as ns/op, GFLOP/s
+// (products and element-wise ops count one flop per element), GB/s of
+// operand traffic, and heap allocations and bytes per op, counted by the
+// replacement operator new below.
+//
+// Usage: ./bench_suite [--benchmark_filter=substring] [--benchmark_min_time=seconds]
+//                      [--benchmark_format=console|json] [--benchmark_out=file.json] [--benchmark_list]
+//   --benchmark_out writes JSON alongside the console table; with
+//   --benchmark_format=json the JSON goes to stdout instead.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+#include "../include/matrix/activation_functions.h"
+#include "../include/matrix/matrix_ops.h"
+#include "../include/transformer/embedding.h"
+#include "../include/transformer/layer_norm.h"
+#include "../include/transformer/vision_transformer.h"
+#include "../include/utils/cpu_features.h"
+#include "../include/utils/file_io.h"
+#include "../include/utils/profiler.h"
+#include "../include/utils/thread_pool.h"
+#include "../include/utils/weight_file.h"
+
+namespace fs = std::filesystem;
+
+// ---------------------------------------------------------------------------
+// Allocation counting: every heap allocation of the process goes through here
+// ---------------------------------------------------------------------------
+
+namespace {
+
+std::atomic<size_t> allocation_count{0};
+std::atomic<size_t> allocated_bytes{0};
+
+void* counted_allocate(size_t size, size_t alignment) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    void* ptr = alignment > alignof(std::max_align_t)
+        ? std::aligned_alloc(alignment, (std::max<size_t>(size, 1) + alignment - 1) / alignment * alignment)
+        : std::malloc(std::max<size_t>(size, 1));
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+} // namespace
+
+void* operator new(size_t size) { return counted_allocate(size, 0); }
+void* operator new(size_t size, std::align_val_t alignment) {
+    return counted_allocate(size, static_cast<size_t>(alignment));
+}
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+namespace {
+
+// ---------------------------------------------------------------------------
+// Registry and runner
+// ---------------------------------------------------------------------------
+
+struct Benchmark {
+    std::string name;       // family/operation/shape
+    double flops;           // Per op
+    double bytes;           // Operand traffic per op
+    std::function<void()> run;
+};
+
+struct Result {
+    const Benchmark* benchmark;
+    size_t iterations;
+    double ns_per_op;
+    double allocations_per_op;
+    double bytes_allocated_per_op;
+};
+
+std::vector<Benchmark>& registry() {
+    static std::vector<Benchmark> benchmarks;
+    return benchmarks;
+}
+
+void add(const std::string& name, double flops, double bytes, std::function<void()> run) {
+    registry().push_back({name, flops, bytes, std::move(run)});
+}
+
+// Keeps a result alive without the compiler seeing through it
+template <typename V>
+void do_not_optimize(const V& value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+// Swallows the layers' load messages while a benchmark runs
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+};
+
+Result run_benchmark(const Benchmark& benchmark, double min_seconds) {
+    NullBuffer null_buffer;
+    std::streambuf* saved = std::cout.rdbuf(&null_buffer);
+
+    benchmark.run(); // warm-up: caches, thread pool, packing buffers
+    size_t iterations = 1;
+    double elapsed = 0.0;
+    size_t allocations = 0;
+    size_t bytes = 0;
+    for (;;) {
+        const size_t count_before = allocation_count.load();
+        const size_t bytes_before = allocated_bytes.load();
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i) {
+            benchmark.run();
+        }
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        allocations = allocation_count.load() - count_before;
+        bytes = allocated_bytes.load() - bytes_before;
+        if (elapsed >= min_seconds || iterations >= 1000000000) {
+            break;
+        }
+        // Aim 40% past the minimum, growing at most 10x per round
+        const double factor = std::min(10.0, 1.4 * min_seconds / std::max(elapsed, 1e-9));
+        iterations = std::max(iterations + 1, static_cast<size_t>(iterations * factor));
+    }
+
+    std::cout.rdbuf(saved);
+    return {&benchmark, iterations, elapsed * 1e9 / iterations, double(allocations) / iterations,
+            double(bytes) / iterations};
+}
+
+double gflops(const Result& result) {
+    return result.benchmark->flops / result.ns_per_op;
+}
+
+double gbytes_per_second(const Result& result) {
+    return result.benchmark->bytes / result.ns_per_op;
+}
+
+void print_console_header() {
+    std::printf("%-52s %11s %13s %9s %8s %9s %12s\n", "benchmark", "iterations", "ns/op", "GFLOP/s", "GB/s",
+                "allocs/op", "bytes/op");
+}
+
+void print_console_row(const Result& result) {
+    std::printf("%-52s %11zu %13.1f %9.2f %8.2f %9.1f %12.0f\n", result.benchmark->name.c_str(), result.iterations,
+                result.ns_per_op, gflops(result), gbytes_per_second(result), result.allocations_per_op,
+                result.bytes_allocated_per_op);
+    std::fflush(stdout);
+}
+
+std::string iso_date() {
+    const std::time_t now = std::time(nullptr);
+    char buffer[32];
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+    return buffer;
+}
+
+// Names are built from identifiers and shapes, so they need no escaping
+void write_json(std::FILE* out, const std::vector<Result>& results, const char* executable, double min_seconds) {
+    std::fprintf(out, "{\n  \"context\": {\n");
+    std::fprintf(out, "    \"date\": \"%s\",\n", iso_date().c_str());
+    std::fprintf(out, "    \"executable\": \"%s\",\n", executable);
+    std::fprintf(out, "    \"num_threads\": %zu,\n", ThreadPool::instance().num_threads());
+    std::fprintf(out, "    \"isa\": \"%s\",\n", CpuFeatures::isa_name(CpuFeatures::active_isa()));
+    std::fprintf(out, "    \"gemm_kernel\": \"%s\",\n", Gemm::kernel_name());
+    std::fprintf(out, "    \"compiler\": \"%s\",\n", __VERSION__);
+    std::fprintf(out, "    \"min_time_s\": %g\n  },\n  \"benchmarks\": [\n", min_seconds);
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& result = results[i];
+        const std::string& name = result.benchmark->name;
+        std::fprintf(out, "    {\"name\": \"%s\", \"family\": \"%s\", \"iterations\": %zu, \"ns_per_op\": %.3f, "
+                          "\"flops_per_op\": %.0f, \"gflops_per_second\": %.4f, \"bytes_per_op\": %.0f, "
+                          "\"gbytes_per_second\": %.4f, \"allocations_per_op\": %.3f, "
+                          "\"bytes_allocated_per_op\": %.1f}%s\n",
+                     name.c_str(), name.substr(0, name.find('/')).c_str(), result.iterations, result.ns_per_op,
+                     result.benchmark->flops, gflops(result), result.benchmark->bytes, gbytes_per_second(result),
+                     result.allocations_per_op, result.bytes_allocated_per_op, i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(out, "  ]\n}\n");
+}
+
+// ---------------------------------------------------------------------------
+// Micro benchmarks
+// ---------------------------------------------------------------------------
+
+struct Shape {
+    size_t rows;
+    size_t cols;
+    std::string name() const { return std::to_string(rows) + "x" + std::to_string(cols); }
+    double elements() const { return double(rows) * cols; }
+};
+
+// Linear product: (m x k) times (k x n)
+struct GemmShape {
+    size_t m;
+    size_t k;
+    size_t n;
+    std::string name() const { return std::to_string(m) + "x" + std::to_string(k) + "x" + std::to_string(n); }
+    double flops() const { return 2.0 * m * k * n; }
+    double bytes() const { return sizeof(float) * (double(m) * k + double(k) * n + double(m) * n); }
+};
+
+const Shape ELEMENT_SHAPES[] = {{1, 49}, {50, 256}, {50, 1024}, {256, 256}};
+
+// One patch through the projection, then the token-major Linears of a
+// 50-token sequence (QKV/output projection, MLP up and down) and a square one
+const GemmShape GEMM_SHAPES[] = {{1, 49, 256}, {50, 256, 256}, {50, 256, 1024}, {50, 1024, 256}, {256, 256, 256}};
+
+using MatrixPtr = std::shared_ptr<MatrixF>;
+
+// Positive inputs, so log, sqrt, power and division are all well defined
+MatrixPtr random_matrix(size_t rows, size_t cols) {
+    return std::make_shared<MatrixF>(MatrixF::random(rows, cols, 0.5f, 1.5f));
+}
+
+MatrixPtr output_matrix(size_t rows, size_t cols) {
+    return std::make_shared<MatrixF>(rows, cols);
+}
+
+// out = op(a), op(a, b): `inputs` operands of the shape plus one output
+using ElementOp = std::function<void(const MatrixF& a, const MatrixF& b, MatrixF& out)>;
+
+void add_element_op(const std::string& family, const std::string& op, int inputs, ElementOp fn) {
+    for (const Shape& shape : ELEMENT_SHAPES) {
+        MatrixPtr a = random_matrix(shape.rows, shape.cols);
+        MatrixPtr b = random_matrix(shape.rows, shape.cols);
+        MatrixPtr out = output_matrix(shape.rows, shape.cols);
+        add(family + "/" + op + "/" + shape.name(), shape.elements(), sizeof(float) * shape.elements() * (inputs + 1),
+            [a, b, out, fn] { fn(*a, *b, *out); });
+    }
+}
+
+void register_matrix_ops() {
+    const std::string family = "MatrixOps";
+
+    for (const GemmShape& shape : GEMM_SHAPES) {
+        MatrixPtr a = random_matrix(shape.m, shape.k);
+        MatrixPtr b = random_matrix(shape.k, shape.n);
+        MatrixPtr b_t = random_matrix(shape.n, shape.k);
+        MatrixPtr a_t = random_matrix(shape.k, shape.m);
+        MatrixPtr c = output_matrix(shape.m, shape.n);
+        auto packed = std::make_shared<Gemm::PackedMatrix<float>>(MatrixOps::pack_rhs(*b));
+        const std::string suffix = "/" + shape.name();
+        const double flops = shape.flops();
+        const double bytes = shape.bytes();
+        const double pack_bytes = 2.0 * sizeof(float) * shape.k * shape.n;
+
+        add(family + "/matmul" + suffix, flops, bytes, [=] { do_not_optimize(MatrixOps::matmul(*a, *b)); });
+        add(family + "/matmul_nt" + suffix, flops, bytes, [=] { do_not_optimize(MatrixOps::matmul_nt(*a, *b_t)); });
+        add(family + "/matmul_tn" + suffix, flops, bytes, [=] { do_not_optimize(MatrixOps::matmul_tn(*a_t, *b)); });
+        add(family + "/matmul_into" + suffix, flops, bytes, [=] { MatrixOps::matmul_into(c->view(), *a, *b); });
+        add(family + "/matmul_nt_into" + suffix, flops, bytes, [=] { MatrixOps::matmul_nt_into(c->view(), *a, *b_t); });
+        add(family + "/matmul_tn_into" + suffix, flops, bytes, [=] { MatrixOps::matmul_tn_into(c->view(), *a_t, *b); });
+        add(family + "/pack_rhs" + suffix, 0.0, pack_bytes, [=] { do_not_optimize(MatrixOps::pack_rhs(*b)); });
+        add(family + "/pack_rhs_transposed" + suffix, 0.0, pack_bytes,
+            [=] { do_not_optimize(MatrixOps::pack_rhs_transposed(*b_t)); });
+        add(family + "/matmul_packed" + suffix, flops, bytes, [=] { do_not_optimize(MatrixOps::matmul(*a, *packed)); });
+        add(family + "/matmul_packed_into" + suffix, flops, bytes,
+            [=] { MatrixOps::matmul_into(c->view(), *a, *packed); });
+    }
+
+    add_element_op(family, "elementWiseMultiply", 2, [](const MatrixF& a, const MatrixF& b, MatrixF&) {
+        do_not_optimize(MatrixOps::elementWiseMultiply(a, b));
+    });
+    add_element_op(family, "elementWiseDivide", 2, [](const MatrixF& a, const MatrixF& b, MatrixF&) {
+        do_not_optimize(MatrixOps::elementWiseDivide(a, b));
+    });
+    add_element_op(family, "elementWiseMultiply_into", 2, [](const MatrixF& a, const MatrixF& b, MatrixF& out) {
+        MatrixOps::elementWiseMultiply_into(out.view(), a, b);
+    });
+    add_element_op(family, "elementWiseDivide_into", 2, [](const MatrixF& a, const MatrixF& b, MatrixF& out) {
+        MatrixOps::elementWiseDivide_into(out.view(), a, b);
+    });
+    add_element_op(family, "add_into", 2, [](const MatrixF& a, const MatrixF& b, MatrixF& out) {
+        MatrixOps::add_into(out.view(), a, b);
+    });
+    add_element_op(family, "subtract_into", 2, [](const MatrixF& a, const MatrixF& b, MatrixF& out) {
+        MatrixOps::subtract_into(out.view(), a, b);
+    });
+    add_element_op(family, "scale_into", 1, [](const MatrixF& a, const MatrixF&, MatrixF& out) {
+        MatrixOps::scale_into(out.view(), a, 0.5);
+    });
+    add_element_op(family, "power", 1, [](const MatrixF& a, const MatrixF&, MatrixF&) {
+        do_not_optimize(MatrixOps::power(a, 1.5));
+    });
+    add_element_op(family, "sqrt", 1, [](const MatrixF& a, const MatrixF&, MatrixF&) {
+        do_not_optimize(MatrixOps::sqrt(a));
+    });
+    add_element_op(family, "exp", 1, [](const MatrixF& a, const MatrixF&, MatrixF&) {
+        do_not_optimize(MatrixOps::exp(a));
+    });
+    add_element_op(family, "log", 1, [](const MatrixF& a, const MatrixF&, MatrixF&) {
+        do_not_optimize(MatrixOps::log(a));
+    });
+    add_element_op(family, "power_into", 1, [](const MatrixF& a, const MatrixF&, MatrixF& out) {
+        MatrixOps::power_into(out.view(), a, 1.5);
+    });
+    add_element_op(family, "sqrt_into", 1, [](const MatrixF& a, const MatrixF&, MatrixF& out) {
+        MatrixOps::sqrt_into(out.view(), a);
+    });
+    add_element_op(family, "exp_into", 1, [](const MatrixF& a, const MatrixF&, MatrixF& out) {
+        MatrixOps::exp_into(out.view(), a);
+    });
+    add_element_op(family, "log_into", 1, [](const MatrixF& a, const MatrixF&, MatrixF& out) {
+        MatrixOps::log_into(out.view(), a);
+    });
+
+    // Shape-changing ops: transposes, broadcasts against a row vector and
+    // reductions
+    for (const Shape& shape : ELEMENT_SHAPES) {
+        MatrixPtr a = random_matrix(shape.rows, shape.cols);
+        MatrixPtr row = random_matrix(1, shape.cols);
+        MatrixPtr out = output_matrix(shape.rows, shape.cols);
+        MatrixPtr out_t = output_matrix(shape.cols, shape.rows);
+        MatrixPtr sums = output_matrix(1, shape.cols);
+        const std::string suffix = "/" + shape.name();
+        const double elements = shape.elements();
+        const double copy_bytes = 2.0 * sizeof(float) * elements;
+        const double read_bytes = sizeof(float) * elements;
+
+        add(family + "/transpose" + suffix, 0.0, copy_bytes, [=] { do_not_optimize(MatrixOps::transpose(*a)); });
+        add(family + "/transpose_view" + suffix, 0.0, copy_bytes,
+            [=] { do_not_optimize(MatrixOps::transpose(ConstMatrixViewF(*a))); });
+        add(family + "/transpose_into" + suffix, 0.0, copy_bytes, [=] { MatrixOps::transpose_into(out_t->view(), *a); });
+        add(family + "/addBroadcast" + suffix, elements, copy_bytes,
+            [=] { do_not_optimize(MatrixOps::addBroadcast(*a, *row)); });
+        add(family + "/multiplyBroadcast" + suffix, elements, copy_bytes,
+            [=] { do_not_optimize(MatrixOps::multiplyBroadcast(*a, *row)); });
+        add(family + "/addBroadcast_into" + suffix, elements, copy_bytes,
+            [=] { MatrixOps::addBroadcast_into(out->view(), *a, *row); });
+        add(family + "/multiplyBroadcast_into" + suffix, elements, copy_bytes,
+            [=] { MatrixOps::multiplyBroadcast_into(out->view(), *a, *row); });
+        add(family + "/sum" + suffix, elements, read_bytes, [=] { do_not_optimize(MatrixOps::sum(*a)); });
+        add(family + "/mean" + suffix, elements, read_bytes, [=] { do_not_optimize(MatrixOps::mean(*a)); });
+        add(family + "/sumAxis" + suffix, elements, read_bytes, [=] { do_not_optimize(MatrixOps::sumAxis(*a, 0)); });
+        add(family + "/meanAxis" + suffix, elements, read_bytes, [=] { do_not_optimize(MatrixOps::meanAxis(*a, 0)); });
+        add(family + "/sumAxis_into" + suffix, elements, read_bytes,
+            [=] { MatrixOps::sumAxis_into(sums->view(), *a, 0); });
+        add(family + "/meanAxis_into" + suffix, elements, read_bytes,
+            [=] { MatrixOps::meanAxis_into(sums->view(), *a, 0); });
+    }
+
+    // Square-only properties: trace on the attention score and projection
+    // shapes; determinant and inverse exist for small matrices only
+    for (size_t n : {50, 256}) {
+        MatrixPtr a = random_matrix(n, n);
+        add(family + "/trace/" + std::to_string(n) + "x" + std::to_string(n), double(n), sizeof(float) * n,
+            [=] { do_not_optimize(MatrixOps::trace(*a)); });
+    }
+    MatrixPtr m3 = random_matrix(3, 3);
+    MatrixPtr m2 = random_matrix(2, 2);
+    (*m2)(0, 1) = -(*m2)(0, 1); // Keep it clearly non-singular
+    MatrixPtr m2_out = output_matrix(2, 2);
+    add(family + "/determinant/3x3", 17.0, sizeof(float) * 9, [=] { do_not_optimize(MatrixOps::determinant(*m3)); });
+    add(family + "/inverse/2x2", 8.0, sizeof(float) * 8, [=] { do_not_optimize(MatrixOps::inverse(*m2)); });
+    add(family + "/inverse_into/2x2", 8.0, sizeof(float) * 8, [=] { MatrixOps::inverse_into(m2_out->view(), *m2); });
+}
+
+void register_activation_functions() {
+    const std::string family = "ActivationFunctions";
+    using ActivationFunctions::GeluMode;
+
+    add_element_op(family, "relu", 1, [](const MatrixF& a, const MatrixF&, MatrixF&) {
+        do_not_optimize(ActivationFunctions::relu(a));
+    });
+    add_element_op(family, "reluDerivative", 1, [](const MatrixF& a, const MatrixF&, MatrixF&) {
+        do_not_optimize(ActivationFunctions::reluDerivative(a));
+    });
+    add_element_op(family, "relu_into", 1, [](const MatrixF& a, const MatrixF&, MatrixF& out) {
+        ActivationFunctions::relu_into(out.view(), a);
+    });
+    add_element_op(family, "reluDerivative_into", 1, [](const MatrixF& a, const MatrixF&, MatrixF& out) {
+        ActivationFunctions::reluDerivative_into(out.view(), a);
+    });
+    add_element_op(family, "gelu_tanh", 1, [](const MatrixF& a, const MatrixF&, MatrixF&) {
+        do_not_optimize(ActivationFunctions::gelu(a, GeluMode::Tanh));
+    });
+    add_element_op(family, "gelu_erf", 1, [](const MatrixF& a, const MatrixF&, MatrixF&) {
+        do_not_optimize(ActivationFunctions::gelu(a, GeluMode::Erf));
+    });
+    add_element_op(family, "geluDerivative", 1, [](const MatrixF& a, const MatrixF&, MatrixF&) {
+        do_not_optimize(ActivationFunctions::geluDerivative(a));
+    });
+    add_element_op(family, "gelu_tanh_into", 1, [](const MatrixF& a, const MatrixF&, MatrixF& out) {
+        ActivationFunctions::gelu_into(out.view(), a, GeluMode::Tanh);
+    });
+    add_element_op(family, "gelu_erf_into", 1, [](const MatrixF& a, const MatrixF&, MatrixF& out) {
+        ActivationFunctions::gelu_into(out.view(), a, GeluMode::Erf);
+    });
+    add_element_op(family, "geluDerivative_into", 1, [](const MatrixF& a, const MatrixF&, MatrixF& out) {
+        ActivationFunctions::geluDerivative_into(out.view(), a);
+    });
+    add_element_op(family, "softmax", 1, [](const MatrixF& a, const MatrixF&, MatrixF&) {
+        do_not_optimize(ActivationFunctions::softmax(a));
+    });
+    add_element_op(family, "softmax_into", 1, [](const MatrixF& a, const MatrixF&, MatrixF& out) {
+        ActivationFunctions::softmax_into(out.view(), a);
+    });
+    add_element_op(family, "softmaxRows", 1, [](const MatrixF& a, const MatrixF&, MatrixF& out) {
+        ActivationFunctions::softmaxRows(ConstMatrixViewF(a), out.view(), 0.125);
+    });
+    add_element_op(family, "dropout", 1, [](const MatrixF& a, const MatrixF&, MatrixF&) {
+        do_not_optimize(ActivationFunctions::dropout(a));
+    });
+    add_element_op(family, "dropout_into", 1, [](const MatrixF& a, const MatrixF&, MatrixF& out) {
+        ActivationFunctions::dropout_into(out.view(), a);
+    });
+    add_element_op(family, "sigmoid", 1, [](const MatrixF& a, const MatrixF&, MatrixF&) {
+        do_not_optimize(ActivationFunctions::sigmoid(a));
+    });
+    add_element_op(family, "tanh", 1, [](const MatrixF& a, const MatrixF&, MatrixF&) {
+        do_not_optimize(ActivationFunctions::tanh(a));
+    });
+    add_element_op(family, "leakyRelu", 1, [](const MatrixF& a, const MatrixF&, MatrixF&) {
+        do_not_optimize(ActivationFunctions::leakyRelu(a));
+    });
+    add_element_op(family, "sigmoid_into", 1, [](const MatrixF& a, const MatrixF&, MatrixF& out) {
+        ActivationFunctions::sigmoid_into(out.view(), a);
+    });
+    add_element_op(family, "tanh_into", 1, [](const MatrixF& a, const MatrixF&, MatrixF& out) {
+        ActivationFunctions::tanh_into(out.view(), a);
+    });
+    add_element_op(family, "leakyRelu_into", 1, [](const MatrixF& a, const MatrixF&, MatrixF& out) {
+        ActivationFunctions::leakyRelu_into(out.view(), a);
+    });
+    add_element_op(family, "clip", 1, [](const MatrixF& a, const MatrixF&, MatrixF&) {
+        do_not_optimize(ActivationFunctions::clip(a, 0.75, 1.25));
+    });
+    add_element_op(family, "clip_into", 1, [](const MatrixF& a, const MatrixF&, MatrixF& out) {
+        ActivationFunctions::clip_into(out.view(), a, 0.75, 1.25);
+    });
+
+    // LayerNorm helpers, over rows with gamma/beta of the row width
+    for (const Shape& shape : ELEMENT_SHAPES) {
+        MatrixPtr a = random_matrix(shape.rows, shape.cols);
+        MatrixPtr gamma = random_matrix(1, shape.cols);
+        MatrixPtr beta = random_matrix(1, shape.cols);
+        MatrixPtr out = output_matrix(shape.rows, shape.cols);
+        MatrixPtr mean = output_matrix(shape.rows, 1);
+        MatrixPtr variance = output_matrix(shape.rows, 1);
+        const std::string suffix = "/" + shape.name();
+        const double elements = shape.elements();
+        const double norm_bytes = 2.0 * sizeof(float) * elements;
+        const double stats_bytes = sizeof(float) * elements;
+
+        add(family + "/layerNorm" + suffix, elements, norm_bytes,
+            [=] { do_not_optimize(ActivationFunctions::layerNorm(*a, *gamma, *beta)); });
+        add(family + "/layerNorm_into" + suffix, elements, norm_bytes,
+            [=] { ActivationFunctions::layerNorm_into(out->view(), *a, *gamma, *beta); });
+        add(family + "/layerNormRows" + suffix, elements, norm_bytes,
+            [=] { ActivationFunctions::layerNormRows(ConstMatrixViewF(*a), *gamma, *beta, 1e-5, out->view()); });
+        // Normalising an already normalised matrix costs the same
+        add(family + "/layerNormInPlace" + suffix, elements, norm_bytes,
+            [=] { ActivationFunctions::layerNormInPlace(*out, *gamma, *beta); });
+        add(family + "/computeMeanAndVariance" + suffix, elements, stats_bytes,
+            [=] { do_not_optimize(ActivationFunctions::computeMeanAndVariance(*a)); });
+        add(family + "/computeMeanAndVariance_into" + suffix, elements, stats_bytes,
+            [=] { ActivationFunctions::computeMeanAndVariance_into(mean->view(), variance->view(), *a); });
+    }
+}
+
+// Element-wise multiply through the accessor under an explicit policy
+template <typename Policy>
+void multiply_indexed(const MatrixF& a, const MatrixF& b, MatrixF& out) {
+    for (size_t i = 0; i < out.getRows(); ++i) {
+        for (size_t j = 0; j < out.getCols(); ++j) {
+            out.get<Policy>(i, j) = a.get<Policy>(i, j) * b.get<Policy>(i, j);
+        }
+    }
+}
+
+// The same loop on row pointers, shapes checked once on entry, the way the
+// MatrixOps kernels are written
+void multiply_rows(const MatrixF& a, const MatrixF& b, MatrixF& out) {
+    if (a.shape() != out.shape() || b.shape() != out.shape()) {
+        throw std::invalid_argument("multiply_rows: shape mismatch");
+    }
+    for (size_t i = 0; i < out.getRows(); ++i) {
+        const float* x = a.row_ptr(i);
+        const float* y = b.row_ptr(i);
+        float* z = out.row_ptr(i);
+        for (size_t j = 0; j < out.getCols(); ++j) {
+            z[j] = x[j] * y[j];
+        }
+    }
+}
+
+void register_access() {
+    add_element_op("Access", "multiply_checked", 2, multiply_indexed<MatrixAccess::Checked>);
+    add_element_op("Access", "multiply_unchecked", 2, multiply_indexed<MatrixAccess::Unchecked>);
+    add_element_op("Access", "multiply_row_ptr", 2, multiply_rows);
+}
+
+// An empty scope: what every instrumented kernel pays. Enabled scopes append
+// an event each, so the trace is dropped every few thousand calls.
+void register_profiler() {
+    add("Profiler/scope_disabled", 0.0, 0.0, [] { VIT_PROFILE_SCOPE("Bench", "empty", 1, 1); });
+    add("Profiler/scope_enabled", 0.0, 0.0, [] {
+        static size_t calls = 0;
+        Profiler::set_enabled(true);
+        {
+            VIT_PROFILE_SCOPE("Bench", "empty", 1, 1);
+        }
+        Profiler::set_enabled(false);
+        if (++calls % 4096 == 0) {
+            Profiler::reset();
+        }
+    });
+}
+
+// ---------------------------------------------------------------------------
+// Macro benchmarks
+// ---------------------------------------------------------------------------
+
+constexpr size_t LAYERS = 6;
+constexpr size_t D_MODEL = 256;
+constexpr size_t HIDDEN = 512;
+constexpr size_t PATCHES = 16;
+constexpr size_t PATCH_DIM = 49;
+constexpr size_t SEQ_LEN = PATCHES + 1;
+constexpr size_t CLASSES = 10;
+
+std::vector<std::pair<std::string, MatrixF>> random_weights() {
+    std::vector<std::pair<std::string, MatrixF>> tensors = {
+        {"other/input_layer_weight", MatrixF::random(D_MODEL, PATCH_DIM, -0.1f, 0.1f)},
+        {"other/input_layer_bias", MatrixF::random(D_MODEL, 1, -0.1f, 0.1f)},
+        {"position_embedding/pos_embedding", MatrixF::random(SEQ_LEN, D_MODEL, -0.1f, 0.1f)},
+        {"class_token/cls_token", MatrixF::random(1, D_MODEL, -0.1f, 0.1f)},
+        {"classifier/mlp_head_0_weight", MatrixF::random(D_MODEL, 1, 0.9f, 1.1f)},
+        {"classifier/mlp_head_0_bias", MatrixF::random(D_MODEL, 1, -0.1f, 0.1f)},
+        {"classifier/mlp_head_1_weight", MatrixF::random(CLASSES, D_MODEL, -0.1f, 0.1f)},
+        {"classifier/mlp_head_1_bias", MatrixF::random(CLASSES, 1, -0.1f, 0.1f)},
+    };
+    for (size_t i = 0; i < LAYERS; ++i) {
+        const std::string prefix = "transformer_layers/transformer_" + std::to_string(i) + "_";
+        for (const char* norm : {"layer_norm_1", "layer_norm_2"}) {
+            tensors.emplace_back(prefix + norm + "_weight", MatrixF::random(D_MODEL, 1, 0.9f, 1.1f));
+            tensors.emplace_back(prefix + norm + "_bias", MatrixF::random(D_MODEL, 1, -0.1f, 0.1f));
+        }
+        tensors.emplace_back(prefix + "attn_in_proj_weight", MatrixF::random(3 * D_MODEL, D_MODEL, -0.1f, 0.1f));
+        tensors.emplace_back(prefix + "attn_in_proj_bias", MatrixF::random(3 * D_MODEL, 1, -0.1f, 0.1f));
+        tensors.emplace_back(prefix + "attn_out_proj_weight", MatrixF::random(D_MODEL, D_MODEL, -0.1f, 0.1f));
+        tensors.emplace_back(prefix + "attn_out_proj_bias", MatrixF::random(D_MODEL, 1, -0.1f, 0.1f));
+        tensors.emplace_back(prefix + "linear_0_weight", MatrixF::random(HIDDEN, D_MODEL, -0.1f, 0.1f));
+        tensors.emplace_back(prefix + "linear_0_bias", MatrixF::random(HIDDEN, 1, -0.1f, 0.1f));
+        tensors.emplace_back(prefix + "linear_3_weight", MatrixF::random(D_MODEL, HIDDEN, -0.1f, 0.1f));
+        tensors.emplace_back(prefix + "linear_3_bias", MatrixF::random(D_MODEL, 1, -0.1f, 0.1f));
+    }
+    return tensors;
+}
+
+// Same layout as the exported weights: a header row, then full-precision values
+void write_weight_csv(const fs::path& filename, const MatrixF& matrix) {
+    std::FILE* file = std::fopen(filename.string().c_str(), "w");
+    if (file == nullptr) {
+        throw std::runtime_error("Cannot create file: " + filename.string());
+    }
+    for (size_t j = 0; j < matrix.getCols(); ++j) {
+        std::fprintf(file, "%zu%s", j, j + 1 < matrix.getCols() ? "," : "\n");
+    }
+    for (size_t i = 0; i < matrix.getRows(); ++i) {
+        const float* row = matrix.row_ptr(i);
+        for (size_t j = 0; j < matrix.getCols(); ++j) {
+            std::fprintf(file, "%.9g%s", row[j], j + 1 < matrix.getCols() ? "," : "\n");
+        }
+    }
+    std::fclose(file);
+}
+
+// The random model as a weights_organized/ tree and as a .vitw, removed on exit
+struct WeightFixture {
+    fs::path root;
+    fs::path csv_dir;
+    fs::path binary;
+    size_t csv_bytes = 0;
+    size_t parameters = 0;
+
+    WeightFixture() {
+        root = fs::temp_directory_path() / ("vit_bench_suite_" + std::to_string(::getpid()));
+        csv_dir = root / "weights_organized";
+        binary = root / "weights.vitw";
+        const auto tensors = random_weights();
+        for (const auto& tensor : tensors) {
+            const fs::path path = csv_dir / (tensor.first + ".csv");
+            fs::create_directories(path.parent_path());
+            write_weight_csv(path, tensor.second);
+            csv_bytes += fs::file_size(path);
+            parameters += tensor.second.size();
+        }
+        WeightFile::write<float>(binary.string(), tensors);
+    }
+
+    ~WeightFixture() {
+        std::error_code ignored;
+        fs::remove_all(root, ignored);
+    }
+};
+
+void register_macro(const std::shared_ptr<WeightFixture>& fixture) {
+    std::shared_ptr<WeightFile> weights = WeightFile::open(fixture->binary.string());
+
+    // LayerNorm over one image's tokens, a 64-image batch, and ViT-B width
+    for (const Shape& shape : {Shape{SEQ_LEN, D_MODEL}, Shape{64 * SEQ_LEN, D_MODEL}, Shape{50, 1024}}) {
+        auto norm = std::make_shared<LayerNorm>(static_cast<int>(shape.cols));
+        if (shape.cols == D_MODEL) {
+            norm->load_weights(*weights, 0, "layer_norm_1");
+        }
+        MatrixPtr x = random_matrix(shape.rows, shape.cols);
+        MatrixPtr out = output_matrix(shape.rows, shape.cols);
+        const double bytes = 2.0 * sizeof(float) * shape.elements();
+        add("LayerNorm/forward/" + shape.name(), shape.elements(), bytes,
+            [=] { do_not_optimize(norm->forward(*x)); });
+        add("LayerNorm/forward_into/" + shape.name(), shape.elements(), bytes,
+            [=] { norm->forward(ConstMatrixViewF(*x), out->view()); });
+    }
+
+    // Patch projection plus class token and positional embeddings
+    auto embedding = std::make_shared<PatchEmbedding>();
+    embedding->load_weights(*weights);
+    for (size_t images : {1, 8, 64}) {
+        MatrixPtr patches = random_matrix(images * PATCHES, PATCH_DIM);
+        MatrixPtr tokens = output_matrix(images * SEQ_LEN, D_MODEL);
+        const std::string suffix = "/" + std::to_string(images) + "img";
+        const double flops = 2.0 * images * PATCHES * PATCH_DIM * D_MODEL;
+        const double bytes = sizeof(float) * (double(images) * PATCHES * PATCH_DIM + double(images) * SEQ_LEN * D_MODEL);
+        add("PatchEmbedding/forward" + suffix, flops, bytes, [=] { do_not_optimize(embedding->forward(*patches)); });
+        add("PatchEmbedding/forward_into" + suffix, flops, bytes,
+            [=] { embedding->forward(ConstMatrixViewF(*patches), tokens->view()); });
+    }
+
+    // Weight load: parse (or map) every tensor, check shapes, pack the GEMM
+    // operands and plan the activation arena
+    const std::string model = "/" + std::to_string(LAYERS) + "L";
+    const double csv_bytes = double(fixture->csv_bytes);
+    const double binary_bytes = double(fs::file_size(fixture->binary));
+    add("WeightLoad/FileIO_csv_tree" + model, 0.0, csv_bytes, [=] {
+        for (const auto& entry : fs::recursive_directory_iterator(fixture->csv_dir)) {
+            if (entry.is_regular_file()) {
+                do_not_optimize(FileIO::load_matrix_from_csv<float>(entry.path().string(), true));
+            }
+        }
+    });
+    add("WeightLoad/VisionTransformer_csv" + model, 0.0, csv_bytes, [=] {
+        VisionTransformer vit;
+        vit.load_weights(fixture->csv_dir.string());
+        do_not_optimize(vit);
+    });
+    add("WeightLoad/WeightFile_open" + model, 0.0, binary_bytes,
+        [=] { do_not_optimize(WeightFile::open(fixture->binary.string())); });
+    add("WeightLoad/VisionTransformer_vitw" + model, 0.0, binary_bytes, [=] {
+        VisionTransformer vit;
+        vit.load_weights(*WeightFile::open(fixture->binary.string()));
+        do_not_optimize(vit);
+    });
+
+    // Same with the packed Linear weights adopted from a warm cache instead
+    // of packed, one cache per storage
+    for (Gemm::Storage storage : {Gemm::Storage::Native, Gemm::Storage::BFloat16}) {
+        const std::string name = Gemm::storage_name(storage);
+        const std::string cache = (fixture->root / ("packed_" + name + ".vitw")).string();
+        {
+            VisionTransformer warm;
+            warm.set_weight_storage(storage);
+            warm.load_weights(*WeightFile::open(fixture->binary.string()), cache);
+        }
+        if (storage != Gemm::Storage::Native) {
+            add("WeightLoad/VisionTransformer_vitw_" + name + model, 0.0, binary_bytes, [=] {
+                VisionTransformer vit;
+                vit.set_weight_storage(storage);
+                vit.load_weights(*WeightFile::open(fixture->binary.string()));
+                do_not_optimize(vit);
+            });
+        }
+        add("WeightLoad/VisionTransformer_vitw_cached_" + name + model, 0.0, binary_bytes, [=] {
+            VisionTransformer vit;
+            vit.set_weight_storage(storage);
+            vit.load_weights(*WeightFile::open(fixture->binary.string()), cache);
+            do_not_optimize(vit);
+        });
+    }
+}
+
+bool starts_with(const std::string& text, const std::string& prefix) {
+    return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string filter;
+    std::string format = "console";
+    std::string out_path;
+    double min_seconds = 0.1;
+    bool list_only = false;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (starts_with(arg, "--benchmark_filter=")) {
+            filter = arg.substr(19);
+        } else if (starts_with(arg, "--benchmark_min_time=")) {
+            min_seconds = std::atof(arg.c_str() + 21);
+        } else if (starts_with(arg, "--benchmark_format=")) {
+            format = arg.substr(19);
+        } else if (starts_with(arg, "--benchmark_out=")) {
+            out_path = arg.substr(16);
+        } else if (arg == "--benchmark_list") {
+            list_only = true;
+        } else {
+            std::fprintf(stderr, "Unknown argument: %s\n", arg.c_str());
+            return 1;
+        }
+    }
+    if (format != "console" && format != "json") {
+        std::fprintf(stderr, "--benchmark_format must be console or json\n");
+        return 1;
+    }
+
+    std::shared_ptr<WeightFixture> fixture;
+    try {
+        fixture = std::make_shared<WeightFixture>();
+        register_matrix_ops();
+        register_activation_functions();
+        register_access();
+        register_profiler();
+        register_macro(fixture);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "✗ Setting up the benchmarks failed: %s\n", e.what());
+        return 1;
+    }
+
+    std::vector<const Benchmark*> selected;
+    for (const Benchmark& benchmark : registry()) {
+        if (benchmark.name.find(filter) != std::string::npos) {
+            selected.push_back(&benchmark);
+        }
+    }
+    if (list_only) {
+        for (const Benchmark* benchmark : selected) {
+            std::printf("%s\n", benchmark->name.c_str());
+        }
+        return 0;
+    }
+
+    const bool console = format == "console";
+    if (console) {
+        std::printf("GEMM kernel: %s, ISA: %s, threads: %zu, min time %.3g s\n\n", Gemm::kernel_name(),
+                    CpuFeatures::isa_name(CpuFeatures::active_isa()), ThreadPool::instance().num_threads(),
+                    min_seconds);
+        print_console_header();
+    }
+    std::vector<Result> results;
+    for (const Benchmark* benchmark : selected) {
+        try {
+            results.push_back(run_benchmark(*benchmark, min_seconds));
+        } catch (const std::exception& e) {
+            std::fprintf(stderr, "✗ %s: %s\n", benchmark->name.c_str(), e.what());
+            return 1;
+        }
+        if (console) {
+            print_console_row(results.back());
+        }
+    }
+
+    if (!console) {
+        write_json(stdout, results, argv[0], min_seconds);
+    }
+    if (!out_path.empty()) {
+        std::FILE* out = std::fopen(out_path.c_str(), "w");
+        if (out == nullptr) {
+            std::fprintf(stderr, "✗ Cannot write %s\n", out_path.c_str());
+            return 1;
+        }
+        write_json(out, results, argv[0], min_seconds);
+        std::fclose(out);
+        if (console) {
+            std::printf("\nJSON: %s (%zu benchmarks)\n", out_path.c_str(), results.size());
+        }
+    }
+    return 0;
+}
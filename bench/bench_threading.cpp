@@ -0,0 +1,75 @@
+//
+// Created by JAYAN on 15/07/2025.
+//
+// Thread scaling of the pooled kernels on ViT-shaped inputs (d_model = 256).
+// Usage: ./bench_threading [max_threads]
+//
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../include/matrix/matrix.h"
+#include "../include/matrix/matrix_ops.h"
+#include "../include/matrix/activation_functions.h"
+#include "../include/utils/thread_pool.h"
+#include "bench_common.h"
+
+namespace {
+
+struct Case {
+    std::string name;
+    double flops;                   // 0 for memory-bound kernels
+    std::function<void()> run;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+    if (argc > 1) {
+        max_threads = std::max(1, std::atoi(argv[1]));
+    }
+
+    const size_t batch_tokens = 32 * 50; // 32 images x seq_len 50
+    MatrixF tokens = MatrixF::random(batch_tokens, 256, -1.0f, 1.0f);
+    MatrixF w_qkv = MatrixF::random(768, 256, -0.1f, 0.1f);
+    MatrixF w_fc1 = MatrixF::random(1024, 256, -0.1f, 0.1f);
+    MatrixF w_fc2 = MatrixF::random(256, 1024, -0.1f, 0.1f);
+    MatrixF hidden = MatrixF::random(batch_tokens, 1024, -1.0f, 1.0f);
+    MatrixF gamma = MatrixF::ones(1, 256);
+    MatrixF beta = MatrixF::zeros(1, 256);
+
+    std::vector<Case> cases = {
+        {"matmul_nt 1600x256 * (768x256)^T", 2.0 * batch_tokens * 256 * 768,
+         [&] { MatrixOps::matmul_nt(tokens, w_qkv); }},
+        {"matmul_nt 1600x256 * (1024x256)^T", 2.0 * batch_tokens * 256 * 1024,
+         [&] { MatrixOps::matmul_nt(tokens, w_fc1); }},
+        {"matmul_nt 1600x1024 * (256x1024)^T", 2.0 * batch_tokens * 1024 * 256,
+         [&] { MatrixOps::matmul_nt(hidden, w_fc2); }},
+        {"gelu 1600x1024", 0.0, [&] { ActivationFunctions::gelu(hidden); }},
+        {"softmax 1600x256", 0.0, [&] { ActivationFunctions::softmax(tokens); }},
+        {"layerNorm 1600x256", 0.0, [&] { ActivationFunctions::layerNorm(tokens, gamma, beta); }},
+    };
+
+    std::printf("%-38s %8s %12s %10s %8s\n", "kernel", "threads", "ms/call", "GFLOP/s", "speedup");
+    for (const Case& c : cases) {
+        double single = 0.0;
+        for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+            ThreadPool::set_num_threads(threads);
+            double seconds = Bench::time_per_call(c.run);
+            if (threads == 1) {
+                single = seconds;
+            }
+            std::printf("%-38s %8zu %12.3f %10.2f %7.2fx\n", c.name.c_str(), threads, seconds * 1e3,
+                        c.flops > 0.0 ? c.flops / seconds / 1e9 : 0.0, single / seconds);
+            if (threads < max_threads && threads * 2 > max_threads) {
+                threads = max_threads / 2; // always finish on max_threads
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,131 @@
+//
+// Created by JAYAN on 28/07/2025.
+//
+// End-to-end VisionTransformer forward (6 encoder blocks, d_model 256,
+// 8 heads, MLP 512, 10 classes, 28x28 images in 7x7 patches) at several
+// batch sizes, with both attention kernels. Also counts heap allocations
+// (operator new is replaced below) during the timed steady-state calls:
+// there must be none, on any thread count; exit code 1 otherwise.
+// Then checks Matrix storage with AllocationTracker: a
+// forward into caller-owned logits must allocate nothing and the allocating
+// forward only its logits; reports the peak Matrix memory of a weight load.
+// Usage: ./bench_vit  (VIT_NUM_THREADS sets the thread count)
+//
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <new>
+#include <vector>
+#include "../include/transformer/vision_transformer.h"
+#include "../include/utils/allocation_tracker.h"
+#include "../include/utils/thread_pool.h"
+#include "../include/utils/weight_file.h"
+#include "bench_common.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::atomic<size_t> allocation_count{0};
+
+} // namespace
+
+void* operator new(size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    const size_t align = static_cast<size_t>(alignment);
+    if (void* ptr = std::aligned_alloc(align, (size + align - 1) / align * align)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+int main() {
+    const size_t patches_per_image = 16;
+    const size_t patch_dim = 49;
+    const std::vector<size_t> batches = {1, 8, 32, 64};
+
+    const fs::path weights_path = fs::temp_directory_path() / "vit_bench_vit.vitw";
+    WeightFile::write<float>(weights_path.string(),
+                             Bench::random_weights(6, 256, 512, patch_dim, patches_per_image + 1, 10));
+    VisionTransformer vit(batches.back());
+    vit.load_weights(*WeightFile::open(weights_path.string()));
+
+    bool ok = true;
+    std::printf("layers %zu, arena %zu KiB, %zu thread(s)\n", vit.get_num_layers(), vit.get_arena_bytes() / 1024,
+                ThreadPool::instance().num_threads());
+    std::printf("%-9s %6s %11s %13s %13s\n", "kernel", "batch", "ms/batch", "images/s", "allocations");
+    for (AttentionKernel kernel : {AttentionKernel::Standard, AttentionKernel::Tiled}) {
+        vit.set_attention_kernel(kernel);
+        for (size_t batch : batches) {
+            MatrixF patches = MatrixF::random(batch * patches_per_image, patch_dim, -1.0f, 1.0f);
+            MatrixF logits(batch, vit.get_num_classes());
+
+            size_t calls = 0;
+            size_t allocations = 0;
+            double seconds = Bench::time_per_call([&] {
+                const size_t before = allocation_count.load();
+                vit.forward(ConstMatrixViewT<float>(patches), logits.view());
+                // The warm-up call may still grow per-thread packing buffers
+                if (calls++ > 0) {
+                    allocations += allocation_count.load() - before;
+                }
+            }, 0.5);
+            ok = ok && allocations == 0;
+            std::printf("%-9s %6zu %11.3f %13.1f %13zu\n", kernel == AttentionKernel::Tiled ? "tiled" : "standard",
+                        batch, seconds * 1e3, batch / seconds, allocations);
+        }
+    }
+
+    if (!ok) {
+        std::printf("✗ steady-state forward allocated\n");
+    }
+
+    // Matrix storage budgets, per forward
+    AllocationTracker::set_enabled(true);
+    {
+        AllocationTracker::Scope load;
+        VisionTransformer loaded(batches.back());
+        loaded.load_weights(*WeightFile::open(weights_path.string()));
+        std::printf("\nweight load (Matrix storage): ");
+        std::fflush(stdout);
+        AllocationTracker::print_stats(load.stats());
+    }
+    fs::remove(weights_path);
+
+    const size_t batch = batches.back();
+    MatrixF patches = MatrixF::random(batch * patches_per_image, patch_dim, -1.0f, 1.0f);
+    MatrixF logits(batch, vit.get_num_classes());
+    try {
+        AllocationTracker::Scope into;
+        vit.forward(ConstMatrixViewT<float>(patches), logits.view());
+        AllocationTracker::check_budget(into.stats(), 0, 0, "forward into logits");
+
+        AllocationTracker::Scope allocating;
+        MatrixF result = vit.forward(patches);
+        const uint64_t logits_bytes = aligned_size<float>(batch * vit.get_num_classes()) * sizeof(float);
+        AllocationTracker::check_budget(allocating.stats(), 1, logits_bytes, "allocating forward");
+        std::printf("forward of %zu images: 0 Matrix allocations into logits, %llu (%llu bytes) allocating\n", batch,
+                    static_cast<unsigned long long>(allocating.stats().allocations),
+                    static_cast<unsigned long long>(allocating.stats().allocated_bytes));
+    } catch (const std::exception& e) {
+        std::printf("✗ %s\n", e.what());
+        ok = false;
+    }
+    AllocationTracker::set_enabled(false);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,221 @@
+//
+// Created by JAYAN on 04/08/2025.
+//
+// 16-bit weight storage (Gemm::Storage BFloat16 / Float16) against float
+// weights, on a 6-layer VisionTransformer (d_model 256, 8 heads, 28x28 images
+// in 7x7 patches).
+//
+// GEMM: each Linear shape of the model (tokens = images * 17) with its packed
+// weight in float, bf16 and f16. Each 16-bit result must match a reference
+// computed from the rounded weights to 1e-4 (relative): the widening in the
+// micro-kernel is exact, so only the weight rounding may differ from float.
+//
+// Model: packed weight bytes and images/s per storage at several batch
+// sizes, then at batch 1 round-robin over REPLICAS copies (weights streamed
+// from memory rather than cache, as with many replicas per box), then the
+// accuracy delta against float over EVAL images. bf16 keeps
+// 8 significant bits, so random weights (near-tied logits) may flip a few
+// predictions; agreement must be at least 95% for bf16 and 99% for f16, exit
+// code 1 otherwise.
+// Usage: ./bench_weight_storage
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../include/matrix/half.h"
+#include "../include/matrix/matrix_ops.h"
+#include "../include/transformer/vision_transformer.h"
+#include "../include/utils/weight_file.h"
+#include "bench_common.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr size_t PATCHES = 16;
+constexpr size_t PATCH_DIM = 49;
+constexpr size_t SEQ_LEN = PATCHES + 1;
+constexpr size_t EVAL = 512;
+constexpr size_t REPLICAS = 16;
+
+const Gemm::Storage STORAGES[] = {Gemm::Storage::Native, Gemm::Storage::BFloat16, Gemm::Storage::Float16};
+
+float round_to(Gemm::Storage storage, float value) {
+    switch (storage) {
+        case Gemm::Storage::BFloat16: return Half::bfloat16_to_float(Half::float_to_bfloat16(value));
+        case Gemm::Storage::Float16: return Half::half_to_float(Half::float_to_half(value));
+        default: return value;
+    }
+}
+
+// One Linear shape in every storage; returns false on a mismatch
+bool bench_linear(const char* name, size_t tokens, size_t k, size_t n) {
+    MatrixF input = MatrixF::random(tokens, k, -1.0f, 1.0f);
+    MatrixF weight = MatrixF::random(n, k, -0.1f, 0.1f);
+    MatrixF bias = MatrixF::random(1, n, -0.1f, 0.1f);
+    Gemm::Epilogue<float> epilogue;
+    epilogue.bias = bias.data();
+
+    bool ok = true;
+    double seconds[3] = {};
+    for (size_t s = 0; s < 3; ++s) {
+        const Gemm::Storage storage = STORAGES[s];
+        Gemm::PackedMatrix<float> packed = MatrixOps::pack_rhs_transposed(weight, storage);
+        MatrixF out(tokens, n);
+        seconds[s] = Bench::time_per_call([&] {
+            Gemm::gemm_packed(tokens, input.data(), k, 1, packed, out.data(), n, epilogue);
+        }, 0.2);
+
+        // Reference from the rounded weights, in double
+        double worst = 0.0;
+        for (size_t i = 0; i < tokens; ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                double expected = bias.data()[j];
+                for (size_t p = 0; p < k; ++p) {
+                    expected += double(input(i, p)) * round_to(storage, weight(j, p));
+                }
+                worst = std::max(worst, std::abs(out(i, j) - expected) / (1.0 + std::abs(expected)));
+            }
+        }
+        if (worst > 1e-4) {
+            std::printf("✗ %s %s: relative error %.2e against the rounded-weight reference\n", name,
+                        Gemm::storage_name(storage), worst);
+            ok = false;
+        }
+    }
+
+    const double ops = 2.0 * tokens * k * n;
+    std::printf("%-12s %6zu %5zu %5zu %10.4f %10.4f %10.4f %8.2fx %8.2fx %9.1f\n", name, tokens, k, n,
+                seconds[0] * 1e3, seconds[1] * 1e3, seconds[2] * 1e3, seconds[0] / seconds[1],
+                seconds[0] / seconds[2], ops / seconds[1] / 1e9);
+    return ok;
+}
+
+size_t argmax_row(const MatrixF& logits, size_t row) {
+    const float* begin = logits.row_ptr(row);
+    return static_cast<size_t>(std::max_element(begin, begin + logits.getCols()) - begin);
+}
+
+// The model's weights with Linear magnitudes spread log-uniformly over
+// [1e-4, 0.2): f16 loses precision below 6e-5 and bf16 keeps 8 significant
+// bits at any scale, so both roundings are exercised across the range
+std::vector<std::pair<std::string, MatrixF>> model_weights() {
+    std::vector<std::pair<std::string, MatrixF>> tensors = Bench::random_weights(6, 256, 512, PATCH_DIM, SEQ_LEN, 10);
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> exponent(std::log10(1e-4f), std::log10(0.2f));
+    for (auto& [name, tensor] : tensors) {
+        const bool linear = name.find("proj_weight") != std::string::npos ||
+                            name.find("linear_") != std::string::npos || name == "classifier/mlp_head_1_weight";
+        if (!linear || name.find("_weight") == std::string::npos) {
+            continue;
+        }
+        for (size_t k = 0; k < tensor.size(); ++k) {
+            tensor.data()[k] = std::copysign(std::pow(10.0f, exponent(rng)), tensor.data()[k]);
+        }
+    }
+    return tensors;
+}
+
+} // namespace
+
+int main() {
+    std::printf("GEMM kernel: %s\n\n", Gemm::kernel_name());
+    std::printf("%-12s %6s %5s %5s %10s %10s %10s %9s %9s %9s\n", "linear", "tokens", "k", "n", "float ms",
+                "bf16 ms", "f16 ms", "bf16 x", "f16 x", "bf16 GF/s");
+    bool ok = true;
+    for (size_t images : {1, 8, 64}) {
+        const size_t tokens = images * SEQ_LEN;
+        ok = bench_linear("qkv", tokens, 256, 768) && ok;
+        ok = bench_linear("out_proj", tokens, 256, 256) && ok;
+        ok = bench_linear("mlp fc1", tokens, 256, 512) && ok;
+        ok = bench_linear("mlp fc2", tokens, 512, 256) && ok;
+    }
+
+    const fs::path weights_path = fs::temp_directory_path() / "vit_bench_weight_storage.vitw";
+    WeightFile::write<float>(weights_path.string(), model_weights());
+    std::shared_ptr<WeightFile> weights = WeightFile::open(weights_path.string());
+
+    const size_t max_batch = 64;
+    std::vector<VisionTransformer> models;
+    models.reserve(3);
+    for (Gemm::Storage storage : STORAGES) {
+        VisionTransformer& model = models.emplace_back(max_batch);
+        model.set_weight_storage(storage);
+        model.load_weights(*weights);
+    }
+    weights.reset();
+    fs::remove(weights_path);
+
+    std::printf("\n%-8s %14s", "storage", "packed KiB");
+    MatrixF images = MatrixF::random(EVAL * PATCHES, PATCH_DIM, 0.0f, 1.0f);
+    const size_t batches[] = {1, 8, 64};
+    for (size_t batch : batches) {
+        std::printf(" %12s", ("b" + std::to_string(batch) + " img/s").c_str());
+    }
+    std::printf("\n");
+    for (size_t s = 0; s < 3; ++s) {
+        std::printf("%-8s %14.1f", Gemm::storage_name(STORAGES[s]), models[s].get_packed_weight_bytes() / 1024.0);
+        for (size_t batch : batches) {
+            ConstMatrixViewF input = images.block(0, 0, batch * PATCHES, PATCH_DIM);
+            MatrixF logits(batch, 10);
+            const double seconds = Bench::time_per_call([&] { models[s].forward(input, logits.view()); }, 0.2);
+            std::printf(" %12.1f", batch / seconds);
+        }
+        std::printf("\n");
+    }
+
+    // Many replicas served round-robin, one image each: the weights no longer
+    // stay in cache and every forward streams them from memory
+    std::printf("\n%zu replicas round-robin, 1 image each:\n", REPLICAS);
+    ConstMatrixViewF single = images.block(0, 0, PATCHES, PATCH_DIM);
+    MatrixF single_logits(1, 10);
+    double replica_seconds[3] = {};
+    for (size_t s = 0; s < 3; ++s) {
+        std::vector<VisionTransformer> replicas(REPLICAS, models[s]);
+        size_t next = 0;
+        replica_seconds[s] = Bench::time_per_call([&] {
+            replicas[next].forward(single, single_logits.view());
+            next = (next + 1) % REPLICAS;
+        }, 0.5);
+        std::printf("  %-8s %10.1f img/s %8.2fx  (%.1f MiB packed)\n", Gemm::storage_name(STORAGES[s]),
+                    1.0 / replica_seconds[s], replica_seconds[0] / replica_seconds[s],
+                    REPLICAS * models[s].get_packed_weight_bytes() / (1024.0 * 1024.0));
+    }
+
+    // Accuracy delta against float on the evaluation images
+    std::vector<MatrixF> logits;
+    for (VisionTransformer& model : models) {
+        MatrixF& out = logits.emplace_back(EVAL, 10);
+        for (size_t first = 0; first < EVAL; first += max_batch) {
+            model.forward(images.block(first * PATCHES, 0, max_batch * PATCHES, PATCH_DIM),
+                          out.block(first, 0, max_batch, 10));
+        }
+    }
+    const double required[] = {1.0, 0.95, 0.99};
+    std::printf("\naccuracy delta against float over %zu images:\n", EVAL);
+    for (size_t s = 1; s < 3; ++s) {
+        size_t agree = 0;
+        double max_delta = 0.0;
+        for (size_t i = 0; i < EVAL; ++i) {
+            agree += argmax_row(logits[0], i) == argmax_row(logits[s], i) ? 1 : 0;
+            for (size_t c = 0; c < 10; ++c) {
+                max_delta = std::max(max_delta, std::abs(double(logits[0](i, c)) - logits[s](i, c)));
+            }
+        }
+        const double agreement = double(agree) / EVAL;
+        std::printf("  %-5s top-1 agreement %.1f%%, max logit error %.5f\n", Gemm::storage_name(STORAGES[s]),
+                    100.0 * agreement, max_delta);
+        if (agreement < required[s]) {
+            std::printf("✗ %s predictions agree with float on fewer than %.0f%% of the images\n",
+                        Gemm::storage_name(STORAGES[s]), 100.0 * required[s]);
+            ok = false;
+        }
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,190 @@
+//
+// Created by JAYAN on 29/07/2025.
+//
+// Temporaries of a small encoder-style request (LayerNorm, two projections
+// with bias, GELU, residual add on 17x256 tokens) built three ways: fresh
+// heap matrices from the value ops, matrices from Workspace::local() reset
+// after every request, and _into calls on buffers allocated once. Runs the
+// request loop on 1..N concurrent threads to show malloc contention, and
+// counts heap allocations (operator new is replaced below) per request.
+// All three must give identical results, and the workspace and _into paths
+// must not allocate in steady state; exit code 1 otherwise.
+// Usage: ./bench_workspace
+//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <thread>
+#include <vector>
+#include "../include/matrix/matrix_ops.h"
+#include "../include/matrix/activation_functions.h"
+#include "../include/utils/workspace.h"
+
+namespace {
+
+std::atomic<size_t> allocation_count{0};
+
+} // namespace
+
+void* operator new(size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    const size_t align = static_cast<size_t>(alignment);
+    if (void* ptr = std::aligned_alloc(align, (size + align - 1) / align * align)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+namespace {
+
+constexpr size_t TOKENS = 17;
+constexpr size_t D_MODEL = 256;
+constexpr size_t HIDDEN = 512;
+
+struct Weights {
+    MatrixF gamma = MatrixF::random(D_MODEL, 1, 0.9f, 1.1f);
+    MatrixF beta = MatrixF::random(D_MODEL, 1, -0.1f, 0.1f);
+    MatrixF w1 = MatrixF::random(HIDDEN, D_MODEL, -0.1f, 0.1f);
+    MatrixF b1 = MatrixF::random(1, HIDDEN, -0.1f, 0.1f);
+    MatrixF w2 = MatrixF::random(D_MODEL, HIDDEN, -0.1f, 0.1f);
+    MatrixF b2 = MatrixF::random(1, D_MODEL, -0.1f, 0.1f);
+};
+
+// x + Linear(GELU(Linear(LayerNorm(x)))) with every temporary from the heap
+// (workspace == nullptr) or from the workspace
+MatrixF request_values(const Weights& w, const MatrixF& x, Workspace* workspace) {
+    using namespace MatrixOps;
+    MatrixF normed = ActivationFunctions::layerNorm(x, w.gamma, w.beta, 1e-5, 1, workspace);
+    MatrixF hidden = addBroadcast(matmul_nt(normed, w.w1, workspace), w.b1, true, workspace);
+    hidden = ActivationFunctions::gelu(hidden, ActivationFunctions::GeluMode::Tanh, workspace);
+    MatrixF out = addBroadcast(matmul_nt(hidden, w.w2, workspace), w.b2, true, workspace);
+    MatrixF result = scratch_matrix<float>(TOKENS, D_MODEL, workspace);
+    add_into(result.view(), x, out);
+    return result;
+}
+
+struct Buffers {
+    MatrixF normed{TOKENS, D_MODEL};
+    MatrixF hidden{TOKENS, HIDDEN};
+    MatrixF out{TOKENS, D_MODEL};
+};
+
+// The same request written with _into calls over preallocated buffers
+void request_into(const Weights& w, const MatrixF& x, Buffers& b) {
+    using namespace MatrixOps;
+    ActivationFunctions::layerNorm_into(b.normed.view(), x, w.gamma, w.beta);
+    matmul_nt_into(b.hidden.view(), b.normed, w.w1);
+    addBroadcast_into(b.hidden.view(), b.hidden, w.b1);
+    ActivationFunctions::gelu_into(b.hidden.view(), b.hidden, ActivationFunctions::GeluMode::Tanh);
+    matmul_nt_into(b.out.view(), b.hidden, w.w2);
+    addBroadcast_into(b.out.view(), b.out, w.b2);
+    add_into(b.out.view(), x, b.out);
+}
+
+enum class Mode { Heap, Workspace, Into };
+
+// Requests per second with `threads` threads each running `requests` requests
+double run_threads(Mode mode, size_t threads, size_t requests, const Weights& w, const MatrixF& x) {
+    auto worker = [&] {
+        Buffers buffers;
+        float sink = 0.0f;
+        for (size_t r = 0; r < requests; ++r) {
+            if (mode == Mode::Heap) {
+                sink += request_values(w, x, nullptr)(0, 0);
+            } else if (mode == Mode::Workspace) {
+                Workspace& workspace = Workspace::local();
+                sink += request_values(w, x, &workspace)(0, 0);
+                workspace.reset();
+            } else {
+                request_into(w, x, buffers);
+                sink += buffers.out(0, 0);
+            }
+        }
+        volatile float keep = sink;
+        (void)keep;
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < threads; ++t) {
+        pool.emplace_back(worker);
+    }
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return threads * requests / elapsed;
+}
+
+// Heap allocations made by one steady-state request on this thread
+size_t allocations_per_request(const std::function<void()>& fn) {
+    fn();
+    fn(); // warm-up: workspace blocks and packing buffers settle
+    const size_t before = allocation_count.load();
+    fn();
+    return allocation_count.load() - before;
+}
+
+} // namespace
+
+int main() {
+    Weights w;
+    MatrixF x = MatrixF::random(TOKENS, D_MODEL, -1.0f, 1.0f);
+
+    MatrixF heap = request_values(w, x, nullptr);
+    MatrixF from_workspace = request_values(w, x, &Workspace::local());
+    Workspace::local().reset();
+    Buffers buffers;
+    request_into(w, x, buffers);
+    bool ok = heap == from_workspace && heap == buffers.out;
+    std::printf("results identical: %s\n", ok ? "yes" : "NO");
+
+    const size_t heap_allocs = allocations_per_request([&] { request_values(w, x, nullptr); });
+    const size_t workspace_allocs = allocations_per_request([&] {
+        request_values(w, x, &Workspace::local());
+        Workspace::local().reset();
+    });
+    const size_t into_allocs = allocations_per_request([&] { request_into(w, x, buffers); });
+    std::printf("allocations/request: heap %zu, workspace %zu, into %zu\n", heap_allocs, workspace_allocs,
+                into_allocs);
+    ok = ok && workspace_allocs == 0 && into_allocs == 0;
+
+    const size_t max_threads = std::max<unsigned>(1, std::thread::hardware_concurrency());
+    std::vector<size_t> thread_counts = {1};
+    for (size_t t = 2; t <= max_threads; t *= 2) {
+        thread_counts.push_back(t);
+    }
+    const size_t requests = 2000;
+
+    std::printf("%8s %14s %14s %14s\n", "threads", "heap req/s", "workspace", "into");
+    for (size_t threads : thread_counts) {
+        double heap_rate = run_threads(Mode::Heap, threads, requests, w, x);
+        double workspace_rate = run_threads(Mode::Workspace, threads, requests, w, x);
+        double into_rate = run_threads(Mode::Into, threads, requests, w, x);
+        std::printf("%8zu %14.0f %14.0f %14.0f\n", threads, heap_rate, workspace_rate, into_rate);
+    }
+
+    if (!ok) {
+        std::printf("✗ workspace/_into results differ or allocate in steady state\n");
+        return 1;
+    }
+    return 0;
+}
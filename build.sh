@@ -1,20 +1,39 @@
 #!/bin/bash
 
 # Script de compilación para el proyecto VIT MNIST
+# Uso: ./build.sh          -> compila ./programa
+#      ./build.sh bench    -> además compila los benchmarks de bench/
+#      ./build.sh tools    -> además compila las herramientas de tools/
+# Para builds con LTO/PGO y objetivos por separado, ver CMakeLists.txt
 
-echo "Compilando proyecto VIT MNIST..."
-
-# Compilar el proyecto
-g++ -o programa main.cpp \
-    src/matrix/matrix.cpp \
+SOURCES="src/matrix/matrix.cpp \
     src/matrix/matrix_ops.cpp \
+    src/matrix/gemm.cpp \
+    src/matrix/qgemm.cpp \
+    src/matrix/vector_math.cpp \
     src/matrix/activation_functions.h.cpp \
     src/utils/file_io.cpp \
+    src/utils/thread_pool.cpp \
+    src/utils/workspace.cpp \
+    src/utils/cpu_features.cpp \
+    src/utils/profiler.cpp \
+    src/utils/allocation_tracker.cpp \
+    src/utils/weight_file.cpp \
+    src/utils/dataset.cpp \
     src/transformer/layer_norm.cpp \
     src/transformer/embedding.cpp \
-    -Iinclude/ \
-    -std=c++17 \
-    -O2
+    src/transformer/attention.cpp \
+    src/transformer/mlp.cpp \
+    src/transformer/quantized_linear.cpp \
+    src/transformer/vision_transformer.cpp \
+    src/transformer/batched_inference.cpp"
+
+FLAGS="-Iinclude/ -std=c++17 -O2 -pthread"
+
+echo "Compilando proyecto VIT MNIST..."
+
+# Compilar el proyecto
+g++ -o programa main.cpp $SOURCES $FLAGS
 
 # Verificar si la compilación fue exitosa
 if [ $? -eq 0 ]; then
@@ -23,4 +42,32 @@ if [ $? -eq 0 ]; then
 else
     echo "✗ Error en la compilación"
     exit 1
-fi
\ No newline at end of file
+fi
+
+# Compilar benchmarks
+if [ "$1" == "bench" ]; then
+    for bench_file in bench/*.cpp; do
+        bench_name=$(basename "$bench_file" .cpp)
+        echo "Compilando $bench_name..."
+        g++ -o "$bench_name" "$bench_file" $SOURCES $FLAGS
+        if [ $? -ne 0 ]; then
+            echo "✗ Error compilando $bench_name"
+            exit 1
+        fi
+    done
+    echo "✓ Benchmarks compilados"
+fi
+
+# Compilar herramientas
+if [ "$1" == "tools" ]; then
+    for tool_file in tools/*.cpp; do
+        tool_name=$(basename "$tool_file" .cpp)
+        echo "Compilando $tool_name..."
+        g++ -o "$tool_name" "$tool_file" $SOURCES $FLAGS
+        if [ $? -ne 0 ]; then
+            echo "✗ Error compilando $tool_name"
+            exit 1
+        fi
+    done
+    echo "✓ Herramientas compiladas"
+fi
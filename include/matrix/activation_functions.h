@@ -6,38 +6,84 @@
 #define ACTIVATION_FUNCTIONS_H
 
 #include "matrix.h"
+#include "../utils/workspace.h"
 
+// Templates over the element type, instantiated for float and double in
+// activation_functions.h.cpp. As in MatrixOps, each function returning a
+// matrix takes an optional Workspace for its result and has an _into form
+// that writes a caller-provided view of the input's shape (which may be the
+// input itself) without allocating.
 namespace ActivationFunctions {
 
     // ReLU activation function
-    Matrix relu(const Matrix& input);
-    Matrix reluDerivative(const Matrix& input);
+    template <typename T> MatrixT<T> relu(const MatrixT<T>& input, Workspace* workspace = nullptr);
+    template <typename T> MatrixT<T> reluDerivative(const MatrixT<T>& input, Workspace* workspace = nullptr);
+    template <typename T> void relu_into(const MatrixViewT<T>& output, ConstViewArg<T> input);
+    template <typename T> void reluDerivative_into(const MatrixViewT<T>& output, ConstViewArg<T> input);
 
-    // GELU activation function
-    Matrix gelu(const Matrix& input);
-    Matrix geluDerivative(const Matrix& input);
+    // GELU activation function: the tanh approximation used by most ViT
+    // checkpoints, or the exact erf form
+    enum class GeluMode { Tanh, Erf };
+    template <typename T> MatrixT<T> gelu(const MatrixT<T>& input, GeluMode mode = GeluMode::Tanh,
+                                          Workspace* workspace = nullptr);
+    template <typename T> MatrixT<T> geluDerivative(const MatrixT<T>& input, Workspace* workspace = nullptr);
+    template <typename T> void gelu_into(const MatrixViewT<T>& output, ConstViewArg<T> input,
+                                         GeluMode mode = GeluMode::Tanh);
+    template <typename T> void geluDerivative_into(const MatrixViewT<T>& output, ConstViewArg<T> input);
 
     // Softmax activation function
-    Matrix softmax(const Matrix& input, int axis = 1);
+    template <typename T> MatrixT<T> softmax(const MatrixT<T>& input, int axis = 1, Workspace* workspace = nullptr);
+    template <typename T> void softmax_into(const MatrixViewT<T>& output, ConstViewArg<T> input, int axis = 1);
 
-    // Dropout (for inference, acts as identity)
-    Matrix dropout(const Matrix& input, double dropout_rate = 0.0, bool training = false);
+    // Row softmax of scale * input with no heap allocation (the attention
+    // 1/sqrt(d_k) scaling folds into scale). output may be the same storage
+    // as input.
+    template <typename T> void softmaxRows(const ConstMatrixViewT<T>& input, const MatrixViewT<T>& output,
+                                           double scale = 1.0);
+
+    // Dropout (for inference, acts as identity; without a workspace the
+    // inference form returns a copy of input)
+    template <typename T> MatrixT<T> dropout(const MatrixT<T>& input, double dropout_rate = 0.0, bool training = false,
+                                             Workspace* workspace = nullptr);
+    template <typename T> void dropout_into(const MatrixViewT<T>& output, ConstViewArg<T> input,
+                                            double dropout_rate = 0.0, bool training = false);
 
     // Layer normalization helpers
-    Matrix layerNorm(const Matrix& input, const Matrix& gamma, const Matrix& beta,
-                     double epsilon = 1e-5, int axis = 1);
+    template <typename T> MatrixT<T> layerNorm(const MatrixT<T>& input, const MatrixT<T>& gamma, const MatrixT<T>& beta,
+                                            double epsilon = 1e-5, int axis = 1, Workspace* workspace = nullptr);
+    template <typename T> void layerNorm_into(const MatrixViewT<T>& output, ConstViewArg<T> input,
+                                              const MatrixT<T>& gamma, const MatrixT<T>& beta,
+                                              double epsilon = 1e-5, int axis = 1);
+
+    // Fused row-wise LayerNorm (axis 1) with no heap allocation: one Welford
+    // pass for the statistics, one pass to normalise and apply gamma/beta.
+    // output may be the same storage as input.
+    template <typename T> void layerNormRows(const ConstMatrixViewT<T>& input, const MatrixT<T>& gamma,
+                                             const MatrixT<T>& beta, double epsilon, const MatrixViewT<T>& output);
+    template <typename T> void layerNormInPlace(MatrixT<T>& x, const MatrixT<T>& gamma, const MatrixT<T>& beta,
+                                                double epsilon = 1e-5);
 
-    // Helper functions for layer normalization
-    Matrix computeLayerNormStats(const Matrix& input, int axis = 1);
-    std::pair<Matrix, Matrix> computeMeanAndVariance(const Matrix& input, int axis = 1);
+    // Helper functions for layer normalization. mean and variance are
+    // (rows, 1) for axis 1 and (1, cols) for axis 0.
+    template <typename T> MatrixT<T> computeLayerNormStats(const MatrixT<T>& input, int axis = 1);
+    template <typename T> std::pair<MatrixT<T>, MatrixT<T>> computeMeanAndVariance(const MatrixT<T>& input, int axis = 1,
+                                                                                   Workspace* workspace = nullptr);
+    template <typename T> void computeMeanAndVariance_into(const MatrixViewT<T>& mean, const MatrixViewT<T>& variance,
+                                                           ConstViewArg<T> input, int axis = 1);
 
     // Additional activation functions
-    Matrix sigmoid(const Matrix& input);
-    Matrix tanh(const Matrix& input);
-    Matrix leakyRelu(const Matrix& input, double alpha = 0.01);
+    template <typename T> MatrixT<T> sigmoid(const MatrixT<T>& input, Workspace* workspace = nullptr);
+    template <typename T> MatrixT<T> tanh(const MatrixT<T>& input, Workspace* workspace = nullptr);
+    template <typename T> MatrixT<T> leakyRelu(const MatrixT<T>& input, double alpha = 0.01, Workspace* workspace = nullptr);
+    template <typename T> void sigmoid_into(const MatrixViewT<T>& output, ConstViewArg<T> input);
+    template <typename T> void tanh_into(const MatrixViewT<T>& output, ConstViewArg<T> input);
+    template <typename T> void leakyRelu_into(const MatrixViewT<T>& output, ConstViewArg<T> input, double alpha = 0.01);
 
     // Utility functions
-    Matrix clip(const Matrix& input, double min_val, double max_val);
+    template <typename T> MatrixT<T> clip(const MatrixT<T>& input, double min_val, double max_val,
+                                          Workspace* workspace = nullptr);
+    template <typename T> void clip_into(const MatrixViewT<T>& output, ConstViewArg<T> input, double min_val,
+                                         double max_val);
 }
 
 #endif //ACTIVATION_FUNCTIONS_H
@@ -0,0 +1,122 @@
+//
+// Created by JAYAN on 14/07/2025.
+//
+
+#ifndef GEMM_H
+#define GEMM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "matrix.h"
+
+// Low-level GEMM engine used by MatrixOps::matmul.
+//
+// Operands are described by a base pointer and two strides: element (i, j)
+// of X lives at x[i * row_stride + j * col_stride]. That lets the same packed
+// routine read row-major, column-major or strided sub-blocks without copying.
+// Instantiated for float and double.
+namespace Gemm {
+
+    enum class Activation { None, GeluTanh, GeluErf };
+
+    // Work folded into the GEMM as each C tile is finished, while it is still
+    // in L1, instead of separate passes over C:
+    //   C = act(A * B + bias)            accumulate = false
+    //   C = act(C + A * B + bias)        accumulate = true (e.g. a residual)
+    // bias has n elements (one per column) and may be null.
+    template <typename T>
+    struct Epilogue {
+        const T* bias = nullptr;
+        Activation activation = Activation::None;
+        bool accumulate = false;
+    };
+
+    // Element format of a PackedMatrix's panels. The 16-bit formats (see
+    // half.h) halve the bytes a product streams from memory; the micro-kernel
+    // widens each B vector to T in registers (F16C / AVX-512F conversions),
+    // so A, C and the accumulation stay in T. Meant for float: the double
+    // kernels widen through the portable path.
+    enum class Storage { Native, BFloat16, Float16 };
+
+    // "native", "bf16", "f16"
+    const char* storage_name(Storage storage);
+    Storage parse_storage(const std::string& name);
+
+    // C (m x n) = A (m x k) * B (k x n). C is row-major with leading dimension ldc
+    // and is overwritten (or updated, see Epilogue).
+    template <typename T>
+    void gemm(size_t m, size_t n, size_t k,
+              const T* a, size_t a_row_stride, size_t a_col_stride,
+              const T* b, size_t b_row_stride, size_t b_col_stride,
+              T* c, size_t ldc, const Epilogue<T>& epilogue = Epilogue<T>());
+
+    // Right-hand operand (k x n) packed once into the active kernel's panel
+    // layout, so repeated products against the same weights skip packing.
+    // With a 16-bit storage the panels are rounded once, here.
+    template <typename T>
+    class PackedMatrix {
+    private:
+        MatrixT<T> panels;                  // All packed blocks, back to back (Native)
+        std::vector<uint16_t> half_panels;  // Same layout, 16-bit (BFloat16, Float16)
+        std::vector<size_t> block_offsets;  // Start of each (nc, kc) block in panels
+        size_t rows;
+        size_t cols;
+        Storage storage;
+
+        // Fill block_offsets for rows x cols under the active kernel; returns
+        // the panel elements needed
+        size_t plan_blocks();
+
+    public:
+        PackedMatrix();
+        PackedMatrix(size_t k, size_t n, const T* b, size_t b_row_stride, size_t b_col_stride,
+                     Storage storage = Storage::Native);
+
+        // Panels saved from a k x n PackedMatrix of the same storage, packed
+        // under the same panel_layout<T>(): count elements of T (Native) or
+        // of uint16_t (16-bit storages). Native panels are borrowed, keeping
+        // owner alive, and must be 64-byte aligned; 16-bit ones are copied.
+        // Throws std::invalid_argument when count does not fit the layout.
+        static PackedMatrix adopt(size_t k, size_t n, Storage storage, const void* data, size_t count,
+                                  std::shared_ptr<const void> owner);
+
+        size_t getRows() const { return rows; }
+        size_t getCols() const { return cols; }
+        bool empty() const { return block_offsets.empty(); }
+        Storage get_storage() const { return storage; }
+
+        // Resident size of the panels
+        size_t bytes() const { return panels.size() * sizeof(T) + half_panels.size() * sizeof(uint16_t); }
+
+        const T* panel_data() const { return panels.data(); }
+        const uint16_t* half_panel_data() const { return half_panels.data(); }
+        // Elements of whichever panel array the storage uses
+        size_t panel_count() const { return storage == Storage::Native ? panels.size() : half_panels.size(); }
+        size_t block_offset(size_t block) const { return block_offsets[block]; }
+    };
+
+    // C (m x n) = A (m x k) * B, with B pre-packed.
+    template <typename T>
+    void gemm_packed(size_t m, const T* a, size_t a_row_stride, size_t a_col_stride,
+                     const PackedMatrix<T>& b, T* c, size_t ldc, const Epilogue<T>& epilogue = Epilogue<T>());
+
+    // Panel layout of the active kernel for T, e.g. "avx512_f32_nr32_kc256_nc4080".
+    // Saved panels can only be adopted by a process that reports the same.
+    template <typename T>
+    std::string panel_layout();
+
+    // Grow the calling thread's packing buffers to their full size now, so
+    // no later product on this thread allocates
+    template <typename T>
+    void reserve_thread_buffers();
+
+    // Name of the micro-kernel family selected for this CPU ("scalar", "avx2",
+    // "avx512"). The choice can be forced with the VIT_GEMM_KERNEL environment
+    // variable, or with VIT_ISA together with the other SIMD kernels.
+    const char* kernel_name();
+}
+
+#endif //GEMM_H
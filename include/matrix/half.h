@@ -0,0 +1,85 @@
+//
+// Created by JAYAN on 04/08/2025.
+//
+
+#ifndef HALF_H
+#define HALF_H
+
+#include <cstdint>
+#include <cstring>
+
+// 16-bit float formats used for weight storage, held as raw uint16_t bits:
+//
+//   bfloat16    the top half of an IEEE float: same exponent range, 8-bit
+//               significand
+//   IEEE half   binary16: 5-bit exponent (max 65504), 11-bit significand
+//
+// Narrowing rounds to nearest even; NaN stays NaN, overflow becomes infinity.
+// Widening is exact. The GEMM widens whole vectors in its micro-kernels (see
+// Gemm::Storage); these scalar forms serve packing, weight files and the
+// portable kernels.
+namespace Half {
+
+    inline uint32_t float_bits(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    inline float bits_float(uint32_t bits) {
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    inline uint16_t float_to_bfloat16(float value) {
+        uint32_t bits = float_bits(value);
+        if ((bits & 0x7FFFFFFFu) > 0x7F800000u) {
+            return static_cast<uint16_t>((bits >> 16) | 0x40u); // Quiet NaN
+        }
+        bits += 0x7FFFu + ((bits >> 16) & 1u);
+        return static_cast<uint16_t>(bits >> 16);
+    }
+
+    inline float bfloat16_to_float(uint16_t value) {
+        return bits_float(static_cast<uint32_t>(value) << 16);
+    }
+
+    inline uint16_t float_to_half(float value) {
+        uint32_t bits = float_bits(value);
+        const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+        bits &= 0x7FFFFFFFu;
+
+        if (bits > 0x7F800000u) {
+            return sign | 0x7E00u;                          // NaN
+        }
+        if (bits >= 0x477FF000u) {
+            return sign | 0x7C00u;                          // Rounds past 65504: infinity
+        }
+        if (bits < 0x38800000u) {
+            // Below 2^-14: subnormal or zero. Adding 0.5 lines the half ulp
+            // (2^-24) up with the float ulp, so the FPU does the rounding.
+            const float shifted = bits_float(bits) + 0.5f;
+            return sign | static_cast<uint16_t>(float_bits(shifted) - 0x3F000000u);
+        }
+        // Rebias the exponent (127 -> 15) and round the 13 dropped bits
+        bits += 0xC8000FFFu + ((bits >> 13) & 1u);
+        return sign | static_cast<uint16_t>(bits >> 13);
+    }
+
+    inline float half_to_float(uint16_t value) {
+        const uint32_t sign = static_cast<uint32_t>(value & 0x8000u) << 16;
+        const uint32_t exponent = (value >> 10) & 0x1Fu;
+        const uint32_t mantissa = value & 0x3FFu;
+        if (exponent == 0) {
+            const float magnitude = static_cast<float>(mantissa) * 5.9604644775390625e-8f; // 2^-24
+            return bits_float(sign | float_bits(magnitude));
+        }
+        if (exponent == 0x1Fu) {
+            return bits_float(sign | 0x7F800000u | (mantissa << 13));
+        }
+        return bits_float(sign | ((exponent + 112u) << 23) | (mantissa << 13));
+    }
+}
+
+#endif //HALF_H
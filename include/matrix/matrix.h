@@ -9,66 +9,315 @@
 #include <iostream>
 #include <stdexcept>
 #include <initializer_list>
+#include <cstddef>
+#include <memory>
 
-class Matrix {
+// Element type is a template parameter. Matrix (double) is the general-purpose
+// type; MatrixF (float) is what the transformer layers run on, which doubles
+// SIMD width and halves memory traffic. Both are explicitly instantiated in
+// matrix.cpp.
+template <typename T> class MatrixT;
+template <typename T> class ConstMatrixViewT;
+
+namespace MatrixExpr {
+    template <typename E> class Expression;
+}
+
+// Bounds checking for element access (operator() on matrices and views).
+// Checked throws std::out_of_range; Unchecked compiles to the bare index, so
+// loops over operator() can be vectorised. operator() uses Default: Checked
+// unless NDEBUG is defined (release builds), overridable with
+// -DVIT_CHECKED_ACCESS=0/1. at() is always checked. Kernels validate shapes
+// once on entry and then walk rows through row_ptr() regardless.
+#ifndef VIT_CHECKED_ACCESS
+#ifdef NDEBUG
+#define VIT_CHECKED_ACCESS 0
+#else
+#define VIT_CHECKED_ACCESS 1
+#endif
+#endif
+
+namespace MatrixAccess {
+    struct Checked {
+        static void check(size_t row, size_t col, size_t rows, size_t cols, const char* what) {
+            if (row >= rows || col >= cols) {
+                throw std::out_of_range(what);
+            }
+        }
+    };
+
+    struct Unchecked {
+        static void check(size_t, size_t, size_t, size_t, const char*) {}
+    };
+
+#if VIT_CHECKED_ACCESS
+    using Default = Checked;
+#else
+    using Default = Unchecked;
+#endif
+}
+
+// Non-owning window over row-major storage: base pointer (already offset to the
+// first element), shape and row stride. Views never allocate; the owner must
+// outlive them.
+template <typename T>
+class MatrixViewT {
 private:
-    std::vector<std::vector<double>> data;
+    T* ptr;
     size_t rows;
     size_t cols;
+    size_t stride;
 
 public:
+    MatrixViewT() : ptr(nullptr), rows(0), cols(0), stride(0) {}
+    MatrixViewT(T* data, size_t rows, size_t cols, size_t stride)
+        : ptr(data), rows(rows), cols(cols), stride(stride) {}
+
+    // Element access, bounds-checked per Policy (see MatrixAccess)
+    template <typename Policy = MatrixAccess::Default>
+    T& get(size_t row, size_t col) const {
+        Policy::check(row, col, rows, cols, "MatrixView indices out of range");
+        return ptr[row * stride + col];
+    }
+    T& operator()(size_t row, size_t col) const { return get(row, col); }
+    T& at(size_t row, size_t col) const { return get<MatrixAccess::Checked>(row, col); }
+
+    T* data() const { return ptr; }
+    T* row_ptr(size_t row) const { return ptr + row * stride; }
+
+    // Dimensions
+    size_t getRows() const { return rows; }
+    size_t getCols() const { return cols; }
+    size_t getStride() const { return stride; }
+    std::pair<size_t, size_t> shape() const { return {rows, cols}; }
+    bool is_contiguous() const { return stride == cols; }
+
+    // Sub-block [row, row + num_rows) x [col, col + num_cols)
+    MatrixViewT block(size_t row, size_t col, size_t num_rows, size_t num_cols) const {
+        if (row + num_rows > rows || col + num_cols > cols) {
+            throw std::out_of_range("MatrixView block out of range");
+        }
+        return MatrixViewT(ptr + row * stride + col, num_rows, num_cols, stride);
+    }
+
+    // Copy the contents of a same-shaped source into this view
+    void assign(const ConstMatrixViewT<T>& source) const;
+    // Evaluate a lazy element-wise expression (matrix_expr.h) into this view
+    template <typename E>
+    void assign(const MatrixExpr::Expression<E>& expr) const;
+    void fill(T value) const;
+};
+
+template <typename T>
+class ConstMatrixViewT {
+private:
+    const T* ptr;
+    size_t rows;
+    size_t cols;
+    size_t stride;
+
+public:
+    ConstMatrixViewT() : ptr(nullptr), rows(0), cols(0), stride(0) {}
+    ConstMatrixViewT(const T* data, size_t rows, size_t cols, size_t stride)
+        : ptr(data), rows(rows), cols(cols), stride(stride) {}
+    ConstMatrixViewT(const MatrixViewT<T>& view)
+        : ptr(view.data()), rows(view.getRows()), cols(view.getCols()), stride(view.getStride()) {}
+    ConstMatrixViewT(const MatrixT<T>& matrix);
+
+    // Element access, bounds-checked per Policy (see MatrixAccess)
+    template <typename Policy = MatrixAccess::Default>
+    const T& get(size_t row, size_t col) const {
+        Policy::check(row, col, rows, cols, "MatrixView indices out of range");
+        return ptr[row * stride + col];
+    }
+    const T& operator()(size_t row, size_t col) const { return get(row, col); }
+    const T& at(size_t row, size_t col) const { return get<MatrixAccess::Checked>(row, col); }
+
+    const T* data() const { return ptr; }
+    const T* row_ptr(size_t row) const { return ptr + row * stride; }
+
+    // Dimensions
+    size_t getRows() const { return rows; }
+    size_t getCols() const { return cols; }
+    size_t getStride() const { return stride; }
+    std::pair<size_t, size_t> shape() const { return {rows, cols}; }
+    bool is_contiguous() const { return stride == cols; }
+
+    ConstMatrixViewT block(size_t row, size_t col, size_t num_rows, size_t num_cols) const {
+        if (row + num_rows > rows || col + num_cols > cols) {
+            throw std::out_of_range("MatrixView block out of range");
+        }
+        return ConstMatrixViewT(ptr + row * stride + col, num_rows, num_cols, stride);
+    }
+};
+
+// Dense row-major matrix backed by a single 64-byte aligned buffer.
+// Element (i, j) lives at data()[i * getCols() + j].
+template <typename T>
+class MatrixT {
+private:
+    T* buffer;              // Aligned contiguous storage (rows * cols elements)
+    size_t rows;
+    size_t cols;
+    size_t capacity;        // Allocated elements, reused by resize() when large enough
+    std::shared_ptr<const void> external; // Keeps borrowed storage alive (e.g. a weight file mapping)
+
+public:
+    using value_type = T;
+    static constexpr size_t ALIGNMENT = 64;
+
     // Constructors
-    Matrix();
-    Matrix(size_t rows, size_t cols, double value = 0.0);
-    Matrix(const std::initializer_list<std::initializer_list<double>>& init_list);
+    MatrixT();
+    MatrixT(size_t rows, size_t cols, T value = T(0));
+    MatrixT(const std::initializer_list<std::initializer_list<T>>& init_list);
+    explicit MatrixT(const ConstMatrixViewT<T>& view);
 
     // Copy constructor and assignment
-    Matrix(const Matrix& other);
-    Matrix& operator=(const Matrix& other);
+    MatrixT(const MatrixT& other);
+    MatrixT& operator=(const MatrixT& other);
 
     // Move constructor and assignment
-    Matrix(Matrix&& other) noexcept;
-    Matrix& operator=(Matrix&& other) noexcept;
+    MatrixT(MatrixT&& other) noexcept;
+    MatrixT& operator=(MatrixT&& other) noexcept;
+
+    // Evaluate a lazy element-wise expression (matrix_expr.h) in one pass
+    template <typename E>
+    MatrixT(const MatrixExpr::Expression<E>& expr);
+    template <typename E>
+    MatrixT& operator=(const MatrixExpr::Expression<E>& expr);
 
     // Destructor
-    ~Matrix() = default;
+    ~MatrixT();
+
+    // Wrap storage owned by someone else (e.g. a memory-mapped weight file)
+    // without copying. `owner` is kept alive for as long as the matrix uses
+    // the buffer. Copies of a borrowed matrix own their data; resize() or
+    // resize_for_overwrite() on a borrowed matrix switches to owned storage
+    // only when the element count changes.
+    static MatrixT borrow(T* data, size_t rows, size_t cols, std::shared_ptr<const void> owner);
+    bool owns_storage() const { return !external; }
 
-    // Element access
-    double& operator()(size_t row, size_t col);
-    const double& operator()(size_t row, size_t col) const;
+    // Element access, bounds-checked per Policy (see MatrixAccess)
+    template <typename Policy = MatrixAccess::Default>
+    T& get(size_t row, size_t col) {
+        Policy::check(row, col, rows, cols, "Matrix indices out of range");
+        return buffer[row * cols + col];
+    }
+    template <typename Policy = MatrixAccess::Default>
+    const T& get(size_t row, size_t col) const {
+        Policy::check(row, col, rows, cols, "Matrix indices out of range");
+        return buffer[row * cols + col];
+    }
+    T& operator()(size_t row, size_t col) { return get(row, col); }
+    const T& operator()(size_t row, size_t col) const { return get(row, col); }
+    T& at(size_t row, size_t col) { return get<MatrixAccess::Checked>(row, col); }
+    const T& at(size_t row, size_t col) const { return get<MatrixAccess::Checked>(row, col); }
+
+    // Raw storage access
+    T* data() { return buffer; }
+    const T* data() const { return buffer; }
+    T* row_ptr(size_t row) { return buffer + row * cols; }
+    const T* row_ptr(size_t row) const { return buffer + row * cols; }
+
+    // Views
+    MatrixViewT<T> view() { return MatrixViewT<T>(buffer, rows, cols, cols); }
+    ConstMatrixViewT<T> view() const { return ConstMatrixViewT<T>(buffer, rows, cols, cols); }
+    MatrixViewT<T> block(size_t row, size_t col, size_t num_rows, size_t num_cols);
+    ConstMatrixViewT<T> block(size_t row, size_t col, size_t num_rows, size_t num_cols) const;
 
     // Dimensions
     size_t getRows() const { return rows; }
     size_t getCols() const { return cols; }
+    size_t size() const { return rows * cols; }
     std::pair<size_t, size_t> shape() const { return {rows, cols}; }
 
     // Utility functions
-    void fill(double value);
-    void resize(size_t new_rows, size_t new_cols, double value = 0.0);
+    void fill(T value);
+    void resize(size_t new_rows, size_t new_cols, T value = T(0));
+    // Like resize() but leaves the contents unspecified, for scratch buffers
+    // the caller overwrites completely
+    void resize_for_overwrite(size_t new_rows, size_t new_cols);
+    // Same elements in the same order under a new shape, e.g. an (n, 1)
+    // column read as a (1, n) row. No copy: borrowed storage stays borrowed.
+    void reshape(size_t new_rows, size_t new_cols);
 
     // Display
     void print() const;
 
     // Static factory methods
-    static Matrix zeros(size_t rows, size_t cols);
-    static Matrix ones(size_t rows, size_t cols);
-    static Matrix identity(size_t size);
-    static Matrix random(size_t rows, size_t cols, double min = 0.0, double max = 1.0);
+    static MatrixT zeros(size_t rows, size_t cols);
+    static MatrixT ones(size_t rows, size_t cols);
+    static MatrixT identity(size_t size);
+    static MatrixT random(size_t rows, size_t cols, T min = T(0), T max = T(1));
 
-    // Basic operators
-    Matrix operator+(const Matrix& other) const;
-    Matrix operator-(const Matrix& other) const;
-    Matrix operator*(double scalar) const;
-    Matrix operator/(double scalar) const;
+    // Basic operators. a + b, a - b, a * s and a / s are lazy expressions
+    // (see matrix_expr.h) evaluated on assignment; += and -= evaluate in
+    // place. MatrixOps::add_into, subtract_into and scale_into are the
+    // equivalent explicit calls.
+    template <typename E>
+    MatrixT& operator+=(const E& other);
+    template <typename E>
+    MatrixT& operator-=(const E& other);
 
     // Comparison
-    bool operator==(const Matrix& other) const;
-    bool operator!=(const Matrix& other) const;
+    bool operator==(const MatrixT& other) const;
+    bool operator!=(const MatrixT& other) const;
+
+    friend std::ostream& operator<<(std::ostream& os, const MatrixT& matrix) { return matrix.write_to(os); }
+
+private:
+    void release_owned();
+    std::ostream& write_to(std::ostream& os) const;
+};
+
+template <typename T>
+inline ConstMatrixViewT<T>::ConstMatrixViewT(const MatrixT<T>& matrix)
+    : ptr(matrix.data()), rows(matrix.getRows()), cols(matrix.getCols()), stride(matrix.getCols()) {}
 
-    // Friends for scalar operations
-    friend Matrix operator*(double scalar, const Matrix& matrix);
-    friend std::ostream& operator<<(std::ostream& os, const Matrix& matrix);
+// Read-only view parameter kept out of template argument deduction: once T
+// is deduced from another parameter (typically an output view), MatrixT,
+// MatrixViewT and ConstMatrixViewT arguments all convert to it
+template <typename T>
+struct ConstViewArgType {
+    using type = ConstMatrixViewT<T>;
 };
+template <typename T>
+using ConstViewArg = typename ConstViewArgType<T>::type;
+
+// n rounded up to a whole number of ALIGNMENT-byte lines, so buffers carved
+// one after another from a single allocation all stay aligned
+template <typename T>
+constexpr size_t aligned_size(size_t n) {
+    constexpr size_t step = MatrixT<T>::ALIGNMENT / sizeof(T);
+    return (n + step - 1) / step * step;
+}
+
+// Element-wise precision conversion, e.g. matrix_cast<float>(double_matrix)
+template <typename To, typename From>
+MatrixT<To> matrix_cast(const MatrixT<From>& source) {
+    MatrixT<To> result(source.getRows(), source.getCols());
+    const From* in = source.data();
+    To* out = result.data();
+    for (size_t k = 0; k < source.size(); ++k) {
+        out[k] = static_cast<To>(in[k]);
+    }
+    return result;
+}
+
+using Matrix = MatrixT<double>;
+using MatrixView = MatrixViewT<double>;
+using ConstMatrixView = ConstMatrixViewT<double>;
+
+using MatrixF = MatrixT<float>;
+using MatrixViewF = MatrixViewT<float>;
+using ConstMatrixViewF = ConstMatrixViewT<float>;
+
+extern template class MatrixT<float>;
+extern template class MatrixT<double>;
+extern template class MatrixViewT<float>;
+extern template class MatrixViewT<double>;
+
+#include "matrix_expr.h"
 
 
 #endif //MATRIX_H
@@ -0,0 +1,363 @@
+//
+// Created by JAYAN on 30/07/2025.
+//
+
+#ifndef MATRIX_EXPR_H
+#define MATRIX_EXPR_H
+
+#include "matrix.h"
+#include "../utils/cpu_features.h"
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+
+// Lazy element-wise arithmetic. The operators +, - between matrices (or
+// views, or other expressions) and *, / by a scalar build a small
+// expression tree instead of a result matrix; the tree is evaluated once it
+// is assigned to a MatrixT, a MatrixViewT or passed to evaluate(), in one
+// loop over the destination with no intermediate matrices:
+//
+//   MatrixF y = (x + residual) * 0.5f;                        // one pass
+//   out.view().assign(MatrixExpr::addBroadcast(x, bias));     // no allocation
+//
+// Nodes hold their operands by value (views for matrices), so an expression
+// is cheap to build, but it must be evaluated before any matrix it reads is
+// destroyed or resized: `auto e = f() + b;` dangles once f()'s temporary is
+// gone. The destination may also appear as an operand (x = x + b), since
+// every element is read before it is written; a broadcast vector must not
+// be part of the destination.
+namespace MatrixExpr {
+
+    // Base of every node; E is the node type itself
+    template <typename E>
+    class Expression {
+    public:
+        const E& self() const { return static_cast<const E&>(*this); }
+
+        // Materialise into a new matrix, e.g. to pass to a MatrixOps function
+        auto eval() const { return MatrixT<typename E::value_type>(*this); }
+    };
+
+    // A matrix or view read in place
+    template <typename T>
+    class Operand : public Expression<Operand<T>> {
+    public:
+        using value_type = T;
+
+        struct Row {
+            const T* ptr;
+            T operator[](size_t j) const { return ptr[j]; }
+        };
+
+        explicit Operand(const ConstMatrixViewT<T>& view) : view(view) {}
+
+        size_t getRows() const { return view.getRows(); }
+        size_t getCols() const { return view.getCols(); }
+        Row row(size_t i) const { return {view.row_ptr(i)}; }
+
+    private:
+        ConstMatrixViewT<T> view;
+    };
+
+    // A vector of `cols` elements repeated down every row. Any shape with
+    // that many elements works, so (cols, 1) bias and gamma matrices as
+    // loaded from the weight files broadcast as rows too.
+    template <typename T>
+    class RowBroadcast : public Expression<RowBroadcast<T>> {
+    public:
+        using value_type = T;
+        using Row = typename Operand<T>::Row;
+
+        RowBroadcast(const MatrixT<T>& vector, size_t rows, size_t cols)
+            : ptr(vector.data()), rows(rows), cols(cols) {
+            if (vector.size() != cols) {
+                throw std::invalid_argument("Vector dimensions incompatible for row broadcasting");
+            }
+        }
+
+        size_t getRows() const { return rows; }
+        size_t getCols() const { return cols; }
+        Row row(size_t) const { return {ptr}; }
+
+    private:
+        const T* ptr;
+        size_t rows;
+        size_t cols;
+    };
+
+    // A vector of `rows` elements, element i repeated across row i
+    template <typename T>
+    class ColBroadcast : public Expression<ColBroadcast<T>> {
+    public:
+        using value_type = T;
+
+        struct Row {
+            T value;
+            T operator[](size_t) const { return value; }
+        };
+
+        ColBroadcast(const MatrixT<T>& vector, size_t rows, size_t cols)
+            : ptr(vector.data()), rows(rows), cols(cols) {
+            if (vector.size() != rows) {
+                throw std::invalid_argument("Vector dimensions incompatible for column broadcasting");
+            }
+        }
+
+        size_t getRows() const { return rows; }
+        size_t getCols() const { return cols; }
+        Row row(size_t i) const { return {ptr[i]}; }
+
+    private:
+        const T* ptr;
+        size_t rows;
+        size_t cols;
+    };
+
+    struct Add {
+        static constexpr const char* mismatch = "Matrices must have the same dimensions for addition";
+        template <typename T> static T apply(T a, T b) { return a + b; }
+    };
+    struct Subtract {
+        static constexpr const char* mismatch = "Matrices must have the same dimensions for subtraction";
+        template <typename T> static T apply(T a, T b) { return a - b; }
+    };
+    struct Multiply {
+        static constexpr const char* mismatch = "Matrices must have same dimensions for element-wise multiplication";
+        template <typename T> static T apply(T a, T b) { return a * b; }
+    };
+    struct Divide {
+        template <typename T> static T apply(T a, T b) { return a / b; }
+    };
+
+    // Element-wise lhs op rhs over two same-shaped expressions
+    template <typename Op, typename L, typename R>
+    class Binary : public Expression<Binary<Op, L, R>> {
+    public:
+        using value_type = typename L::value_type;
+        static_assert(std::is_same<value_type, typename R::value_type>::value,
+                      "Both operands of a matrix expression must have the same element type");
+
+        struct Row {
+            typename L::Row lhs;
+            typename R::Row rhs;
+            value_type operator[](size_t j) const { return Op::apply(lhs[j], rhs[j]); }
+        };
+
+        Binary(const L& lhs, const R& rhs) : lhs(lhs), rhs(rhs) {
+            if (lhs.getRows() != rhs.getRows() || lhs.getCols() != rhs.getCols()) {
+                throw std::invalid_argument(Op::mismatch);
+            }
+        }
+
+        size_t getRows() const { return lhs.getRows(); }
+        size_t getCols() const { return lhs.getCols(); }
+        Row row(size_t i) const { return {lhs.row(i), rhs.row(i)}; }
+
+    private:
+        L lhs;
+        R rhs;
+    };
+
+    // Element-wise e op scalar
+    template <typename Op, typename E>
+    class ScalarBinary : public Expression<ScalarBinary<Op, E>> {
+    public:
+        using value_type = typename E::value_type;
+
+        struct Row {
+            typename E::Row inner;
+            value_type scalar;
+            value_type operator[](size_t j) const { return Op::apply(inner[j], scalar); }
+        };
+
+        ScalarBinary(const E& inner, value_type scalar) : inner(inner), scalar(scalar) {}
+
+        size_t getRows() const { return inner.getRows(); }
+        size_t getCols() const { return inner.getCols(); }
+        Row row(size_t i) const { return {inner.row(i), scalar}; }
+
+    private:
+        E inner;
+        value_type scalar;
+    };
+
+    // What the operators accept: matrices, views and expression nodes
+    template <typename X, typename = void>
+    struct is_expression : std::is_base_of<Expression<X>, X> {};
+    template <typename T> struct is_expression<MatrixT<T>> : std::true_type {};
+    template <typename T> struct is_expression<MatrixViewT<T>> : std::true_type {};
+    template <typename T> struct is_expression<ConstMatrixViewT<T>> : std::true_type {};
+
+    template <typename X>
+    constexpr bool is_expression_v = is_expression<X>::value;
+
+    template <typename T> Operand<T> operand(const MatrixT<T>& m) { return Operand<T>(m.view()); }
+    template <typename T> Operand<T> operand(const MatrixViewT<T>& v) { return Operand<T>(v); }
+    template <typename T> Operand<T> operand(const ConstMatrixViewT<T>& v) { return Operand<T>(v); }
+    template <typename E> const E& operand(const Expression<E>& e) { return e.self(); }
+
+    template <typename X>
+    using operand_t = std::decay_t<decltype(operand(std::declval<const X&>()))>;
+
+    // Lazy counterparts of MatrixOps::elementWiseMultiply, addBroadcast and
+    // multiplyBroadcast (row vectors; ColBroadcast gives the column form)
+    template <typename A, typename B, typename = std::enable_if_t<is_expression_v<A> && is_expression_v<B>>>
+    Binary<Multiply, operand_t<A>, operand_t<B>> elementWiseMultiply(const A& a, const B& b) {
+        return {operand(a), operand(b)};
+    }
+
+    template <typename A, typename = std::enable_if_t<is_expression_v<A>>>
+    Binary<Add, operand_t<A>, RowBroadcast<typename operand_t<A>::value_type>>
+    addBroadcast(const A& a, const MatrixT<typename operand_t<A>::value_type>& vector) {
+        const operand_t<A>& lhs = operand(a);
+        return {lhs, RowBroadcast<typename operand_t<A>::value_type>(vector, lhs.getRows(), lhs.getCols())};
+    }
+
+    template <typename A, typename = std::enable_if_t<is_expression_v<A>>>
+    Binary<Multiply, operand_t<A>, RowBroadcast<typename operand_t<A>::value_type>>
+    multiplyBroadcast(const A& a, const MatrixT<typename operand_t<A>::value_type>& vector) {
+        const operand_t<A>& lhs = operand(a);
+        return {lhs, RowBroadcast<typename operand_t<A>::value_type>(vector, lhs.getRows(), lhs.getCols())};
+    }
+
+    namespace detail {
+
+    // out[j] = row[j] for j < n, in fixed-width chunks the vectoriser turns
+    // into straight SIMD code at -O2. ivdep: out may be one of the operands,
+    // but only at the same index, so there is no loop-carried dependence.
+    template <typename T, typename Row>
+    inline __attribute__((always_inline)) void assign_row_body(T* out, const Row& row, size_t n) {
+        constexpr size_t CHUNK = 16;
+        size_t j = 0;
+        for (; j + CHUNK <= n; j += CHUNK) {
+#pragma GCC ivdep
+            for (size_t k = 0; k < CHUNK; ++k) {
+                out[j + k] = row[j + k];
+            }
+        }
+        for (; j < n; ++j) {
+            out[j] = row[j];
+        }
+    }
+
+    template <typename T, typename Row>
+    void assign_row(T* out, const Row& row, size_t n) {
+        assign_row_body(out, row, n);
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    // Same loop with 256-bit vectors (also used on AVX-512 machines: these
+    // loops are bound by memory bandwidth, not vector width). No FMA, so
+    // a * b + c rounds exactly as the eager operators did.
+    template <typename T, typename Row>
+    __attribute__((target("avx2"))) void assign_row_avx2(T* out, const Row& row, size_t n) {
+        assign_row_body(out, row, n);
+    }
+#endif
+
+    } // namespace detail
+
+    // out = expr, in one pass over out
+    template <typename T, typename E>
+    void evaluate(const MatrixViewT<T>& out, const Expression<E>& expr) {
+        static_assert(std::is_same<T, typename E::value_type>::value,
+                      "Matrix expression element type must match the destination");
+        const E& e = expr.self();
+        if (out.getRows() != e.getRows() || out.getCols() != e.getCols()) {
+            throw std::invalid_argument("Expression dimensions must match the destination");
+        }
+
+#if defined(__x86_64__) || defined(__i386__)
+        if (CpuFeatures::active_isa() != CpuFeatures::IsaLevel::Scalar) {
+            for (size_t i = 0; i < e.getRows(); ++i) {
+                detail::assign_row_avx2(out.row_ptr(i), e.row(i), e.getCols());
+            }
+            return;
+        }
+#endif
+        for (size_t i = 0; i < e.getRows(); ++i) {
+            detail::assign_row(out.row_ptr(i), e.row(i), e.getCols());
+        }
+    }
+}
+
+// The operators live at global scope, next to MatrixT, so plain a + b finds
+// them for matrices, views and expression nodes alike.
+template <typename A, typename B,
+          typename = std::enable_if_t<MatrixExpr::is_expression_v<A> && MatrixExpr::is_expression_v<B>>>
+MatrixExpr::Binary<MatrixExpr::Add, MatrixExpr::operand_t<A>, MatrixExpr::operand_t<B>>
+operator+(const A& a, const B& b) {
+    return {MatrixExpr::operand(a), MatrixExpr::operand(b)};
+}
+
+template <typename A, typename B,
+          typename = std::enable_if_t<MatrixExpr::is_expression_v<A> && MatrixExpr::is_expression_v<B>>>
+MatrixExpr::Binary<MatrixExpr::Subtract, MatrixExpr::operand_t<A>, MatrixExpr::operand_t<B>>
+operator-(const A& a, const B& b) {
+    return {MatrixExpr::operand(a), MatrixExpr::operand(b)};
+}
+
+template <typename A, typename S,
+          typename = std::enable_if_t<MatrixExpr::is_expression_v<A> && std::is_arithmetic<S>::value>>
+MatrixExpr::ScalarBinary<MatrixExpr::Multiply, MatrixExpr::operand_t<A>> operator*(const A& a, S scalar) {
+    using T = typename MatrixExpr::operand_t<A>::value_type;
+    return {MatrixExpr::operand(a), static_cast<T>(scalar)};
+}
+
+template <typename S, typename A,
+          typename = std::enable_if_t<MatrixExpr::is_expression_v<A> && std::is_arithmetic<S>::value>>
+MatrixExpr::ScalarBinary<MatrixExpr::Multiply, MatrixExpr::operand_t<A>> operator*(S scalar, const A& a) {
+    return a * scalar;
+}
+
+template <typename A, typename S,
+          typename = std::enable_if_t<MatrixExpr::is_expression_v<A> && std::is_arithmetic<S>::value>>
+MatrixExpr::ScalarBinary<MatrixExpr::Divide, MatrixExpr::operand_t<A>> operator/(const A& a, S scalar) {
+    using T = typename MatrixExpr::operand_t<A>::value_type;
+    if (static_cast<T>(scalar) == T(0)) {
+        throw std::invalid_argument("Division by zero");
+    }
+    return {MatrixExpr::operand(a), static_cast<T>(scalar)};
+}
+
+// Evaluation into matrices and views
+template <typename T>
+template <typename E>
+MatrixT<T>::MatrixT(const MatrixExpr::Expression<E>& expr) : MatrixT() {
+    resize_for_overwrite(expr.self().getRows(), expr.self().getCols());
+    MatrixExpr::evaluate(view(), expr);
+}
+
+template <typename T>
+template <typename E>
+MatrixT<T>& MatrixT<T>::operator=(const MatrixExpr::Expression<E>& expr) {
+    if (rows != expr.self().getRows() || cols != expr.self().getCols()) {
+        // Evaluate before giving up the current storage, which the
+        // expression may still read
+        return *this = MatrixT(expr);
+    }
+    MatrixExpr::evaluate(view(), expr);
+    return *this;
+}
+
+template <typename T>
+template <typename E>
+MatrixT<T>& MatrixT<T>::operator+=(const E& other) {
+    MatrixExpr::evaluate(view(), *this + other);
+    return *this;
+}
+
+template <typename T>
+template <typename E>
+MatrixT<T>& MatrixT<T>::operator-=(const E& other) {
+    MatrixExpr::evaluate(view(), *this - other);
+    return *this;
+}
+
+template <typename T>
+template <typename E>
+void MatrixViewT<T>::assign(const MatrixExpr::Expression<E>& expr) const {
+    MatrixExpr::evaluate(*this, expr);
+}
+
+#endif //MATRIX_EXPR_H
@@ -6,38 +6,93 @@
 #define MATRIX_OPS_H
 
 #include "matrix.h"
+#include "gemm.h"
+#include "../utils/workspace.h"
 
+// All operations are templates over the element type and are instantiated for
+// float and double in matrix_ops.cpp. Scalar arguments stay double so calls
+// like power(m, 0.5) deduce T from the matrix alone.
+//
+// Every operation that produces a matrix comes in two forms:
+//   - op(args..., workspace = nullptr) returns a new matrix, taking its
+//     storage from the workspace when one is given (see workspace.h for how
+//     long that stays valid) and from the heap otherwise;
+//   - op_into(out, args...) writes into a caller-provided view of the right
+//     shape and never allocates. Element-wise ops allow out to be the same
+//     storage as an input; products and transposes throw if out overlaps an
+//     input.
+// Inputs of the _into forms are ConstViewArg, so MatrixT, MatrixViewT and
+// ConstMatrixViewT arguments all work; T is deduced from out.
 namespace MatrixOps {
     // Matrix multiplication
-    Matrix matmul(const Matrix& a, const Matrix& b);
+    template <typename T> MatrixT<T> matmul(const MatrixT<T>& a, const MatrixT<T>& b, Workspace* workspace = nullptr);
+    template <typename T> MatrixT<T> matmul_nt(const MatrixT<T>& a, const MatrixT<T>& b, Workspace* workspace = nullptr); // a * b^T without materialising b^T
+    template <typename T> MatrixT<T> matmul_tn(const MatrixT<T>& a, const MatrixT<T>& b, Workspace* workspace = nullptr); // a^T * b without materialising a^T
+    template <typename T> void matmul_into(const MatrixViewT<T>& out, ConstViewArg<T> a, ConstViewArg<T> b);
+    template <typename T> void matmul_nt_into(const MatrixViewT<T>& out, ConstViewArg<T> a, ConstViewArg<T> b);
+    template <typename T> void matmul_tn_into(const MatrixViewT<T>& out, ConstViewArg<T> a, ConstViewArg<T> b);
+
+    // Pre-packed right-hand operands (e.g. layer weights packed once at load
+    // time), optionally stored in 16 bits (see Gemm::Storage)
+    template <typename T> Gemm::PackedMatrix<T> pack_rhs(const MatrixT<T>& b);            // for a * b
+    template <typename T> Gemm::PackedMatrix<T> pack_rhs_transposed(const MatrixT<T>& b,  // for a * b^T
+                                                                    Gemm::Storage storage = Gemm::Storage::Native);
+    template <typename T> MatrixT<T> matmul(const MatrixT<T>& a, const Gemm::PackedMatrix<T>& b,
+                                            Workspace* workspace = nullptr);
+    template <typename T> void matmul_into(const MatrixViewT<T>& out, ConstViewArg<T> a, const Gemm::PackedMatrix<T>& b);
 
-    // Element-wise operations
-    Matrix elementWiseMultiply(const Matrix& a, const Matrix& b);
-    Matrix elementWiseDivide(const Matrix& a, const Matrix& b);
+    // Element-wise operations (the _into forms of MatrixT's +, - and * scalar
+    // are add_into, subtract_into and scale_into)
+    template <typename T> MatrixT<T> elementWiseMultiply(const MatrixT<T>& a, const MatrixT<T>& b, Workspace* workspace = nullptr);
+    template <typename T> MatrixT<T> elementWiseDivide(const MatrixT<T>& a, const MatrixT<T>& b, Workspace* workspace = nullptr);
+    template <typename T> void elementWiseMultiply_into(const MatrixViewT<T>& out, ConstViewArg<T> a, ConstViewArg<T> b);
+    template <typename T> void elementWiseDivide_into(const MatrixViewT<T>& out, ConstViewArg<T> a, ConstViewArg<T> b);
+    template <typename T> void add_into(const MatrixViewT<T>& out, ConstViewArg<T> a, ConstViewArg<T> b);
+    template <typename T> void subtract_into(const MatrixViewT<T>& out, ConstViewArg<T> a, ConstViewArg<T> b);
+    template <typename T> void scale_into(const MatrixViewT<T>& out, ConstViewArg<T> a, double scalar);
 
     // Matrix operations
-    Matrix transpose(const Matrix& matrix);
+    template <typename T> MatrixT<T> transpose(const MatrixT<T>& matrix, Workspace* workspace = nullptr);
+    template <typename T> MatrixT<T> transpose(const ConstMatrixViewT<T>& view, Workspace* workspace = nullptr);
+    template <typename T> void transpose_into(const MatrixViewT<T>& out, ConstViewArg<T> view);
+    // A vector as a (1, n) row. Biases are stored as (n, 1) columns in the
+    // CSV export; the row has the same elements, so this is a reshape rather
+    // than a transposed copy.
+    template <typename T> MatrixT<T> as_row_vector(MatrixT<T> vector);
 
     // Broadcasting operations
-    Matrix addBroadcast(const Matrix& matrix, const Matrix& vector, bool row_vector = true);
-    Matrix multiplyBroadcast(const Matrix& matrix, const Matrix& vector, bool row_vector = true);
+    template <typename T> MatrixT<T> addBroadcast(const MatrixT<T>& matrix, const MatrixT<T>& vector, bool row_vector = true,
+                                                  Workspace* workspace = nullptr);
+    template <typename T> MatrixT<T> multiplyBroadcast(const MatrixT<T>& matrix, const MatrixT<T>& vector, bool row_vector = true,
+                                                       Workspace* workspace = nullptr);
+    template <typename T> void addBroadcast_into(const MatrixViewT<T>& out, ConstViewArg<T> matrix, ConstViewArg<T> vector,
+                                                 bool row_vector = true);
+    template <typename T> void multiplyBroadcast_into(const MatrixViewT<T>& out, ConstViewArg<T> matrix, ConstViewArg<T> vector,
+                                                      bool row_vector = true);
 
-    // Reduction operations
-    double sum(const Matrix& matrix);
-    double mean(const Matrix& matrix);
-    Matrix sumAxis(const Matrix& matrix, int axis); // axis 0: sum columns, axis 1: sum rows
-    Matrix meanAxis(const Matrix& matrix, int axis);
+    // Reduction operations (accumulated in double)
+    template <typename T> double sum(const MatrixT<T>& matrix);
+    template <typename T> double mean(const MatrixT<T>& matrix);
+    template <typename T> MatrixT<T> sumAxis(const MatrixT<T>& matrix, int axis, Workspace* workspace = nullptr); // axis 0: sum columns, axis 1: sum rows
+    template <typename T> MatrixT<T> meanAxis(const MatrixT<T>& matrix, int axis, Workspace* workspace = nullptr);
+    template <typename T> void sumAxis_into(const MatrixViewT<T>& out, ConstViewArg<T> matrix, int axis); // out: (1, cols) or (rows, 1)
+    template <typename T> void meanAxis_into(const MatrixViewT<T>& out, ConstViewArg<T> matrix, int axis);
 
     // Utility functions
-    Matrix power(const Matrix& matrix, double exponent);
-    Matrix sqrt(const Matrix& matrix);
-    Matrix exp(const Matrix& matrix);
-    Matrix log(const Matrix& matrix);
+    template <typename T> MatrixT<T> power(const MatrixT<T>& matrix, double exponent, Workspace* workspace = nullptr);
+    template <typename T> MatrixT<T> sqrt(const MatrixT<T>& matrix, Workspace* workspace = nullptr);
+    template <typename T> MatrixT<T> exp(const MatrixT<T>& matrix, Workspace* workspace = nullptr);
+    template <typename T> MatrixT<T> log(const MatrixT<T>& matrix, Workspace* workspace = nullptr);
+    template <typename T> void power_into(const MatrixViewT<T>& out, ConstViewArg<T> matrix, double exponent);
+    template <typename T> void sqrt_into(const MatrixViewT<T>& out, ConstViewArg<T> matrix);
+    template <typename T> void exp_into(const MatrixViewT<T>& out, ConstViewArg<T> matrix);
+    template <typename T> void log_into(const MatrixViewT<T>& out, ConstViewArg<T> matrix);
 
     // Matrix properties
-    double trace(const Matrix& matrix);
-    double determinant(const Matrix& matrix); // For small matrices
-    Matrix inverse(const Matrix& matrix); // For small matrices
+    template <typename T> double trace(const MatrixT<T>& matrix);
+    template <typename T> double determinant(const MatrixT<T>& matrix); // For small matrices
+    template <typename T> MatrixT<T> inverse(const MatrixT<T>& matrix, Workspace* workspace = nullptr); // For small matrices
+    template <typename T> void inverse_into(const MatrixViewT<T>& out, const MatrixT<T>& matrix);
 }
 
 
@@ -0,0 +1,99 @@
+//
+// Created by JAYAN on 01/08/2025.
+//
+
+#ifndef QGEMM_H
+#define QGEMM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "gemm.h"
+
+// Integer GEMM for int8 post-training quantised Linear layers.
+//
+//   weights      symmetric int8 in [-127, 127], one scale per output channel:
+//                w[j][p] ~= weight_scale[j] * qw[j][p]
+//   activations  asymmetric unsigned 7-bit, one scale and zero point per
+//                tensor: x ~= scale * (qx - zero_point), qx in [0, 127]
+//
+// C = A * W^T is accumulated exactly in int32 and dequantised in the
+// epilogue, per finished tile:
+//
+//   C[i][j] = scale * weight_scale[j] * (acc[i][j] - zero_point * colsum[j]) + bias[j]
+//
+// followed by the Gemm::Epilogue activation / accumulation. Activations stop
+// at 127 so that the AVX2 path (vpmaddubsw, which adds u8 x s8 pairs into a
+// saturating int16) can never saturate: 2 * 127 * 127 < 32767. Scalar, AVX2
+// and AVX-512 VNNI (vpdpbusd) therefore produce bit-identical int32 sums.
+// Instantiated for float and double outputs.
+namespace QGemm {
+
+    constexpr int ACTIVATION_MAX = 127;
+    constexpr int WEIGHT_MAX = 127;
+
+    struct ActivationParams {
+        float scale = 1.0f;
+        int32_t zero_point = 0;
+    };
+
+    // Scale and zero point covering [min_value, max_value] (widened to hold 0)
+    ActivationParams choose_activation_params(float min_value, float max_value);
+
+    // Per-output-channel symmetric quantisation of a row-major (n, k) weight
+    // (the nn.Linear layout): q gets n * k values, scales n.
+    template <typename T>
+    void quantize_weights(const T* weight, size_t n, size_t k, std::vector<int8_t>& q, std::vector<float>& scales);
+
+    // Quantise m rows of k activations (row stride lda) into out (row stride
+    // ldq >= padded_depth(k)); the padding bytes are zeroed.
+    template <typename T>
+    void quantize_activations(size_t m, size_t k, const T* a, size_t lda, const ActivationParams& params,
+                              uint8_t* out, size_t ldq);
+
+    // k rounded up to the 4-byte groups the kernels consume
+    inline size_t padded_depth(size_t k) { return (k + 3) & ~size_t(3); }
+
+    // int8 weights (n outputs x k inputs) packed once into panels of 16
+    // output channels: for each group of 4 inputs, 16 x 4 bytes, channel-major.
+    // Also keeps the per-channel scales and the column sums the zero-point
+    // correction needs.
+    class PackedWeights {
+    private:
+        std::vector<int8_t> panels;
+        std::vector<float> scales;          // n
+        std::vector<int32_t> column_sums;   // n: sum over k of q
+        size_t rows;                        // k
+        size_t cols;                        // n
+
+    public:
+        static constexpr size_t PANEL = 16;
+
+        PackedWeights();
+        // q is row-major (n, k), as quantize_weights produces it
+        PackedWeights(size_t n, size_t k, const int8_t* q, const float* scales);
+
+        size_t getRows() const { return rows; }
+        size_t getCols() const { return cols; }
+        bool empty() const { return cols == 0; }
+
+        const int8_t* panel_data() const { return panels.data(); }
+        const float* scale_data() const { return scales.data(); }
+        const int32_t* column_sum_data() const { return column_sums.data(); }
+
+        // Back to the row-major (n, k) int8 values
+        std::vector<int8_t> unpack() const;
+    };
+
+    // C (m x n) = dequant(A_q (m x k) * W^T), A_q quantised with params and
+    // stored with row stride lda (>= padded_depth(k)), see above.
+    template <typename T>
+    void gemm(size_t m, const uint8_t* a, size_t lda, const ActivationParams& params, const PackedWeights& w,
+              T* c, size_t ldc, const Gemm::Epilogue<T>& epilogue = Gemm::Epilogue<T>());
+
+    // Kernel family selected for this CPU ("scalar", "avx2", "avx512-vnni").
+    // Follows VIT_ISA like the other SIMD kernels.
+    const char* kernel_name();
+}
+
+#endif //QGEMM_H
@@ -0,0 +1,51 @@
+//
+// Created by JAYAN on 25/07/2025.
+//
+
+#ifndef VECTOR_MATH_H
+#define VECTOR_MATH_H
+
+#include <cstddef>
+
+// Element-wise transcendental kernels over contiguous arrays, used by
+// ActivationFunctions and MatrixOps. out may alias in.
+//
+// float runs Cephes-style polynomial approximations, vectorised with AVX2 or
+// AVX-512 (picked at runtime through CpuFeatures; the scalar fallback runs
+// the same polynomials). Maximum errors against the correctly rounded result,
+// measured over the whole float range by bench_activations:
+//
+//   exp       relative < 1.5e-7 (~1 ulp); 0 below -87.33, saturates at 88.37
+//   tanh      absolute < 1e-7, relative < 1e-7
+//   sigmoid   absolute < 1e-7
+//   gelu_tanh absolute < 1.5e-7 * |x| + 1e-7 against the formula in double
+//   gelu_erf  absolute < 1.5e-7 * |x| + 3e-7 (Abramowitz & Stegun 7.1.26 erf)
+//
+// double goes through the standard library element by element and is exact
+// to libm precision; it is the reference the float kernels are checked
+// against.
+namespace VectorMath {
+
+    template <typename T> void exp(const T* in, T* out, size_t n);
+    template <typename T> void tanh(const T* in, T* out, size_t n);
+    template <typename T> void sigmoid(const T* in, T* out, size_t n);
+
+    // 0.5 x (1 + tanh(sqrt(2/pi) (x + 0.044715 x^3)))
+    template <typename T> void gelu_tanh(const T* in, T* out, size_t n);
+    // 0.5 x (1 + erf(x / sqrt(2))), the exact GELU
+    template <typename T> void gelu_erf(const T* in, T* out, size_t n);
+
+    // Row softmax of scale * in with no scratch memory: one pass for the
+    // maximum, one pass writing exp(scale * (x - max)) straight into out while
+    // summing it, and a final in-cache pass multiplying by 1 / sum.
+    // scale must be positive.
+    template <typename T> void softmax(const T* in, T* out, size_t n, T scale = T(1));
+
+    // Building blocks for streaming (online) softmax: the largest of n > 0
+    // values, and exp(scale * x + shift) written into out with its sum
+    // returned
+    template <typename T> T reduce_max(const T* in, size_t n);
+    template <typename T> T exp_sum(const T* in, T* out, size_t n, T scale, T shift);
+}
+
+#endif //VECTOR_MATH_H
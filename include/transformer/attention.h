@@ -0,0 +1,167 @@
+//
+// Created by JAYAN on 26/07/2025.
+//
+
+#ifndef ATTENTION_H
+#define ATTENTION_H
+
+#include "../matrix/matrix.h"
+#include "../matrix/gemm.h"
+#include "../utils/file_io.h"
+#include "../utils/weight_file.h"
+#include "quantized_linear.h"
+#include <string>
+#include <vector>
+
+// Attention loop run by MultiHeadAttentionT::forward
+enum class AttentionKernel {
+    Standard,   // Full score matrix per head; keeps attention weights for inspection
+    Tiled       // Online softmax over key/value tiles; no score matrix
+};
+
+// Multi-head self-attention with the PyTorch nn.MultiheadAttention weight
+// layout (in_proj_weight holds W_q, W_k, W_v stacked by rows).
+//
+// forward runs one fused QKV GEMM for every token, then, for each
+// (sequence, head) pair in parallel: Q_h * K_h^T straight from strided views
+// into the QKV buffer, the 1/sqrt(head_dim) scale folded into an in-place row
+// softmax, and probabilities * V_h written into that head's columns of the
+// context buffer. Nothing is copied per head and the score matrix is written
+// once. Scratch buffers are kept between calls, so a forward is not
+// thread-safe on a shared instance.
+//
+// AttentionKernel::Tiled replaces the per-head score matrix with a
+// flash-style loop: query blocks stream over key/value blocks, keeping a
+// running row max and sum (online softmax) and rescaling the partial output
+// as the max grows. Peak scratch is one tile per thread, O(seq_len * d)
+// overall instead of O(seq_len^2) per head, which is what lets 14x14 and
+// 28x28 patch grids stay in cache. Results match Standard to float rounding.
+//
+// The QKV and output projections can run in int8 (see QuantizedLinearT) or
+// on bfloat16 / half packed weights (set_weight_storage); the attention loop
+// itself stays in floating point.
+//
+// Templated on element type; MultiHeadAttention (float) is the transformer
+// default.
+template <typename T>
+class MultiHeadAttentionT {
+private:
+    MatrixT<T> in_proj_weight;      // (3 * d_model, d_model): W_q | W_k | W_v
+    MatrixT<T> in_proj_bias;        // (1, 3 * d_model)
+    MatrixT<T> out_proj_weight;     // (d_model, d_model)
+    MatrixT<T> out_proj_bias;       // (1, d_model)
+    Gemm::PackedMatrix<T> in_proj_packed;   // in_proj_weight^T packed for the GEMM
+    Gemm::PackedMatrix<T> out_proj_packed;  // out_proj_weight^T packed for the GEMM
+    QuantizedLinearT<T> in_proj_quantized;
+    QuantizedLinearT<T> out_proj_quantized;
+    Gemm::Storage weight_storage;   // Element format of the packed projections
+
+    int d_model;                    // Model dimension (e.g., 256)
+    int num_heads;                  // Number of heads (e.g., 8)
+    int head_dim;                   // d_model / num_heads
+    AttentionKernel kernel;         // Which attention loop forward runs
+
+    // Scratch reused across forward calls without a workspace (resize keeps
+    // the storage)
+    MatrixT<T> qkv;                 // (tokens, 3 * d_model)
+    MatrixT<T> scores;              // (sequences * num_heads * seq_len, seq_len)
+    MatrixT<T> context;             // (tokens, d_model), heads side by side
+
+public:
+    static constexpr int DEFAULT_NUM_HEADS = 8;
+
+    // Constructor
+    MultiHeadAttentionT(int d_model, int num_heads = DEFAULT_NUM_HEADS);
+
+    // Default constructor: d_model is taken from the weights when they load
+    MultiHeadAttentionT();
+
+    // Forward pass over input (tokens, d_model) holding tokens / seq_len
+    // sequences back to back; seq_len = 0 treats the input as one sequence.
+    MatrixT<T> forward(const MatrixT<T>& input, size_t seq_len = 0);
+
+    // Same, writing into output (tokens, d_model). output may be the same
+    // storage as input. With a workspace of at least
+    // workspace_size(tokens, seq_len) elements, 64-byte aligned, the scratch
+    // buffers live there instead of in this instance and get_attention_weights
+    // is left untouched.
+    void forward(const ConstMatrixViewT<T>& input, size_t seq_len, const MatrixViewT<T>& output,
+                 T* workspace = nullptr);
+
+    // residual += attention(input), the output projection accumulating in
+    // place. residual may be the same storage as input.
+    void forward_residual(const ConstMatrixViewT<T>& input, size_t seq_len, const MatrixViewT<T>& residual,
+                          T* workspace = nullptr);
+
+    // Elements of scratch a forward over `tokens` rows needs with the current
+    // kernel (the score matrix only exists for Standard)
+    size_t workspace_size(size_t tokens, size_t seq_len) const;
+
+    // Grow the calling thread's Tiled kernel scratch for this head size now
+    // rather than in a later forward
+    void reserve_thread_scratch() const;
+
+    // Load weights from CSV files
+    void load_weights(const std::string& base_path, int layer_idx);
+
+    // Load weights from a binary weight file (same tensor names, no .csv);
+    // pack = false leaves the packed projections to the caller (see
+    // PatchEmbeddingT::load_weights)
+    void load_weights(const WeightFile& weights, int layer_idx, bool pack = true);
+
+    // Append in_proj and out_proj of block layer_idx, by weight tensor name
+    void collect_linears(int layer_idx, std::vector<typename QuantizedLinearT<T>::Slot>& slots);
+    void collect_linears(int layer_idx, std::vector<typename QuantizedLinearT<T>::ConstSlot>& slots) const;
+
+    // Attention loop used by forward (Standard by default)
+    void set_kernel(AttentionKernel kernel) { this->kernel = kernel; }
+    AttentionKernel get_kernel() const { return kernel; }
+
+    // Re-pack both projections in storage; kept for later loads
+    void set_weight_storage(Gemm::Storage storage);
+    Gemm::Storage get_weight_storage() const { return weight_storage; }
+    size_t get_packed_bytes() const { return in_proj_packed.bytes() + out_proj_packed.bytes(); }
+
+    // Head count is not part of the weights; set it before or after loading
+    void set_num_heads(int num_heads) { set_dimensions(d_model, num_heads); }
+
+    // Softmax probabilities of the last Standard forward, one
+    // seq_len x seq_len block per (sequence, head), sequence-major. Empty
+    // after a Tiled forward.
+    const MatrixT<T>& get_attention_weights() const { return scores; }
+
+    // Getters
+    const MatrixT<T>& get_in_proj_weight() const { return in_proj_weight; }
+    const MatrixT<T>& get_in_proj_bias() const { return in_proj_bias; }
+    const MatrixT<T>& get_out_proj_weight() const { return out_proj_weight; }
+    const MatrixT<T>& get_out_proj_bias() const { return out_proj_bias; }
+    int get_d_model() const { return d_model; }
+    int get_num_heads() const { return num_heads; }
+    int get_head_dim() const { return head_dim; }
+
+    // Initialize with specific dimensions
+    void initialize(int d_model, int num_heads = DEFAULT_NUM_HEADS);
+
+private:
+    // Tensor name relative to the weights root, e.g.
+    // "transformer_layers/transformer_0_attn_in_proj_weight"
+    static std::string tensor_name(int layer_idx, const std::string& param);
+
+    // Adopt freshly loaded tensors, check their shapes and re-pack them
+    // unless pack is false
+    void set_weights(MatrixT<T> in_weight, MatrixT<T> in_bias, MatrixT<T> out_weight, MatrixT<T> out_bias,
+                     bool pack = true);
+    void set_dimensions(int d_model, int num_heads);
+    void pack_weights();
+
+    // Shared path of forward and forward_residual
+    void run(const ConstMatrixViewT<T>& input, size_t seq_len, const MatrixViewT<T>& output, bool accumulate,
+             T* workspace);
+};
+
+using MultiHeadAttention = MultiHeadAttentionT<float>;
+
+extern template class MultiHeadAttentionT<float>;
+extern template class MultiHeadAttentionT<double>;
+
+#endif //ATTENTION_H
@@ -0,0 +1,135 @@
+//
+// Created by JAYAN on 31/07/2025.
+//
+
+#ifndef BATCHED_INFERENCE_H
+#define BATCHED_INFERENCE_H
+
+#include "../matrix/matrix.h"
+#include "vision_transformer.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Throughput / latency knobs of a BatchedInference front end
+struct BatchingOptions {
+    size_t max_batch = 32;          // Images per forward
+    double max_delay_ms = 2.0;      // How long the oldest waiting image may wait for others to join its batch
+    size_t max_queue = 1024;        // submit() blocks while this many images are waiting
+};
+
+// Dynamic micro-batching in front of a VisionTransformer. Any number of
+// caller threads submit single images and get a future back; one batching
+// thread collects them and runs a forward as soon as max_batch images are
+// waiting or the oldest has waited max_delay_ms, whichever comes first, then
+// completes every future of that batch. Under light load an image waits at
+// most max_delay_ms on top of a single-image forward; under heavy load the
+// batches fill up and the GEMMs run at batched efficiency.
+//
+// The model is used only by the batching thread from construction until the
+// destructor returns; the caller keeps it alive and must not run it
+// concurrently. The destructor finishes every request already submitted.
+//
+// Statistics (batch-size and latency histograms) are kept from construction
+// or the last reset_stats().
+template <typename T>
+class BatchedInferenceT {
+public:
+    struct Result {
+        MatrixT<T> logits;      // (1, num_classes)
+        int predicted;          // Index of the largest logit
+        size_t batch_size;      // Images in the forward that served this request
+        double queue_ms;        // From submit() to the start of that forward
+        double latency_ms;      // From submit() to completion
+    };
+
+    struct Stats {
+        // Latency bucket b holds requests that took [2^(b-1), 2^b) us; bucket
+        // 0 is under 1 us and the last one is open-ended
+        static constexpr size_t LATENCY_BUCKETS = 32;
+
+        size_t requests = 0;
+        size_t batches = 0;
+        std::vector<size_t> batch_sizes;        // batch_sizes[n]: forwards that ran n images
+        std::vector<size_t> latency_buckets = std::vector<size_t>(LATENCY_BUCKETS, 0);
+        double total_latency_ms = 0.0;
+        double total_queue_ms = 0.0;
+        double elapsed_seconds = 0.0;           // Wall time covered by these statistics
+
+        double mean_batch_size() const { return batches ? double(requests) / batches : 0.0; }
+        double mean_latency_ms() const { return requests ? total_latency_ms / requests : 0.0; }
+        double mean_queue_ms() const { return requests ? total_queue_ms / requests : 0.0; }
+        double images_per_second() const { return elapsed_seconds > 0.0 ? requests / elapsed_seconds : 0.0; }
+        // Upper edge of the latency bucket holding the p-th percentile (0-100)
+        double latency_percentile_ms(double p) const;
+
+        void print(std::ostream& os = std::cout) const;
+    };
+
+    explicit BatchedInferenceT(VisionTransformerT<T>& model, const BatchingOptions& options = BatchingOptions());
+    ~BatchedInferenceT();
+    BatchedInferenceT(const BatchedInferenceT&) = delete;
+    BatchedInferenceT& operator=(const BatchedInferenceT&) = delete;
+
+    // Queue one image, (num_patches, patch_dim) as the DatasetReader lays it
+    // out; the patches are copied, so the caller's buffer is free on return
+    std::future<Result> submit(const ConstMatrixViewT<T>& patches);
+
+    // submit() and wait
+    Result infer(const ConstMatrixViewT<T>& patches) { return submit(patches).get(); }
+
+    // Takes effect from the next batch
+    void set_options(const BatchingOptions& options);
+    BatchingOptions get_options() const;
+
+    Stats get_stats() const;
+    void reset_stats();
+
+    size_t pending() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Request {
+        MatrixT<T> patches;
+        std::promise<Result> promise;
+        Clock::time_point submitted;
+    };
+
+    VisionTransformerT<T>& model;
+    BatchingOptions options;
+    size_t num_patches;
+    size_t patch_dim;
+
+    mutable std::mutex mutex;
+    std::condition_variable ready_cv;   // Submitters -> batching thread
+    std::condition_variable space_cv;   // Batching thread -> blocked submitters
+    std::deque<Request> queue;
+    bool stopping;
+
+    Stats stats;
+    Clock::time_point stats_start;
+
+    // Batching thread only
+    MatrixT<T> batch_patches;           // (max_batch * num_patches, patch_dim)
+    MatrixT<T> batch_logits;            // (max_batch, num_classes)
+
+    std::thread worker;
+
+    void run();
+    void run_batch(std::vector<Request>& batch, const BatchingOptions& options);
+    static void check_options(const BatchingOptions& options);
+};
+
+using BatchedInference = BatchedInferenceT<float>;
+
+extern template class BatchedInferenceT<float>;
+extern template class BatchedInferenceT<double>;
+
+#endif //BATCHED_INFERENCE_H
@@ -6,48 +6,99 @@
 #define EMBEDDING_H
 
 #include "../matrix/matrix.h"
+#include "../matrix/gemm.h"
 #include "../utils/file_io.h"
+#include "../utils/weight_file.h"
+#include "quantized_linear.h"
 #include <string>
+#include <vector>
 
-class PatchEmbedding {
+// ViT input stage. Each image arrives as num_patches rows of patch_dim pixels
+// (the DatasetReader layout: a 28x28 image in 7x7 patches is 16 rows of 49)
+// and leaves as a sequence of seq_len = num_patches + 1 tokens:
+//
+//   token 0     = cls_token + pos_embed[0]    (combined once, at load)
+//   token 1 + p = patch_p * proj_weight^T + proj_bias + pos_embed[1 + p]
+//
+// Dimensions come from the weights: features and patch_dim from proj_weight,
+// seq_len from pos_embed. The projection can run in int8 (see
+// QuantizedLinearT) or on a bfloat16 / half packed weight.
+//
+// Templated on element type; PatchEmbedding (float) is the transformer default.
+template <typename T>
+class PatchEmbeddingT {
 private:
-    Matrix proj_weight;         // Projection weight matrix (features, num_patches)
-    Matrix proj_bias;           // Projection bias vector (features,)
-    Matrix pos_embed;           // Positional embeddings (seq_len, features)
-    Matrix cls_token;           // Class token (1, features)
+    MatrixT<T> proj_weight;     // Projection weight matrix (features, patch_dim)
+    MatrixT<T> proj_bias;       // Projection bias vector (1, features)
+    MatrixT<T> pos_embed;       // Positional embeddings (seq_len, features)
+    MatrixT<T> cls_token;       // Class token (1, features)
+    MatrixT<T> cls_pos;         // cls_token + pos_embed[0], token 0 of every image
+    Gemm::PackedMatrix<T> proj_weight_packed; // proj_weight^T packed for the GEMM (patch_dim, features)
+    QuantizedLinearT<T> proj_quantized;
+    Gemm::Storage weight_storage;   // Element format of proj_weight_packed
     
-    int num_patches;            // Number of patches (e.g., 49 for 7x7 patches)
+    int num_patches;            // Patches per image (e.g., 16 for a 28x28 image in 7x7 patches)
+    int patch_dim;              // Pixels per patch (e.g., 49)
     int features;               // Feature dimension (e.g., 256)
-    int seq_len;                // Sequence length (num_patches + 1 for class token)
+    int seq_len;                // Tokens per image (num_patches + 1 for class token)
 
 public:
-    // Constructor
-    PatchEmbedding(int num_patches, int features = 256);
+    // Constructor (patch_dim and features keep their original positions)
+    PatchEmbeddingT(int patch_dim, int features = 256, int num_patches = 16);
     
     // Default constructor
-    PatchEmbedding();
+    PatchEmbeddingT();
     
-    // Forward pass: convert image patches to embeddings
-    Matrix forward(const Matrix& image_patches);
+    // Forward pass: (images * num_patches, patch_dim) patches to
+    // (images * seq_len, features) token embeddings
+    MatrixT<T> forward(const MatrixT<T>& image_patches);
+    
+    // Same, writing into output (images * seq_len, features) without allocating
+    void forward(const ConstMatrixViewT<T>& image_patches, const MatrixViewT<T>& output);
     
     // Load weights from CSV files
     void load_weights(const std::string& base_path);
     
-    // Utility functions
-    Matrix add_class_token(const Matrix& embedded_patches);
-    Matrix add_positional_embeddings(const Matrix& embedded_with_cls);
+    // Load weights from a binary weight file (same tensor names, no .csv).
+    // pack = false leaves the packed projection to the caller, which fills
+    // it through collect_linears (VisionTransformerT's packed weight cache).
+    void load_weights(const WeightFile& weights, bool pack = true);
+    
+    // Append the projection, by weight tensor name
+    void collect_linears(std::vector<typename QuantizedLinearT<T>::Slot>& slots);
+    void collect_linears(std::vector<typename QuantizedLinearT<T>::ConstSlot>& slots) const;
+    
+    // Re-pack the projection in storage; kept for later loads
+    void set_weight_storage(Gemm::Storage storage);
+    Gemm::Storage get_weight_storage() const { return weight_storage; }
+    size_t get_packed_bytes() const { return proj_weight_packed.bytes(); }
     
     // Getters
-    const Matrix& get_proj_weight() const { return proj_weight; }
-    const Matrix& get_proj_bias() const { return proj_bias; }
-    const Matrix& get_pos_embed() const { return pos_embed; }
-    const Matrix& get_cls_token() const { return cls_token; }
+    const MatrixT<T>& get_proj_weight() const { return proj_weight; }
+    const MatrixT<T>& get_proj_bias() const { return proj_bias; }
+    const MatrixT<T>& get_pos_embed() const { return pos_embed; }
+    const MatrixT<T>& get_cls_token() const { return cls_token; }
+    const MatrixT<T>& get_cls_pos() const { return cls_pos; }
     int get_num_patches() const { return num_patches; }
+    int get_patch_dim() const { return patch_dim; }
     int get_features() const { return features; }
     int get_seq_len() const { return seq_len; }
     
     // Initialize with specific dimensions
-    void initialize(int num_patches, int features);
+    void initialize(int patch_dim, int features, int num_patches = 16);
+
+private:
+    // Re-pack proj_weight^T after the weights change
+    void pack_weights();
+    
+    // Adopt freshly loaded tensors, derive the dimensions from them and
+    // precompute what forward reads (cls_pos, the packed projection)
+    void set_weights(MatrixT<T> weight, MatrixT<T> bias, MatrixT<T> pos, MatrixT<T> cls, bool pack = true);
 };
 
+using PatchEmbedding = PatchEmbeddingT<float>;
+
+extern template class PatchEmbeddingT<float>;
+extern template class PatchEmbeddingT<double>;
+
 #endif //EMBEDDING_H
\ No newline at end of file
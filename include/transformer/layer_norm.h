@@ -7,36 +7,62 @@
 
 #include "../matrix/matrix.h"
 #include "../utils/file_io.h"
+#include "../utils/weight_file.h"
 #include <string>
 
-class LayerNorm {
+// Templated on element type; LayerNorm (float) is the transformer default.
+template <typename T>
+class LayerNormT {
 private:
-    Matrix gamma;           // Scale parameters (weight)
-    Matrix beta;            // Shift parameters (bias)
+    MatrixT<T> gamma;       // Scale parameters (weight)
+    MatrixT<T> beta;        // Shift parameters (bias)
     double epsilon;         // Small constant for numerical stability
     int features;           // Number of features
 
 public:
     // Constructor
-    LayerNorm(int features, double eps = 1e-5);
+    LayerNormT(int features, double eps = 1e-5);
     
     // Default constructor for dynamic initialization
-    LayerNorm();
+    LayerNormT();
     
     // Forward pass
-    Matrix forward(const Matrix& input);
+    MatrixT<T> forward(const MatrixT<T>& input);
+    
+    // Forward pass overwriting the input, without allocating
+    void forward_inplace(MatrixT<T>& x);
+    
+    // Forward pass into output (same shape as input), without allocating.
+    // output may be the same storage as input.
+    void forward(const ConstMatrixViewT<T>& input, const MatrixViewT<T>& output);
     
     // Load weights from CSV files
     void load_weights(const std::string& base_path, int layer_idx, const std::string& norm_type);
     
+    // Load weights from a binary weight file (same tensor names, no .csv)
+    void load_weights(const WeightFile& weights, int layer_idx, const std::string& norm_type);
+    
     // Getters
-    const Matrix& get_gamma() const { return gamma; }
-    const Matrix& get_beta() const { return beta; }
+    const MatrixT<T>& get_gamma() const { return gamma; }
+    const MatrixT<T>& get_beta() const { return beta; }
     double get_epsilon() const { return epsilon; }
     int get_features() const { return features; }
     
     // Initialize with specific dimensions
     void initialize(int features, double eps = 1e-5);
+    
+    // Adopt tensors loaded elsewhere (e.g. the classifier's mlp_head_0 norm)
+    void set_weights(MatrixT<T> weight, MatrixT<T> bias);
+
+private:
+    // Tensor name relative to the weights root, e.g.
+    // "transformer_layers/transformer_0_layer_norm_1_weight"
+    static std::string tensor_name(int layer_idx, const std::string& norm_type, const std::string& param);
 };
 
+using LayerNorm = LayerNormT<float>;
+
+extern template class LayerNormT<float>;
+extern template class LayerNormT<double>;
+
 #endif //LAYER_NORM_H
\ No newline at end of file
@@ -0,0 +1,125 @@
+//
+// Created by JAYAN on 27/07/2025.
+//
+
+#ifndef MLP_H
+#define MLP_H
+
+#include "../matrix/matrix.h"
+#include "../matrix/gemm.h"
+#include "../matrix/activation_functions.h"
+#include "../utils/file_io.h"
+#include "../utils/weight_file.h"
+#include "quantized_linear.h"
+#include <string>
+#include <vector>
+
+// Transformer feed-forward block: Linear(d_model -> hidden) -> GELU ->
+// Linear(hidden -> d_model), with the PyTorch nn.Sequential weight names
+// (linear_0 and linear_3; 1 and 2 are GELU and dropout).
+//
+// Bias and GELU run in the first GEMM's epilogue as each tile of the hidden
+// activation is finished, and the second GEMM's epilogue adds its bias and
+// accumulates into the residual stream, so the 4x-wide hidden activation is
+// written once and read once. The hidden buffer is kept between calls, so a
+// forward is not thread-safe on a shared instance.
+//
+// Both linears can run in int8 (see QuantizedLinearT); collect_linears lists
+// them for calibration. Their packed weights can be kept in bfloat16 or half
+// (set_weight_storage), the float weights staying as loaded.
+//
+// Templated on element type; MLP (float) is the transformer default.
+template <typename T>
+class MLPT {
+private:
+    MatrixT<T> fc1_weight;          // (hidden_dim, d_model)
+    MatrixT<T> fc1_bias;            // (1, hidden_dim)
+    MatrixT<T> fc2_weight;          // (d_model, hidden_dim)
+    MatrixT<T> fc2_bias;            // (1, d_model)
+    Gemm::PackedMatrix<T> fc1_packed;   // fc1_weight^T packed for the GEMM
+    Gemm::PackedMatrix<T> fc2_packed;   // fc2_weight^T packed for the GEMM
+    QuantizedLinearT<T> fc1_quantized;
+    QuantizedLinearT<T> fc2_quantized;
+    Gemm::Storage weight_storage;   // Element format of fc1_packed and fc2_packed
+
+    int d_model;                    // Model dimension (e.g., 256)
+    int hidden_dim;                 // Hidden dimension (e.g., 4 * d_model)
+    ActivationFunctions::GeluMode gelu_mode;
+
+    MatrixT<T> hidden;              // (tokens, hidden_dim) scratch when no workspace is given
+
+public:
+    // Constructor. GELU defaults to the exact erf form, as nn.GELU does.
+    MLPT(int d_model, int hidden_dim, ActivationFunctions::GeluMode gelu_mode = ActivationFunctions::GeluMode::Erf);
+
+    // Default constructor: dimensions are taken from the weights when they load
+    MLPT();
+
+    // Forward pass: returns MLP(input) for input (tokens, d_model)
+    MatrixT<T> forward(const MatrixT<T>& input);
+
+    // Same, writing into output (tokens, d_model). output may be the same
+    // storage as input. With a workspace of at least workspace_size(tokens)
+    // elements, 64-byte aligned, the hidden activation lives there instead of
+    // in this instance.
+    void forward(const ConstMatrixViewT<T>& input, const MatrixViewT<T>& output, T* workspace = nullptr);
+
+    // residual += MLP(input), the second GEMM accumulating in place.
+    // residual may be the same storage as input.
+    void forward_residual(const ConstMatrixViewT<T>& input, const MatrixViewT<T>& residual,
+                          T* workspace = nullptr);
+
+    // Elements of scratch a forward over `tokens` rows needs
+    size_t workspace_size(size_t tokens) const { return aligned_size<T>(tokens * hidden_dim); }
+
+    // Load weights from CSV files
+    void load_weights(const std::string& base_path, int layer_idx);
+
+    // Load weights from a binary weight file (same tensor names, no .csv);
+    // pack = false leaves the packed linears to the caller (see
+    // PatchEmbeddingT::load_weights)
+    void load_weights(const WeightFile& weights, int layer_idx, bool pack = true);
+
+    // Append fc1 and fc2 of block layer_idx, by weight tensor name
+    void collect_linears(int layer_idx, std::vector<typename QuantizedLinearT<T>::Slot>& slots);
+    void collect_linears(int layer_idx, std::vector<typename QuantizedLinearT<T>::ConstSlot>& slots) const;
+
+    // Re-pack fc1 and fc2 in storage; kept for later loads
+    void set_weight_storage(Gemm::Storage storage);
+    Gemm::Storage get_weight_storage() const { return weight_storage; }
+    size_t get_packed_bytes() const { return fc1_packed.bytes() + fc2_packed.bytes(); }
+
+    void set_gelu_mode(ActivationFunctions::GeluMode mode) { gelu_mode = mode; }
+    ActivationFunctions::GeluMode get_gelu_mode() const { return gelu_mode; }
+
+    // Getters
+    const MatrixT<T>& get_fc1_weight() const { return fc1_weight; }
+    const MatrixT<T>& get_fc1_bias() const { return fc1_bias; }
+    const MatrixT<T>& get_fc2_weight() const { return fc2_weight; }
+    const MatrixT<T>& get_fc2_bias() const { return fc2_bias; }
+    int get_d_model() const { return d_model; }
+    int get_hidden_dim() const { return hidden_dim; }
+
+    // Initialize with specific dimensions
+    void initialize(int d_model, int hidden_dim);
+
+private:
+    // Tensor name relative to the weights root, e.g.
+    // "transformer_layers/transformer_0_linear_0_weight"
+    static std::string tensor_name(int layer_idx, int linear_idx, const std::string& param);
+
+    // Adopt freshly loaded tensors, check their shapes and re-pack them
+    // unless pack is false
+    void set_weights(MatrixT<T> w1, MatrixT<T> b1, MatrixT<T> w2, MatrixT<T> b2, bool pack = true);
+    void pack_weights();
+
+    // Shared path of forward and forward_residual
+    void run(const ConstMatrixViewT<T>& input, const MatrixViewT<T>& output, bool accumulate, T* workspace);
+};
+
+using MLP = MLPT<float>;
+
+extern template class MLPT<float>;
+extern template class MLPT<double>;
+
+#endif //MLP_H
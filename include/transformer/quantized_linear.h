@@ -0,0 +1,105 @@
+//
+// Created by JAYAN on 01/08/2025.
+//
+
+#ifndef QUANTIZED_LINEAR_H
+#define QUANTIZED_LINEAR_H
+
+#include "../matrix/matrix.h"
+#include "../matrix/gemm.h"
+#include "../matrix/qgemm.h"
+#include "../utils/weight_file.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// int8 companion of one Linear layer (x * W^T + b) of the transformer. The
+// layer keeps its float weights and calls gemm() where it used to call
+// Gemm::gemm_packed; what runs depends on the state:
+//
+//   Float        the float GEMM, unchanged
+//   Calibrating  the float GEMM, recording the range of every input it sees
+//   Quantized    QGemm on int8 weights (per output channel scales) and int8
+//                activations (the calibrated range), dequantised in the epilogue
+//
+// Quantised weights are stored in a weight file as an Int8 tensor under the
+// float weight's name, plus <name>_scale (n, 1) and <name>_input_quant
+// (1, 2: scale, zero point); load_weight() recognises them.
+//
+// The activations are quantised into the calling thread's Workspace, so a
+// steady-state forward does not allocate.
+template <typename T>
+class QuantizedLinearT {
+public:
+    enum class State { Float, Calibrating, Quantized };
+
+    // One Linear of a model, as listed for calibration and export
+    struct Slot {
+        std::string name;               // Weight tensor name, e.g. "classifier/mlp_head_1_weight"
+        const MatrixT<T>* weight;       // Float weight (out_features, in_features)
+        QuantizedLinearT* linear;
+        Gemm::PackedMatrix<T>* packed;  // The layer's packed float W^T
+    };
+
+    // Read-only Slot, as listed by a const model
+    struct ConstSlot {
+        std::string name;
+        const MatrixT<T>* weight;
+        const QuantizedLinearT* linear;
+        const Gemm::PackedMatrix<T>* packed;
+    };
+
+    QuantizedLinearT();
+
+    // C (m x n) = A (m x k) * W^T, with the Gemm::gemm_packed contract;
+    // float_weights is the layer's packed float W^T
+    void gemm(size_t m, const T* a, size_t lda, const Gemm::PackedMatrix<T>& float_weights, T* c, size_t ldc,
+              const Gemm::Epilogue<T>& epilogue);
+
+    // Forget any previous range and record inputs from the next forwards on
+    void start_calibration();
+
+    // Quantise weight per output channel and freeze the calibrated input
+    // range; needs at least one calibrated forward
+    void quantize(const MatrixT<T>& weight);
+
+    // Adopt already quantised weights: q is (n, k) row-major
+    void set_quantized(const int8_t* q, size_t n, size_t k, const float* scales,
+                       const QGemm::ActivationParams& input_params);
+
+    // Back to the float path
+    void clear();
+
+    // Weight tensor `name` of a weight file as float. An Int8 tensor comes
+    // back dequantised and puts this linear in the Quantized state; a float
+    // one puts it back to Float.
+    MatrixT<T> load_weight(const WeightFile& weights, const std::string& name);
+
+    static std::string scale_tensor_name(const std::string& weight_name) { return weight_name + "_scale"; }
+    static std::string input_tensor_name(const std::string& weight_name) { return weight_name + "_input_quant"; }
+
+    // Getters
+    State get_state() const { return state; }
+    bool is_quantized() const { return state == State::Quantized; }
+    const QGemm::PackedWeights& get_weights() const { return weights; }
+    const QGemm::ActivationParams& get_input_params() const { return input_params; }
+    float get_observed_min() const { return observed_min; }
+    float get_observed_max() const { return observed_max; }
+
+private:
+    State state;
+    QGemm::PackedWeights weights;
+    QGemm::ActivationParams input_params;
+    float observed_min;
+    float observed_max;
+    size_t observed_rows;
+
+    void observe(size_t m, size_t k, const T* a, size_t lda);
+};
+
+using QuantizedLinear = QuantizedLinearT<float>;
+
+extern template class QuantizedLinearT<float>;
+extern template class QuantizedLinearT<double>;
+
+#endif //QUANTIZED_LINEAR_H
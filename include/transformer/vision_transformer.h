@@ -0,0 +1,203 @@
+//
+// Created by JAYAN on 28/07/2025.
+//
+
+#ifndef VISION_TRANSFORMER_H
+#define VISION_TRANSFORMER_H
+
+#include "../matrix/matrix.h"
+#include "../matrix/gemm.h"
+#include "../utils/weight_file.h"
+#include "embedding.h"
+#include "layer_norm.h"
+#include "attention.h"
+#include "mlp.h"
+#include "quantized_linear.h"
+#include <string>
+#include <vector>
+
+// The whole classifier: patch embedding, num_layers pre-norm encoder blocks
+//
+//   x = x + attention(norm_1(x))
+//   x = x + mlp(norm_2(x))
+//
+// and the mlp_head (LayerNorm then Linear) applied to each image's class token.
+// Layer count, widths and class count come from the weights; the head count
+// does not, so it is a constructor argument.
+//
+// Activation memory is planned once per max batch rather than allocated per
+// call. reserve() runs a shape-inference pass over one forward for max_batch
+// images, records when each intermediate buffer is first written and last
+// read, and packs the buffers into a single arena so that buffers whose
+// lifetimes do not overlap share storage (the attention and MLP scratch
+// share one region; the classifier input reuses the normalised activations).
+// Every layer then runs on views into the arena through its workspace
+// overload, so a steady-state forward for up to max_batch images makes no
+// heap allocations, on any thread count; only the first forward may still
+// grow per-thread scratch (GEMM packing buffers, Workspace, job records).
+// A forward is not thread-safe on a shared instance.
+//
+// Every Linear (patch projection, QKV and output projections, both MLP
+// layers, classifier) can be switched to int8 post-training quantisation:
+// start_calibration(), calibrate() on a sample of images, then quantize();
+// or load a weight file written by tools/quantize_weights. LayerNorm,
+// softmax, GELU and the residual stream stay in floating point.
+//
+// Independently, set_weight_storage(BFloat16 or Float16) keeps every packed
+// Linear weight in 16 bits, widened to float inside the GEMM: half the
+// packed weight memory and half the weight bytes streamed per forward, which
+// is what small batches are bound by. It applies to weights loaded later too,
+// so it can be set before load_weights.
+//
+// Every weight is put in the layout its kernel reads once, at load: Linear
+// weights transposed and packed into GEMM panels, bias and LayerNorm vectors
+// as contiguous rows, the class token combined with its positional
+// embedding. The packed panels can be cached on disk next to a weight file
+// (load_weights with a cache path); later starts map them instead of
+// packing, and native panels are shared through the page cache like the
+// weights themselves.
+//
+// Templated on element type; VisionTransformer (float) is the default.
+template <typename T>
+class VisionTransformerT {
+public:
+    struct EncoderBlock {
+        LayerNormT<T> norm_1;
+        MultiHeadAttentionT<T> attention;
+        LayerNormT<T> norm_2;
+        MLPT<T> mlp;
+    };
+
+    // One intermediate buffer of the activation plan. Steps number the
+    // forward's stages; encoder blocks all reuse the same buffers, so one
+    // block's stages stand for all of them.
+    struct PlannedBuffer {
+        const char* name;
+        size_t elements;        // Capacity for max_batch images, aligned
+        int first_step;         // Stage that first writes it
+        int last_step;          // Stage that last reads it
+        size_t offset;          // Element offset in the arena
+    };
+
+    explicit VisionTransformerT(size_t max_batch = 1, int num_heads = MultiHeadAttentionT<T>::DEFAULT_NUM_HEADS);
+
+    // Load weights from CSV files; the number of encoder blocks is however
+    // many transformer_layers/transformer_<i>_* sets exist
+    void load_weights(const std::string& base_path);
+
+    // Load weights from a binary weight file (same tensor names, no .csv)
+    void load_weights(const WeightFile& weights);
+
+    // Same, taking the packed Linear weights from the cache file
+    // packed_cache instead of packing them, for every Linear the cache has
+    // under the current weight storage and kernel layout (Gemm::panel_layout).
+    // A cache written for another weight file (size, modification time or
+    // content checksum differ), packed for another storage or kernel layout,
+    // or unreadable is ignored. When anything had to be
+    // packed the cache is rewritten, so the next start adopts every Linear;
+    // failing to write it only prints a warning.
+    // Returns the number of Linears taken from the cache.
+    size_t load_weights(const WeightFile& weights, const std::string& packed_cache);
+
+    // Write the packed Linear weights as a cache for load_weights, tagged
+    // with the weight file they were loaded from. The file is replaced
+    // atomically, so models still using an older cache are unaffected.
+    void save_packed_weights(const std::string& path, const WeightFile& source);
+
+    // Forward pass: (images * num_patches, patch_dim) patches, as the
+    // DatasetReader produces them, to (images, num_classes) logits
+    MatrixT<T> forward(const MatrixT<T>& patches);
+
+    // Same, writing the logits into a caller-owned view. Allocation-free for
+    // images <= max_batch; more images than that is an error.
+    void forward(const ConstMatrixViewT<T>& patches, const MatrixViewT<T>& logits);
+
+    // Re-plan the activation arena for up to max_batch images per forward
+    void reserve(size_t max_batch);
+
+    // Attention loop of every encoder block; re-plans, since Standard keeps
+    // a score matrix that Tiled does not
+    void set_attention_kernel(AttentionKernel kernel);
+    AttentionKernel get_attention_kernel() const { return attention_kernel; }
+
+    // Record the input range of every Linear over the following calibrate()
+    // (or forward) calls
+    void start_calibration();
+
+    // Forward a calibration sample (any number of images, run max_batch at a
+    // time), logits discarded
+    void calibrate(const ConstMatrixViewT<T>& patches);
+
+    // Quantise every Linear to int8 with the recorded ranges
+    void quantize();
+
+    // Back to the float path everywhere
+    void dequantize();
+
+    // Element format of every packed Linear weight; re-packs what is loaded
+    void set_weight_storage(Gemm::Storage storage);
+    Gemm::Storage get_weight_storage() const { return weight_storage; }
+
+    // Bytes held by the packed Linear weights
+    size_t get_packed_weight_bytes() const;
+
+    // Every Linear by weight tensor name, in forward order
+    std::vector<typename QuantizedLinearT<T>::Slot> get_linears();
+    std::vector<typename QuantizedLinearT<T>::ConstSlot> get_linears() const;
+
+    // Linears currently running in int8
+    size_t get_quantized_count() const;
+
+    // Getters
+    const PatchEmbeddingT<T>& get_embedding() const { return embedding; }
+    const std::vector<EncoderBlock>& get_blocks() const { return blocks; }
+    const LayerNormT<T>& get_head_norm() const { return head_norm; }
+    const MatrixT<T>& get_head_weight() const { return head_weight; }
+    const MatrixT<T>& get_head_bias() const { return head_bias; }
+    size_t get_num_layers() const { return blocks.size(); }
+    int get_num_heads() const { return num_heads; }
+    int get_d_model() const { return embedding.get_features(); }
+    int get_num_classes() const { return static_cast<int>(head_weight.getRows()); }
+    size_t get_max_batch() const { return max_batch; }
+    const std::vector<PlannedBuffer>& get_memory_plan() const { return plan; }
+    size_t get_arena_bytes() const { return arena.size() * sizeof(T); }
+
+private:
+    PatchEmbeddingT<T> embedding;
+    std::vector<EncoderBlock> blocks;
+    LayerNormT<T> head_norm;            // mlp_head_0
+    MatrixT<T> head_weight;             // mlp_head_1: (num_classes, d_model)
+    MatrixT<T> head_bias;               // (1, num_classes)
+    Gemm::PackedMatrix<T> head_packed;  // head_weight^T packed for the GEMM
+    QuantizedLinearT<T> head_quantized;
+
+    int num_heads;
+    Gemm::Storage weight_storage;
+    AttentionKernel attention_kernel;
+    size_t max_batch;
+
+    std::vector<PlannedBuffer> plan;    // Indexed by the Buffer enum in the .cpp
+    MatrixT<T> arena;                   // (1, arena elements), every activation lives here
+
+    // Tensor name relative to the weights root, e.g.
+    // "classifier/mlp_head_1_weight"
+    static std::string head_tensor_name(int index, const std::string& param);
+    static std::string block_probe_name(size_t layer_idx);
+    // Cache tensor holding the packed form of a Linear's weight
+    std::string packed_tensor_name(const std::string& weight_name) const;
+
+    // load_weights from a weight file; pack = false leaves every packed
+    // Linear weight to the caller
+    void read_weights(const WeightFile& weights, bool pack);
+    void set_head_weights(MatrixT<T> norm_weight, MatrixT<T> norm_bias, MatrixT<T> weight, MatrixT<T> bias,
+                          bool pack = true);
+    void configure_blocks();
+    void plan_memory();
+};
+
+using VisionTransformer = VisionTransformerT<float>;
+
+extern template class VisionTransformerT<float>;
+extern template class VisionTransformerT<double>;
+
+#endif //VISION_TRANSFORMER_H
@@ -0,0 +1,96 @@
+//
+// Created by JAYAN on 08/08/2025.
+//
+
+#ifndef ALLOCATION_TRACKER_H
+#define ALLOCATION_TRACKER_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+// Process-wide counters on Matrix storage: every buffer a MatrixT allocates or
+// frees (constructors, copies, resize, the returning MatrixOps forms) is
+// reported here while tracking is enabled. Borrowed storage (weight file
+// mappings, Workspace slices) is not Matrix-owned and is not counted.
+//
+// Tracking is off by default; when off the hook is one relaxed atomic load
+// per allocation. Counters are global across threads. live_bytes counts from
+// the last reset(), so buffers allocated before it and freed after make it
+// negative.
+//
+// Scope reports what happened between its construction and stats(), including
+// the peak live bytes above the level it started at. Each open scope keeps its
+// own high-water mark, so scopes may nest or be open on several threads at
+// once (up to MAX_SCOPES).
+//
+//   AllocationTracker::set_enabled(true);
+//   AllocationTracker::Scope scope;
+//   vit.forward(patches, logits.view());
+//   AllocationTracker::check_budget(scope.stats(), 0, 0, "forward");
+namespace AllocationTracker {
+
+    // Power-of-two size classes: bucket b holds sizes in [2^(b-1), 2^b),
+    // bucket 0 is unused (storage is at least one 64-byte line)
+    constexpr size_t HISTOGRAM_BUCKETS = 48;
+
+    // Scopes open at the same time, across all threads
+    constexpr size_t MAX_SCOPES = 64;
+
+    struct Stats {
+        uint64_t allocations = 0;
+        uint64_t frees = 0;
+        uint64_t allocated_bytes = 0;   // Total requested, freed or not
+        int64_t live_bytes = 0;         // Allocated minus freed
+        int64_t peak_bytes = 0;         // Highest live_bytes reached
+        std::array<uint64_t, HISTOGRAM_BUCKETS> histogram{};   // Allocations per size class
+    };
+
+    namespace detail {
+        extern std::atomic<bool> enabled;
+    }
+
+    inline bool enabled() { return detail::enabled.load(std::memory_order_relaxed); }
+    void set_enabled(bool on);
+
+    // Zero every counter
+    void reset();
+
+    // Counters since the last reset()
+    Stats snapshot();
+
+    // Hooks called by Matrix storage
+    void record_allocation(size_t bytes);
+    void record_free(size_t bytes);
+
+    // Size class of an allocation of `bytes`
+    size_t bucket(size_t bytes);
+
+    class Scope {
+    public:
+        Scope();
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        // Counters since construction; peak_bytes is the highest live level
+        // reached above the one at construction
+        Stats stats() const;
+
+    private:
+        size_t slot;            // This scope's high-water mark, raised by record_allocation
+        Stats start;
+    };
+
+    // Throws std::runtime_error naming `what` when stats exceed either limit
+    void check_budget(const Stats& stats, uint64_t max_allocations, uint64_t max_bytes, const std::string& what);
+
+    // Counts, live/peak bytes and the non-empty histogram buckets
+    void print_stats(const Stats& stats, std::ostream& os = std::cout);
+}
+
+#endif //ALLOCATION_TRACKER_H
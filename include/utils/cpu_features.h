@@ -0,0 +1,35 @@
+//
+// Created by JAYAN on 24/07/2025.
+//
+
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+// Runtime instruction-set detection shared by the SIMD kernels (GEMM
+// micro-kernels, fused row kernels). Kernels are compiled per ISA with
+// __attribute__((target(...))) and picked once at startup, so the same
+// binary runs on any x86-64 CPU.
+namespace CpuFeatures {
+
+    enum class IsaLevel { Scalar, Avx2, Avx512 };
+
+    // Best level this CPU supports (AVX2 implies FMA here)
+    IsaLevel supported_isa();
+
+    // supported_isa(), unless the environment variable env_var names a lower
+    // supported level ("scalar", "avx2", "avx512")
+    IsaLevel select_isa(const char* env_var);
+
+    // Level used by the row kernels: select_isa("VIT_ISA"), cached
+    IsaLevel active_isa();
+
+    // AVX-512 VNNI (vpdpbusd), used by the int8 GEMM on top of Avx512
+    bool supports_avx512_vnni();
+
+    // F16C (vcvtph2ps), used by the AVX2 GEMM kernel on half-precision weights
+    bool supports_f16c();
+
+    const char* isa_name(IsaLevel level);
+}
+
+#endif //CPU_FEATURES_H
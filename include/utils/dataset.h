@@ -0,0 +1,120 @@
+//
+// Created by JAYAN on 23/07/2025.
+//
+
+#ifndef DATASET_H
+#define DATASET_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../matrix/matrix.h"
+
+// Streaming reader for image datasets too large to hold in memory: MNIST IDX
+// files (train/t10k-images-idx3-ubyte + labels-idx1-ubyte) or CSVs with one
+// image per line (optionally led by its label, as in the usual mnist_test.csv).
+//
+// A background thread reads and assembles up to `prefetch` batches ahead of
+// the consumer, so memory stays bounded at prefetch + 2 batches no matter
+// how many images the source holds. Batch buffers are recycled: the batch
+// passed to next() is handed back to the producer, so the steady state does
+// not allocate.
+//
+// Images come out already split into non-overlapping patch_size x patch_size
+// patches, one patch per row in row-major grid order, which is the layout
+// PatchEmbedding::forward takes: a 28x28 image with patch_size 7 becomes
+// 16 rows of 49 pixels. patch_size 0 keeps each image as a single flat row.
+
+template <typename T>
+struct ImageBatchT {
+    MatrixT<T> patches;             // (count * patches_per_image, patch_dim)
+    std::vector<int> labels;        // One per image, -1 when the source has none
+    size_t count = 0;               // Images in this batch (the last one may be short)
+    size_t first_index = 0;         // Dataset index of the first image
+};
+
+struct DatasetOptions {
+    size_t batch_size = 64;
+    size_t patch_size = 7;          // 0: one flat row per image
+    size_t prefetch = 2;            // Batches assembled ahead of the consumer
+    size_t limit = 0;               // Stop after this many images (0: whole source)
+    double pixel_scale = 1.0 / 255; // Pixel value p becomes (p * pixel_scale - mean) / stddev
+    double mean = 0.0;
+    double stddev = 1.0;
+
+    // CSV sources only
+    bool has_header = false;
+    bool has_label = true;          // First column is the label
+    size_t image_rows = 28;
+    size_t image_cols = 28;
+};
+
+template <typename T>
+class DatasetReaderT {
+public:
+    // Where the raw pixels come from. Sources are read only by the prefetch
+    // thread.
+    class Source {
+    public:
+        virtual ~Source() = default;
+        virtual size_t image_rows() const = 0;
+        virtual size_t image_cols() const = 0;
+        // Read up to max_images images into pixels (image_rows * image_cols
+        // each) and labels; returns how many were read, 0 at the end.
+        virtual size_t read(size_t max_images, std::vector<float>& pixels, int* labels) = 0;
+    };
+
+    // MNIST IDX image file, with an optional (empty path) IDX label file
+    static std::unique_ptr<DatasetReaderT> open_idx(const std::string& images_path, const std::string& labels_path,
+                                                    const DatasetOptions& options = DatasetOptions());
+    static std::unique_ptr<DatasetReaderT> open_csv(const std::string& path,
+                                                    const DatasetOptions& options = DatasetOptions());
+
+    DatasetReaderT(std::unique_ptr<Source> source, const DatasetOptions& options);
+    ~DatasetReaderT();
+    DatasetReaderT(const DatasetReaderT&) = delete;
+    DatasetReaderT& operator=(const DatasetReaderT&) = delete;
+
+    // Replace batch with the next one; returns false once the source is
+    // exhausted. Errors from the reader thread are rethrown here.
+    bool next(ImageBatchT<T>& batch);
+
+    size_t patches_per_image() const { return grid_rows * grid_cols; }
+    size_t patch_dim() const { return patch_rows * patch_cols; }
+    size_t images_read() const { return delivered; }
+
+private:
+    std::unique_ptr<Source> source;
+    DatasetOptions options;
+    size_t patch_rows, patch_cols;
+    size_t grid_rows, grid_cols;
+    size_t delivered;
+
+    std::mutex mutex;
+    std::condition_variable ready_cv;   // Producer -> consumer
+    std::condition_variable space_cv;   // Consumer -> producer
+    std::deque<ImageBatchT<T>> ready;   // Assembled batches waiting for next()
+    std::vector<ImageBatchT<T>> spare;  // Recycled buffers for the producer
+    bool finished;
+    bool stopping;
+    std::exception_ptr error;
+    std::thread producer;
+
+    void produce();
+    void assemble(const std::vector<float>& pixels, size_t count, ImageBatchT<T>& batch) const;
+};
+
+using ImageBatch = ImageBatchT<float>;
+using DatasetReader = DatasetReaderT<float>;
+
+extern template class DatasetReaderT<float>;
+extern template class DatasetReaderT<double>;
+
+#endif //DATASET_H
@@ -1,31 +1,37 @@
-//
-// Created by JAYAN on 01/07/2025.
-//
-
-#ifndef FILE_IO_H
-#define FILE_IO_H
-
-#include <string>
-#include <vector>
-#include "../matrix/matrix.h"
-
-namespace FileIO {
-    
-    // Load matrix from CSV file
-    Matrix load_matrix_from_csv(const std::string& filename, bool has_header = false);
-    
-    // Load vector from CSV file (single column or row)
-    std::vector<double> load_vector_from_csv(const std::string& filename, bool has_header = false);
-    
-    // Load vector from CSV file as Matrix (single row vector)
-    Matrix load_vector_as_matrix(const std::string& filename, bool has_header = false);
-    
-    // Save matrix to CSV file
-    void save_matrix_to_csv(const Matrix& matrix, const std::string& filename);
-    
-    // Utility functions
-    std::vector<std::string> split_string(const std::string& str, char delimiter);
-    bool file_exists(const std::string& filename);
-}
-
+//
+// Created by JAYAN on 01/07/2025.
+//
+
+#ifndef FILE_IO_H
+#define FILE_IO_H
+
+#include <string>
+#include <vector>
+#include "../matrix/matrix.h"
+
+// Matrix loaders are templates over the element type (double by default) so
+// callers can parse straight into the precision they run at, e.g.
+// load_matrix_from_csv<float>(path, true). Instantiated for float and double.
+namespace FileIO {
+    
+    // Load matrix from CSV file
+    template <typename T = double>
+    MatrixT<T> load_matrix_from_csv(const std::string& filename, bool has_header = false);
+    
+    // Load vector from CSV file (single column or row)
+    std::vector<double> load_vector_from_csv(const std::string& filename, bool has_header = false);
+    
+    // Load vector from CSV file as Matrix (single row vector)
+    template <typename T = double>
+    MatrixT<T> load_vector_as_matrix(const std::string& filename, bool has_header = false);
+    
+    // Save matrix to CSV file
+    template <typename T>
+    void save_matrix_to_csv(const MatrixT<T>& matrix, const std::string& filename);
+    
+    // Utility functions
+    std::vector<std::string> split_string(const std::string& str, char delimiter);
+    bool file_exists(const std::string& filename);
+}
+
 #endif //FILE_IO_H
\ No newline at end of file
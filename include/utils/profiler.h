@@ -0,0 +1,130 @@
+//
+// Created by JAYAN on 07/08/2025.
+//
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Built-in tracing for the inference pipeline. Every layer forward
+// (PatchEmbedding, LayerNorm, attention, MLP, classifier) and every MatrixOps
+// kernel opens a Scope; while profiling is enabled each scope records its
+// start and duration (steady clock, ns), the FLOPs and operand bytes it was
+// handed, and the Matrix storage allocations made on its thread. Scopes nest,
+// so the summary separates a scope's own time from its children's.
+//
+// Cost: with profiling disabled (the default) a scope is one relaxed atomic
+// load and a branch; building with -DVIT_PROFILING=0 removes the scopes
+// entirely. Enabled, a scope costs two clock reads and an append to its
+// thread's event buffer.
+//
+// Events go to per-thread buffers, so scopes inside parallel_for workers are
+// recorded on their own track. reset(), summary() and the exporters must not
+// run while profiled work is in flight.
+//
+// Usage:
+//   Profiler::set_enabled(true);
+//   vit.forward(patches, logits);
+//   Profiler::print_summary();
+//   Profiler::write_chrome_trace("trace.json");    // chrome://tracing, Perfetto
+#ifndef VIT_PROFILING
+#define VIT_PROFILING 1
+#endif
+
+namespace Profiler {
+
+    namespace detail {
+        extern std::atomic<bool> enabled;
+    }
+
+    inline bool enabled() { return detail::enabled.load(std::memory_order_relaxed); }
+    void set_enabled(bool on);
+
+    // Drop every recorded event and restart the trace clock
+    void reset();
+
+    // Matrix storage allocated on the calling thread, credited to the scopes
+    // open on it. Called by Matrix storage allocation while profiling is on.
+    void note_allocation(size_t bytes);
+
+    class Scope {
+    public:
+        // name and category must be string literals (they are kept by pointer)
+        Scope(const char* category, const char* name, double flops = 0.0, double bytes = 0.0)
+            : active(enabled()) {
+            if (active) {
+                begin(category, name, flops, bytes);
+            }
+        }
+        ~Scope() {
+            if (active) {
+                end();
+            }
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        void begin(const char* category, const char* name, double flops, double bytes);
+        void end();
+
+        bool active;
+        const char* category;
+        const char* name;
+        double flops;
+        double bytes;
+        uint64_t start_ns;
+        uint64_t child_ns;              // Time spent in nested scopes
+        uint64_t allocations_start;
+        uint64_t allocated_bytes_start;
+        Scope* parent;
+    };
+
+    // One row of the flat summary: every call of a (category, name) pair.
+    // Allocations include nested scopes; self_ns does not.
+    struct Summary {
+        std::string category;
+        std::string name;
+        size_t calls;
+        double total_ns;
+        double self_ns;
+        double flops;
+        double bytes;
+        uint64_t allocations;
+        uint64_t allocated_bytes;
+    };
+
+    // Rows sorted by self time, largest first
+    std::vector<Summary> summary();
+
+    // Table of summary(): calls, total/self ms, share of self time, GFLOP/s,
+    // GB/s and allocations
+    void print_summary(std::ostream& os = std::cout);
+
+    // Chrome trace event format ("X" complete events, one track per thread,
+    // work and allocation counts under args)
+    void write_chrome_trace(std::ostream& os);
+    void write_chrome_trace(const std::string& filename);
+}
+
+#if VIT_PROFILING
+#define VIT_PROFILE_CONCAT_INNER(a, b) a##b
+#define VIT_PROFILE_CONCAT(a, b) VIT_PROFILE_CONCAT_INNER(a, b)
+// Profile the rest of the enclosing block; flops and bytes are only
+// evaluated while profiling is enabled
+#define VIT_PROFILE_SCOPE(category, name, flops, bytes)                                           \
+    ::Profiler::Scope VIT_PROFILE_CONCAT(vit_profile_scope_, __LINE__)(                          \
+        category, name, ::Profiler::enabled() ? static_cast<double>(flops) : 0.0,                \
+        ::Profiler::enabled() ? static_cast<double>(bytes) : 0.0)
+#else
+#define VIT_PROFILE_SCOPE(category, name, flops, bytes) ((void)0)
+#endif
+
+#endif //PROFILER_H
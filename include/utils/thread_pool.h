@@ -0,0 +1,131 @@
+//
+// Created by JAYAN on 15/07/2025.
+//
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Process-wide pool of persistent workers used by the matrix kernels.
+//
+// parallel_for splits a range into chunks and hands "help with this job"
+// tokens to every worker's queue. Workers pop their own queue first and
+// steal from the others when it runs dry; the calling thread works on the
+// same job until every chunk is done. A caller only ever runs chunks of its
+// own job, so nested parallel_for calls (e.g. a GEMM inside a parallel
+// attention head) cannot deadlock or interleave thread-local scratch.
+//
+// Steady state makes no heap allocations: each calling thread reuses its
+// job records (one per nesting level, created on first use) and the queues
+// are fixed-capacity rings. Tokens carry the job's id, so a token still
+// queued after its job finished is recognised and dropped. When a ring is
+// full the token is not queued and the caller does that share itself.
+//
+// Thread count: VIT_NUM_THREADS if set, otherwise hardware_concurrency();
+// ThreadPool::set_num_threads overrides it at runtime.
+class ThreadPool {
+public:
+    // Non-owning reference to a callable taking (begin, end). parallel_for
+    // only calls the body while it runs, so unlike std::function (whose small
+    // buffer most capturing lambdas overflow) binding one never allocates.
+    class RangeFunction {
+    public:
+        template <typename F,
+                  typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, RangeFunction>>>
+        RangeFunction(F&& body)
+            : object(const_cast<void*>(static_cast<const void*>(std::addressof(body)))),
+              invoke([](void* object, size_t begin, size_t end) {
+                  (*static_cast<std::remove_reference_t<F>*>(object))(begin, end);
+              }) {}
+
+        void operator()(size_t begin, size_t end) const { invoke(object, begin, end); }
+
+    private:
+        void* object;
+        void (*invoke)(void* object, size_t begin, size_t end);
+    };
+
+    static ThreadPool& instance();
+
+    // Total threads taking part in a parallel_for, including the caller.
+    size_t num_threads() const { return workers.size() + 1; }
+
+    // Restart the pool with n threads (n >= 1). Must not be called while
+    // parallel work is in flight.
+    static void set_num_threads(size_t n);
+
+    // Run body over [begin, end) in chunks of at least `grain` items and wait
+    // for completion. Runs inline when the range fits in one chunk or the
+    // pool has a single thread. The first exception thrown by body is
+    // rethrown to the caller.
+    void parallel_for(size_t begin, size_t end, size_t grain, const RangeFunction& body);
+
+    // Run body(i, i + 1) exactly once on each of the num_threads() threads
+    // and wait: i is the worker's index, num_threads() - 1 for the caller.
+    // For setting up per-thread state (scratch buffers) ahead of time. Must
+    // not be called from inside parallel work. The first exception thrown by
+    // body is rethrown to the caller.
+    void run_on_each_thread(const RangeFunction& body);
+
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+private:
+    struct Job;
+    struct JobStack;
+
+    struct Token {
+        Job* job;
+        uint64_t id;        // Job::id when queued; stale once it changes
+    };
+
+    // Tokens per worker queue
+    static constexpr size_t QUEUE_CAPACITY = 64;
+
+    struct WorkQueue {
+        std::mutex mutex;
+        std::array<Token, QUEUE_CAPACITY> tokens;
+        size_t head = 0;    // Oldest token
+        size_t count = 0;
+        const RangeFunction* pinned = nullptr;  // run_on_each_thread body for this worker only
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::mutex jobs_mutex;
+    std::vector<std::unique_ptr<Job>> jobs;     // Every job record, kept for the pool's lifetime
+    std::vector<Job*> free_jobs;                // Records of exited threads, for reuse
+    std::atomic<size_t> pinned_remaining;       // Workers yet to run the run_on_each_thread body
+    std::mutex pinned_mutex;
+    std::exception_ptr pinned_error;
+    std::mutex sleep_mutex;
+    std::condition_variable wake;
+    std::atomic<size_t> pending_tokens;
+    std::atomic<size_t> next_queue;
+    bool stopping;
+
+    explicit ThreadPool(size_t n);
+    void start(size_t n);
+    void stop();
+    void worker_loop(size_t index);
+    bool take_token(size_t index, Token& token);
+    bool run_pinned(size_t index);
+    static JobStack& job_stack();
+    Job* acquire_job();
+    void release_job(Job* job);
+    static void run_chunks(Job& job);
+};
+
+#endif //THREAD_POOL_H
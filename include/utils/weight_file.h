@@ -0,0 +1,101 @@
+//
+// Created by JAYAN on 21/07/2025.
+//
+
+#ifndef WEIGHT_FILE_H
+#define WEIGHT_FILE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "../matrix/matrix.h"
+
+// Single-file binary model container (.vitw).
+//
+// Layout (little endian):
+//   header    64 bytes: magic "VITW", version, tensor count, directory offset/size
+//   directory one entry per tensor: name, dtype, rows, cols, data offset, byte size
+//   data      raw row-major tensors, each starting on a 64-byte boundary
+//
+// Tensors are keyed by their path in the weights_organized/ tree without the
+// .csv extension, e.g. "transformer_layers/transformer_0_layer_norm_1_weight".
+// open() maps the file private (copy-on-write), so matrices returned by get()
+// point straight into the mapping and clean pages are shared between
+// processes through the page cache.
+class WeightFile : public std::enable_shared_from_this<WeightFile> {
+public:
+    enum class DType : uint32_t {
+        Float32 = 0,
+        Float64 = 1,
+        Int8 = 2,       // Quantised weights; see QuantizedLinearT
+        BFloat16 = 3,   // 16-bit floats as raw bits, see half.h
+        Float16 = 4,
+    };
+
+    struct TensorInfo {
+        DType dtype;
+        size_t rows;
+        size_t cols;
+        size_t offset;      // Byte offset of the data from the start of the file
+        size_t bytes;
+    };
+
+    // A tensor to write in any dtype; data is rows * cols packed elements
+    struct RawTensor {
+        std::string name;
+        DType dtype;
+        size_t rows;
+        size_t cols;
+        const void* data;
+    };
+
+    ~WeightFile();
+    WeightFile(const WeightFile&) = delete;
+    WeightFile& operator=(const WeightFile&) = delete;
+
+    // Map a container. Matrices returned by get() keep the mapping alive.
+    static std::shared_ptr<WeightFile> open(const std::string& path);
+
+    // Write a container. Tensors are stored in the element type they are given.
+    template <typename T>
+    static void write(const std::string& path, const std::vector<std::pair<std::string, MatrixT<T>>>& tensors);
+    static void write(const std::string& path, const std::vector<RawTensor>& tensors);
+
+    bool contains(const std::string& name) const;
+    const TensorInfo& info(const std::string& name) const;
+    std::vector<std::string> names() const;
+    size_t tensor_count() const { return directory.size(); }
+    const std::string& path() const { return file_path; }
+
+    // Borrowed view into the mapping when the stored dtype matches T,
+    // otherwise an owned converted copy (Int8 values are converted as they
+    // are, without any scale; 16-bit floats are widened exactly).
+    template <typename T>
+    MatrixT<T> get(const std::string& name) const;
+
+    // Stored bytes of a tensor, in its own dtype
+    const void* raw(const std::string& name) const;
+
+    // 64-bit hash of the whole file (FNV-1a over 8-byte words), to tell
+    // whether something derived from it is stale
+    uint64_t checksum() const;
+
+private:
+    WeightFile() = default;
+
+    std::string file_path;
+    void* mapping = nullptr;
+    size_t mapping_size = 0;
+    std::unordered_map<std::string, TensorInfo> directory;
+    std::vector<std::string> order;         // Names in file order
+};
+
+extern template MatrixT<float> WeightFile::get<float>(const std::string&) const;
+extern template MatrixT<double> WeightFile::get<double>(const std::string&) const;
+extern template void WeightFile::write<float>(const std::string&, const std::vector<std::pair<std::string, MatrixF>>&);
+extern template void WeightFile::write<double>(const std::string&, const std::vector<std::pair<std::string, Matrix>>&);
+
+#endif //WEIGHT_FILE_H
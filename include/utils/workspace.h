@@ -0,0 +1,113 @@
+//
+// Created by JAYAN on 29/07/2025.
+//
+
+#ifndef WORKSPACE_H
+#define WORKSPACE_H
+
+#include "../matrix/matrix.h"
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Bump allocator for temporaries. allocate() hands out 64-byte aligned slices
+// of a few large blocks by advancing an offset; nothing is freed one by one.
+// reset() (or the end of a Scope) rewinds the offset, so a request that
+// builds the same temporaries every time settles into reusing the same
+// memory without touching malloc.
+//
+// When a round outgrows the current block another block is chained on; the
+// next reset() merges the chain into one block as large as the whole round,
+// so after the first few requests everything fits in a single block.
+//
+// Memory from a workspace is only valid until the reset (or Scope exit) that
+// rewinds past it: matrices returned by matrix() and by the MatrixOps /
+// ActivationFunctions overloads taking a Workspace must not outlive it.
+//
+// A workspace is not thread-safe; each thread uses its own, normally
+// Workspace::local().
+class Workspace {
+public:
+    static constexpr size_t DEFAULT_BLOCK_BYTES = size_t(1) << 20;
+    static constexpr size_t ALIGNMENT = 64;
+
+    explicit Workspace(size_t block_bytes = DEFAULT_BLOCK_BYTES);
+    ~Workspace();
+
+    Workspace(const Workspace&) = delete;
+    Workspace& operator=(const Workspace&) = delete;
+
+    // The calling thread's workspace
+    static Workspace& local();
+
+    // Uninitialised storage for count elements of T
+    template <typename T>
+    T* allocate(size_t count) {
+        return static_cast<T*>(allocate_bytes(count * sizeof(T)));
+    }
+
+    // rows x cols matrix over workspace storage (contents unspecified). The
+    // matrix borrows the storage: copies of it own their data, and resizing it
+    // moves it to heap storage.
+    template <typename T>
+    MatrixT<T> matrix(size_t rows, size_t cols) {
+        T* data = allocate<T>(rows * cols);
+        // Aliasing constructor: a non-null owner with no control block, so
+        // borrowing allocates nothing
+        return MatrixT<T>::borrow(data, rows, cols, std::shared_ptr<const void>(std::shared_ptr<const void>(), data));
+    }
+
+    // Release everything handed out so far
+    void reset();
+
+    // Rewinds the workspace on destruction to where it stood on construction,
+    // e.g. around one request or one layer's temporaries
+    class Scope {
+    public:
+        explicit Scope(Workspace& workspace);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Workspace& workspace;
+        size_t block;
+        size_t offset;
+    };
+
+    // Statistics
+    size_t bytes_in_use() const;
+    size_t capacity() const;
+    size_t peak_bytes() const { return peak; }
+
+private:
+    struct Block {
+        std::byte* data;
+        size_t size;
+    };
+
+    std::vector<Block> blocks;
+    size_t current;         // Block being bumped
+    size_t offset;          // Bytes used in blocks[current]
+    size_t block_bytes;     // Minimum size of a new block
+    size_t peak;            // Largest bytes_in_use() seen
+
+    void* allocate_bytes(size_t bytes);
+    void add_block(size_t bytes);
+    void release_blocks();
+};
+
+// rows x cols matrix with unspecified contents: from the workspace when one is
+// given, otherwise on the heap. Shared by the ops that take an optional
+// Workspace for their result.
+template <typename T>
+MatrixT<T> scratch_matrix(size_t rows, size_t cols, Workspace* workspace) {
+    if (workspace) {
+        return workspace->matrix<T>(rows, cols);
+    }
+    MatrixT<T> result;
+    result.resize_for_overwrite(rows, cols);
+    return result;
+}
+
+#endif //WORKSPACE_H
@@ -1,10 +1,27 @@
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <thread>
+#include <vector>
 #include "include/matrix/matrix.h"
 #include "include/matrix/matrix_ops.h"
 #include "include/matrix/activation_functions.h"
+#include "include/matrix/half.h"
+#include "include/matrix/qgemm.h"
+#include "include/utils/allocation_tracker.h"
 #include "include/utils/file_io.h"
+#include "include/utils/profiler.h"
+#include "include/utils/weight_file.h"
+#include "include/utils/workspace.h"
 #include "include/transformer/layer_norm.h"
 #include "include/transformer/embedding.h"
+#include "include/transformer/attention.h"
+#include "include/transformer/mlp.h"
+#include "include/transformer/vision_transformer.h"
+#include "include/transformer/batched_inference.h"
 
 void test_original_functionality() {
     std::cout << "=== PRUEBA ORIGINAL: Carga de Pesos ===" << std::endl;
@@ -36,8 +53,8 @@ void test_day2_components() {
         layer_norm.load_weights("weights_organized", 0, "layer_norm_1");
         
         // Crear entrada de prueba (simula embeddings de patches)
-        Matrix test_input = Matrix::random(2, 256);  // batch_size=2, features=256
-        Matrix norm_output = layer_norm.forward(test_input);
+        MatrixF test_input = MatrixF::random(2, 256);  // batch_size=2, features=256
+        MatrixF norm_output = layer_norm.forward(test_input);
         
         std::cout << "✅ LayerNorm funciona correctamente" << std::endl;
         std::cout << "   Entrada: " << test_input.getRows() << "x" << test_input.getCols() << std::endl;
@@ -45,12 +62,12 @@ void test_day2_components() {
         
         // Test 2: PatchEmbedding
         std::cout << "\n2️⃣ Probando PatchEmbedding..." << std::endl;
-        PatchEmbedding patch_embed(49, 256);
+        PatchEmbedding patch_embed(49, 256, 16);
         patch_embed.load_weights("weights_organized");
         
-        // Crear patches de prueba (simula imagen 28x28 dividida en 7x7 = 49 patches)
-        Matrix test_patches = Matrix::random(1, 49);  // batch_size=1, num_patches=49
-        Matrix embed_output = patch_embed.forward(test_patches);
+        // Crear patches de prueba (imagen 28x28 dividida en 16 patches de 7x7 = 49 píxeles)
+        MatrixF test_patches = MatrixF::random(16, 49);  // 1 imagen, 16 patches
+        MatrixF embed_output = patch_embed.forward(test_patches);  // 17 tokens: CLS + 16 patches
         
         std::cout << "✅ PatchEmbedding funciona correctamente" << std::endl;
         std::cout << "   Patches entrada: " << test_patches.getRows() << "x" << test_patches.getCols() << std::endl;
@@ -72,14 +89,578 @@ void test_day2_components() {
     }
 }
 
+void test_workspace() {
+    std::cout << "\n=== PRUEBA: Workspace para temporales ===" << std::endl;
+    try {
+        Matrix x = Matrix::random(17, 256, -1.0f, 1.0f);
+        Matrix w = Matrix::random(256, 64, -0.1f, 0.1f);
+        Matrix heap = ActivationFunctions::gelu(MatrixOps::matmul(x, w));
+
+        Workspace& workspace = Workspace::local();
+        bool same = false;
+        {
+            Workspace::Scope scope(workspace);
+            Matrix product = MatrixOps::matmul(x, w, &workspace);
+            Matrix activated = ActivationFunctions::gelu(product, ActivationFunctions::GeluMode::Tanh, &workspace);
+            same = activated == heap;
+        }
+
+        // Sin asignaciones: el resultado va a una vista existente
+        Matrix out(17, 64);
+        MatrixOps::matmul_into(out.view(), x, w);
+        ActivationFunctions::gelu_into(out.view(), out);
+        same = same && out == heap;
+
+        std::cout << (same ? "✅" : "❌") << " Workspace y _into coinciden con la versión en heap" << std::endl;
+
+        // Expresión perezosa: una sola pasada, sin matrices intermedias
+        Matrix bias = Matrix::random(64, 1, -0.1, 0.1);
+        Matrix fused = MatrixExpr::addBroadcast(heap + out, bias) * 0.5;
+        bool expr_ok = std::abs(fused(3, 5) - (heap(3, 5) + out(3, 5) + bias(5, 0)) * 0.5) < 1e-12;
+        std::cout << (expr_ok ? "✅" : "❌") << " Expresiones perezosas coinciden con el cálculo elemento a elemento"
+                  << std::endl;
+        std::cout << "✅ Workspace: pico " << workspace.peak_bytes() / 1024 << " KiB, en uso tras el scope "
+                  << workspace.bytes_in_use() << " bytes" << std::endl;
+    } catch (const std::exception& e) {
+        std::cout << "❌ Error en pruebas del Workspace: " << e.what() << std::endl;
+    }
+}
+
+void test_weight_file() {
+    std::cout << "\n=== PRUEBA: Archivo binario de pesos ===" << std::endl;
+    const std::string path = "weights.vitw";
+    if (!FileIO::file_exists(path)) {
+        std::cout << "⏭️  " << path << " no existe (genéralo con ./convert_weights)" << std::endl;
+        return;
+    }
+    
+    try {
+        std::shared_ptr<WeightFile> weights = WeightFile::open(path);
+        std::cout << "✅ " << path << " mapeado: " << weights->tensor_count() << " tensores" << std::endl;
+        
+        LayerNorm from_csv;
+        LayerNorm from_binary;
+        from_csv.load_weights("weights_organized", 0, "layer_norm_1");
+        from_binary.load_weights(*weights, 0, "layer_norm_1");
+        
+        PatchEmbedding patch_embed;
+        patch_embed.load_weights(*weights);
+        
+        bool same = from_csv.get_gamma() == from_binary.get_gamma() && from_csv.get_beta() == from_binary.get_beta();
+        std::cout << (same ? "✅" : "❌") << " LayerNorm desde binario coincide con CSV" << std::endl;
+        std::cout << "✅ PatchEmbedding desde binario: " << patch_embed.get_features() << " features, "
+                  << patch_embed.get_num_patches() << " patches" << std::endl;
+    } catch (const std::exception& e) {
+        std::cout << "❌ Error con el archivo binario: " << e.what() << std::endl;
+    }
+}
+
+void test_attention() {
+    std::cout << "\n=== PRUEBAS DÍA 3: Multi-Head Self-Attention ===" << std::endl;
+    
+    try {
+        MultiHeadAttention attention;
+        attention.load_weights("weights_organized", 0);
+        
+        // Dos secuencias de 17 tokens (16 patches + token de clase)
+        const size_t seq_len = 17;
+        MatrixF tokens = MatrixF::random(2 * seq_len, attention.get_d_model());
+        MatrixF output = attention.forward(tokens, seq_len);
+        
+        std::cout << "✅ MultiHeadAttention funciona correctamente" << std::endl;
+        std::cout << "   Entrada: " << tokens.getRows() << "x" << tokens.getCols()
+                  << " (" << attention.get_num_heads() << " cabezas de " << attention.get_head_dim() << ")" << std::endl;
+        std::cout << "   Salida:  " << output.getRows() << "x" << output.getCols() << std::endl;
+        
+        // Cada fila de pesos de atención debe sumar 1
+        const MatrixF& weights = attention.get_attention_weights();
+        double worst = 0.0;
+        for (size_t i = 0; i < weights.getRows(); ++i) {
+            double row_sum = 0.0;
+            for (size_t j = 0; j < weights.getCols(); ++j) {
+                row_sum += weights(i, j);
+            }
+            worst = std::max(worst, std::abs(row_sum - 1.0));
+        }
+        std::cout << (worst < 1e-5 ? "✅" : "❌") << " Pesos de atención suman 1 (error máximo "
+                  << worst << ")" << std::endl;
+    } catch (const std::exception& e) {
+        std::cout << "❌ Error en pruebas del Día 3: " << e.what() << std::endl;
+    }
+}
+
+void test_mlp() {
+    std::cout << "\n=== PRUEBAS DÍA 4: MLP ===" << std::endl;
+    
+    try {
+        MLP mlp;
+        mlp.load_weights("weights_organized", 0);
+        
+        MatrixF tokens = MatrixF::random(17, mlp.get_d_model());
+        MatrixF output = mlp.forward(tokens);
+        
+        // forward_residual debe dar x + MLP(x) sin matrices intermedias
+        MatrixF residual = tokens;
+        mlp.forward_residual(ConstMatrixViewF(tokens), residual.view());
+        double worst = 0.0;
+        for (size_t i = 0; i < residual.size(); ++i) {
+            worst = std::max(worst, (double)std::abs(residual.data()[i] - (tokens.data()[i] + output.data()[i])));
+        }
+        
+        std::cout << "✅ MLP funciona correctamente" << std::endl;
+        std::cout << "   Entrada: " << tokens.getRows() << "x" << tokens.getCols()
+                  << " → oculta " << mlp.get_hidden_dim() << " → salida "
+                  << output.getRows() << "x" << output.getCols() << std::endl;
+        std::cout << (worst < 1e-5 ? "✅" : "❌") << " Residual en el epílogo coincide con x + MLP(x) (error máximo "
+                  << worst << ")" << std::endl;
+    } catch (const std::exception& e) {
+        std::cout << "❌ Error en pruebas del Día 4: " << e.what() << std::endl;
+    }
+}
+
+void test_vision_transformer() {
+    std::cout << "\n=== PRUEBAS DÍA 5: Vision Transformer completo ===" << std::endl;
+    
+    try {
+        const size_t images = 4;
+        VisionTransformer vit(images);
+        vit.load_weights("weights_organized");
+        
+        const PatchEmbedding& embedding = vit.get_embedding();
+        const size_t seq_len = embedding.get_seq_len();
+        MatrixF patches = MatrixF::random(images * embedding.get_num_patches(), embedding.get_patch_dim(), -1.0f, 1.0f);
+        MatrixF logits = vit.forward(patches);
+        
+        // Misma red capa a capa, con matrices temporales en cada paso
+        PatchEmbedding reference_embedding = embedding;
+        MatrixF x = reference_embedding.forward(patches);
+        for (VisionTransformer::EncoderBlock block : vit.get_blocks()) {
+            x = x + block.attention.forward(block.norm_1.forward(x), seq_len);
+            x = x + block.mlp.forward(block.norm_2.forward(x));
+        }
+        MatrixF cls_tokens(images, x.getCols());
+        for (size_t b = 0; b < images; ++b) {
+            cls_tokens.block(b, 0, 1, x.getCols()).assign(x.block(b * seq_len, 0, 1, x.getCols()));
+        }
+        LayerNorm head_norm = vit.get_head_norm();
+        MatrixF expected = MatrixOps::matmul_nt(head_norm.forward(cls_tokens), vit.get_head_weight());
+        
+        double worst = 0.0;
+        for (size_t b = 0; b < images; ++b) {
+            for (size_t c = 0; c < logits.getCols(); ++c) {
+                double reference = expected(b, c) + vit.get_head_bias()(0, c);
+                worst = std::max(worst, std::abs(logits(b, c) - reference));
+            }
+        }
+        
+        vit.set_attention_kernel(AttentionKernel::Tiled);
+        MatrixF tiled_logits = vit.forward(patches);
+        double tiled_worst = 0.0;
+        for (size_t i = 0; i < logits.size(); ++i) {
+            tiled_worst = std::max(tiled_worst, (double)std::abs(tiled_logits.data()[i] - logits.data()[i]));
+        }
+        
+        std::cout << "✅ VisionTransformer funciona correctamente" << std::endl;
+        std::cout << "   " << vit.get_num_layers() << " capas, " << vit.get_num_heads() << " cabezas, "
+                  << images << " imágenes → logits " << logits.getRows() << "x" << logits.getCols() << std::endl;
+        std::cout << "   Arena de activaciones: " << vit.get_arena_bytes() / 1024 << " KiB" << std::endl;
+        for (const auto& buffer : vit.get_memory_plan()) {
+            std::cout << "     " << buffer.name << ": " << buffer.elements * sizeof(float) / 1024
+                      << " KiB en +" << buffer.offset * sizeof(float) / 1024 << " KiB" << std::endl;
+        }
+        std::cout << "   Predicciones:";
+        for (size_t b = 0; b < images; ++b) {
+            size_t best = 0;
+            for (size_t c = 1; c < logits.getCols(); ++c) {
+                if (logits(b, c) > logits(b, best)) {
+                    best = c;
+                }
+            }
+            std::cout << " " << best;
+        }
+        std::cout << std::endl;
+        std::cout << (worst < 1e-4 ? "✅" : "❌") << " Coincide con la composición capa a capa (error máximo "
+                  << worst << ")" << std::endl;
+        std::cout << (tiled_worst < 1e-4 ? "✅" : "❌") << " Atención Tiled coincide con Standard (error máximo "
+                  << tiled_worst << ")" << std::endl;
+    } catch (const std::exception& e) {
+        std::cout << "❌ Error en pruebas del Día 5: " << e.what() << std::endl;
+    }
+}
+
+void test_batched_inference() {
+    std::cout << "\n=== PRUEBA: Inferencia por micro-lotes ===" << std::endl;
+    
+    try {
+        VisionTransformer vit;
+        vit.load_weights("weights_organized");
+        const size_t num_patches = vit.get_embedding().get_num_patches();
+        const size_t patch_dim = vit.get_embedding().get_patch_dim();
+        
+        const size_t clients = 4;
+        const size_t per_client = 8;
+        MatrixF images = MatrixF::random(clients * per_client * num_patches, patch_dim, -1.0f, 1.0f);
+        VisionTransformer reference_vit(clients * per_client);
+        reference_vit.load_weights("weights_organized");
+        MatrixF expected = reference_vit.forward(images);
+        
+        BatchingOptions options;
+        options.max_batch = 8;
+        options.max_delay_ms = 2.0;
+        BatchedInference server(vit, options);
+        
+        // Varios hilos cliente envían imágenes sueltas
+        std::vector<std::future<BatchedInference::Result>> futures(clients * per_client);
+        std::vector<std::thread> threads;
+        for (size_t c = 0; c < clients; ++c) {
+            threads.emplace_back([&, c] {
+                for (size_t i = c * per_client; i < (c + 1) * per_client; ++i) {
+                    futures[i] = server.submit(images.block(i * num_patches, 0, num_patches, patch_dim));
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        
+        double worst = 0.0;
+        for (size_t i = 0; i < futures.size(); ++i) {
+            BatchedInference::Result result = futures[i].get();
+            for (size_t c = 0; c < result.logits.getCols(); ++c) {
+                worst = std::max(worst, (double)std::abs(result.logits(0, c) - expected(i, c)));
+            }
+        }
+        
+        BatchedInference::Stats stats = server.get_stats();
+        std::cout << (worst < 1e-4 ? "✅" : "❌") << " " << stats.requests << " imágenes en " << stats.batches
+                  << " lotes (media " << stats.mean_batch_size() << "), coinciden con el lote completo (error máximo "
+                  << worst << ")" << std::endl;
+        std::cout << "   Latencia p95 <= " << stats.latency_percentile_ms(95) << " ms" << std::endl;
+    } catch (const std::exception& e) {
+        std::cout << "❌ Error en inferencia por micro-lotes: " << e.what() << std::endl;
+    }
+}
+
+void test_quantization() {
+    std::cout << "\n=== PRUEBA: Cuantización int8 post-entrenamiento ===" << std::endl;
+    
+    try {
+        const size_t images = 32;
+        VisionTransformer vit(images);
+        vit.load_weights("weights_organized");
+        VisionTransformer int8_vit = vit;
+        const size_t num_patches = vit.get_embedding().get_num_patches();
+        const size_t patch_dim = vit.get_embedding().get_patch_dim();
+        
+        // Calibración con unas imágenes y evaluación con otras
+        MatrixF calibration = MatrixF::random(images * num_patches, patch_dim, 0.0f, 1.0f);
+        MatrixF patches = MatrixF::random(images * num_patches, patch_dim, 0.0f, 1.0f);
+        int8_vit.start_calibration();
+        int8_vit.calibrate(calibration);
+        int8_vit.quantize();
+        
+        MatrixF expected = vit.forward(patches);
+        MatrixF logits = int8_vit.forward(patches);
+        size_t agree = 0;
+        double worst = 0.0;
+        double largest = 0.0;
+        for (size_t b = 0; b < images; ++b) {
+            size_t best = 0;
+            size_t expected_best = 0;
+            for (size_t c = 0; c < logits.getCols(); ++c) {
+                best = logits(b, c) > logits(b, best) ? c : best;
+                expected_best = expected(b, c) > expected(b, expected_best) ? c : expected_best;
+                worst = std::max(worst, (double)std::abs(logits(b, c) - expected(b, c)));
+                largest = std::max(largest, (double)std::abs(expected(b, c)));
+            }
+            agree += best == expected_best ? 1 : 0;
+        }
+        
+        // Pesos int8 a través del contenedor binario
+        const QuantizedLinear& head = *int8_vit.get_linears().back().linear;
+        const QGemm::PackedWeights& head_weights = head.get_weights();
+        std::vector<int8_t> values = head_weights.unpack();
+        MatrixF scales(head_weights.getCols(), 1);
+        std::copy(head_weights.scale_data(), head_weights.scale_data() + head_weights.getCols(), scales.data());
+        MatrixF input(1, 2);
+        input(0, 0) = head.get_input_params().scale;
+        input(0, 1) = static_cast<float>(head.get_input_params().zero_point);
+        const std::string name = "classifier/mlp_head_1_weight";
+        WeightFile::write("test_int8.vitw", {
+            {name, WeightFile::DType::Int8, head_weights.getCols(), head_weights.getRows(), values.data()},
+            {QuantizedLinear::scale_tensor_name(name), WeightFile::DType::Float32, scales.getRows(), 1, scales.data()},
+            {QuantizedLinear::input_tensor_name(name), WeightFile::DType::Float32, 1, 2, input.data()},
+        });
+        QuantizedLinear reloaded;
+        MatrixF dequantized = reloaded.load_weight(*WeightFile::open("test_int8.vitw"), name);
+        double weight_error = 0.0;
+        double max_scale = 0.0;
+        for (size_t j = 0; j < dequantized.getRows(); ++j) {
+            max_scale = std::max(max_scale, (double)scales(j, 0));
+            for (size_t p = 0; p < dequantized.getCols(); ++p) {
+                weight_error = std::max(weight_error,
+                                        (double)std::abs(dequantized(j, p) - vit.get_head_weight()(j, p)));
+            }
+        }
+        std::remove("test_int8.vitw");
+        
+        std::cout << "✅ " << int8_vit.get_quantized_count() << " capas lineales en int8 (kernel "
+                  << QGemm::kernel_name() << ")" << std::endl;
+        std::cout << (agree * 10 >= images * 9 ? "✅" : "❌") << " Coincidencia top-1 con float: " << agree << "/"
+                  << images << ", error máximo en logits " << worst << " (|logit| máximo " << largest << ")"
+                  << std::endl;
+        std::cout << (reloaded.is_quantized() && weight_error <= 0.5 * max_scale + 1e-7 ? "✅" : "❌")
+                  << " Pesos int8 leídos del contenedor (error máximo " << weight_error << ")" << std::endl;
+    } catch (const std::exception& e) {
+        std::cout << "❌ Error en cuantización int8: " << e.what() << std::endl;
+    }
+}
+
+void test_weight_storage() {
+    std::cout << "\n=== PRUEBA: Pesos en bfloat16 / float16 ===" << std::endl;
+    
+    try {
+        const size_t images = 32;
+        VisionTransformer vit(images);
+        vit.load_weights("weights_organized");
+        const size_t num_patches = vit.get_embedding().get_num_patches();
+        const size_t patch_dim = vit.get_embedding().get_patch_dim();
+        MatrixF patches = MatrixF::random(images * num_patches, patch_dim, 0.0f, 1.0f);
+        MatrixF expected = vit.forward(patches);
+        const size_t float_bytes = vit.get_packed_weight_bytes();
+        
+        for (Gemm::Storage storage : {Gemm::Storage::BFloat16, Gemm::Storage::Float16}) {
+            VisionTransformer half_vit(images);
+            half_vit.set_weight_storage(storage);
+            half_vit.load_weights("weights_organized");
+            MatrixF logits = half_vit.forward(patches);
+            size_t agree = 0;
+            double worst = 0.0;
+            for (size_t b = 0; b < images; ++b) {
+                size_t best = 0;
+                size_t expected_best = 0;
+                for (size_t c = 0; c < logits.getCols(); ++c) {
+                    best = logits(b, c) > logits(b, best) ? c : best;
+                    expected_best = expected(b, c) > expected(b, expected_best) ? c : expected_best;
+                    worst = std::max(worst, (double)std::abs(logits(b, c) - expected(b, c)));
+                }
+                agree += best == expected_best ? 1 : 0;
+            }
+            const bool halved = half_vit.get_packed_weight_bytes() * 2 == float_bytes;
+            std::cout << (agree * 10 >= images * 9 && halved ? "✅" : "❌") << " " << Gemm::storage_name(storage)
+                      << ": " << half_vit.get_packed_weight_bytes() / 1024 << " KiB empaquetados (float "
+                      << float_bytes / 1024 << " KiB), coincidencia top-1 " << agree << "/" << images
+                      << ", error máximo en logits " << worst << std::endl;
+        }
+        
+        // Conversión exacta de ida y vuelta a través del contenedor
+        const MatrixF& weight = vit.get_head_weight();
+        std::vector<uint16_t> bf16(weight.size());
+        std::vector<uint16_t> f16(weight.size());
+        for (size_t i = 0; i < weight.size(); ++i) {
+            bf16[i] = Half::float_to_bfloat16(weight.data()[i]);
+            f16[i] = Half::float_to_half(weight.data()[i]);
+        }
+        WeightFile::write("test_half.vitw", {
+            {"bf16", WeightFile::DType::BFloat16, weight.getRows(), weight.getCols(), bf16.data()},
+            {"f16", WeightFile::DType::Float16, weight.getRows(), weight.getCols(), f16.data()},
+        });
+        std::shared_ptr<WeightFile> file = WeightFile::open("test_half.vitw");
+        MatrixF bf16_weight = file->get<float>("bf16");
+        MatrixF f16_weight = file->get<float>("f16");
+        double bf16_error = 0.0;
+        double f16_error = 0.0;
+        bool exact = true;
+        for (size_t i = 0; i < weight.size(); ++i) {
+            bf16_error = std::max(bf16_error, (double)std::abs(bf16_weight.data()[i] - weight.data()[i]));
+            f16_error = std::max(f16_error, (double)std::abs(f16_weight.data()[i] - weight.data()[i]));
+            exact = exact && Half::float_to_bfloat16(bf16_weight.data()[i]) == bf16[i] &&
+                    Half::float_to_half(f16_weight.data()[i]) == f16[i];
+        }
+        file.reset();
+        std::remove("test_half.vitw");
+        std::cout << (exact ? "✅" : "❌") << " Tensores de 16 bits leídos del contenedor (error de redondeo bf16 "
+                  << bf16_error << ", f16 " << f16_error << ")" << std::endl;
+    } catch (const std::exception& e) {
+        std::cout << "❌ Error en pesos de 16 bits: " << e.what() << std::endl;
+    }
+}
+
+void test_packed_cache() {
+    std::cout << "\n=== PRUEBA: Pesos empaquetados en caché ===" << std::endl;
+    const std::string path = "weights.vitw";
+    if (!FileIO::file_exists(path)) {
+        std::cout << "⏭️  " << path << " no existe (genéralo con ./convert_weights)" << std::endl;
+        return;
+    }
+    const std::string cache = "test_packed.vitw";
+    
+    try {
+        std::remove(cache.c_str());
+        std::shared_ptr<WeightFile> weights = WeightFile::open(path);
+        const size_t images = 8;
+        VisionTransformer reference(images);
+        reference.load_weights(*weights);
+        MatrixF patches = MatrixF::random(images * reference.get_embedding().get_num_patches(),
+                                          reference.get_embedding().get_patch_dim(), 0.0f, 1.0f);
+        MatrixF expected = reference.forward(patches);
+        const size_t linears = reference.get_linears().size();
+        
+        // Token de clase combinado con su embedding posicional al cargar
+        const PatchEmbedding& embedding = reference.get_embedding();
+        bool combined = embedding.get_cls_pos().size() == static_cast<size_t>(embedding.get_features());
+        for (size_t j = 0; combined && j < embedding.get_cls_pos().size(); ++j) {
+            combined = embedding.get_cls_pos().data()[j] ==
+                       embedding.get_cls_token().data()[j] + embedding.get_pos_embed().data()[j];
+        }
+        std::cout << (combined ? "✅" : "❌") << " cls_token + pos_embed[0] precombinado" << std::endl;
+        
+        // Primer arranque: empaqueta y escribe la caché; el segundo la adopta
+        VisionTransformer cold(images);
+        const size_t cold_adopted = cold.load_weights(*weights, cache);
+        VisionTransformer warm(images);
+        const size_t warm_adopted = warm.load_weights(*weights, cache);
+        const bool same = warm.forward(patches) == expected && cold.forward(patches) == expected;
+        std::cout << (cold_adopted == 0 && warm_adopted == linears && same ? "✅" : "❌")
+                  << " Caché " << cache << ": " << cold_adopted << " capas adoptadas en frío, " << warm_adopted
+                  << "/" << linears << " en caliente, logits idénticos" << std::endl;
+        
+        // Otro formato de almacenamiento no reutiliza los paneles nativos
+        VisionTransformer half_cold(images);
+        half_cold.set_weight_storage(Gemm::Storage::BFloat16);
+        const size_t half_cold_adopted = half_cold.load_weights(*weights, cache);
+        VisionTransformer half_warm(images);
+        half_warm.set_weight_storage(Gemm::Storage::BFloat16);
+        const size_t half_warm_adopted = half_warm.load_weights(*weights, cache);
+        const bool half_same = half_warm.forward(patches) == half_cold.forward(patches);
+        std::cout << (half_cold_adopted == 0 && half_warm_adopted == linears && half_same ? "✅" : "❌")
+                  << " Caché bf16 separada de la nativa (" << half_warm_adopted << "/" << linears
+                  << " adoptadas)" << std::endl;
+        std::remove(cache.c_str());
+    } catch (const std::exception& e) {
+        std::remove(cache.c_str());
+        std::cout << "❌ Error en la caché de pesos empaquetados: " << e.what() << std::endl;
+    }
+}
+
+void test_profiler() {
+    std::cout << "\n=== PRUEBA: Perfilado por capa ===" << std::endl;
+    if (!VIT_PROFILING) {
+        std::cout << "⏭️ Ámbitos de perfilado eliminados en compilación (VIT_PROFILING=0)" << std::endl;
+        return;
+    }
+    
+    try {
+        const size_t images = 8;
+        VisionTransformer vit(images);
+        vit.load_weights("weights_organized");
+        const size_t layers = vit.get_blocks().size();
+        MatrixF patches = MatrixF::random(images * vit.get_embedding().get_num_patches(),
+                                          vit.get_embedding().get_patch_dim(), 0.0f, 1.0f);
+        MatrixF logits(images, vit.get_head_weight().getRows());
+        vit.forward(patches, logits.view());
+        
+        Profiler::reset();
+        Profiler::set_enabled(true);
+        vit.forward(patches, logits.view());
+        MatrixF product = MatrixOps::matmul(patches, MatrixOps::transpose(patches));
+        Profiler::set_enabled(false);
+        
+        // Una llamada por capa y paso; matmul y transpose asignan su resultado
+        // fuera de su propio ámbito
+        auto find = [](const std::vector<Profiler::Summary>& rows, const std::string& name) {
+            for (const Profiler::Summary& row : rows) {
+                if (row.name == name) return row;
+            }
+            return Profiler::Summary{"", name, 0, 0.0, 0.0, 0.0, 0.0, 0, 0};
+        };
+        const std::vector<Profiler::Summary> rows = Profiler::summary();
+        const bool counts = find(rows, "PatchEmbedding.forward").calls == 1 &&
+                            find(rows, "LayerNorm.forward").calls == 2 * layers + 1 &&
+                            find(rows, "MultiHeadAttention.forward").calls == layers &&
+                            find(rows, "MLP.forward").calls == layers &&
+                            find(rows, "Classifier.forward").calls == 1 &&
+                            find(rows, "matmul").calls == 1 && find(rows, "transpose").calls == 1;
+        const Profiler::Summary model = find(rows, "VisionTransformer.forward");
+        const bool no_allocations = model.calls == 1 && model.allocations == 0;
+        std::cout << (counts ? "✅" : "❌") << " Ámbitos registrados: " << rows.size() << " (" << layers
+                  << " bloques)" << std::endl;
+        std::cout << (no_allocations ? "✅" : "❌") << " Forward sin asignaciones de Matrix, "
+                  << model.total_ns / 1e6 << " ms" << std::endl;
+        Profiler::print_summary();
+        
+        Profiler::write_chrome_trace("test_trace.json");
+        std::ifstream trace("test_trace.json");
+        const std::string text((std::istreambuf_iterator<char>(trace)), std::istreambuf_iterator<char>());
+        trace.close();
+        std::remove("test_trace.json");
+        const bool valid = text.find("\"traceEvents\"") != std::string::npos &&
+                           text.find("\"MLP.forward\"") != std::string::npos;
+        std::cout << (valid ? "✅" : "❌") << " Traza Chrome escrita (" << text.size() << " bytes)" << std::endl;
+        Profiler::reset();
+    } catch (const std::exception& e) {
+        std::cout << "❌ Error en el perfilado: " << e.what() << std::endl;
+    }
+}
+
+void test_allocation_tracking() {
+    std::cout << "\n=== PRUEBA: Seguimiento de memoria de Matrix ===" << std::endl;
+    
+    try {
+        AllocationTracker::set_enabled(true);
+        
+        // Contadores básicos: dos buffers de 40000 bytes, liberados al salir
+        AllocationTracker::Stats matrices;
+        {
+            AllocationTracker::Scope scope;
+            {
+                MatrixF a(100, 100);
+                MatrixF b = a;
+            }
+            matrices = scope.stats();
+        }
+        const bool counted = matrices.allocations == 2 && matrices.frees == 2 && matrices.live_bytes == 0 &&
+                             matrices.peak_bytes == 80000 &&
+                             matrices.histogram[AllocationTracker::bucket(40000)] == 2;
+        std::cout << (counted ? "✅" : "❌") << " Asignaciones, liberaciones, pico e histograma: ";
+        AllocationTracker::print_stats(matrices);
+        
+        // Presupuesto de un forward
+        const size_t images = 8;
+        VisionTransformer vit(images);
+        vit.load_weights("weights_organized");
+        MatrixF patches = MatrixF::random(images * vit.get_embedding().get_num_patches(),
+                                          vit.get_embedding().get_patch_dim(), 0.0f, 1.0f);
+        MatrixF logits(images, vit.get_head_weight().getRows());
+        AllocationTracker::Scope forward;
+        vit.forward(patches, logits.view());
+        AllocationTracker::check_budget(forward.stats(), 0, 0, "forward");
+        std::cout << "✅ Forward de " << images << " imágenes dentro del presupuesto (0 asignaciones)" << std::endl;
+        
+        bool rejected = false;
+        try {
+            AllocationTracker::Scope allocating;
+            MatrixF result = vit.forward(patches);
+            AllocationTracker::check_budget(allocating.stats(), 0, 0, "allocating forward");
+        } catch (const std::runtime_error&) {
+            rejected = true;
+        }
+        std::cout << (rejected ? "✅" : "❌") << " Presupuesto excedido detectado en el forward que asigna" << std::endl;
+        AllocationTracker::set_enabled(false);
+    } catch (const std::exception& e) {
+        AllocationTracker::set_enabled(false);
+        std::cout << "❌ Error en el seguimiento de memoria: " << e.what() << std::endl;
+    }
+}
+
 void show_next_steps() {
     std::cout << "\n=== PRÓXIMOS PASOS ===" << std::endl;
     std::cout << "✅ Día 1: Librería de matrices - COMPLETADO" << std::endl;
     std::cout << "✅ Día 2: Componentes neuronales - COMPLETADO" << std::endl;
-    std::cout << "⏳ Día 3: Multi-Head Self-Attention - PENDIENTE" << std::endl;
-    std::cout << "⏳ Día 4: MLP y capas transformer - PENDIENTE" << std::endl;
-    std::cout << "⏳ Día 5: Integración final - PENDIENTE" << std::endl;
-    std::cout << "\n🚀 ¡Listo para implementar Multi-Head Attention!" << std::endl;
+    std::cout << "✅ Día 3: Multi-Head Self-Attention - COMPLETADO" << std::endl;
+    std::cout << "✅ Día 4: MLP y capas transformer - COMPLETADO" << std::endl;
+    std::cout << "✅ Día 5: Integración final - COMPLETADO" << std::endl;
+    std::cout << "\n🚀 ¡Vision Transformer completo de extremo a extremo!" << std::endl;
 }
 
 int main() {
@@ -89,6 +670,17 @@ int main() {
     // Ejecutar todas las pruebas
     test_original_functionality();
     test_day2_components();
+    test_workspace();
+    test_weight_file();
+    test_attention();
+    test_mlp();
+    test_vision_transformer();
+    test_batched_inference();
+    test_quantization();
+    test_weight_storage();
+    test_packed_cache();
+    test_profiler();
+    test_allocation_tracking();
     show_next_steps();
     
     return 0;
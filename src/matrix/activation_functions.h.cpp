@@ -4,247 +4,656 @@
 
 #include "../../include/matrix/activation_functions.h"
 #include "../../include/matrix/matrix_ops.h"
+#include "../../include/matrix/vector_math.h"
+#include "../../include/utils/thread_pool.h"
+#include "../../include/utils/cpu_features.h"
 const double M_PI = 3.14159265358979323846;
 #include <cmath>
 #include  <random>
 #include <algorithm>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define VIT_ACTIVATION_X86 1
+#endif
 
 namespace ActivationFunctions {
 
-Matrix relu(const Matrix& input) {
-    Matrix result(input.getRows(), input.getCols());
-    for (size_t i = 0; i < input.getRows(); ++i) {
-        for (size_t j = 0; j < input.getCols(); ++j) {
-            result(i, j) = std::max(0.0, input(i, j));
-        }
+namespace {
+
+// Row-wise kernels only fan out to the thread pool once a matrix has this
+// many elements; below it the wake-up cost outweighs the work.
+constexpr size_t PARALLEL_MIN_ELEMENTS = size_t(1) << 15;
+
+// Calls body(row_begin, row_end) over all rows, in parallel for large inputs.
+void for_each_row_range(size_t rows, size_t cols, const ThreadPool::RangeFunction& body) {
+    if (rows * cols < PARALLEL_MIN_ELEMENTS) {
+        body(0, rows);
+        return;
     }
-    return result;
+    const size_t grain = std::max<size_t>(1, (PARALLEL_MIN_ELEMENTS / 4) / std::max<size_t>(cols, 1));
+    ThreadPool::instance().parallel_for(0, rows, grain, body);
 }
 
-Matrix reluDerivative(const Matrix& input) {
-    Matrix result(input.getRows(), input.getCols());
+// Applies an element-wise VectorMath kernel to a whole matrix, splitting it
+// by rows. Contiguous operands are handed to the kernel a row range at a
+// time; strided views go row by row.
+template <typename T>
+void map_elements(const MatrixViewT<T>& output, const ConstMatrixViewT<T>& input,
+                  void (*kernel)(const T*, T*, size_t)) {
+    if (output.getRows() != input.getRows() || output.getCols() != input.getCols()) {
+        throw std::invalid_argument("Output must match the input dimensions");
+    }
+    const size_t cols = input.getCols();
+    const bool contiguous = input.is_contiguous() && output.is_contiguous();
+    for_each_row_range(input.getRows(), cols, [&](size_t row_begin, size_t row_end) {
+        if (contiguous) {
+            kernel(input.row_ptr(row_begin), output.row_ptr(row_begin), (row_end - row_begin) * cols);
+            return;
+        }
+        for (size_t i = row_begin; i < row_end; ++i) {
+            kernel(input.row_ptr(i), output.row_ptr(i), cols);
+        }
+    });
+}
+
+// output = f(input) element by element, for the scalar activations
+template <typename T, typename F>
+void map_scalar(const MatrixViewT<T>& output, const ConstMatrixViewT<T>& input, F f) {
+    if (output.getRows() != input.getRows() || output.getCols() != input.getCols()) {
+        throw std::invalid_argument("Output must match the input dimensions");
+    }
     for (size_t i = 0; i < input.getRows(); ++i) {
+        const T* in = input.row_ptr(i);
+        T* out = output.row_ptr(i);
         for (size_t j = 0; j < input.getCols(); ++j) {
-            result(i, j) = input(i, j) > 0.0 ? 1.0 : 0.0;
+            out[j] = f(in[j]);
         }
     }
-    return result;
 }
 
-Matrix gelu(const Matrix& input) {
-    Matrix result(input.getRows(), input.getCols());
-    const double sqrt_2_pi = std::sqrt(2.0 / M_PI);
+// Running (count, mean, M2) of a set of values, as in Welford's algorithm
+template <typename T>
+struct Moments {
+    T count;
+    T mean;
+    T m2;
+};
+
+// Chan et al. pairwise update: merge b into a
+template <typename T>
+void merge_moments(Moments<T>& a, const Moments<T>& b) {
+    if (b.count == T(0)) {
+        return;
+    }
+    T count = a.count + b.count;
+    T delta = b.mean - a.mean;
+    a.mean += delta * (b.count / count);
+    a.m2 += b.m2 + delta * delta * (a.count * b.count / count);
+    a.count = count;
+}
 
-    for (size_t i = 0; i < input.getRows(); ++i) {
-        for (size_t j = 0; j < input.getCols(); ++j) {
-            double x = input(i, j);
-            double tanh_arg = sqrt_2_pi * (x + 0.044715 * x * x * x);
-            result(i, j) = 0.5 * x * (1.0 + std::tanh(tanh_arg));
+// Mean and (population) variance of x[0, n) in a single pass. WELFORD_LANES
+// independent Welford accumulators run side by side, one per SIMD lane, all
+// at the same count so the 1/count update is a broadcast scalar; the lanes
+// and the scalar tail are merged pairwise at the end. Unlike the
+// sum / sum-of-squares shortcut this does not cancel catastrophically when
+// |mean| >> stddev, so it is safe to accumulate in float.
+constexpr size_t WELFORD_LANES = 16;
+
+// Merge the per-lane accumulators (each over `blocks` values) and fold in the
+// elements past the last full block
+template <typename T>
+Moments<T> finish_moments(const T* lane_mean, const T* lane_m2, size_t blocks, const T* x, size_t n) {
+    // Pairwise tree over the lanes. Both halves of every merge hold the same
+    // count, so Chan's update reduces to an average and a fixed weight.
+    T mean[WELFORD_LANES];
+    T m2[WELFORD_LANES];
+    std::copy(lane_mean, lane_mean + WELFORD_LANES, mean);
+    std::copy(lane_m2, lane_m2 + WELFORD_LANES, m2);
+    T count = static_cast<T>(blocks);
+    for (size_t width = WELFORD_LANES / 2; width > 0; width /= 2) {
+        for (size_t l = 0; l < width; ++l) {
+            T delta = mean[l + width] - mean[l];
+            mean[l] += delta * T(0.5);
+            m2[l] += m2[l + width] + delta * delta * (count * T(0.5));
         }
+        count += count;
     }
-    return result;
+    Moments<T> merged = {count, mean[0], m2[0]};
+
+    Moments<T> tail = {T(0), T(0), T(0)};
+    for (size_t j = blocks * WELFORD_LANES; j < n; ++j) {
+        tail.count += T(1);
+        T delta = x[j] - tail.mean;
+        tail.mean += delta / tail.count;
+        tail.m2 += delta * (x[j] - tail.mean);
+    }
+    if (blocks == 0) {
+        return tail;
+    }
+    merge_moments(merged, tail);
+    return merged;
 }
 
-Matrix geluDerivative(const Matrix& input) {
-    Matrix result(input.getRows(), input.getCols());
-    const double sqrt_2_pi = std::sqrt(2.0 / M_PI);
-
-    for (size_t i = 0; i < input.getRows(); ++i) {
-        for (size_t j = 0; j < input.getCols(); ++j) {
-            double x = input(i, j);
-            double tanh_arg = sqrt_2_pi * (x + 0.044715 * x * x * x);
-            double tanh_val = std::tanh(tanh_arg);
-            double sech2_val = 1.0 - tanh_val * tanh_val;
-
-            double derivative = 0.5 * (1.0 + tanh_val) +
-                               0.5 * x * sech2_val * sqrt_2_pi * (1.0 + 3.0 * 0.044715 * x * x);
-            result(i, j) = derivative;
+template <typename T>
+Moments<T> row_moments_scalar(const T* x, size_t n) {
+    T lane_mean[WELFORD_LANES] = {};
+    T lane_m2[WELFORD_LANES] = {};
+    const size_t blocks = n / WELFORD_LANES;
+
+    for (size_t b = 0; b < blocks; ++b) {
+        const T* in = x + b * WELFORD_LANES;
+        const T inv_count = T(1) / static_cast<T>(b + 1);
+        for (size_t l = 0; l < WELFORD_LANES; ++l) {
+            T delta = in[l] - lane_mean[l];
+            lane_mean[l] += delta * inv_count;
+            lane_m2[l] += delta * (in[l] - lane_mean[l]);
         }
     }
+    return finish_moments(lane_mean, lane_m2, blocks, x, n);
+}
+
+template <typename T>
+void normalize_row_scalar(const T* in, const T* gamma, const T* beta, T mean, T inv_std, size_t n, T* out) {
+    for (size_t j = 0; j < n; ++j) {
+        out[j] = (in[j] - mean) * inv_std * gamma[j] + beta[j];
+    }
+}
+
+#ifdef VIT_ACTIVATION_X86
+
+// Float kernels: 16 Welford lanes as one zmm or two ymm registers
+
+__attribute__((target("avx2,fma")))
+Moments<float> row_moments_avx2(const float* x, size_t n) {
+    __m256 mean_lo = _mm256_setzero_ps(), mean_hi = _mm256_setzero_ps();
+    __m256 m2_lo = _mm256_setzero_ps(), m2_hi = _mm256_setzero_ps();
+    const size_t blocks = n / WELFORD_LANES;
+
+    for (size_t b = 0; b < blocks; ++b) {
+        const __m256 inv_count = _mm256_set1_ps(1.0f / static_cast<float>(b + 1));
+        const __m256 lo = _mm256_loadu_ps(x + b * WELFORD_LANES);
+        const __m256 hi = _mm256_loadu_ps(x + b * WELFORD_LANES + 8);
+        const __m256 delta_lo = _mm256_sub_ps(lo, mean_lo);
+        const __m256 delta_hi = _mm256_sub_ps(hi, mean_hi);
+        mean_lo = _mm256_fmadd_ps(delta_lo, inv_count, mean_lo);
+        mean_hi = _mm256_fmadd_ps(delta_hi, inv_count, mean_hi);
+        m2_lo = _mm256_fmadd_ps(delta_lo, _mm256_sub_ps(lo, mean_lo), m2_lo);
+        m2_hi = _mm256_fmadd_ps(delta_hi, _mm256_sub_ps(hi, mean_hi), m2_hi);
+    }
+
+    alignas(32) float lane_mean[WELFORD_LANES];
+    alignas(32) float lane_m2[WELFORD_LANES];
+    _mm256_store_ps(lane_mean, mean_lo);
+    _mm256_store_ps(lane_mean + 8, mean_hi);
+    _mm256_store_ps(lane_m2, m2_lo);
+    _mm256_store_ps(lane_m2 + 8, m2_hi);
+    _mm256_zeroupper(); // finish_moments is SSE code; avoid the transition penalty
+    return finish_moments(lane_mean, lane_m2, blocks, x, n);
+}
+
+__attribute__((target("avx2,fma")))
+void normalize_row_avx2(const float* in, const float* gamma, const float* beta, float mean, float inv_std,
+                        size_t n, float* out) {
+    const __m256 vmean = _mm256_set1_ps(mean);
+    const __m256 vscale = _mm256_set1_ps(inv_std);
+    size_t j = 0;
+    for (; j + 8 <= n; j += 8) {
+        __m256 scale = _mm256_mul_ps(_mm256_loadu_ps(gamma + j), vscale);
+        __m256 centered = _mm256_sub_ps(_mm256_loadu_ps(in + j), vmean);
+        _mm256_storeu_ps(out + j, _mm256_fmadd_ps(centered, scale, _mm256_loadu_ps(beta + j)));
+    }
+    _mm256_zeroupper();
+    normalize_row_scalar(in + j, gamma + j, beta + j, mean, inv_std, n - j, out + j);
+}
+
+__attribute__((target("avx512f")))
+Moments<float> row_moments_avx512(const float* x, size_t n) {
+    __m512 mean = _mm512_setzero_ps();
+    __m512 m2 = _mm512_setzero_ps();
+    const size_t blocks = n / WELFORD_LANES;
+
+    for (size_t b = 0; b < blocks; ++b) {
+        const __m512 inv_count = _mm512_set1_ps(1.0f / static_cast<float>(b + 1));
+        const __m512 v = _mm512_loadu_ps(x + b * WELFORD_LANES);
+        const __m512 delta = _mm512_sub_ps(v, mean);
+        mean = _mm512_fmadd_ps(delta, inv_count, mean);
+        m2 = _mm512_fmadd_ps(delta, _mm512_sub_ps(v, mean), m2);
+    }
+
+    alignas(64) float lane_mean[WELFORD_LANES];
+    alignas(64) float lane_m2[WELFORD_LANES];
+    _mm512_store_ps(lane_mean, mean);
+    _mm512_store_ps(lane_m2, m2);
+    _mm256_zeroupper(); // finish_moments is SSE code; avoid the transition penalty
+    return finish_moments(lane_mean, lane_m2, blocks, x, n);
+}
+
+__attribute__((target("avx512f")))
+void normalize_row_avx512(const float* in, const float* gamma, const float* beta, float mean, float inv_std,
+                          size_t n, float* out) {
+    const __m512 vmean = _mm512_set1_ps(mean);
+    const __m512 vscale = _mm512_set1_ps(inv_std);
+    size_t j = 0;
+    for (; j + 16 <= n; j += 16) {
+        __m512 scale = _mm512_mul_ps(_mm512_loadu_ps(gamma + j), vscale);
+        __m512 centered = _mm512_sub_ps(_mm512_loadu_ps(in + j), vmean);
+        _mm512_storeu_ps(out + j, _mm512_fmadd_ps(centered, scale, _mm512_loadu_ps(beta + j)));
+    }
+    if (j < n) {
+        const __mmask16 mask = static_cast<__mmask16>((1u << (n - j)) - 1);
+        __m512 scale = _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, gamma + j), vscale);
+        __m512 centered = _mm512_sub_ps(_mm512_maskz_loadu_ps(mask, in + j), vmean);
+        _mm512_mask_storeu_ps(out + j, mask, _mm512_fmadd_ps(centered, scale, _mm512_maskz_loadu_ps(mask, beta + j)));
+    }
+}
+
+#endif // VIT_ACTIVATION_X86
+
+template <typename T>
+Moments<T> row_moments(const T* x, size_t n) {
+    return row_moments_scalar(x, n);
+}
+
+template <typename T>
+void normalize_row(const T* in, const T* gamma, const T* beta, T mean, T inv_std, size_t n, T* out) {
+    normalize_row_scalar(in, gamma, beta, mean, inv_std, n, out);
+}
+
+#ifdef VIT_ACTIVATION_X86
+template <>
+Moments<float> row_moments<float>(const float* x, size_t n) {
+    switch (CpuFeatures::active_isa()) {
+        case CpuFeatures::IsaLevel::Avx512: return row_moments_avx512(x, n);
+        case CpuFeatures::IsaLevel::Avx2: return row_moments_avx2(x, n);
+        default: return row_moments_scalar(x, n);
+    }
+}
+
+template <>
+void normalize_row<float>(const float* in, const float* gamma, const float* beta, float mean, float inv_std,
+                          size_t n, float* out) {
+    switch (CpuFeatures::active_isa()) {
+        case CpuFeatures::IsaLevel::Avx512: return normalize_row_avx512(in, gamma, beta, mean, inv_std, n, out);
+        case CpuFeatures::IsaLevel::Avx2: return normalize_row_avx2(in, gamma, beta, mean, inv_std, n, out);
+        default: return normalize_row_scalar(in, gamma, beta, mean, inv_std, n, out);
+    }
+}
+#endif
+
+// Fused row LayerNorm: Welford statistics, then one normalise + affine pass.
+// out may alias in (the in-place variant), since each element is read before
+// it is written.
+template <typename T>
+void layer_norm_row(const T* in, const T* gamma, const T* beta, T epsilon, size_t n, T* out) {
+    Moments<T> moments = row_moments(in, n);
+    const T inv_std = T(1) / std::sqrt(moments.m2 / static_cast<T>(n) + epsilon);
+    normalize_row(in, gamma, beta, moments.mean, inv_std, n, out);
+}
+
+template <typename T>
+void check_layer_norm_params(size_t features, const MatrixT<T>& gamma, const MatrixT<T>& beta) {
+    if (gamma.size() != features || beta.size() != features) {
+        throw std::invalid_argument("LayerNorm gamma/beta must have " + std::to_string(features) +
+                                    " elements, got " + std::to_string(gamma.size()) + " and " +
+                                    std::to_string(beta.size()));
+    }
+}
+
+} // namespace
+
+template <typename T>
+void relu_into(const MatrixViewT<T>& output, ConstViewArg<T> input) {
+    map_scalar(output, input, [](T x) { return std::max(T(0), x); });
+}
+
+template <typename T>
+void reluDerivative_into(const MatrixViewT<T>& output, ConstViewArg<T> input) {
+    map_scalar(output, input, [](T x) { return x > T(0) ? T(1) : T(0); });
+}
+
+template <typename T>
+MatrixT<T> relu(const MatrixT<T>& input, Workspace* workspace) {
+    MatrixT<T> result = scratch_matrix<T>(input.getRows(), input.getCols(), workspace);
+    relu_into(result.view(), input);
     return result;
 }
 
-Matrix softmax(const Matrix& input, int axis) {
-    Matrix result(input.getRows(), input.getCols());
+template <typename T>
+MatrixT<T> reluDerivative(const MatrixT<T>& input, Workspace* workspace) {
+    MatrixT<T> result = scratch_matrix<T>(input.getRows(), input.getCols(), workspace);
+    reluDerivative_into(result.view(), input);
+    return result;
+}
 
-    if (axis == 1) {
-        // Softmax across columns (each row sums to 1)
-        for (size_t i = 0; i < input.getRows(); ++i) {
-            // Find max for numerical stability
-            double max_val = input(i, 0);
-            for (size_t j = 1; j < input.getCols(); ++j) {
-                max_val = std::max(max_val, input(i, j));
-            }
+template <typename T>
+void gelu_into(const MatrixViewT<T>& output, ConstViewArg<T> input, GeluMode mode) {
+    map_elements(output, input, mode == GeluMode::Erf ? &VectorMath::gelu_erf<T> : &VectorMath::gelu_tanh<T>);
+}
 
-            // Compute exponentials and sum
-            double sum_exp = 0.0;
-            std::vector<double> exp_vals(input.getCols());
-            for (size_t j = 0; j < input.getCols(); ++j) {
-                exp_vals[j] = std::exp(input(i, j) - max_val);
-                sum_exp += exp_vals[j];
-            }
+template <typename T>
+MatrixT<T> gelu(const MatrixT<T>& input, GeluMode mode, Workspace* workspace) {
+    MatrixT<T> result = scratch_matrix<T>(input.getRows(), input.getCols(), workspace);
+    gelu_into(result.view(), input, mode);
+    return result;
+}
 
-            // Normalize
-            for (size_t j = 0; j < input.getCols(); ++j) {
-                result(i, j) = exp_vals[j] / sum_exp;
-            }
-        }
+template <typename T>
+void geluDerivative_into(const MatrixViewT<T>& output, ConstViewArg<T> input) {
+    const double sqrt_2_pi = std::sqrt(2.0 / M_PI);
+
+    map_scalar(output, input, [sqrt_2_pi](T value) {
+        double x = value;
+        double tanh_arg = sqrt_2_pi * (x + 0.044715 * x * x * x);
+        double tanh_val = std::tanh(tanh_arg);
+        double sech2_val = 1.0 - tanh_val * tanh_val;
+
+        double derivative = 0.5 * (1.0 + tanh_val) +
+                           0.5 * x * sech2_val * sqrt_2_pi * (1.0 + 3.0 * 0.044715 * x * x);
+        return static_cast<T>(derivative);
+    });
+}
+
+template <typename T>
+MatrixT<T> geluDerivative(const MatrixT<T>& input, Workspace* workspace) {
+    MatrixT<T> result = scratch_matrix<T>(input.getRows(), input.getCols(), workspace);
+    geluDerivative_into(result.view(), input);
+    return result;
+}
+
+template <typename T>
+void softmax_into(const MatrixViewT<T>& output, ConstViewArg<T> input, int axis) {
+    if (axis == 1) {
+        // Softmax across columns (each row sums to 1)
+        softmaxRows(input, output);
     } else if (axis == 0) {
-        // Softmax across rows (each column sums to 1)
+        if (output.getRows() != input.getRows() || output.getCols() != input.getCols()) {
+            throw std::invalid_argument("Output must match the input dimensions");
+        }
+        // Softmax across rows (each column sums to 1). The exponentials go
+        // straight into output, which is then normalised in place.
         for (size_t j = 0; j < input.getCols(); ++j) {
             // Find max for numerical stability
-            double max_val = input(0, j);
+            T max_val = input.row_ptr(0)[j];
             for (size_t i = 1; i < input.getRows(); ++i) {
-                max_val = std::max(max_val, input(i, j));
+                max_val = std::max(max_val, input.row_ptr(i)[j]);
             }
 
             // Compute exponentials and sum
             double sum_exp = 0.0;
-            std::vector<double> exp_vals(input.getRows());
             for (size_t i = 0; i < input.getRows(); ++i) {
-                exp_vals[i] = std::exp(input(i, j) - max_val);
-                sum_exp += exp_vals[i];
+                T e = std::exp(input.row_ptr(i)[j] - max_val);
+                output.row_ptr(i)[j] = e;
+                sum_exp += e;
             }
 
             // Normalize
             for (size_t i = 0; i < input.getRows(); ++i) {
-                result(i, j) = exp_vals[i] / sum_exp;
+                output.row_ptr(i)[j] = static_cast<T>(output.row_ptr(i)[j] / sum_exp);
             }
         }
     } else {
         throw std::invalid_argument("Axis must be 0 or 1");
     }
+}
 
+template <typename T>
+MatrixT<T> softmax(const MatrixT<T>& input, int axis, Workspace* workspace) {
+    MatrixT<T> result = scratch_matrix<T>(input.getRows(), input.getCols(), workspace);
+    softmax_into(result.view(), input, axis);
     return result;
 }
 
-Matrix dropout(const Matrix& input, double dropout_rate, bool training) {
+template <typename T>
+void softmaxRows(const ConstMatrixViewT<T>& input, const MatrixViewT<T>& output, double scale) {
+    if (output.getRows() != input.getRows() || output.getCols() != input.getCols()) {
+        throw std::invalid_argument("softmaxRows output must match the input dimensions");
+    }
+    if (!(scale > 0.0)) {
+        throw std::invalid_argument("softmaxRows scale must be positive");
+    }
+
+    const T row_scale = static_cast<T>(scale);
+    for_each_row_range(input.getRows(), input.getCols(), [&](size_t row_begin, size_t row_end) {
+        for (size_t i = row_begin; i < row_end; ++i) {
+            VectorMath::softmax(input.row_ptr(i), output.row_ptr(i), input.getCols(), row_scale);
+        }
+    });
+}
+
+template <typename T>
+void dropout_into(const MatrixViewT<T>& output, ConstViewArg<T> input, double dropout_rate, bool training) {
     if (!training) {
         // During inference, dropout acts as identity
-        return input;
+        map_scalar(output, input, [](T x) { return x; });
+        return;
     }
 
     // During training, randomly set elements to zero
-    Matrix result = input;
     std::random_device rd;
     std::mt19937 gen(rd());
     std::bernoulli_distribution dis(1.0 - dropout_rate);
 
-    double scale = 1.0 / (1.0 - dropout_rate);
+    const T scale = static_cast<T>(1.0 / (1.0 - dropout_rate));
+    map_scalar(output, input, [&](T x) { return dis(gen) ? x * scale : T(0); });
+}
 
-    for (size_t i = 0; i < input.getRows(); ++i) {
-        for (size_t j = 0; j < input.getCols(); ++j) {
-            if (dis(gen)) {
-                result(i, j) *= scale;
-            } else {
-                result(i, j) = 0.0;
-            }
-        }
+template <typename T>
+MatrixT<T> dropout(const MatrixT<T>& input, double dropout_rate, bool training, Workspace* workspace) {
+    if (!training && !workspace) {
+        return input;
     }
-
+    MatrixT<T> result = scratch_matrix<T>(input.getRows(), input.getCols(), workspace);
+    dropout_into(result.view(), input, dropout_rate, training);
     return result;
 }
 
-std::pair<Matrix, Matrix> computeMeanAndVariance(const Matrix& input, int axis) {
-    Matrix mean = MatrixOps::meanAxis(input, axis);
+template <typename T>
+void computeMeanAndVariance_into(const MatrixViewT<T>& mean, const MatrixViewT<T>& variance, ConstViewArg<T> input,
+                                 int axis) {
+    const size_t rows = input.getRows();
+    const size_t cols = input.getCols();
+    if (axis != 0 && axis != 1) {
+        throw std::invalid_argument("Axis must be 0 or 1");
+    }
+    const size_t out_rows = axis == 1 ? rows : 1;
+    const size_t out_cols = axis == 1 ? 1 : cols;
+    if (mean.getRows() != out_rows || mean.getCols() != out_cols || variance.getRows() != out_rows ||
+        variance.getCols() != out_cols) {
+        throw std::invalid_argument("Mean and variance outputs must be " + std::to_string(out_rows) + "x" +
+                                    std::to_string(out_cols));
+    }
 
-    Matrix variance;
     if (axis == 1) {
-        // Compute variance across columns
-        variance = Matrix(input.getRows(), 1, 0.0);
-        for (size_t i = 0; i < input.getRows(); ++i) {
-            double var_sum = 0.0;
-            for (size_t j = 0; j < input.getCols(); ++j) {
-                double diff = input(i, j) - mean(i, 0);
-                var_sum += diff * diff;
+        // Compute mean and variance across columns in one pass per row
+        for_each_row_range(rows, cols, [&](size_t row_begin, size_t row_end) {
+            for (size_t i = row_begin; i < row_end; ++i) {
+                Moments<T> moments = row_moments(input.row_ptr(i), cols);
+                mean.row_ptr(i)[0] = moments.mean;
+                variance.row_ptr(i)[0] = moments.m2 / static_cast<T>(cols);
             }
-            variance(i, 0) = var_sum / input.getCols();
-        }
-    } else if (axis == 0) {
+        });
+    } else {
         // Compute variance across rows
-        variance = Matrix(1, input.getCols(), 0.0);
-        for (size_t j = 0; j < input.getCols(); ++j) {
+        MatrixOps::meanAxis_into(mean, input, axis);
+        const T* column_mean = mean.row_ptr(0);
+        for (size_t j = 0; j < cols; ++j) {
             double var_sum = 0.0;
-            for (size_t i = 0; i < input.getRows(); ++i) {
-                double diff = input(i, j) - mean(0, j);
+            for (size_t i = 0; i < rows; ++i) {
+                double diff = input.row_ptr(i)[j] - column_mean[j];
                 var_sum += diff * diff;
             }
-            variance(0, j) = var_sum / input.getRows();
+            variance.row_ptr(0)[j] = var_sum / rows;
         }
-    } else {
-        throw std::invalid_argument("Axis must be 0 or 1");
     }
-
-    return {mean, variance};
 }
 
-Matrix layerNorm(const Matrix& input, const Matrix& gamma, const Matrix& beta,
-                 double epsilon, int axis) {
-    auto [mean, variance] = computeMeanAndVariance(input, axis);
-
-    Matrix result(input.getRows(), input.getCols());
+template <typename T>
+std::pair<MatrixT<T>, MatrixT<T>> computeMeanAndVariance(const MatrixT<T>& input, int axis, Workspace* workspace) {
+    if (axis != 0 && axis != 1) {
+        throw std::invalid_argument("Axis must be 0 or 1");
+    }
+    const size_t rows = axis == 1 ? input.getRows() : 1;
+    const size_t cols = axis == 1 ? 1 : input.getCols();
+    MatrixT<T> mean = scratch_matrix<T>(rows, cols, workspace);
+    MatrixT<T> variance = scratch_matrix<T>(rows, cols, workspace);
+    computeMeanAndVariance_into(mean.view(), variance.view(), input, axis);
+    return {std::move(mean), std::move(variance)};
+}
 
+template <typename T>
+void layerNorm_into(const MatrixViewT<T>& output, ConstViewArg<T> input, const MatrixT<T>& gamma,
+                    const MatrixT<T>& beta, double epsilon, int axis) {
     if (axis == 1) {
-        // Normalize across columns
-        for (size_t i = 0; i < input.getRows(); ++i) {
-            double std_dev = std::sqrt(variance(i, 0) + epsilon);
-            for (size_t j = 0; j < input.getCols(); ++j) {
-                double normalized = (input(i, j) - mean(i, 0)) / std_dev;
-                result(i, j) = gamma(0, j) * normalized + beta(0, j);
-            }
-        }
+        // Normalize across columns with the fused kernel
+        layerNormRows(input, gamma, beta, epsilon, output);
     } else if (axis == 0) {
-        // Normalize across rows
+        if (output.getRows() != input.getRows() || output.getCols() != input.getCols()) {
+            throw std::invalid_argument("Output must match the input dimensions");
+        }
+        // Normalize across rows, one column at a time: statistics first, so
+        // output may be the same storage as input
         for (size_t j = 0; j < input.getCols(); ++j) {
-            double std_dev = std::sqrt(variance(0, j) + epsilon);
+            double mean = 0.0;
+            for (size_t i = 0; i < input.getRows(); ++i) {
+                mean += input.row_ptr(i)[j];
+            }
+            mean /= input.getRows();
+            double var_sum = 0.0;
             for (size_t i = 0; i < input.getRows(); ++i) {
-                double normalized = (input(i, j) - mean(0, j)) / std_dev;
-                result(i, j) = gamma(i, 0) * normalized + beta(i, 0);
+                double diff = input.row_ptr(i)[j] - mean;
+                var_sum += diff * diff;
+            }
+            double std_dev = std::sqrt(var_sum / input.getRows() + epsilon);
+            for (size_t i = 0; i < input.getRows(); ++i) {
+                double normalized = (input.row_ptr(i)[j] - mean) / std_dev;
+                output.row_ptr(i)[j] = gamma(i, 0) * normalized + beta(i, 0);
             }
         }
+    } else {
+        throw std::invalid_argument("Axis must be 0 or 1");
     }
+}
 
+template <typename T>
+MatrixT<T> layerNorm(const MatrixT<T>& input, const MatrixT<T>& gamma, const MatrixT<T>& beta,
+                 double epsilon, int axis, Workspace* workspace) {
+    MatrixT<T> result = scratch_matrix<T>(input.getRows(), input.getCols(), workspace);
+    layerNorm_into(result.view(), input, gamma, beta, epsilon, axis);
     return result;
 }
 
-Matrix sigmoid(const Matrix& input) {
-    Matrix result(input.getRows(), input.getCols());
-    for (size_t i = 0; i < input.getRows(); ++i) {
-        for (size_t j = 0; j < input.getCols(); ++j) {
-            result(i, j) = 1.0 / (1.0 + std::exp(-input(i, j)));
-        }
+template <typename T>
+void layerNormRows(const ConstMatrixViewT<T>& input, const MatrixT<T>& gamma, const MatrixT<T>& beta,
+                   double epsilon, const MatrixViewT<T>& output) {
+    if (output.getRows() != input.getRows() || output.getCols() != input.getCols()) {
+        throw std::invalid_argument("layerNormRows output must match the input dimensions");
     }
+    check_layer_norm_params(input.getCols(), gamma, beta);
+
+    const T eps = static_cast<T>(epsilon);
+    for_each_row_range(input.getRows(), input.getCols(), [&](size_t row_begin, size_t row_end) {
+        for (size_t i = row_begin; i < row_end; ++i) {
+            layer_norm_row(input.row_ptr(i), gamma.data(), beta.data(), eps, input.getCols(), output.row_ptr(i));
+        }
+    });
+}
+
+template <typename T>
+void layerNormInPlace(MatrixT<T>& x, const MatrixT<T>& gamma, const MatrixT<T>& beta, double epsilon) {
+    layerNormRows(ConstMatrixViewT<T>(x), gamma, beta, epsilon, x.view());
+}
+
+template <typename T>
+void sigmoid_into(const MatrixViewT<T>& output, ConstViewArg<T> input) {
+    map_elements(output, input, &VectorMath::sigmoid<T>);
+}
+
+template <typename T>
+void tanh_into(const MatrixViewT<T>& output, ConstViewArg<T> input) {
+    map_elements(output, input, &VectorMath::tanh<T>);
+}
+
+template <typename T>
+void leakyRelu_into(const MatrixViewT<T>& output, ConstViewArg<T> input, double alpha) {
+    const T slope = static_cast<T>(alpha);
+    map_scalar(output, input, [slope](T x) { return x > T(0) ? x : slope * x; });
+}
+
+template <typename T>
+void clip_into(const MatrixViewT<T>& output, ConstViewArg<T> input, double min_val, double max_val) {
+    const T lo = static_cast<T>(min_val);
+    const T hi = static_cast<T>(max_val);
+    map_scalar(output, input, [lo, hi](T x) { return std::clamp(x, lo, hi); });
+}
+
+template <typename T>
+MatrixT<T> sigmoid(const MatrixT<T>& input, Workspace* workspace) {
+    MatrixT<T> result = scratch_matrix<T>(input.getRows(), input.getCols(), workspace);
+    sigmoid_into(result.view(), input);
     return result;
 }
 
-Matrix tanh(const Matrix& input) {
-    Matrix result(input.getRows(), input.getCols());
-    for (size_t i = 0; i < input.getRows(); ++i) {
-        for (size_t j = 0; j < input.getCols(); ++j) {
-            result(i, j) = std::tanh(input(i, j));
-        }
-    }
+template <typename T>
+MatrixT<T> tanh(const MatrixT<T>& input, Workspace* workspace) {
+    MatrixT<T> result = scratch_matrix<T>(input.getRows(), input.getCols(), workspace);
+    tanh_into(result.view(), input);
     return result;
 }
 
-Matrix leakyRelu(const Matrix& input, double alpha) {
-    Matrix result(input.getRows(), input.getCols());
-    for (size_t i = 0; i < input.getRows(); ++i) {
-        for (size_t j = 0; j < input.getCols(); ++j) {
-            result(i, j) = input(i, j) > 0.0 ? input(i, j) : alpha * input(i, j);
-        }
-    }
+template <typename T>
+MatrixT<T> leakyRelu(const MatrixT<T>& input, double alpha, Workspace* workspace) {
+    MatrixT<T> result = scratch_matrix<T>(input.getRows(), input.getCols(), workspace);
+    leakyRelu_into(result.view(), input, alpha);
     return result;
 }
 
-Matrix clip(const Matrix& input, double min_val, double max_val) {
-    Matrix result(input.getRows(), input.getCols());
-    for (size_t i = 0; i < input.getRows(); ++i) {
-        for (size_t j = 0; j < input.getCols(); ++j) {
-            result(i, j) = std::clamp(input(i, j), min_val, max_val);
-        }
-    }
+template <typename T>
+MatrixT<T> clip(const MatrixT<T>& input, double min_val, double max_val, Workspace* workspace) {
+    MatrixT<T> result = scratch_matrix<T>(input.getRows(), input.getCols(), workspace);
+    clip_into(result.view(), input, min_val, max_val);
     return result;
 }
 
+#define ACTIVATION_INSTANTIATE(T)                                                                    \
+    template MatrixT<T> relu<T>(const MatrixT<T>&, Workspace*);                                     \
+    template MatrixT<T> reluDerivative<T>(const MatrixT<T>&, Workspace*);                           \
+    template void relu_into<T>(const MatrixViewT<T>&, ConstViewArg<T>);                             \
+    template void reluDerivative_into<T>(const MatrixViewT<T>&, ConstViewArg<T>);                   \
+    template MatrixT<T> gelu<T>(const MatrixT<T>&, GeluMode, Workspace*);                           \
+    template MatrixT<T> geluDerivative<T>(const MatrixT<T>&, Workspace*);                           \
+    template void gelu_into<T>(const MatrixViewT<T>&, ConstViewArg<T>, GeluMode);                   \
+    template void geluDerivative_into<T>(const MatrixViewT<T>&, ConstViewArg<T>);                   \
+    template MatrixT<T> softmax<T>(const MatrixT<T>&, int, Workspace*);                             \
+    template void softmax_into<T>(const MatrixViewT<T>&, ConstViewArg<T>, int);                     \
+    template void softmaxRows<T>(const ConstMatrixViewT<T>&, const MatrixViewT<T>&, double);         \
+    template MatrixT<T> dropout<T>(const MatrixT<T>&, double, bool, Workspace*);                    \
+    template void dropout_into<T>(const MatrixViewT<T>&, ConstViewArg<T>, double, bool);            \
+    template MatrixT<T> layerNorm<T>(const MatrixT<T>&, const MatrixT<T>&, const MatrixT<T>&,       \
+                                     double, int, Workspace*);                                      \
+    template void layerNorm_into<T>(const MatrixViewT<T>&, ConstViewArg<T>, const MatrixT<T>&,     \
+                                    const MatrixT<T>&, double, int);                                \
+    template void layerNormRows<T>(const ConstMatrixViewT<T>&, const MatrixT<T>&, const MatrixT<T>&, \
+                                   double, const MatrixViewT<T>&);                                  \
+    template void layerNormInPlace<T>(MatrixT<T>&, const MatrixT<T>&, const MatrixT<T>&, double);   \
+    template std::pair<MatrixT<T>, MatrixT<T>> computeMeanAndVariance<T>(const MatrixT<T>&, int,    \
+                                                                         Workspace*);               \
+    template void computeMeanAndVariance_into<T>(const MatrixViewT<T>&, const MatrixViewT<T>&,      \
+                                                 ConstViewArg<T>, int);                             \
+    template MatrixT<T> sigmoid<T>(const MatrixT<T>&, Workspace*);                                  \
+    template MatrixT<T> tanh<T>(const MatrixT<T>&, Workspace*);                                     \
+    template MatrixT<T> leakyRelu<T>(const MatrixT<T>&, double, Workspace*);                        \
+    template MatrixT<T> clip<T>(const MatrixT<T>&, double, double, Workspace*);                     \
+    template void sigmoid_into<T>(const MatrixViewT<T>&, ConstViewArg<T>);                          \
+    template void tanh_into<T>(const MatrixViewT<T>&, ConstViewArg<T>);                             \
+    template void leakyRelu_into<T>(const MatrixViewT<T>&, ConstViewArg<T>, double);                \
+    template void clip_into<T>(const MatrixViewT<T>&, ConstViewArg<T>, double, double);
+
+ACTIVATION_INSTANTIATE(float)
+ACTIVATION_INSTANTIATE(double)
+
+#undef ACTIVATION_INSTANTIATE
+
 } // namespace Act
\ No newline at end of file
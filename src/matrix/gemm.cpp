@@ -0,0 +1,781 @@
+//
+// Created by JAYAN on 14/07/2025.
+//
+
+#include "../../include/matrix/gemm.h"
+#include "../../include/matrix/half.h"
+#include "../../include/matrix/vector_math.h"
+#include "../../include/utils/thread_pool.h"
+#include "../../include/utils/cpu_features.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define VIT_GEMM_X86 1
+#endif
+
+namespace Gemm {
+
+namespace {
+
+// Computes a full MR x NR tile of A_panel * B_panel over kc steps and writes it
+// to c (row stride ldc). When accumulate is set the tile is added to c. B is
+// the packed panel in its storage type (T, or 16-bit bits widened on load).
+template <typename T, typename B = T>
+using MicroKernel = void (*)(size_t kc, const T* a, const B* b, T* c, size_t ldc, bool accumulate);
+
+template <typename T>
+struct KernelConfig {
+    const char* name;
+    size_t mr;      // Register tile rows
+    size_t nr;      // Register tile columns
+    size_t mc;      // Rows of A kept in L2 (multiple of mr)
+    size_t kc;      // Depth of one packed panel, sized so a B micro-panel stays in L1
+    size_t nc;      // Columns of B kept in L3 (multiple of nr)
+    MicroKernel<T> kernel;
+    MicroKernel<T, uint16_t> bf16_kernel;   // Same tile on Storage::BFloat16 panels
+    MicroKernel<T, uint16_t> f16_kernel;    // Same tile on Storage::Float16 panels
+};
+
+// Storage formats of a packed B row of NR values. A bfloat16 row is stored
+// as pairs (column j, column NR/2 + j), so one load yields both halves of the
+// row as 32-bit lanes: shifted left, the low columns; masked, the high ones.
+template <typename T>
+struct NativeFormat {
+    using Stored = T;
+    static T widen(const T* row, size_t, size_t j) { return row[j]; }
+};
+
+struct BFloat16Format {
+    using Stored = uint16_t;
+    static float widen(const uint16_t* row, size_t nr, size_t j) {
+        const size_t half = nr / 2;
+        return Half::bfloat16_to_float(row[j < half ? 2 * j : 2 * (j - half) + 1]);
+    }
+};
+
+struct Float16Format {
+    using Stored = uint16_t;
+    static float widen(const uint16_t* row, size_t, size_t j) { return Half::half_to_float(row[j]); }
+};
+
+constexpr size_t MAX_TILE = 16 * 32;
+
+// ---------------------------------------------------------------------------
+// Portable fallback
+// ---------------------------------------------------------------------------
+
+template <typename T, size_t MR, size_t NR, typename Format = NativeFormat<T>>
+void scalar_kernel(size_t kc, const T* a, const typename Format::Stored* b, T* c, size_t ldc, bool accumulate) {
+    T acc[MR][NR] = {};
+    T b_row[NR];
+    for (size_t p = 0; p < kc; ++p) {
+        for (size_t j = 0; j < NR; ++j) {
+            b_row[j] = static_cast<T>(Format::widen(b, NR, j));
+        }
+        for (size_t i = 0; i < MR; ++i) {
+            const T a_val = a[i];
+            for (size_t j = 0; j < NR; ++j) {
+                acc[i][j] += a_val * b_row[j];
+            }
+        }
+        a += MR;
+        b += NR;
+    }
+    for (size_t i = 0; i < MR; ++i) {
+        T* c_row = c + i * ldc;
+        for (size_t j = 0; j < NR; ++j) {
+            c_row[j] = accumulate ? c_row[j] + acc[i][j] : acc[i][j];
+        }
+    }
+}
+
+#ifdef VIT_GEMM_X86
+
+// ---------------------------------------------------------------------------
+// AVX2 + FMA: 6 rows x 2 ymm, 12 accumulators (6x8 double, 6x16 float)
+// ---------------------------------------------------------------------------
+
+__attribute__((target("avx2,fma")))
+void avx2_kernel_6x8(size_t kc, const double* a, const double* b, double* c, size_t ldc, bool accumulate) {
+    __m256d acc[6][2];
+#pragma GCC unroll 6
+    for (int i = 0; i < 6; ++i) {
+        acc[i][0] = _mm256_setzero_pd();
+        acc[i][1] = _mm256_setzero_pd();
+    }
+
+    for (size_t p = 0; p < kc; ++p) {
+        const __m256d b0 = _mm256_load_pd(b);
+        const __m256d b1 = _mm256_load_pd(b + 4);
+#pragma GCC unroll 6
+        for (int i = 0; i < 6; ++i) {
+            const __m256d a_val = _mm256_broadcast_sd(a + i);
+            acc[i][0] = _mm256_fmadd_pd(a_val, b0, acc[i][0]);
+            acc[i][1] = _mm256_fmadd_pd(a_val, b1, acc[i][1]);
+        }
+        a += 6;
+        b += 8;
+    }
+
+#pragma GCC unroll 6
+    for (int i = 0; i < 6; ++i) {
+        double* c_row = c + i * ldc;
+        if (accumulate) {
+            acc[i][0] = _mm256_add_pd(acc[i][0], _mm256_loadu_pd(c_row));
+            acc[i][1] = _mm256_add_pd(acc[i][1], _mm256_loadu_pd(c_row + 4));
+        }
+        _mm256_storeu_pd(c_row, acc[i][0]);
+        _mm256_storeu_pd(c_row + 4, acc[i][1]);
+    }
+}
+
+// One packed B row of 16 values as two float vectors
+__attribute__((target("avx2,fma,f16c"), always_inline))
+inline void load_row(const float* b, NativeFormat<float>, __m256& b0, __m256& b1) {
+    b0 = _mm256_load_ps(b);
+    b1 = _mm256_load_ps(b + 8);
+}
+
+__attribute__((target("avx2,fma,f16c"), always_inline))
+inline void load_row(const uint16_t* b, BFloat16Format, __m256& b0, __m256& b1) {
+    const __m256i pairs = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+    b0 = _mm256_castsi256_ps(_mm256_slli_epi32(pairs, 16));
+    b1 = _mm256_castsi256_ps(_mm256_and_si256(pairs, _mm256_set1_epi32(static_cast<int>(0xFFFF0000u))));
+}
+
+__attribute__((target("avx2,fma,f16c"), always_inline))
+inline void load_row(const uint16_t* b, Float16Format, __m256& b0, __m256& b1) {
+    b0 = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b)));
+    b1 = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + 8)));
+}
+
+// Runs only where F16C is present when Format is Float16Format
+template <typename Format>
+__attribute__((target("avx2,fma,f16c")))
+void avx2_kernel_6x16(size_t kc, const float* a, const typename Format::Stored* b, float* c, size_t ldc,
+                      bool accumulate) {
+    __m256 acc[6][2];
+#pragma GCC unroll 6
+    for (int i = 0; i < 6; ++i) {
+        acc[i][0] = _mm256_setzero_ps();
+        acc[i][1] = _mm256_setzero_ps();
+    }
+
+    for (size_t p = 0; p < kc; ++p) {
+        __m256 b0;
+        __m256 b1;
+        load_row(b, Format(), b0, b1);
+#pragma GCC unroll 6
+        for (int i = 0; i < 6; ++i) {
+            const __m256 a_val = _mm256_broadcast_ss(a + i);
+            acc[i][0] = _mm256_fmadd_ps(a_val, b0, acc[i][0]);
+            acc[i][1] = _mm256_fmadd_ps(a_val, b1, acc[i][1]);
+        }
+        a += 6;
+        b += 16;
+    }
+
+#pragma GCC unroll 6
+    for (int i = 0; i < 6; ++i) {
+        float* c_row = c + i * ldc;
+        if (accumulate) {
+            acc[i][0] = _mm256_add_ps(acc[i][0], _mm256_loadu_ps(c_row));
+            acc[i][1] = _mm256_add_ps(acc[i][1], _mm256_loadu_ps(c_row + 8));
+        }
+        _mm256_storeu_ps(c_row, acc[i][0]);
+        _mm256_storeu_ps(c_row + 8, acc[i][1]);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// AVX-512F: 12 rows x 2 zmm, 24 accumulators (12x16 double, 12x32 float)
+// ---------------------------------------------------------------------------
+
+__attribute__((target("avx512f")))
+void avx512_kernel_12x16(size_t kc, const double* a, const double* b, double* c, size_t ldc, bool accumulate) {
+    __m512d acc[12][2];
+#pragma GCC unroll 12
+    for (int i = 0; i < 12; ++i) {
+        acc[i][0] = _mm512_setzero_pd();
+        acc[i][1] = _mm512_setzero_pd();
+    }
+
+    for (size_t p = 0; p < kc; ++p) {
+        const __m512d b0 = _mm512_load_pd(b);
+        const __m512d b1 = _mm512_load_pd(b + 8);
+#pragma GCC unroll 12
+        for (int i = 0; i < 12; ++i) {
+            const __m512d a_val = _mm512_set1_pd(a[i]);
+            acc[i][0] = _mm512_fmadd_pd(a_val, b0, acc[i][0]);
+            acc[i][1] = _mm512_fmadd_pd(a_val, b1, acc[i][1]);
+        }
+        a += 12;
+        b += 16;
+    }
+
+#pragma GCC unroll 12
+    for (int i = 0; i < 12; ++i) {
+        double* c_row = c + i * ldc;
+        if (accumulate) {
+            acc[i][0] = _mm512_add_pd(acc[i][0], _mm512_loadu_pd(c_row));
+            acc[i][1] = _mm512_add_pd(acc[i][1], _mm512_loadu_pd(c_row + 8));
+        }
+        _mm512_storeu_pd(c_row, acc[i][0]);
+        _mm512_storeu_pd(c_row + 8, acc[i][1]);
+    }
+}
+
+// One packed B row of 32 values as two float vectors. bfloat16 widens with
+// integer ops: AVX512-BF16 only adds narrowing and bf16 x bf16 dot products,
+// which would need A in bf16 too.
+__attribute__((target("avx512f"), always_inline))
+inline void load_row(const float* b, NativeFormat<float>, __m512& b0, __m512& b1) {
+    b0 = _mm512_load_ps(b);
+    b1 = _mm512_load_ps(b + 16);
+}
+
+// GCC 12 reports the _mm512_undefined_*() pass-through operand inside
+// _mm512_slli_epi32 and _mm512_cvtph_ps as uninitialized (PR105593); it is
+// never read
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+__attribute__((target("avx512f"), always_inline))
+inline void load_row(const uint16_t* b, BFloat16Format, __m512& b0, __m512& b1) {
+    const __m512i pairs = _mm512_loadu_si512(b);
+    b0 = _mm512_castsi512_ps(_mm512_slli_epi32(pairs, 16));
+    b1 = _mm512_castsi512_ps(_mm512_and_si512(pairs, _mm512_set1_epi32(static_cast<int>(0xFFFF0000u))));
+}
+
+__attribute__((target("avx512f"), always_inline))
+inline void load_row(const uint16_t* b, Float16Format, __m512& b0, __m512& b1) {
+    b0 = _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b)));
+    b1 = _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + 16)));
+}
+
+#pragma GCC diagnostic pop
+
+template <typename Format>
+__attribute__((target("avx512f")))
+void avx512_kernel_12x32(size_t kc, const float* a, const typename Format::Stored* b, float* c, size_t ldc,
+                         bool accumulate) {
+    __m512 acc[12][2];
+#pragma GCC unroll 12
+    for (int i = 0; i < 12; ++i) {
+        acc[i][0] = _mm512_setzero_ps();
+        acc[i][1] = _mm512_setzero_ps();
+    }
+
+    for (size_t p = 0; p < kc; ++p) {
+        __m512 b0;
+        __m512 b1;
+        load_row(b, Format(), b0, b1);
+#pragma GCC unroll 12
+        for (int i = 0; i < 12; ++i) {
+            const __m512 a_val = _mm512_set1_ps(a[i]);
+            acc[i][0] = _mm512_fmadd_ps(a_val, b0, acc[i][0]);
+            acc[i][1] = _mm512_fmadd_ps(a_val, b1, acc[i][1]);
+        }
+        a += 12;
+        b += 32;
+    }
+
+#pragma GCC unroll 12
+    for (int i = 0; i < 12; ++i) {
+        float* c_row = c + i * ldc;
+        if (accumulate) {
+            acc[i][0] = _mm512_add_ps(acc[i][0], _mm512_loadu_ps(c_row));
+            acc[i][1] = _mm512_add_ps(acc[i][1], _mm512_loadu_ps(c_row + 16));
+        }
+        _mm512_storeu_ps(c_row, acc[i][0]);
+        _mm512_storeu_ps(c_row + 16, acc[i][1]);
+    }
+}
+
+#endif // VIT_GEMM_X86
+
+// ---------------------------------------------------------------------------
+// Runtime dispatch
+// ---------------------------------------------------------------------------
+
+using CpuFeatures::IsaLevel;
+
+// VIT_GEMM_KERNEL forces the GEMM kernel family; otherwise follow VIT_ISA
+IsaLevel active_isa() {
+    static const IsaLevel level = std::getenv("VIT_GEMM_KERNEL") != nullptr
+        ? CpuFeatures::select_isa("VIT_GEMM_KERNEL")
+        : CpuFeatures::active_isa();
+    return level;
+}
+
+template <typename T>
+const KernelConfig<T>& active_kernel();
+
+template <>
+const KernelConfig<double>& active_kernel<double>() {
+    static const KernelConfig<double> scalar = {"scalar", 4, 4, 128, 256, 4096, scalar_kernel<double, 4, 4>,
+                                                scalar_kernel<double, 4, 4, BFloat16Format>,
+                                                scalar_kernel<double, 4, 4, Float16Format>};
+#ifdef VIT_GEMM_X86
+    static const KernelConfig<double> avx2 = {"avx2", 6, 8, 120, 256, 4096, avx2_kernel_6x8,
+                                              scalar_kernel<double, 6, 8, BFloat16Format>,
+                                              scalar_kernel<double, 6, 8, Float16Format>};
+    static const KernelConfig<double> avx512 = {"avx512", 12, 16, 144, 256, 4096, avx512_kernel_12x16,
+                                                scalar_kernel<double, 12, 16, BFloat16Format>,
+                                                scalar_kernel<double, 12, 16, Float16Format>};
+    switch (active_isa()) {
+        case IsaLevel::Avx512: return avx512;
+        case IsaLevel::Avx2: return avx2;
+        default: break;
+    }
+#endif
+    return scalar;
+}
+
+template <>
+const KernelConfig<float>& active_kernel<float>() {
+    static const KernelConfig<float> scalar = {"scalar", 4, 8, 128, 256, 4096, scalar_kernel<float, 4, 8>,
+                                               scalar_kernel<float, 4, 8, BFloat16Format>,
+                                               scalar_kernel<float, 4, 8, Float16Format>};
+#ifdef VIT_GEMM_X86
+    static const KernelConfig<float> avx2 = {"avx2", 6, 16, 120, 256, 4096,
+                                             avx2_kernel_6x16<NativeFormat<float>>,
+                                             avx2_kernel_6x16<BFloat16Format>,
+                                             CpuFeatures::supports_f16c()
+                                                 ? avx2_kernel_6x16<Float16Format>
+                                                 : scalar_kernel<float, 6, 16, Float16Format>};
+    static const KernelConfig<float> avx512 = {"avx512", 12, 32, 144, 256, 4096,
+                                               avx512_kernel_12x32<NativeFormat<float>>,
+                                               avx512_kernel_12x32<BFloat16Format>,
+                                               avx512_kernel_12x32<Float16Format>};
+    switch (active_isa()) {
+        case IsaLevel::Avx512: return avx512;
+        case IsaLevel::Avx2: return avx2;
+        default: break;
+    }
+#endif
+    return scalar;
+}
+
+// ---------------------------------------------------------------------------
+// Packing
+// ---------------------------------------------------------------------------
+
+struct AlignedDelete {
+    void operator()(void* ptr) const { ::operator delete(ptr, std::align_val_t(64)); }
+};
+
+// Per-thread scratch for packed panels; grows on demand and is never shrunk.
+template <typename T>
+class PackBuffer {
+private:
+    std::unique_ptr<T, AlignedDelete> storage;
+    size_t capacity = 0;
+
+public:
+    T* get(size_t count) {
+        if (count > capacity) {
+            storage.reset(static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(64))));
+            capacity = count;
+        }
+        return storage.get();
+    }
+};
+
+// The calling thread's packing buffers, for A blocks and on-the-fly B blocks
+template <typename T>
+PackBuffer<T>& a_pack_buffer() {
+    thread_local PackBuffer<T> buffer;
+    return buffer;
+}
+
+template <typename T>
+PackBuffer<T>& b_pack_buffer() {
+    thread_local PackBuffer<T> buffer;
+    return buffer;
+}
+
+// Packs an mc x kc block of A into consecutive MR-row micro-panels laid out
+// k-major (MR values per k step). Short panels are zero-padded.
+template <typename T>
+void pack_a(size_t mc, size_t kc, const T* a, size_t rs, size_t cs, size_t mr, T* dst) {
+    for (size_t ir = 0; ir < mc; ir += mr) {
+        const size_t rows = std::min(mr, mc - ir);
+        const T* src = a + ir * rs;
+        for (size_t p = 0; p < kc; ++p) {
+            const T* col = src + p * cs;
+            size_t i = 0;
+            for (; i < rows; ++i) {
+                dst[i] = col[i * rs];
+            }
+            for (; i < mr; ++i) {
+                dst[i] = T(0);
+            }
+            dst += mr;
+        }
+    }
+}
+
+// Packs a kc x nc block of B into consecutive NR-column micro-panels laid out
+// k-major (NR values per k step). Short panels are zero-padded.
+template <typename T>
+void pack_b(size_t kc, size_t nc, const T* b, size_t rs, size_t cs, size_t nr, T* dst) {
+    for (size_t jr = 0; jr < nc; jr += nr) {
+        const size_t cols = std::min(nr, nc - jr);
+        const T* src = b + jr * cs;
+        for (size_t p = 0; p < kc; ++p) {
+            const T* row = src + p * rs;
+            size_t j = 0;
+            if (cs == 1) {
+                std::memcpy(dst, row, cols * sizeof(T));
+                j = cols;
+            } else {
+                for (; j < cols; ++j) {
+                    dst[j] = row[j * cs];
+                }
+            }
+            for (; j < nr; ++j) {
+                dst[j] = T(0);
+            }
+            dst += nr;
+        }
+    }
+}
+
+// Applies bias and activation to a finished rows x cols tile of C; bias
+// points at the tile's first column
+template <typename T>
+void apply_epilogue(const Epilogue<T>& epilogue, const T* bias, T* c_tile, size_t ldc, size_t rows, size_t cols) {
+    for (size_t i = 0; i < rows; ++i) {
+        T* c_row = c_tile + i * ldc;
+        if (bias) {
+            for (size_t j = 0; j < cols; ++j) {
+                c_row[j] += bias[j];
+            }
+        }
+        switch (epilogue.activation) {
+            case Activation::GeluTanh: VectorMath::gelu_tanh(c_row, c_row, cols); break;
+            case Activation::GeluErf: VectorMath::gelu_erf(c_row, c_row, cols); break;
+            case Activation::None: break;
+        }
+    }
+}
+
+// Multiplies one packed mc x kc block of A (rows ic..ic+mc) against the
+// NR-column panels [jr_begin, jr_end) of the packed kc x nc block of B.
+// epilogue is only passed with the last kc block, when the tiles are final;
+// its bias is already offset to the block's first column.
+template <typename T, typename B>
+void compute_block(const KernelConfig<T>& cfg, MicroKernel<T, B> kernel, size_t ic, size_t mc, size_t kc, size_t nc,
+                   size_t jr_begin, size_t jr_end,
+                   const T* a, size_t a_row_stride, size_t a_col_stride,
+                   const B* packed_b, T* c, size_t ldc, bool accumulate, const Epilogue<T>* epilogue) {
+    const bool has_epilogue = epilogue && (epilogue->bias || epilogue->activation != Activation::None);
+    const size_t mr = cfg.mr;
+    const size_t nr = cfg.nr;
+
+    T* packed_a = a_pack_buffer<T>().get(cfg.mc * cfg.kc);
+    pack_a(mc, kc, a + ic * a_row_stride, a_row_stride, a_col_stride, mr, packed_a);
+
+    alignas(64) T edge_tile[MAX_TILE];
+
+    for (size_t jr = jr_begin; jr < jr_end; jr += nr) {
+        const size_t cols = std::min(nr, nc - jr);
+        const B* b_panel = packed_b + jr * kc;
+
+        for (size_t ir = 0; ir < mc; ir += mr) {
+            const size_t rows = std::min(mr, mc - ir);
+            const T* a_panel = packed_a + ir * kc;
+            T* c_tile = c + (ic + ir) * ldc + jr;
+
+            if (rows == mr && cols == nr) {
+                kernel(kc, a_panel, b_panel, c_tile, ldc, accumulate);
+            } else {
+                // Partial tile: run the full kernel into scratch and
+                // copy back only the valid corner.
+                kernel(kc, a_panel, b_panel, edge_tile, nr, false);
+                for (size_t i = 0; i < rows; ++i) {
+                    T* c_row = c_tile + i * ldc;
+                    const T* t_row = edge_tile + i * nr;
+                    for (size_t j = 0; j < cols; ++j) {
+                        c_row[j] = accumulate ? c_row[j] + t_row[j] : t_row[j];
+                    }
+                }
+            }
+
+            if (has_epilogue) {
+                apply_epilogue(*epilogue, epilogue->bias ? epilogue->bias + jr : nullptr, c_tile, ldc, rows, cols);
+            }
+        }
+    }
+}
+
+// Below this many multiply-adds per (nc, kc) block the GEMM stays on the
+// calling thread; waking workers costs more than it saves.
+constexpr size_t PARALLEL_MIN_WORK = size_t(1) << 18;
+
+// Shared loop nest. b_block(jc, nc, pc, kc) returns the packed kc x nc block
+// of B, either packed on the fly or taken from a PackedMatrix; kernel is the
+// micro-kernel for its storage.
+//
+// Each (nc, kc) block is split into tasks over MC row blocks of A and ranges
+// of NR panels of B, and the tasks are spread across the thread pool. Small
+// M (a handful of tokens) is compensated by cutting N finer.
+template <typename T, typename B, typename BlockSource>
+void run_gemm(const KernelConfig<T>& cfg, MicroKernel<T, B> kernel, size_t m, size_t n, size_t k,
+              const T* a, size_t a_row_stride, size_t a_col_stride,
+              BlockSource b_block, T* c, size_t ldc, const Epilogue<T>& epilogue) {
+    if (m == 0 || n == 0) {
+        return;
+    }
+    if (k == 0) {
+        for (size_t i = 0; i < m && !epilogue.accumulate; ++i) {
+            std::fill(c + i * ldc, c + i * ldc + n, T(0));
+        }
+        apply_epilogue(epilogue, epilogue.bias, c, ldc, m, n);
+        return;
+    }
+
+    ThreadPool& pool = ThreadPool::instance();
+    const size_t m_blocks = (m + cfg.mc - 1) / cfg.mc;
+
+    for (size_t jc = 0; jc < n; jc += cfg.nc) {
+        const size_t nc = std::min(cfg.nc, n - jc);
+        const size_t panels = (nc + cfg.nr - 1) / cfg.nr;
+
+        for (size_t pc = 0; pc < k; pc += cfg.kc) {
+            const size_t kc = std::min(cfg.kc, k - pc);
+            const bool accumulate = pc != 0 || epilogue.accumulate;
+            const B* packed_b = b_block(jc, nc, pc, kc);
+            const T* a_block = a + pc * a_col_stride;
+            T* c_block = c + jc;
+
+            // The epilogue runs once, on the final value of each tile
+            Epilogue<T> block_epilogue = epilogue;
+            if (block_epilogue.bias) {
+                block_epilogue.bias += jc;
+            }
+            const Epilogue<T>* last_epilogue = pc + kc == k ? &block_epilogue : nullptr;
+
+            size_t n_splits = 1;
+            if (pool.num_threads() > 1 && m * nc * kc >= PARALLEL_MIN_WORK) {
+                const size_t wanted = 2 * pool.num_threads();
+                n_splits = std::min(panels, (wanted + m_blocks - 1) / m_blocks);
+            }
+
+            auto run_tasks = [&](size_t task_begin, size_t task_end) {
+                for (size_t task = task_begin; task < task_end; ++task) {
+                    const size_t ic = (task / n_splits) * cfg.mc;
+                    const size_t split = task % n_splits;
+                    const size_t jr_begin = (split * panels / n_splits) * cfg.nr;
+                    const size_t jr_end = std::min(nc, ((split + 1) * panels / n_splits) * cfg.nr);
+                    compute_block(cfg, kernel, ic, std::min(cfg.mc, m - ic), kc, nc, jr_begin, jr_end,
+                                  a_block, a_row_stride, a_col_stride,
+                                  packed_b, c_block, ldc, accumulate, last_epilogue);
+                }
+            };
+            pool.parallel_for(0, m_blocks * n_splits, 1, run_tasks);
+        }
+    }
+}
+
+size_t round_up(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+// run_gemm over the blocks of a PackedMatrix, whose panels start at panels
+template <typename T, typename B>
+void run_packed(const KernelConfig<T>& cfg, MicroKernel<T, B> kernel, const B* panels, size_t m,
+                const T* a, size_t a_row_stride, size_t a_col_stride,
+                const PackedMatrix<T>& b, T* c, size_t ldc, const Epilogue<T>& epilogue) {
+    const size_t k_blocks = (b.getRows() + cfg.kc - 1) / cfg.kc;
+    auto prepacked = [&](size_t jc, size_t, size_t pc, size_t) -> const B* {
+        const size_t block = (jc / cfg.nc) * k_blocks + pc / cfg.kc;
+        return panels + b.block_offset(block);
+    };
+    run_gemm(cfg, kernel, m, b.getCols(), b.getRows(), a, a_row_stride, a_col_stride, prepacked, c, ldc, epilogue);
+}
+
+} // namespace
+
+template <typename T>
+void gemm(size_t m, size_t n, size_t k,
+          const T* a, size_t a_row_stride, size_t a_col_stride,
+          const T* b, size_t b_row_stride, size_t b_col_stride,
+          T* c, size_t ldc, const Epilogue<T>& epilogue) {
+    const KernelConfig<T>& cfg = active_kernel<T>();
+
+    T* packed_b = b_pack_buffer<T>().get(cfg.kc * round_up(cfg.nc, cfg.nr));
+
+    auto pack_on_the_fly = [&](size_t jc, size_t nc, size_t pc, size_t kc) -> const T* {
+        pack_b(kc, nc, b + pc * b_row_stride + jc * b_col_stride,
+               b_row_stride, b_col_stride, cfg.nr, packed_b);
+        return packed_b;
+    };
+    run_gemm(cfg, cfg.kernel, m, n, k, a, a_row_stride, a_col_stride, pack_on_the_fly, c, ldc, epilogue);
+}
+
+const char* storage_name(Storage storage) {
+    switch (storage) {
+        case Storage::BFloat16: return "bf16";
+        case Storage::Float16: return "f16";
+        default: return "native";
+    }
+}
+
+Storage parse_storage(const std::string& name) {
+    if (name == "native") return Storage::Native;
+    if (name == "bf16") return Storage::BFloat16;
+    if (name == "f16") return Storage::Float16;
+    throw std::invalid_argument("Unknown weight storage '" + name + "' (expected native, bf16 or f16)");
+}
+
+template <typename T>
+PackedMatrix<T>::PackedMatrix() : rows(0), cols(0), storage(Storage::Native) {}
+
+template <typename T>
+size_t PackedMatrix<T>::plan_blocks() {
+    const KernelConfig<T>& cfg = active_kernel<T>();
+
+    // Blocks are stored in the order run_gemm visits them: jc outer, pc inner.
+    block_offsets.clear();
+    size_t total = 0;
+    for (size_t jc = 0; jc < cols; jc += cfg.nc) {
+        const size_t nc = std::min(cfg.nc, cols - jc);
+        for (size_t pc = 0; pc < rows; pc += cfg.kc) {
+            const size_t kc = std::min(cfg.kc, rows - pc);
+            block_offsets.push_back(total);
+            total += kc * round_up(nc, cfg.nr);
+        }
+    }
+    return total;
+}
+
+template <typename T>
+PackedMatrix<T>::PackedMatrix(size_t k, size_t n, const T* b, size_t b_row_stride, size_t b_col_stride,
+                              Storage storage)
+    : rows(k), cols(n), storage(storage) {
+    const KernelConfig<T>& cfg = active_kernel<T>();
+    const size_t total = plan_blocks();
+
+    panels = MatrixT<T>(1, total);
+    size_t block = 0;
+    for (size_t jc = 0; jc < n; jc += cfg.nc) {
+        const size_t nc = std::min(cfg.nc, n - jc);
+        for (size_t pc = 0; pc < k; pc += cfg.kc) {
+            const size_t kc = std::min(cfg.kc, k - pc);
+            pack_b(kc, nc, b + pc * b_row_stride + jc * b_col_stride,
+                   b_row_stride, b_col_stride, cfg.nr, panels.data() + block_offsets[block++]);
+        }
+    }
+
+    // Round the finished panels once (bfloat16 rows interleaved, see
+    // BFloat16Format); only the 16-bit copy is kept. Blocks are whole rows
+    // of nr values, so total is a multiple of nr.
+    if (storage != Storage::Native) {
+        half_panels.resize(total);
+        const size_t half = cfg.nr / 2;
+        for (size_t row = 0; row < total; row += cfg.nr) {
+            const T* values = panels.data() + row;
+            uint16_t* out = half_panels.data() + row;
+            for (size_t j = 0; j < cfg.nr; ++j) {
+                const float value = static_cast<float>(values[j]);
+                if (storage == Storage::BFloat16) {
+                    out[j < half ? 2 * j : 2 * (j - half) + 1] = Half::float_to_bfloat16(value);
+                } else {
+                    out[j] = Half::float_to_half(value);
+                }
+            }
+        }
+        panels = MatrixT<T>();
+    }
+}
+
+template <typename T>
+PackedMatrix<T> PackedMatrix<T>::adopt(size_t k, size_t n, Storage storage, const void* data, size_t count,
+                                       std::shared_ptr<const void> owner) {
+    PackedMatrix<T> packed;
+    packed.rows = k;
+    packed.cols = n;
+    packed.storage = storage;
+    const size_t total = packed.plan_blocks();
+    if (count != total) {
+        throw std::invalid_argument("Packed panels hold " + std::to_string(count) + " elements, a " +
+                                    std::to_string(k) + "x" + std::to_string(n) + " operand needs " +
+                                    std::to_string(total) + " under " + panel_layout<T>());
+    }
+
+    if (storage == Storage::Native) {
+        // The micro-kernels use aligned loads on B
+        if (reinterpret_cast<uintptr_t>(data) % MatrixT<T>::ALIGNMENT != 0) {
+            throw std::invalid_argument("Packed panels must be 64-byte aligned");
+        }
+        packed.panels = MatrixT<T>::borrow(static_cast<T*>(const_cast<void*>(data)), 1, total, std::move(owner));
+    } else {
+        const uint16_t* half = static_cast<const uint16_t*>(data);
+        packed.half_panels.assign(half, half + total);
+    }
+    return packed;
+}
+
+template <typename T>
+std::string panel_layout() {
+    const KernelConfig<T>& cfg = active_kernel<T>();
+    return std::string(cfg.name) + (sizeof(T) == sizeof(float) ? "_f32" : "_f64") + "_nr" + std::to_string(cfg.nr) +
+           "_kc" + std::to_string(cfg.kc) + "_nc" + std::to_string(cfg.nc);
+}
+
+template <typename T>
+void gemm_packed(size_t m, const T* a, size_t a_row_stride, size_t a_col_stride,
+                 const PackedMatrix<T>& b, T* c, size_t ldc, const Epilogue<T>& epilogue) {
+    const KernelConfig<T>& cfg = active_kernel<T>();
+    switch (b.get_storage()) {
+        case Storage::BFloat16:
+            run_packed(cfg, cfg.bf16_kernel, b.half_panel_data(), m, a, a_row_stride, a_col_stride, b, c, ldc,
+                       epilogue);
+            break;
+        case Storage::Float16:
+            run_packed(cfg, cfg.f16_kernel, b.half_panel_data(), m, a, a_row_stride, a_col_stride, b, c, ldc,
+                       epilogue);
+            break;
+        default:
+            run_packed(cfg, cfg.kernel, b.panel_data(), m, a, a_row_stride, a_col_stride, b, c, ldc, epilogue);
+            break;
+    }
+}
+
+template <typename T>
+void reserve_thread_buffers() {
+    const KernelConfig<T>& cfg = active_kernel<T>();
+    a_pack_buffer<T>().get(cfg.mc * cfg.kc);
+    b_pack_buffer<T>().get(cfg.kc * round_up(cfg.nc, cfg.nr));
+}
+
+const char* kernel_name() {
+    return active_kernel<float>().name;
+}
+
+#define GEMM_INSTANTIATE(T)                                                              \
+    template void gemm<T>(size_t, size_t, size_t, const T*, size_t, size_t,             \
+                          const T*, size_t, size_t, T*, size_t, const Epilogue<T>&);     \
+    template class PackedMatrix<T>;                                                      \
+    template std::string panel_layout<T>();                                              \
+    template void reserve_thread_buffers<T>();                                           \
+    template void gemm_packed<T>(size_t, const T*, size_t, size_t,                       \
+                                 const PackedMatrix<T>&, T*, size_t, const Epilogue<T>&);
+
+GEMM_INSTANTIATE(float)
+GEMM_INSTANTIATE(double)
+
+#undef GEMM_INSTANTIATE
+
+} // namespace Gemm
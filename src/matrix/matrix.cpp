@@ -3,217 +3,320 @@
 //
 
 #include "../../include/matrix/matrix.h"
+#include "../../include/utils/allocation_tracker.h"
+#include "../../include/utils/profiler.h"
 #include <random>
 #include <iomanip>
+#include <algorithm>
+#include <new>
+#include <cmath>
+
+namespace {
+
+constexpr size_t STORAGE_ALIGNMENT = 64;
+
+// Storage is rounded up to whole cache lines so kernels may read a full
+// 64-byte vector past the last element of a row without faulting.
+template <typename T>
+size_t aligned_bytes(size_t count) {
+    size_t bytes = count * sizeof(T);
+    return (bytes + STORAGE_ALIGNMENT - 1) / STORAGE_ALIGNMENT * STORAGE_ALIGNMENT;
+}
+
+template <typename T>
+T* allocate_storage(size_t count) {
+    if (count == 0) {
+        return nullptr;
+    }
+    if (AllocationTracker::enabled()) {
+        AllocationTracker::record_allocation(aligned_bytes<T>(count));
+    }
+    if (Profiler::enabled()) {
+        Profiler::note_allocation(aligned_bytes<T>(count));
+    }
+    return static_cast<T*>(::operator new(aligned_bytes<T>(count), std::align_val_t(STORAGE_ALIGNMENT)));
+}
+
+// count: the capacity the buffer was allocated with
+template <typename T>
+void release_storage(T* ptr, size_t count) {
+    if (ptr != nullptr) {
+        if (AllocationTracker::enabled()) {
+            AllocationTracker::record_free(aligned_bytes<T>(count));
+        }
+        ::operator delete(ptr, std::align_val_t(STORAGE_ALIGNMENT));
+    }
+}
+
+} // namespace
 
 // Default constructor
-Matrix::Matrix() : rows(0), cols(0) {}
+template <typename T>
+MatrixT<T>::MatrixT() : buffer(nullptr), rows(0), cols(0), capacity(0) {}
 
 // Parameterized constructor
-Matrix::Matrix(size_t rows, size_t cols, double value)
-    : rows(rows), cols(cols), data(rows, std::vector<double>(cols, value)) {}
+template <typename T>
+MatrixT<T>::MatrixT(size_t rows, size_t cols, T value)
+    : buffer(allocate_storage<T>(rows * cols)), rows(rows), cols(cols), capacity(rows * cols) {
+    std::fill(buffer, buffer + size(), value);
+}
 
 // Initializer list constructor
-Matrix::Matrix(const std::initializer_list<std::initializer_list<double>>& init_list) {
-    rows = init_list.size();
+template <typename T>
+MatrixT<T>::MatrixT(const std::initializer_list<std::initializer_list<T>>& init_list)
+    : buffer(nullptr), rows(init_list.size()), cols(0), capacity(0) {
     if (rows == 0) {
-        cols = 0;
         return;
     }
 
     cols = init_list.begin()->size();
-    data.resize(rows);
-
-    size_t i = 0;
     for (const auto& row : init_list) {
         if (row.size() != cols) {
             throw std::invalid_argument("All rows must have the same number of columns");
         }
-        data[i].assign(row.begin(), row.end());
-        ++i;
+    }
+
+    buffer = allocate_storage<T>(rows * cols);
+    capacity = rows * cols;
+
+    T* out = buffer;
+    for (const auto& row : init_list) {
+        out = std::copy(row.begin(), row.end(), out);
+    }
+}
+
+// Copy out of a (possibly strided) view
+template <typename T>
+MatrixT<T>::MatrixT(const ConstMatrixViewT<T>& view)
+    : buffer(allocate_storage<T>(view.getRows() * view.getCols())),
+      rows(view.getRows()), cols(view.getCols()), capacity(view.getRows() * view.getCols()) {
+    for (size_t i = 0; i < rows; ++i) {
+        std::copy(view.row_ptr(i), view.row_ptr(i) + cols, row_ptr(i));
     }
 }
 
 // Copy constructor
-Matrix::Matrix(const Matrix& other)
-    : rows(other.rows), cols(other.cols), data(other.data) {}
+template <typename T>
+MatrixT<T>::MatrixT(const MatrixT& other)
+    : buffer(allocate_storage<T>(other.size())), rows(other.rows), cols(other.cols), capacity(other.size()) {
+    std::copy(other.buffer, other.buffer + other.size(), buffer);
+}
 
 // Copy assignment
-Matrix& Matrix::operator=(const Matrix& other) {
+template <typename T>
+MatrixT<T>& MatrixT<T>::operator=(const MatrixT& other) {
     if (this != &other) {
+        if (external || capacity < other.size()) {
+            release_owned();
+            buffer = allocate_storage<T>(other.size());
+            capacity = other.size();
+        }
         rows = other.rows;
         cols = other.cols;
-        data = other.data;
+        std::copy(other.buffer, other.buffer + other.size(), buffer);
     }
     return *this;
 }
 
 // Move constructor
-Matrix::Matrix(Matrix&& other) noexcept
-    : rows(other.rows), cols(other.cols), data(std::move(other.data)) {
+template <typename T>
+MatrixT<T>::MatrixT(MatrixT&& other) noexcept
+    : buffer(other.buffer), rows(other.rows), cols(other.cols), capacity(other.capacity),
+      external(std::move(other.external)) {
+    other.buffer = nullptr;
     other.rows = 0;
     other.cols = 0;
+    other.capacity = 0;
 }
 
 // Move assignment
-Matrix& Matrix::operator=(Matrix&& other) noexcept {
+template <typename T>
+MatrixT<T>& MatrixT<T>::operator=(MatrixT&& other) noexcept {
     if (this != &other) {
+        release_owned();
+        buffer = other.buffer;
         rows = other.rows;
         cols = other.cols;
-        data = std::move(other.data);
+        capacity = other.capacity;
+        external = std::move(other.external);
+        other.buffer = nullptr;
         other.rows = 0;
         other.cols = 0;
+        other.capacity = 0;
     }
     return *this;
 }
 
-// Element access
-double& Matrix::operator()(size_t row, size_t col) {
-    if (row >= rows || col >= cols) {
-        throw std::out_of_range("Matrix indices out of range");
-    }
-    return data[row][col];
+// Destructor
+template <typename T>
+MatrixT<T>::~MatrixT() {
+    release_owned();
 }
 
-const double& Matrix::operator()(size_t row, size_t col) const {
-    if (row >= rows || col >= cols) {
-        throw std::out_of_range("Matrix indices out of range");
+template <typename T>
+void MatrixT<T>::release_owned() {
+    if (external) {
+        external.reset();
+    } else {
+        release_storage(buffer, capacity);
     }
-    return data[row][col];
+    buffer = nullptr;
+    capacity = 0;
 }
 
-// Utility functions
-void Matrix::fill(double value) {
-    for (auto& row : data) {
-        std::fill(row.begin(), row.end(), value);
-    }
+// Borrowed storage
+template <typename T>
+MatrixT<T> MatrixT<T>::borrow(T* data, size_t rows, size_t cols, std::shared_ptr<const void> owner) {
+    MatrixT result;
+    result.buffer = data;
+    result.rows = rows;
+    result.cols = cols;
+    result.capacity = rows * cols;
+    result.external = owner ? std::move(owner) : std::make_shared<int>(0);
+    return result;
 }
 
-void Matrix::resize(size_t new_rows, size_t new_cols, double value) {
-    rows = new_rows;
-    cols = new_cols;
-    data.assign(rows, std::vector<double>(cols, value));
+// Views
+template <typename T>
+MatrixViewT<T> MatrixT<T>::block(size_t row, size_t col, size_t num_rows, size_t num_cols) {
+    return view().block(row, col, num_rows, num_cols);
 }
 
-void Matrix::print() const {
-    for (const auto& row : data) {
-        for (const auto& elem : row) {
-            std::cout << std::setw(8) << std::fixed << std::setprecision(3) << elem << " ";
-        }
-        std::cout << std::endl;
-    }
+template <typename T>
+ConstMatrixViewT<T> MatrixT<T>::block(size_t row, size_t col, size_t num_rows, size_t num_cols) const {
+    return view().block(row, col, num_rows, num_cols);
 }
 
-// Static factory methods
-Matrix Matrix::zeros(size_t rows, size_t cols) {
-    return Matrix(rows, cols, 0.0);
+template <typename T>
+void MatrixViewT<T>::assign(const ConstMatrixViewT<T>& source) const {
+    if (source.getRows() != rows || source.getCols() != cols) {
+        throw std::invalid_argument("MatrixView assign requires matching dimensions");
+    }
+    for (size_t i = 0; i < rows; ++i) {
+        std::copy(source.row_ptr(i), source.row_ptr(i) + cols, row_ptr(i));
+    }
 }
 
-Matrix Matrix::ones(size_t rows, size_t cols) {
-    return Matrix(rows, cols, 1.0);
+template <typename T>
+void MatrixViewT<T>::fill(T value) const {
+    for (size_t i = 0; i < rows; ++i) {
+        std::fill(row_ptr(i), row_ptr(i) + cols, value);
+    }
 }
 
-Matrix Matrix::identity(size_t size) {
-    Matrix result(size, size, 0.0);
-    for (size_t i = 0; i < size; ++i) {
-        result(i, i) = 1.0;
-    }
-    return result;
+// Utility functions
+template <typename T>
+void MatrixT<T>::fill(T value) {
+    std::fill(buffer, buffer + size(), value);
 }
 
-Matrix Matrix::random(size_t rows, size_t cols, double min, double max) {
-    Matrix result(rows, cols);
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<double> dis(min, max);
+template <typename T>
+void MatrixT<T>::resize(size_t new_rows, size_t new_cols, T value) {
+    resize_for_overwrite(new_rows, new_cols);
+    fill(value);
+}
 
-    for (size_t i = 0; i < rows; ++i) {
-        for (size_t j = 0; j < cols; ++j) {
-            result(i, j) = dis(gen);
-        }
+template <typename T>
+void MatrixT<T>::resize_for_overwrite(size_t new_rows, size_t new_cols) {
+    size_t count = new_rows * new_cols;
+    // Borrowed storage is kept while the element count matches (see borrow())
+    if (external ? count != size() : capacity < count) {
+        release_owned();
+        buffer = allocate_storage<T>(count);
+        capacity = count;
     }
-    return result;
+    rows = new_rows;
+    cols = new_cols;
 }
 
-// Basic operators
-Matrix Matrix::operator+(const Matrix& other) const {
-    if (rows != other.rows || cols != other.cols) {
-        throw std::invalid_argument("Matrices must have the same dimensions for addition");
+template <typename T>
+void MatrixT<T>::reshape(size_t new_rows, size_t new_cols) {
+    if (new_rows * new_cols != rows * cols) {
+        throw std::invalid_argument("Cannot reshape a " + std::to_string(rows) + "x" + std::to_string(cols) +
+                                    " matrix to " + std::to_string(new_rows) + "x" + std::to_string(new_cols));
     }
+    rows = new_rows;
+    cols = new_cols;
+}
 
-    Matrix result(rows, cols);
+template <typename T>
+void MatrixT<T>::print() const {
     for (size_t i = 0; i < rows; ++i) {
+        const T* row = row_ptr(i);
         for (size_t j = 0; j < cols; ++j) {
-            result(i, j) = data[i][j] + other.data[i][j];
+            std::cout << std::setw(8) << std::fixed << std::setprecision(3) << row[j] << " ";
         }
+        std::cout << std::endl;
     }
-    return result;
 }
 
-Matrix Matrix::operator-(const Matrix& other) const {
-    if (rows != other.rows || cols != other.cols) {
-        throw std::invalid_argument("Matrices must have the same dimensions for subtraction");
-    }
+// Static factory methods
+template <typename T>
+MatrixT<T> MatrixT<T>::zeros(size_t rows, size_t cols) {
+    return MatrixT(rows, cols, T(0));
+}
 
-    Matrix result(rows, cols);
-    for (size_t i = 0; i < rows; ++i) {
-        for (size_t j = 0; j < cols; ++j) {
-            result(i, j) = data[i][j] - other.data[i][j];
-        }
-    }
-    return result;
+template <typename T>
+MatrixT<T> MatrixT<T>::ones(size_t rows, size_t cols) {
+    return MatrixT(rows, cols, T(1));
 }
 
-Matrix Matrix::operator*(double scalar) const {
-    Matrix result(rows, cols);
-    for (size_t i = 0; i < rows; ++i) {
-        for (size_t j = 0; j < cols; ++j) {
-            result(i, j) = data[i][j] * scalar;
-        }
+template <typename T>
+MatrixT<T> MatrixT<T>::identity(size_t size) {
+    MatrixT result(size, size, T(0));
+    for (size_t i = 0; i < size; ++i) {
+        result.buffer[i * (size + 1)] = T(1);
     }
     return result;
 }
 
-Matrix Matrix::operator/(double scalar) const {
-    if (scalar == 0.0) {
-        throw std::invalid_argument("Division by zero");
+template <typename T>
+MatrixT<T> MatrixT<T>::random(size_t rows, size_t cols, T min, T max) {
+    MatrixT result(rows, cols);
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    std::uniform_real_distribution<T> dis(min, max);
+
+    for (size_t k = 0; k < result.size(); ++k) {
+        result.buffer[k] = dis(gen);
     }
-    return (*this) * (1.0 / scalar);
+    return result;
 }
 
-// Comparison operators
-bool Matrix::operator==(const Matrix& other) const {
+template <typename T>
+bool MatrixT<T>::operator==(const MatrixT& other) const {
     if (rows != other.rows || cols != other.cols) {
         return false;
     }
 
-    const double epsilon = 1e-9;
-    for (size_t i = 0; i < rows; ++i) {
-        for (size_t j = 0; j < cols; ++j) {
-            if (std::abs(data[i][j] - other.data[i][j]) > epsilon) {
-                return false;
-            }
+    const T epsilon = T(1e-9);
+    for (size_t k = 0; k < size(); ++k) {
+        if (std::abs(buffer[k] - other.buffer[k]) > epsilon) {
+            return false;
         }
     }
     return true;
 }
 
-bool Matrix::operator!=(const Matrix& other) const {
+template <typename T>
+bool MatrixT<T>::operator!=(const MatrixT& other) const {
     return !(*this == other);
 }
 
-// Friend functions
-Matrix operator*(double scalar, const Matrix& matrix) {
-    return matrix * scalar;
-}
-
-std::ostream& operator<<(std::ostream& os, const Matrix& matrix) {
-    for (size_t i = 0; i < matrix.rows; ++i) {
-        for (size_t j = 0; j < matrix.cols; ++j) {
-            os << std::setw(8) << std::fixed << std::setprecision(3) << matrix.data[i][j];
-            if (j < matrix.cols - 1) os << " ";
+template <typename T>
+std::ostream& MatrixT<T>::write_to(std::ostream& os) const {
+    for (size_t i = 0; i < rows; ++i) {
+        const T* row = row_ptr(i);
+        for (size_t j = 0; j < cols; ++j) {
+            os << std::setw(8) << std::fixed << std::setprecision(3) << row[j];
+            if (j < cols - 1) os << " ";
         }
-        if (i < matrix.rows - 1) os << "\n";
+        if (i < rows - 1) os << "\n";
     }
     return os;
-}
\ No newline at end of file
+}
+
+template class MatrixT<float>;
+template class MatrixT<double>;
+template class MatrixViewT<float>;
+template class MatrixViewT<double>;
@@ -3,232 +3,565 @@
 //
 
 #include "../../include/matrix/matrix_ops.h"
+#include "../../include/matrix/vector_math.h"
+#include "../../include/utils/profiler.h"
 #include <cmath>
 #include <algorithm>
+#include <functional>
+#include <string>
 
 namespace MatrixOps {
 
-Matrix matmul(const Matrix& a, const Matrix& b) {
-    if (a.getCols() != b.getRows()) {
-        throw std::invalid_argument("Matrix dimensions incompatible for multiplication");
-    }
-
-    size_t rows = a.getRows();
-    size_t cols = b.getCols();
-    size_t inner = a.getCols();
+namespace {
 
-    Matrix result(rows, cols, 0.0);
+template <typename T>
+bool same_shape(const MatrixViewT<T>& out, const ConstMatrixViewT<T>& in) {
+    return out.getRows() == in.getRows() && out.getCols() == in.getCols();
+}
 
-    for (size_t i = 0; i < rows; ++i) {
-        for (size_t j = 0; j < cols; ++j) {
-            for (size_t k = 0; k < inner; ++k) {
-                result(i, j) += a(i, k) * b(k, j);
-            }
-        }
+// True when the memory spanned by out and in intersects. Products and
+// transposes read their inputs after writing parts of out, so they cannot
+// run in place.
+template <typename T>
+bool overlaps(const MatrixViewT<T>& out, const ConstMatrixViewT<T>& in) {
+    if (out.getRows() == 0 || out.getCols() == 0 || in.getRows() == 0 || in.getCols() == 0) {
+        return false;
     }
-
-    return result;
+    const T* out_begin = out.data();
+    const T* out_end = out.row_ptr(out.getRows() - 1) + out.getCols();
+    const T* in_begin = in.data();
+    const T* in_end = in.row_ptr(in.getRows() - 1) + in.getCols();
+    std::less<const T*> before;
+    return before(out_begin, in_end) && before(in_begin, out_end);
 }
 
-Matrix elementWiseMultiply(const Matrix& a, const Matrix& b) {
-    if (a.getRows() != b.getRows() || a.getCols() != b.getCols()) {
-        throw std::invalid_argument("Matrices must have same dimensions for element-wise multiplication");
+template <typename T>
+void check_product_output(const MatrixViewT<T>& out, size_t rows, size_t cols, const ConstMatrixViewT<T>& a,
+                          const ConstMatrixViewT<T>& b) {
+    if (out.getRows() != rows || out.getCols() != cols) {
+        throw std::invalid_argument("Output must be " + std::to_string(rows) + "x" + std::to_string(cols) +
+                                    " for this multiplication");
     }
+    if (overlaps(out, a) || overlaps(out, b)) {
+        throw std::invalid_argument("Matrix multiplication output must not overlap its inputs");
+    }
+}
 
-    Matrix result(a.getRows(), a.getCols());
+// out = f(a) element by element, row by row
+template <typename T, typename F>
+void map_rows(const MatrixViewT<T>& out, const ConstMatrixViewT<T>& a, F f) {
+    if (!same_shape(out, a)) {
+        throw std::invalid_argument("Output must match the input dimensions");
+    }
     for (size_t i = 0; i < a.getRows(); ++i) {
+        const T* in = a.row_ptr(i);
+        T* dst = out.row_ptr(i);
         for (size_t j = 0; j < a.getCols(); ++j) {
-            result(i, j) = a(i, j) * b(i, j);
+            dst[j] = f(in[j]);
         }
     }
-    return result;
 }
 
-Matrix elementWiseDivide(const Matrix& a, const Matrix& b) {
-    if (a.getRows() != b.getRows() || a.getCols() != b.getCols()) {
-        throw std::invalid_argument("Matrices must have same dimensions for element-wise division");
+// out = f(a, b) element by element, row by row
+template <typename T, typename F>
+void zip_rows(const MatrixViewT<T>& out, const ConstMatrixViewT<T>& a, const ConstMatrixViewT<T>& b, F f) {
+    if (!same_shape(out, a)) {
+        throw std::invalid_argument("Output must match the input dimensions");
     }
-
-    Matrix result(a.getRows(), a.getCols());
     for (size_t i = 0; i < a.getRows(); ++i) {
+        const T* lhs = a.row_ptr(i);
+        const T* rhs = b.row_ptr(i);
+        T* dst = out.row_ptr(i);
         for (size_t j = 0; j < a.getCols(); ++j) {
-            if (b(i, j) == 0.0) {
-                throw std::invalid_argument("Division by zero in element-wise division");
-            }
-            result(i, j) = a(i, j) / b(i, j);
+            dst[j] = f(lhs[j], rhs[j]);
         }
     }
-    return result;
 }
 
-Matrix transpose(const Matrix& matrix) {
-    Matrix result(matrix.getCols(), matrix.getRows());
-    for (size_t i = 0; i < matrix.getRows(); ++i) {
-        for (size_t j = 0; j < matrix.getCols(); ++j) {
-            result(j, i) = matrix(i, j);
-        }
+template <typename T>
+void check_same_dimensions(const ConstMatrixViewT<T>& a, const ConstMatrixViewT<T>& b, const char* message) {
+    if (a.getRows() != b.getRows() || a.getCols() != b.getCols()) {
+        throw std::invalid_argument(message);
     }
-    return result;
 }
 
-Matrix addBroadcast(const Matrix& matrix, const Matrix& vector, bool row_vector) {
-    Matrix result(matrix.getRows(), matrix.getCols());
-
+template <typename T>
+void check_broadcast(const ConstMatrixViewT<T>& matrix, const ConstMatrixViewT<T>& vector, bool row_vector) {
     if (row_vector) {
-        // Broadcasting row vector across all rows
         if (vector.getCols() != matrix.getCols() || vector.getRows() != 1) {
             throw std::invalid_argument("Vector dimensions incompatible for row broadcasting");
         }
+    } else if (vector.getRows() != matrix.getRows() || vector.getCols() != 1) {
+        throw std::invalid_argument("Vector dimensions incompatible for column broadcasting");
+    }
+}
 
-        for (size_t i = 0; i < matrix.getRows(); ++i) {
-            for (size_t j = 0; j < matrix.getCols(); ++j) {
-                result(i, j) = matrix(i, j) + vector(0, j);
-            }
-        }
-    } else {
-        // Broadcasting column vector across all columns
-        if (vector.getRows() != matrix.getRows() || vector.getCols() != 1) {
-            throw std::invalid_argument("Vector dimensions incompatible for column broadcasting");
-        }
+std::pair<size_t, size_t> reduced_shape(size_t rows, size_t cols, int axis) {
+    if (axis == 0) {
+        return {1, cols};
+    }
+    if (axis == 1) {
+        return {rows, 1};
+    }
+    throw std::invalid_argument("Axis must be 0 or 1");
+}
 
-        for (size_t i = 0; i < matrix.getRows(); ++i) {
-            for (size_t j = 0; j < matrix.getCols(); ++j) {
-                result(i, j) = matrix(i, j) + vector(i, 0);
-            }
-        }
+// Work counts for the profiler scopes: 2mnk for an (m x k) * (k x n) product,
+// one flop per element for element-wise kernels; bytes are operand traffic
+double product_flops(size_t m, size_t k, size_t n) {
+    return 2.0 * m * k * n;
+}
+
+template <typename T>
+double product_bytes(size_t m, size_t k, size_t n) {
+    return double(sizeof(T)) * (double(m) * k + double(k) * n + double(m) * n);
+}
+
+template <typename T>
+double elements(const ConstMatrixViewT<T>& a) {
+    return double(a.getRows()) * a.getCols();
+}
+
+// `inputs` same-shaped inputs plus the output
+template <typename T>
+double elementwise_bytes(const ConstMatrixViewT<T>& a, int inputs) {
+    return double(sizeof(T)) * elements(a) * (inputs + 1);
+}
+
+} // namespace
+
+template <typename T>
+void matmul_into(const MatrixViewT<T>& out, ConstViewArg<T> a, ConstViewArg<T> b) {
+    VIT_PROFILE_SCOPE("MatrixOps", "matmul", product_flops(a.getRows(), a.getCols(), b.getCols()),
+                      product_bytes<T>(a.getRows(), a.getCols(), b.getCols()));
+    if (a.getCols() != b.getRows()) {
+        throw std::invalid_argument("MatrixT<T> dimensions incompatible for multiplication");
+    }
+    check_product_output(out, a.getRows(), b.getCols(), a, b);
+
+    Gemm::gemm(a.getRows(), b.getCols(), a.getCols(),
+               a.data(), a.getStride(), 1,
+               b.data(), b.getStride(), 1,
+               out.data(), out.getStride());
+}
+
+template <typename T>
+void matmul_nt_into(const MatrixViewT<T>& out, ConstViewArg<T> a, ConstViewArg<T> b) {
+    VIT_PROFILE_SCOPE("MatrixOps", "matmul_nt", product_flops(a.getRows(), a.getCols(), b.getRows()),
+                      product_bytes<T>(a.getRows(), a.getCols(), b.getRows()));
+    if (a.getCols() != b.getCols()) {
+        throw std::invalid_argument("MatrixT<T> dimensions incompatible for multiplication");
+    }
+    check_product_output(out, a.getRows(), b.getRows(), a, b);
+
+    // b^T (k x n) read in place: element (p, j) is b(j, p)
+    Gemm::gemm(a.getRows(), b.getRows(), a.getCols(),
+               a.data(), a.getStride(), 1,
+               b.data(), 1, b.getStride(),
+               out.data(), out.getStride());
+}
+
+template <typename T>
+void matmul_tn_into(const MatrixViewT<T>& out, ConstViewArg<T> a, ConstViewArg<T> b) {
+    VIT_PROFILE_SCOPE("MatrixOps", "matmul_tn", product_flops(a.getCols(), a.getRows(), b.getCols()),
+                      product_bytes<T>(a.getCols(), a.getRows(), b.getCols()));
+    if (a.getRows() != b.getRows()) {
+        throw std::invalid_argument("MatrixT<T> dimensions incompatible for multiplication");
     }
+    check_product_output(out, a.getCols(), b.getCols(), a, b);
+
+    // a^T (m x k) read in place: element (i, p) is a(p, i)
+    Gemm::gemm(a.getCols(), b.getCols(), a.getRows(),
+               a.data(), 1, a.getStride(),
+               b.data(), b.getStride(), 1,
+               out.data(), out.getStride());
+}
 
+template <typename T>
+MatrixT<T> matmul(const MatrixT<T>& a, const MatrixT<T>& b, Workspace* workspace) {
+    MatrixT<T> result = scratch_matrix<T>(a.getRows(), b.getCols(), workspace);
+    matmul_into(result.view(), a, b);
     return result;
 }
 
-Matrix multiplyBroadcast(const Matrix& matrix, const Matrix& vector, bool row_vector) {
-    Matrix result(matrix.getRows(), matrix.getCols());
+template <typename T>
+MatrixT<T> matmul_nt(const MatrixT<T>& a, const MatrixT<T>& b, Workspace* workspace) {
+    MatrixT<T> result = scratch_matrix<T>(a.getRows(), b.getRows(), workspace);
+    matmul_nt_into(result.view(), a, b);
+    return result;
+}
 
-    if (row_vector) {
-        if (vector.getCols() != matrix.getCols() || vector.getRows() != 1) {
-            throw std::invalid_argument("Vector dimensions incompatible for row broadcasting");
+template <typename T>
+MatrixT<T> matmul_tn(const MatrixT<T>& a, const MatrixT<T>& b, Workspace* workspace) {
+    MatrixT<T> result = scratch_matrix<T>(a.getCols(), b.getCols(), workspace);
+    matmul_tn_into(result.view(), a, b);
+    return result;
+}
+
+template <typename T>
+Gemm::PackedMatrix<T> pack_rhs(const MatrixT<T>& b) {
+    VIT_PROFILE_SCOPE("MatrixOps", "pack_rhs", 0, 2.0 * sizeof(T) * b.size());
+    return Gemm::PackedMatrix<T>(b.getRows(), b.getCols(), b.data(), b.getCols(), 1);
+}
+
+template <typename T>
+Gemm::PackedMatrix<T> pack_rhs_transposed(const MatrixT<T>& b, Gemm::Storage storage) {
+    VIT_PROFILE_SCOPE("MatrixOps", "pack_rhs_transposed", 0, 2.0 * sizeof(T) * b.size());
+    return Gemm::PackedMatrix<T>(b.getCols(), b.getRows(), b.data(), 1, b.getCols(), storage);
+}
+
+template <typename T>
+void matmul_into(const MatrixViewT<T>& out, ConstViewArg<T> a, const Gemm::PackedMatrix<T>& b) {
+    VIT_PROFILE_SCOPE("MatrixOps", "matmul_packed", product_flops(a.getRows(), a.getCols(), b.getCols()),
+                      product_bytes<T>(a.getRows(), a.getCols(), b.getCols()));
+    if (a.getCols() != b.getRows()) {
+        throw std::invalid_argument("MatrixT<T> dimensions incompatible for multiplication");
+    }
+    if (out.getRows() != a.getRows() || out.getCols() != b.getCols()) {
+        throw std::invalid_argument("Output must be " + std::to_string(a.getRows()) + "x" +
+                                    std::to_string(b.getCols()) + " for this multiplication");
+    }
+    if (overlaps(out, a)) {
+        throw std::invalid_argument("Matrix multiplication output must not overlap its inputs");
+    }
+
+    Gemm::gemm_packed(a.getRows(), a.data(), a.getStride(), 1, b, out.data(), out.getStride());
+}
+
+template <typename T>
+MatrixT<T> matmul(const MatrixT<T>& a, const Gemm::PackedMatrix<T>& b, Workspace* workspace) {
+    MatrixT<T> result = scratch_matrix<T>(a.getRows(), b.getCols(), workspace);
+    matmul_into(result.view(), a, b);
+    return result;
+}
+
+template <typename T>
+void elementWiseMultiply_into(const MatrixViewT<T>& out, ConstViewArg<T> a, ConstViewArg<T> b) {
+    VIT_PROFILE_SCOPE("MatrixOps", "elementWiseMultiply", elements(a), elementwise_bytes(a, 2));
+    check_same_dimensions(a, b, "Matrices must have same dimensions for element-wise multiplication");
+    zip_rows(out, a, b, [](T x, T y) { return x * y; });
+}
+
+template <typename T>
+void elementWiseDivide_into(const MatrixViewT<T>& out, ConstViewArg<T> a, ConstViewArg<T> b) {
+    VIT_PROFILE_SCOPE("MatrixOps", "elementWiseDivide", elements(a), elementwise_bytes(a, 2));
+    check_same_dimensions(a, b, "Matrices must have same dimensions for element-wise division");
+    zip_rows(out, a, b, [](T x, T y) {
+        if (y == T(0)) {
+            throw std::invalid_argument("Division by zero in element-wise division");
         }
+        return x / y;
+    });
+}
 
-        for (size_t i = 0; i < matrix.getRows(); ++i) {
-            for (size_t j = 0; j < matrix.getCols(); ++j) {
-                result(i, j) = matrix(i, j) * vector(0, j);
+template <typename T>
+MatrixT<T> elementWiseMultiply(const MatrixT<T>& a, const MatrixT<T>& b, Workspace* workspace) {
+    MatrixT<T> result = scratch_matrix<T>(a.getRows(), a.getCols(), workspace);
+    elementWiseMultiply_into(result.view(), a, b);
+    return result;
+}
+
+template <typename T>
+MatrixT<T> elementWiseDivide(const MatrixT<T>& a, const MatrixT<T>& b, Workspace* workspace) {
+    MatrixT<T> result = scratch_matrix<T>(a.getRows(), a.getCols(), workspace);
+    elementWiseDivide_into(result.view(), a, b);
+    return result;
+}
+
+template <typename T>
+void add_into(const MatrixViewT<T>& out, ConstViewArg<T> a, ConstViewArg<T> b) {
+    VIT_PROFILE_SCOPE("MatrixOps", "add", elements(a), elementwise_bytes(a, 2));
+    check_same_dimensions(a, b, "Matrices must have the same dimensions for addition");
+    zip_rows(out, a, b, [](T x, T y) { return x + y; });
+}
+
+template <typename T>
+void subtract_into(const MatrixViewT<T>& out, ConstViewArg<T> a, ConstViewArg<T> b) {
+    VIT_PROFILE_SCOPE("MatrixOps", "subtract", elements(a), elementwise_bytes(a, 2));
+    check_same_dimensions(a, b, "Matrices must have the same dimensions for subtraction");
+    zip_rows(out, a, b, [](T x, T y) { return x - y; });
+}
+
+template <typename T>
+void scale_into(const MatrixViewT<T>& out, ConstViewArg<T> a, double scalar) {
+    VIT_PROFILE_SCOPE("MatrixOps", "scale", elements(a), elementwise_bytes(a, 1));
+    const T factor = static_cast<T>(scalar);
+    map_rows(out, a, [factor](T x) { return x * factor; });
+}
+
+template <typename T>
+MatrixT<T> transpose(const MatrixT<T>& matrix, Workspace* workspace) {
+    return transpose(matrix.view(), workspace);
+}
+
+template <typename T>
+MatrixT<T> transpose(const ConstMatrixViewT<T>& view, Workspace* workspace) {
+    MatrixT<T> result = scratch_matrix<T>(view.getCols(), view.getRows(), workspace);
+    transpose_into(result.view(), view);
+    return result;
+}
+
+template <typename T>
+MatrixT<T> as_row_vector(MatrixT<T> vector) {
+    vector.reshape(1, vector.size());
+    return vector;
+}
+
+template <typename T>
+void transpose_into(const MatrixViewT<T>& out, ConstViewArg<T> view) {
+    VIT_PROFILE_SCOPE("MatrixOps", "transpose", 0, elementwise_bytes(view, 1));
+    const size_t rows = view.getRows();
+    const size_t cols = view.getCols();
+    if (out.getRows() != cols || out.getCols() != rows) {
+        throw std::invalid_argument("Transpose output must be " + std::to_string(cols) + "x" + std::to_string(rows));
+    }
+    if (overlaps(out, view)) {
+        throw std::invalid_argument("Transpose output must not overlap its input");
+    }
+
+    // Walk the source in square tiles so both the reads and the strided
+    // writes stay within a handful of cache lines.
+    const size_t tile = 32;
+    for (size_t i0 = 0; i0 < rows; i0 += tile) {
+        size_t i_end = std::min(i0 + tile, rows);
+        for (size_t j0 = 0; j0 < cols; j0 += tile) {
+            size_t j_end = std::min(j0 + tile, cols);
+            for (size_t i = i0; i < i_end; ++i) {
+                const T* src = view.row_ptr(i);
+                for (size_t j = j0; j < j_end; ++j) {
+                    out.row_ptr(j)[i] = src[j];
+                }
             }
         }
-    } else {
-        if (vector.getRows() != matrix.getRows() || vector.getCols() != 1) {
-            throw std::invalid_argument("Vector dimensions incompatible for column broadcasting");
+    }
+}
+
+template <typename T>
+void addBroadcast_into(const MatrixViewT<T>& out, ConstViewArg<T> matrix, ConstViewArg<T> vector, bool row_vector) {
+    VIT_PROFILE_SCOPE("MatrixOps", "addBroadcast", elements(matrix), elementwise_bytes(matrix, 1));
+    check_broadcast(matrix, vector, row_vector);
+    if (!same_shape(out, matrix)) {
+        throw std::invalid_argument("Output must match the input dimensions");
+    }
+
+    for (size_t i = 0; i < matrix.getRows(); ++i) {
+        const T* in = matrix.row_ptr(i);
+        T* dst = out.row_ptr(i);
+        if (row_vector) {
+            // Broadcasting row vector across all rows
+            const T* v = vector.row_ptr(0);
+            for (size_t j = 0; j < matrix.getCols(); ++j) {
+                dst[j] = in[j] + v[j];
+            }
+        } else {
+            // Broadcasting column vector across all columns
+            const T v = vector.row_ptr(i)[0];
+            for (size_t j = 0; j < matrix.getCols(); ++j) {
+                dst[j] = in[j] + v;
+            }
         }
+    }
+}
 
-        for (size_t i = 0; i < matrix.getRows(); ++i) {
+template <typename T>
+void multiplyBroadcast_into(const MatrixViewT<T>& out, ConstViewArg<T> matrix, ConstViewArg<T> vector,
+                            bool row_vector) {
+    VIT_PROFILE_SCOPE("MatrixOps", "multiplyBroadcast", elements(matrix), elementwise_bytes(matrix, 1));
+    check_broadcast(matrix, vector, row_vector);
+    if (!same_shape(out, matrix)) {
+        throw std::invalid_argument("Output must match the input dimensions");
+    }
+
+    for (size_t i = 0; i < matrix.getRows(); ++i) {
+        const T* in = matrix.row_ptr(i);
+        T* dst = out.row_ptr(i);
+        if (row_vector) {
+            const T* v = vector.row_ptr(0);
             for (size_t j = 0; j < matrix.getCols(); ++j) {
-                result(i, j) = matrix(i, j) * vector(i, 0);
+                dst[j] = in[j] * v[j];
+            }
+        } else {
+            const T v = vector.row_ptr(i)[0];
+            for (size_t j = 0; j < matrix.getCols(); ++j) {
+                dst[j] = in[j] * v;
             }
         }
     }
+}
 
+template <typename T>
+MatrixT<T> addBroadcast(const MatrixT<T>& matrix, const MatrixT<T>& vector, bool row_vector, Workspace* workspace) {
+    MatrixT<T> result = scratch_matrix<T>(matrix.getRows(), matrix.getCols(), workspace);
+    addBroadcast_into(result.view(), matrix, vector, row_vector);
     return result;
 }
 
-double sum(const Matrix& matrix) {
+template <typename T>
+MatrixT<T> multiplyBroadcast(const MatrixT<T>& matrix, const MatrixT<T>& vector, bool row_vector,
+                             Workspace* workspace) {
+    MatrixT<T> result = scratch_matrix<T>(matrix.getRows(), matrix.getCols(), workspace);
+    multiplyBroadcast_into(result.view(), matrix, vector, row_vector);
+    return result;
+}
+
+template <typename T>
+double sum(const MatrixT<T>& matrix) {
+    VIT_PROFILE_SCOPE("MatrixOps", "sum", matrix.size(), sizeof(T) * matrix.size());
     double total = 0.0;
-    for (size_t i = 0; i < matrix.getRows(); ++i) {
-        for (size_t j = 0; j < matrix.getCols(); ++j) {
-            total += matrix(i, j);
-        }
+    for (size_t k = 0; k < matrix.size(); ++k) {
+        total += matrix.data()[k];
     }
     return total;
 }
 
-double mean(const Matrix& matrix) {
+template <typename T>
+double mean(const MatrixT<T>& matrix) {
     return sum(matrix) / (matrix.getRows() * matrix.getCols());
 }
 
-Matrix sumAxis(const Matrix& matrix, int axis) {
+template <typename T>
+void sumAxis_into(const MatrixViewT<T>& out, ConstViewArg<T> matrix, int axis) {
+    VIT_PROFILE_SCOPE("MatrixOps", "sumAxis", elements(matrix), sizeof(T) * elements(matrix));
+    auto [rows, cols] = reduced_shape(matrix.getRows(), matrix.getCols(), axis);
+    if (out.getRows() != rows || out.getCols() != cols) {
+        throw std::invalid_argument("Reduction output must be " + std::to_string(rows) + "x" + std::to_string(cols));
+    }
+
     if (axis == 0) {
-        // Sum across rows (result is row vector)
-        Matrix result(1, matrix.getCols(), 0.0);
-        for (size_t j = 0; j < matrix.getCols(); ++j) {
-            for (size_t i = 0; i < matrix.getRows(); ++i) {
-                result(0, j) += matrix(i, j);
+        // Sum across rows (result is row vector), accumulated row by row
+        T* dst = out.row_ptr(0);
+        std::fill(dst, dst + matrix.getCols(), T(0));
+        for (size_t i = 0; i < matrix.getRows(); ++i) {
+            const T* in = matrix.row_ptr(i);
+            for (size_t j = 0; j < matrix.getCols(); ++j) {
+                dst[j] += in[j];
             }
         }
-        return result;
-    } else if (axis == 1) {
+    } else {
         // Sum across columns (result is column vector)
-        Matrix result(matrix.getRows(), 1, 0.0);
         for (size_t i = 0; i < matrix.getRows(); ++i) {
+            const T* in = matrix.row_ptr(i);
+            T total = T(0);
             for (size_t j = 0; j < matrix.getCols(); ++j) {
-                result(i, 0) += matrix(i, j);
+                total += in[j];
             }
+            out.row_ptr(i)[0] = total;
         }
-        return result;
-    } else {
-        throw std::invalid_argument("Axis must be 0 or 1");
     }
 }
 
-Matrix meanAxis(const Matrix& matrix, int axis) {
-    Matrix result = sumAxis(matrix, axis);
-    if (axis == 0) {
-        result = result / static_cast<double>(matrix.getRows());
-    } else {
-        result = result / static_cast<double>(matrix.getCols());
-    }
+template <typename T>
+void meanAxis_into(const MatrixViewT<T>& out, ConstViewArg<T> matrix, int axis) {
+    VIT_PROFILE_SCOPE("MatrixOps", "meanAxis", 0, 0);
+    sumAxis_into(out, matrix, axis);
+    const size_t count = axis == 0 ? matrix.getRows() : matrix.getCols();
+    scale_into(out, out, 1.0 / static_cast<double>(count));
+}
+
+template <typename T>
+MatrixT<T> sumAxis(const MatrixT<T>& matrix, int axis, Workspace* workspace) {
+    auto [rows, cols] = reduced_shape(matrix.getRows(), matrix.getCols(), axis);
+    MatrixT<T> result = scratch_matrix<T>(rows, cols, workspace);
+    sumAxis_into(result.view(), matrix, axis);
     return result;
 }
 
-Matrix power(const Matrix& matrix, double exponent) {
-    Matrix result(matrix.getRows(), matrix.getCols());
-    for (size_t i = 0; i < matrix.getRows(); ++i) {
-        for (size_t j = 0; j < matrix.getCols(); ++j) {
-            result(i, j) = std::pow(matrix(i, j), exponent);
-        }
-    }
+template <typename T>
+MatrixT<T> meanAxis(const MatrixT<T>& matrix, int axis, Workspace* workspace) {
+    auto [rows, cols] = reduced_shape(matrix.getRows(), matrix.getCols(), axis);
+    MatrixT<T> result = scratch_matrix<T>(rows, cols, workspace);
+    meanAxis_into(result.view(), matrix, axis);
     return result;
 }
 
-Matrix sqrt(const Matrix& matrix) {
-    return power(matrix, 0.5);
+template <typename T>
+void power_into(const MatrixViewT<T>& out, ConstViewArg<T> matrix, double exponent) {
+    VIT_PROFILE_SCOPE("MatrixOps", "power", elements(matrix), elementwise_bytes(matrix, 1));
+    map_rows(out, matrix, [exponent](T x) { return static_cast<T>(std::pow(x, exponent)); });
+}
+
+template <typename T>
+void sqrt_into(const MatrixViewT<T>& out, ConstViewArg<T> matrix) {
+    VIT_PROFILE_SCOPE("MatrixOps", "sqrt", elements(matrix), elementwise_bytes(matrix, 1));
+    map_rows(out, matrix, [](T x) { return std::sqrt(x); });
 }
 
-Matrix exp(const Matrix& matrix) {
-    Matrix result(matrix.getRows(), matrix.getCols());
+template <typename T>
+void exp_into(const MatrixViewT<T>& out, ConstViewArg<T> matrix) {
+    VIT_PROFILE_SCOPE("MatrixOps", "exp", elements(matrix), elementwise_bytes(matrix, 1));
+    if (!same_shape(out, matrix)) {
+        throw std::invalid_argument("Output must match the input dimensions");
+    }
+    if (out.is_contiguous() && matrix.is_contiguous()) {
+        VectorMath::exp(matrix.data(), out.data(), matrix.getRows() * matrix.getCols());
+        return;
+    }
     for (size_t i = 0; i < matrix.getRows(); ++i) {
-        for (size_t j = 0; j < matrix.getCols(); ++j) {
-            result(i, j) = std::exp(matrix(i, j));
-        }
+        VectorMath::exp(matrix.row_ptr(i), out.row_ptr(i), matrix.getCols());
     }
-    return result;
 }
 
-Matrix log(const Matrix& matrix) {
-    Matrix result(matrix.getRows(), matrix.getCols());
-    for (size_t i = 0; i < matrix.getRows(); ++i) {
-        for (size_t j = 0; j < matrix.getCols(); ++j) {
-            if (matrix(i, j) <= 0.0) {
-                throw std::invalid_argument("Logarithm of non-positive number");
-            }
-            result(i, j) = std::log(matrix(i, j));
+template <typename T>
+void log_into(const MatrixViewT<T>& out, ConstViewArg<T> matrix) {
+    VIT_PROFILE_SCOPE("MatrixOps", "log", elements(matrix), elementwise_bytes(matrix, 1));
+    map_rows(out, matrix, [](T x) {
+        if (x <= T(0)) {
+            throw std::invalid_argument("Logarithm of non-positive number");
         }
-    }
+        return std::log(x);
+    });
+}
+
+template <typename T>
+MatrixT<T> power(const MatrixT<T>& matrix, double exponent, Workspace* workspace) {
+    MatrixT<T> result = scratch_matrix<T>(matrix.getRows(), matrix.getCols(), workspace);
+    power_into(result.view(), matrix, exponent);
     return result;
 }
 
-double trace(const Matrix& matrix) {
+template <typename T>
+MatrixT<T> sqrt(const MatrixT<T>& matrix, Workspace* workspace) {
+    MatrixT<T> result = scratch_matrix<T>(matrix.getRows(), matrix.getCols(), workspace);
+    sqrt_into(result.view(), matrix);
+    return result;
+}
+
+template <typename T>
+MatrixT<T> exp(const MatrixT<T>& matrix, Workspace* workspace) {
+    MatrixT<T> result = scratch_matrix<T>(matrix.getRows(), matrix.getCols(), workspace);
+    exp_into(result.view(), matrix);
+    return result;
+}
+
+template <typename T>
+MatrixT<T> log(const MatrixT<T>& matrix, Workspace* workspace) {
+    MatrixT<T> result = scratch_matrix<T>(matrix.getRows(), matrix.getCols(), workspace);
+    log_into(result.view(), matrix);
+    return result;
+}
+
+template <typename T>
+double trace(const MatrixT<T>& matrix) {
+    VIT_PROFILE_SCOPE("MatrixOps", "trace", matrix.getRows(), sizeof(T) * matrix.getRows());
     if (matrix.getRows() != matrix.getCols()) {
-        throw std::invalid_argument("Matrix must be square to calculate trace");
+        throw std::invalid_argument("MatrixT<T> must be square to calculate trace");
     }
 
+    // Diagonal elements are cols + 1 apart
+    const T* in = matrix.data();
+    const size_t step = matrix.getCols() + 1;
     double tr = 0.0;
     for (size_t i = 0; i < matrix.getRows(); ++i) {
-        tr += matrix(i, i);
+        tr += in[i * step];
     }
     return tr;
 }
 
-double determinant(const Matrix& matrix) {
+template <typename T>
+double determinant(const MatrixT<T>& matrix) {
+    VIT_PROFILE_SCOPE("MatrixOps", "determinant", 0, sizeof(T) * matrix.size());
     if (matrix.getRows() != matrix.getCols()) {
-        throw std::invalid_argument("Matrix must be square to calculate determinant");
+        throw std::invalid_argument("MatrixT<T> must be square to calculate determinant");
     }
 
     size_t n = matrix.getRows();
@@ -246,32 +579,92 @@ double determinant(const Matrix& matrix) {
     }
 }
 
-Matrix inverse(const Matrix& matrix) {
+template <typename T>
+void inverse_into(const MatrixViewT<T>& out, const MatrixT<T>& matrix) {
+    VIT_PROFILE_SCOPE("MatrixOps", "inverse", 0, 2.0 * sizeof(T) * matrix.size());
     if (matrix.getRows() != matrix.getCols()) {
-        throw std::invalid_argument("Matrix must be square to calculate inverse");
+        throw std::invalid_argument("MatrixT<T> must be square to calculate inverse");
+    }
+    if (out.getRows() != matrix.getRows() || out.getCols() != matrix.getCols()) {
+        throw std::invalid_argument("Inverse output must match the input dimensions");
     }
 
     double det = determinant(matrix);
     if (std::abs(det) < 1e-10) {
-        throw std::invalid_argument("Matrix is singular and cannot be inverted");
+        throw std::invalid_argument("MatrixT<T> is singular and cannot be inverted");
     }
 
     size_t n = matrix.getRows();
 
+    // Read every input element before writing, so out may alias the input
     if (n == 1) {
-        Matrix result(1, 1);
-        result(0, 0) = 1.0 / matrix(0, 0);
-        return result;
+        out(0, 0) = 1.0 / matrix(0, 0);
     } else if (n == 2) {
-        Matrix result(2, 2);
-        result(0, 0) = matrix(1, 1) / det;
-        result(0, 1) = -matrix(0, 1) / det;
-        result(1, 0) = -matrix(1, 0) / det;
-        result(1, 1) = matrix(0, 0) / det;
-        return result;
+        const T a = matrix(0, 0), b = matrix(0, 1), c = matrix(1, 0), d = matrix(1, 1);
+        out(0, 0) = d / det;
+        out(0, 1) = -b / det;
+        out(1, 0) = -c / det;
+        out(1, 1) = a / det;
     } else {
-        throw std::invalid_argument("Matrix inverse only implemented for matrices up to 2x2");
+        throw std::invalid_argument("MatrixT<T> inverse only implemented for matrices up to 2x2");
     }
 }
 
+template <typename T>
+MatrixT<T> inverse(const MatrixT<T>& matrix, Workspace* workspace) {
+    MatrixT<T> result = scratch_matrix<T>(matrix.getRows(), matrix.getCols(), workspace);
+    inverse_into(result.view(), matrix);
+    return result;
+}
+
+#define MATRIX_OPS_INSTANTIATE(T)                                                                  \
+    template MatrixT<T> matmul<T>(const MatrixT<T>&, const MatrixT<T>&, Workspace*);              \
+    template MatrixT<T> matmul_nt<T>(const MatrixT<T>&, const MatrixT<T>&, Workspace*);           \
+    template MatrixT<T> matmul_tn<T>(const MatrixT<T>&, const MatrixT<T>&, Workspace*);           \
+    template void matmul_into<T>(const MatrixViewT<T>&, ConstViewArg<T>, ConstViewArg<T>);        \
+    template void matmul_nt_into<T>(const MatrixViewT<T>&, ConstViewArg<T>, ConstViewArg<T>);     \
+    template void matmul_tn_into<T>(const MatrixViewT<T>&, ConstViewArg<T>, ConstViewArg<T>);     \
+    template Gemm::PackedMatrix<T> pack_rhs<T>(const MatrixT<T>&);                                \
+    template Gemm::PackedMatrix<T> pack_rhs_transposed<T>(const MatrixT<T>&, Gemm::Storage);      \
+    template MatrixT<T> matmul<T>(const MatrixT<T>&, const Gemm::PackedMatrix<T>&, Workspace*);   \
+    template void matmul_into<T>(const MatrixViewT<T>&, ConstViewArg<T>, const Gemm::PackedMatrix<T>&); \
+    template MatrixT<T> elementWiseMultiply<T>(const MatrixT<T>&, const MatrixT<T>&, Workspace*); \
+    template MatrixT<T> elementWiseDivide<T>(const MatrixT<T>&, const MatrixT<T>&, Workspace*);   \
+    template void elementWiseMultiply_into<T>(const MatrixViewT<T>&, ConstViewArg<T>, ConstViewArg<T>); \
+    template void elementWiseDivide_into<T>(const MatrixViewT<T>&, ConstViewArg<T>, ConstViewArg<T>); \
+    template void add_into<T>(const MatrixViewT<T>&, ConstViewArg<T>, ConstViewArg<T>);           \
+    template void subtract_into<T>(const MatrixViewT<T>&, ConstViewArg<T>, ConstViewArg<T>);      \
+    template void scale_into<T>(const MatrixViewT<T>&, ConstViewArg<T>, double);                  \
+    template MatrixT<T> transpose<T>(const MatrixT<T>&, Workspace*);                              \
+    template MatrixT<T> transpose<T>(const ConstMatrixViewT<T>&, Workspace*);                     \
+    template void transpose_into<T>(const MatrixViewT<T>&, ConstViewArg<T>);                      \
+    template MatrixT<T> as_row_vector<T>(MatrixT<T>);                                             \
+    template MatrixT<T> addBroadcast<T>(const MatrixT<T>&, const MatrixT<T>&, bool, Workspace*);  \
+    template MatrixT<T> multiplyBroadcast<T>(const MatrixT<T>&, const MatrixT<T>&, bool, Workspace*); \
+    template void addBroadcast_into<T>(const MatrixViewT<T>&, ConstViewArg<T>, ConstViewArg<T>, bool); \
+    template void multiplyBroadcast_into<T>(const MatrixViewT<T>&, ConstViewArg<T>, ConstViewArg<T>, bool); \
+    template double sum<T>(const MatrixT<T>&);                                                    \
+    template double mean<T>(const MatrixT<T>&);                                                   \
+    template MatrixT<T> sumAxis<T>(const MatrixT<T>&, int, Workspace*);                           \
+    template MatrixT<T> meanAxis<T>(const MatrixT<T>&, int, Workspace*);                          \
+    template void sumAxis_into<T>(const MatrixViewT<T>&, ConstViewArg<T>, int);                   \
+    template void meanAxis_into<T>(const MatrixViewT<T>&, ConstViewArg<T>, int);                  \
+    template MatrixT<T> power<T>(const MatrixT<T>&, double, Workspace*);                          \
+    template MatrixT<T> sqrt<T>(const MatrixT<T>&, Workspace*);                                   \
+    template MatrixT<T> exp<T>(const MatrixT<T>&, Workspace*);                                    \
+    template MatrixT<T> log<T>(const MatrixT<T>&, Workspace*);                                    \
+    template void power_into<T>(const MatrixViewT<T>&, ConstViewArg<T>, double);                  \
+    template void sqrt_into<T>(const MatrixViewT<T>&, ConstViewArg<T>);                           \
+    template void exp_into<T>(const MatrixViewT<T>&, ConstViewArg<T>);                            \
+    template void log_into<T>(const MatrixViewT<T>&, ConstViewArg<T>);                            \
+    template double trace<T>(const MatrixT<T>&);                                                  \
+    template double determinant<T>(const MatrixT<T>&);                                            \
+    template MatrixT<T> inverse<T>(const MatrixT<T>&, Workspace*);                                \
+    template void inverse_into<T>(const MatrixViewT<T>&, const MatrixT<T>&);
+
+MATRIX_OPS_INSTANTIATE(float)
+MATRIX_OPS_INSTANTIATE(double)
+
+#undef MATRIX_OPS_INSTANTIATE
+
 } // namespace MatrixOps
\ No newline at end of file
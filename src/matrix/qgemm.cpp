@@ -0,0 +1,392 @@
+//
+// Created by JAYAN on 01/08/2025.
+//
+
+#include "../../include/matrix/qgemm.h"
+#include "../../include/matrix/vector_math.h"
+#include "../../include/utils/cpu_features.h"
+#include "../../include/utils/thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define VIT_QGEMM_X86 1
+#endif
+
+namespace QGemm {
+
+namespace {
+
+constexpr size_t PANEL = PackedWeights::PANEL;
+constexpr size_t GROUP = 4;                 // Inputs per 32-bit lane
+constexpr size_t PANEL_GROUP_BYTES = PANEL * GROUP;
+constexpr size_t MAX_MR = 8;
+constexpr size_t MC = 64;                   // Rows of A per block: 64 x k bytes stay in L1/L2
+
+// int32 tile of `rows` (<= MR) rows x PANEL columns: sums over `groups`
+// 4-input groups of A rows (stride lda) against one weight panel. Rows past
+// `rows` are not written.
+using Kernel = void (*)(size_t rows, size_t groups, const uint8_t* a, size_t lda, const int8_t* panel,
+                        int32_t* tile);
+
+struct KernelConfig {
+    const char* name;
+    size_t mr;
+    Kernel kernel;
+};
+
+int32_t load_group(const uint8_t* a) {
+    int32_t value;
+    std::memcpy(&value, a, sizeof(value));
+    return value;
+}
+
+// ---------------------------------------------------------------------------
+// Portable fallback
+// ---------------------------------------------------------------------------
+
+void scalar_kernel(size_t rows, size_t groups, const uint8_t* a, size_t lda, const int8_t* panel, int32_t* tile) {
+    for (size_t i = 0; i < rows; ++i) {
+        const uint8_t* a_row = a + i * lda;
+        int32_t acc[PANEL] = {};
+        const int8_t* b = panel;
+        for (size_t g = 0; g < groups; ++g) {
+            const uint8_t* a_group = a_row + g * GROUP;
+            for (size_t j = 0; j < PANEL; ++j) {
+                for (size_t p = 0; p < GROUP; ++p) {
+                    acc[j] += int32_t(a_group[p]) * int32_t(b[j * GROUP + p]);
+                }
+            }
+            b += PANEL_GROUP_BYTES;
+        }
+        std::memcpy(tile + i * PANEL, acc, sizeof(acc));
+    }
+}
+
+#ifdef VIT_QGEMM_X86
+
+// ---------------------------------------------------------------------------
+// AVX2: 4 rows x 2 ymm. vpmaddubsw multiplies u8 x s8 and adds neighbouring
+// pairs into int16, vpmaddwd against ones adds those pairs into int32.
+// ---------------------------------------------------------------------------
+
+__attribute__((target("avx2")))
+void avx2_kernel_4x16(size_t rows, size_t groups, const uint8_t* a, size_t lda, const int8_t* panel,
+                      int32_t* tile) {
+    constexpr int MR = 4;
+    // Missing rows re-read row 0; their results are never stored
+    const uint8_t* a_rows[MR];
+    for (int i = 0; i < MR; ++i) {
+        a_rows[i] = a + (static_cast<size_t>(i) < rows ? i * lda : 0);
+    }
+
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i acc[MR][2];
+#pragma GCC unroll 4
+    for (int i = 0; i < MR; ++i) {
+        acc[i][0] = _mm256_setzero_si256();
+        acc[i][1] = _mm256_setzero_si256();
+    }
+
+    for (size_t g = 0; g < groups; ++g) {
+        const __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(panel));
+        const __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(panel + 32));
+        panel += PANEL_GROUP_BYTES;
+#pragma GCC unroll 4
+        for (int i = 0; i < MR; ++i) {
+            const __m256i a_group = _mm256_set1_epi32(load_group(a_rows[i] + g * GROUP));
+            acc[i][0] = _mm256_add_epi32(acc[i][0], _mm256_madd_epi16(_mm256_maddubs_epi16(a_group, b0), ones));
+            acc[i][1] = _mm256_add_epi32(acc[i][1], _mm256_madd_epi16(_mm256_maddubs_epi16(a_group, b1), ones));
+        }
+    }
+
+    for (size_t i = 0; i < rows; ++i) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(tile + i * PANEL), acc[i][0]);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(tile + i * PANEL + 8), acc[i][1]);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// AVX-512 VNNI: 8 rows x 1 zmm. vpdpbusd does the u8 x s8 products and the
+// 4-way sum into int32 in one instruction, without an int16 step.
+// ---------------------------------------------------------------------------
+
+__attribute__((target("avx512f,avx512bw,avx512vnni")))
+void vnni_kernel_8x16(size_t rows, size_t groups, const uint8_t* a, size_t lda, const int8_t* panel,
+                      int32_t* tile) {
+    constexpr int MR = 8;
+    const uint8_t* a_rows[MR];
+    for (int i = 0; i < MR; ++i) {
+        a_rows[i] = a + (static_cast<size_t>(i) < rows ? i * lda : 0);
+    }
+
+    __m512i acc[MR];
+#pragma GCC unroll 8
+    for (int i = 0; i < MR; ++i) {
+        acc[i] = _mm512_setzero_si512();
+    }
+
+    for (size_t g = 0; g < groups; ++g) {
+        const __m512i b = _mm512_loadu_si512(panel);
+        panel += PANEL_GROUP_BYTES;
+#pragma GCC unroll 8
+        for (int i = 0; i < MR; ++i) {
+            acc[i] = _mm512_dpbusd_epi32(acc[i], _mm512_set1_epi32(load_group(a_rows[i] + g * GROUP)), b);
+        }
+    }
+
+    for (size_t i = 0; i < rows; ++i) {
+        _mm512_storeu_si512(tile + i * PANEL, acc[i]);
+    }
+}
+
+// 8 activations to int32: x * inv_scale + zero_point, clamped to [0, 127]
+// and rounded to nearest even like the scalar path's lrint
+__attribute__((target("avx2"), always_inline))
+inline __m256i quantize_8(const float* x, __m256 inv_scale, __m256 zero_point) {
+    const __m256 value = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(x), inv_scale), zero_point);
+    const __m256 clamped = _mm256_min_ps(_mm256_max_ps(value, _mm256_setzero_ps()),
+                                         _mm256_set1_ps(static_cast<float>(ACTIVATION_MAX)));
+    return _mm256_cvtps_epi32(clamped);
+}
+
+// Activations of one float row, 32 per step; returns how many were done
+__attribute__((target("avx2")))
+size_t quantize_row_avx2(const float* in, size_t k, float inv_scale, float zero_point, uint8_t* out) {
+    const __m256 scale = _mm256_set1_ps(inv_scale);
+    const __m256 offset = _mm256_set1_ps(zero_point);
+    // packs/packus work per 128-bit lane; this puts the dwords back in order
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    size_t p = 0;
+    for (; p + 32 <= k; p += 32) {
+        const __m256i lo = _mm256_packs_epi32(quantize_8(in + p, scale, offset), quantize_8(in + p + 8, scale, offset));
+        const __m256i hi = _mm256_packs_epi32(quantize_8(in + p + 16, scale, offset),
+                                              quantize_8(in + p + 24, scale, offset));
+        const __m256i bytes = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(lo, hi), order);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + p), bytes);
+    }
+    return p;
+}
+
+#endif // VIT_QGEMM_X86
+
+// First columns of a float row done by the SIMD path; the caller finishes
+// the rest
+template <typename T>
+size_t quantize_row_simd(const T*, size_t, T, T, uint8_t*) {
+    return 0;
+}
+
+template <>
+size_t quantize_row_simd<float>(const float* in, size_t k, float inv_scale, float zero_point, uint8_t* out) {
+#ifdef VIT_QGEMM_X86
+    if (CpuFeatures::active_isa() >= CpuFeatures::IsaLevel::Avx2) {
+        return quantize_row_avx2(in, k, inv_scale, zero_point, out);
+    }
+#endif
+    return 0;
+}
+
+const KernelConfig& active_kernel() {
+    static const KernelConfig scalar = {"scalar", 4, scalar_kernel};
+#ifdef VIT_QGEMM_X86
+    static const KernelConfig avx2 = {"avx2", 4, avx2_kernel_4x16};
+    static const KernelConfig vnni = {"avx512-vnni", 8, vnni_kernel_8x16};
+    static const KernelConfig& selected = [&]() -> const KernelConfig& {
+        const CpuFeatures::IsaLevel level = CpuFeatures::active_isa();
+        if (level == CpuFeatures::IsaLevel::Avx512 && CpuFeatures::supports_avx512_vnni()) return vnni;
+        if (level >= CpuFeatures::IsaLevel::Avx2) return avx2;
+        return scalar;
+    }();
+    return selected;
+#else
+    return scalar;
+#endif
+}
+
+// Per-column constants of one panel, in the output type
+template <typename T>
+struct PanelEpilogue {
+    T multiplier[PANEL];        // Activation scale * weight scale
+    int32_t offset[PANEL];      // zero_point * column sum
+    T bias[PANEL];              // Zero without a bias
+};
+
+// Dequantises a finished rows x cols int32 tile into C and applies the
+// epilogue. Full panels run a fixed 16-wide loop the compiler vectorises.
+template <typename T>
+void dequantize_tile(const int32_t* tile, size_t rows, size_t cols, const PanelEpilogue<T>& panel,
+                     const Gemm::Epilogue<T>& epilogue, T* c, size_t ldc) {
+    for (size_t i = 0; i < rows; ++i) {
+        const int32_t* acc = tile + i * PANEL;
+        T* c_row = c + i * ldc;
+        if (cols == PANEL && epilogue.accumulate) {
+#pragma GCC ivdep
+            for (size_t j = 0; j < PANEL; ++j) {
+                c_row[j] += panel.multiplier[j] * static_cast<T>(acc[j] - panel.offset[j]) + panel.bias[j];
+            }
+        } else if (cols == PANEL) {
+#pragma GCC ivdep
+            for (size_t j = 0; j < PANEL; ++j) {
+                c_row[j] = panel.multiplier[j] * static_cast<T>(acc[j] - panel.offset[j]) + panel.bias[j];
+            }
+        } else {
+            for (size_t j = 0; j < cols; ++j) {
+                const T value = panel.multiplier[j] * static_cast<T>(acc[j] - panel.offset[j]) + panel.bias[j];
+                c_row[j] = epilogue.accumulate ? c_row[j] + value : value;
+            }
+        }
+        switch (epilogue.activation) {
+            case Gemm::Activation::GeluTanh: VectorMath::gelu_tanh(c_row, c_row, cols); break;
+            case Gemm::Activation::GeluErf: VectorMath::gelu_erf(c_row, c_row, cols); break;
+            case Gemm::Activation::None: break;
+        }
+    }
+}
+
+} // namespace
+
+ActivationParams choose_activation_params(float min_value, float max_value) {
+    // The range must contain 0 so that zero padding quantises exactly
+    min_value = std::min(min_value, 0.0f);
+    max_value = std::max(max_value, 0.0f);
+    ActivationParams params;
+    if (!(max_value > min_value) || !std::isfinite(max_value - min_value)) {
+        return params;
+    }
+    params.scale = (max_value - min_value) / ACTIVATION_MAX;
+    params.zero_point = std::clamp(static_cast<int32_t>(std::lround(-min_value / params.scale)), 0, ACTIVATION_MAX);
+    return params;
+}
+
+template <typename T>
+void quantize_weights(const T* weight, size_t n, size_t k, std::vector<int8_t>& q, std::vector<float>& scales) {
+    q.resize(n * k);
+    scales.resize(n);
+    for (size_t j = 0; j < n; ++j) {
+        const T* row = weight + j * k;
+        T max_abs = T(0);
+        for (size_t p = 0; p < k; ++p) {
+            max_abs = std::max(max_abs, std::abs(row[p]));
+        }
+        const double scale = max_abs > T(0) ? static_cast<double>(max_abs) / WEIGHT_MAX : 1.0;
+        scales[j] = static_cast<float>(scale);
+        for (size_t p = 0; p < k; ++p) {
+            const long value = std::lround(static_cast<double>(row[p]) / scale);
+            q[j * k + p] = static_cast<int8_t>(std::clamp<long>(value, -WEIGHT_MAX, WEIGHT_MAX));
+        }
+    }
+}
+
+template <typename T>
+void quantize_activations(size_t m, size_t k, const T* a, size_t lda, const ActivationParams& params,
+                          uint8_t* out, size_t ldq) {
+    const size_t kp = padded_depth(k);
+    if (ldq < kp) {
+        throw std::invalid_argument("QGemm::quantize_activations row stride " + std::to_string(ldq) +
+                                    " is below the padded depth " + std::to_string(kp));
+    }
+    const T inv_scale = T(1) / static_cast<T>(params.scale);
+    const T zero_point = static_cast<T>(params.zero_point);
+    for (size_t i = 0; i < m; ++i) {
+        const T* row = a + i * lda;
+        uint8_t* q_row = out + i * ldq;
+        for (size_t p = quantize_row_simd(row, k, inv_scale, zero_point, q_row); p < k; ++p) {
+            const T value = std::clamp(row[p] * inv_scale + zero_point, T(0), T(ACTIVATION_MAX));
+            q_row[p] = static_cast<uint8_t>(std::lrint(value));
+        }
+        std::fill(q_row + k, q_row + kp, uint8_t(0));
+    }
+}
+
+PackedWeights::PackedWeights() : rows(0), cols(0) {}
+
+PackedWeights::PackedWeights(size_t n, size_t k, const int8_t* q, const float* weight_scales)
+    : scales(weight_scales, weight_scales + n), column_sums(n, 0), rows(k), cols(n) {
+    const size_t groups = padded_depth(k) / GROUP;
+    const size_t panel_count = (n + PANEL - 1) / PANEL;
+    panels.assign(panel_count * groups * PANEL_GROUP_BYTES, 0);
+
+    for (size_t j = 0; j < n; ++j) {
+        int8_t* panel = panels.data() + (j / PANEL) * groups * PANEL_GROUP_BYTES + (j % PANEL) * GROUP;
+        const int8_t* row = q + j * k;
+        for (size_t p = 0; p < k; ++p) {
+            panel[(p / GROUP) * PANEL_GROUP_BYTES + p % GROUP] = row[p];
+            column_sums[j] += row[p];
+        }
+    }
+}
+
+std::vector<int8_t> PackedWeights::unpack() const {
+    const size_t groups = padded_depth(rows) / GROUP;
+    std::vector<int8_t> q(cols * rows);
+    for (size_t j = 0; j < cols; ++j) {
+        const int8_t* panel = panels.data() + (j / PANEL) * groups * PANEL_GROUP_BYTES + (j % PANEL) * GROUP;
+        for (size_t p = 0; p < rows; ++p) {
+            q[j * rows + p] = panel[(p / GROUP) * PANEL_GROUP_BYTES + p % GROUP];
+        }
+    }
+    return q;
+}
+
+template <typename T>
+void gemm(size_t m, const uint8_t* a, size_t lda, const ActivationParams& params, const PackedWeights& w,
+          T* c, size_t ldc, const Gemm::Epilogue<T>& epilogue) {
+    const size_t n = w.getCols();
+    if (m == 0 || n == 0) {
+        return;
+    }
+    const KernelConfig& cfg = active_kernel();
+    const size_t groups = padded_depth(w.getRows()) / GROUP;
+    const size_t panel_bytes = groups * PANEL_GROUP_BYTES;
+    const size_t panel_count = (n + PANEL - 1) / PANEL;
+
+    // Panels of output channels are split between threads. Each thread
+    // walks A in MC-row blocks that stay in cache while its panels stream
+    // past them.
+    ThreadPool::instance().parallel_for(0, panel_count, 1, [&](size_t panel_begin, size_t panel_end) {
+        int32_t tile[MAX_MR * PANEL];
+        PanelEpilogue<T> constants;
+        for (size_t ic = 0; ic < m; ic += MC) {
+            const size_t mc = std::min(MC, m - ic);
+            for (size_t panel = panel_begin; panel < panel_end; ++panel) {
+                const size_t j0 = panel * PANEL;
+                const size_t cols = std::min(PANEL, n - j0);
+                for (size_t j = 0; j < cols; ++j) {
+                    constants.multiplier[j] = static_cast<T>(params.scale * w.scale_data()[j0 + j]);
+                    constants.offset[j] = params.zero_point * w.column_sum_data()[j0 + j];
+                    constants.bias[j] = epilogue.bias ? epilogue.bias[j0 + j] : T(0);
+                }
+                const int8_t* b = w.panel_data() + panel * panel_bytes;
+
+                for (size_t i = ic; i < ic + mc; i += cfg.mr) {
+                    const size_t rows = std::min(cfg.mr, ic + mc - i);
+                    cfg.kernel(rows, groups, a + i * lda, lda, b, tile);
+                    dequantize_tile(tile, rows, cols, constants, epilogue, c + i * ldc + j0, ldc);
+                }
+            }
+        }
+    });
+}
+
+const char* kernel_name() {
+    return active_kernel().name;
+}
+
+#define QGEMM_INSTANTIATE(T)                                                                               \
+    template void quantize_weights<T>(const T*, size_t, size_t, std::vector<int8_t>&, std::vector<float>&); \
+    template void quantize_activations<T>(size_t, size_t, const T*, size_t, const ActivationParams&,       \
+                                          uint8_t*, size_t);                                              \
+    template void gemm<T>(size_t, const uint8_t*, size_t, const ActivationParams&, const PackedWeights&, T*, \
+                          size_t, const Gemm::Epilogue<T>&);
+
+QGEMM_INSTANTIATE(float)
+QGEMM_INSTANTIATE(double)
+
+#undef QGEMM_INSTANTIATE
+
+} // namespace QGemm
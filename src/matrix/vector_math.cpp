@@ -0,0 +1,288 @@
+//
+// Created by JAYAN on 25/07/2025.
+//
+
+#include "../../include/matrix/vector_math.h"
+#include "../../include/utils/cpu_features.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define VIT_VECTOR_MATH_X86 1
+#endif
+
+namespace VectorMath {
+
+namespace {
+
+// ---------------------------------------------------------------------------
+// SIMD wrappers: one per ISA, each exposing the same primitive operations to
+// vector_math_kernels.inc
+// ---------------------------------------------------------------------------
+
+struct ScalarOps {
+    using V = float;
+    using M = bool;
+    static constexpr size_t LANES = 1;
+
+    static V set1(float x) { return x; }
+    static V load(const float* p) { return *p; }
+    static void store(float* p, V x) { *p = x; }
+    static V add(V a, V b) { return a + b; }
+    static V sub(V a, V b) { return a - b; }
+    static V mul(V a, V b) { return a * b; }
+    static V div(V a, V b) { return a / b; }
+    static V fmadd(V a, V b, V c) { return a * b + c; }
+    static V min(V a, V b) { return std::min(a, b); }
+    static V max(V a, V b) { return std::max(a, b); }
+    static V abs(V x) { return std::fabs(x); }
+    static V round(V x) { return std::nearbyint(x); }
+    static V copysign(V magnitude, V sign) { return std::copysign(magnitude, sign); }
+    static M lt(V a, V b) { return a < b; }
+    static V select(M mask, V a, V b) { return mask ? a : b; }
+    static float reduce_max(V x) { return x; }
+    static float reduce_add(V x) { return x; }
+
+    // 2^n for integral n in [-126, 127], built in the exponent field
+    static V pow2(V n) {
+        uint32_t bits = static_cast<uint32_t>(static_cast<int32_t>(n) + 127) << 23;
+        float result;
+        std::memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+};
+
+namespace scalar_impl {
+using Ops = ScalarOps;
+#include "vector_math_kernels.inc"
+}
+
+#ifdef VIT_VECTOR_MATH_X86
+
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+
+struct Avx2Ops {
+    using V = __m256;
+    using M = __m256;
+    static constexpr size_t LANES = 8;
+
+    static V set1(float x) { return _mm256_set1_ps(x); }
+    static V load(const float* p) { return _mm256_loadu_ps(p); }
+    static void store(float* p, V x) { _mm256_storeu_ps(p, x); }
+    static V add(V a, V b) { return _mm256_add_ps(a, b); }
+    static V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+    static V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+    static V div(V a, V b) { return _mm256_div_ps(a, b); }
+    static V fmadd(V a, V b, V c) { return _mm256_fmadd_ps(a, b, c); }
+    static V min(V a, V b) { return _mm256_min_ps(a, b); }
+    static V max(V a, V b) { return _mm256_max_ps(a, b); }
+    static V abs(V x) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), x); }
+    static V round(V x) { return _mm256_round_ps(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+    static V copysign(V magnitude, V sign) {
+        const V sign_bit = _mm256_set1_ps(-0.0f);
+        return _mm256_or_ps(_mm256_andnot_ps(sign_bit, magnitude), _mm256_and_ps(sign_bit, sign));
+    }
+    static M lt(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static V select(M mask, V a, V b) { return _mm256_blendv_ps(b, a, mask); }
+    static V pow2(V n) {
+        __m256i bits = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+        return _mm256_castsi256_ps(bits);
+    }
+    static float reduce_max(V x) {
+        __m128 v = _mm_max_ps(_mm256_castps256_ps128(x), _mm256_extractf128_ps(x, 1));
+        v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+        v = _mm_max_ss(v, _mm_shuffle_ps(v, v, 1));
+        return _mm_cvtss_f32(v);
+    }
+    static float reduce_add(V x) {
+        __m128 v = _mm_add_ps(_mm256_castps256_ps128(x), _mm256_extractf128_ps(x, 1));
+        v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+        v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+        return _mm_cvtss_f32(v);
+    }
+};
+
+namespace avx2_impl {
+using Ops = Avx2Ops;
+#include "vector_math_kernels.inc"
+}
+
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+// GCC 12's AVX-512 intrinsics build their pass-through operands from
+// _mm512_undefined_*(), which -Wall reports as (maybe-)uninitialized once
+// inlined (GCC PR105593). The values are never read; silence just that here.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+struct Avx512Ops {
+    using V = __m512;
+    using M = __mmask16;
+    static constexpr size_t LANES = 16;
+
+    static V set1(float x) { return _mm512_set1_ps(x); }
+    static V load(const float* p) { return _mm512_loadu_ps(p); }
+    static void store(float* p, V x) { _mm512_storeu_ps(p, x); }
+    static V add(V a, V b) { return _mm512_add_ps(a, b); }
+    static V sub(V a, V b) { return _mm512_sub_ps(a, b); }
+    static V mul(V a, V b) { return _mm512_mul_ps(a, b); }
+    static V div(V a, V b) { return _mm512_div_ps(a, b); }
+    static V fmadd(V a, V b, V c) { return _mm512_fmadd_ps(a, b, c); }
+    static V min(V a, V b) { return _mm512_min_ps(a, b); }
+    static V max(V a, V b) { return _mm512_max_ps(a, b); }
+    static V abs(V x) { return _mm512_abs_ps(x); }
+    static V round(V x) { return _mm512_roundscale_ps(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+    static V copysign(V magnitude, V sign) {
+        const __m512i sign_bit = _mm512_set1_epi32(static_cast<int>(0x80000000u));
+        __m512i bits = _mm512_or_si512(_mm512_andnot_si512(sign_bit, _mm512_castps_si512(magnitude)),
+                                       _mm512_and_si512(sign_bit, _mm512_castps_si512(sign)));
+        return _mm512_castsi512_ps(bits);
+    }
+    static M lt(V a, V b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+    static V select(M mask, V a, V b) { return _mm512_mask_blend_ps(mask, b, a); }
+    static V pow2(V n) {
+        __m512i bits = _mm512_slli_epi32(_mm512_add_epi32(_mm512_cvtps_epi32(n), _mm512_set1_epi32(127)), 23);
+        return _mm512_castsi512_ps(bits);
+    }
+    static float reduce_max(V x) { return _mm512_reduce_max_ps(x); }
+    static float reduce_add(V x) { return _mm512_reduce_add_ps(x); }
+};
+
+namespace avx512_impl {
+using Ops = Avx512Ops;
+#include "vector_math_kernels.inc"
+}
+
+#pragma GCC diagnostic pop
+#pragma GCC pop_options
+
+#endif // VIT_VECTOR_MATH_X86
+
+// ---------------------------------------------------------------------------
+// Runtime dispatch
+// ---------------------------------------------------------------------------
+
+struct FloatKernels {
+    void (*exp)(const float*, float*, size_t);
+    void (*tanh)(const float*, float*, size_t);
+    void (*sigmoid)(const float*, float*, size_t);
+    void (*gelu_tanh)(const float*, float*, size_t);
+    void (*gelu_erf)(const float*, float*, size_t);
+    void (*softmax)(const float*, float*, size_t, float);
+    float (*reduce_max)(const float*, size_t);
+    float (*exp_sum)(const float*, float*, size_t, float, float);
+};
+
+#define VECTOR_MATH_KERNELS(ns) \
+    {ns::exp, ns::tanh, ns::sigmoid, ns::gelu_tanh, ns::gelu_erf, ns::softmax, ns::reduce_max, ns::exp_sum}
+
+const FloatKernels& float_kernels() {
+    static const FloatKernels scalar = VECTOR_MATH_KERNELS(scalar_impl);
+#ifdef VIT_VECTOR_MATH_X86
+    static const FloatKernels avx2 = VECTOR_MATH_KERNELS(avx2_impl);
+    static const FloatKernels avx512 = VECTOR_MATH_KERNELS(avx512_impl);
+    switch (CpuFeatures::active_isa()) {
+        case CpuFeatures::IsaLevel::Avx512: return avx512;
+        case CpuFeatures::IsaLevel::Avx2: return avx2;
+        default: break;
+    }
+#endif
+    return scalar;
+}
+
+#undef VECTOR_MATH_KERNELS
+
+// double reference path
+template <typename F>
+void map_double(const double* in, double* out, size_t n, F f) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = f(in[i]);
+    }
+}
+
+} // namespace
+
+template <> void exp<float>(const float* in, float* out, size_t n) { float_kernels().exp(in, out, n); }
+template <> void tanh<float>(const float* in, float* out, size_t n) { float_kernels().tanh(in, out, n); }
+template <> void sigmoid<float>(const float* in, float* out, size_t n) { float_kernels().sigmoid(in, out, n); }
+template <> void gelu_tanh<float>(const float* in, float* out, size_t n) { float_kernels().gelu_tanh(in, out, n); }
+template <> void gelu_erf<float>(const float* in, float* out, size_t n) { float_kernels().gelu_erf(in, out, n); }
+
+template <> void softmax<float>(const float* in, float* out, size_t n, float scale) {
+    if (!(scale > 0.0f)) {
+        throw std::invalid_argument("softmax scale must be positive");
+    }
+    float_kernels().softmax(in, out, n, scale);
+}
+
+template <> float reduce_max<float>(const float* in, size_t n) {
+    if (n == 0) {
+        throw std::invalid_argument("reduce_max of an empty array");
+    }
+    return float_kernels().reduce_max(in, n);
+}
+
+template <> float exp_sum<float>(const float* in, float* out, size_t n, float scale, float shift) {
+    return float_kernels().exp_sum(in, out, n, scale, shift);
+}
+
+template <> void exp<double>(const double* in, double* out, size_t n) {
+    map_double(in, out, n, [](double x) { return std::exp(x); });
+}
+
+template <> void tanh<double>(const double* in, double* out, size_t n) {
+    map_double(in, out, n, [](double x) { return std::tanh(x); });
+}
+
+template <> void sigmoid<double>(const double* in, double* out, size_t n) {
+    map_double(in, out, n, [](double x) { return 1.0 / (1.0 + std::exp(-x)); });
+}
+
+template <> void gelu_tanh<double>(const double* in, double* out, size_t n) {
+    const double sqrt_2_pi = 0.7978845608028654;
+    map_double(in, out, n, [=](double x) { return 0.5 * x * (1.0 + std::tanh(sqrt_2_pi * (x + 0.044715 * x * x * x))); });
+}
+
+template <> void gelu_erf<double>(const double* in, double* out, size_t n) {
+    map_double(in, out, n, [](double x) { return 0.5 * x * std::erfc(-x * 0.7071067811865476); });
+}
+
+template <> double reduce_max<double>(const double* in, size_t n) {
+    if (n == 0) {
+        throw std::invalid_argument("reduce_max of an empty array");
+    }
+    return *std::max_element(in, in + n);
+}
+
+template <> double exp_sum<double>(const double* in, double* out, size_t n, double scale, double shift) {
+    double sum = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = std::exp(scale * in[i] + shift);
+        sum += out[i];
+    }
+    return sum;
+}
+
+template <> void softmax<double>(const double* in, double* out, size_t n, double scale) {
+    if (!(scale > 0.0)) {
+        throw std::invalid_argument("softmax scale must be positive");
+    }
+    if (n == 0) {
+        return;
+    }
+    const double max_val = reduce_max(in, n);
+    const double sum = exp_sum(in, out, n, scale, -scale * max_val);
+    for (size_t i = 0; i < n; ++i) {
+        out[i] /= sum;
+    }
+}
+
+} // namespace VectorMath
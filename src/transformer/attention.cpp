@@ -0,0 +1,347 @@
+//
+// Created by JAYAN on 26/07/2025.
+//
+
+#include "../../include/transformer/attention.h"
+#include "../../include/matrix/matrix_ops.h"
+#include "../../include/matrix/vector_math.h"
+#include "../../include/utils/thread_pool.h"
+#include "../../include/utils/profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+// Query rows and key/value rows per tile of the tiled kernel: a 64 x 128
+// score tile plus a 64 x head_dim partial output fit in L1/L2 together with
+// the K and V tiles being streamed.
+constexpr size_t TILE_QUERIES = 64;
+constexpr size_t TILE_KEYS = 128;
+
+// Per-thread tile scratch of tiled_head_attention; grows on demand and is
+// never shrunk
+template <typename T>
+T* tile_scratch(size_t dk) {
+    thread_local std::vector<T> scratch;
+    const size_t needed = TILE_QUERIES * TILE_KEYS + TILE_QUERIES * dk + 3 * TILE_QUERIES;
+    if (scratch.size() < needed) {
+        scratch.resize(needed);
+    }
+    return scratch.data();
+}
+
+// One head of softmax(scale * Q K^T) V with online softmax. q, k and v are
+// seq_len x dk with row stride ld; out (row stride out_ld) receives the
+// result and doubles as the running accumulator.
+template <typename T>
+void tiled_head_attention(const T* q, const T* k, const T* v, size_t ld, size_t seq_len, size_t dk, T scale,
+                          T* out, size_t out_ld) {
+    T* tile = tile_scratch<T>(dk);                          // TILE_QUERIES x TILE_KEYS
+    T* partial = tile + TILE_QUERIES * TILE_KEYS;           // TILE_QUERIES x dk
+    T* row_max = partial + TILE_QUERIES * dk;
+    T* row_sum = row_max + TILE_QUERIES;
+    T* rescale = row_sum + TILE_QUERIES;
+
+    for (size_t qb = 0; qb < seq_len; qb += TILE_QUERIES) {
+        const size_t rows = std::min(TILE_QUERIES, seq_len - qb);
+        std::fill(row_max, row_max + rows, -std::numeric_limits<T>::infinity());
+        std::fill(row_sum, row_sum + rows, T(0));
+
+        for (size_t kb = 0; kb < seq_len; kb += TILE_KEYS) {
+            const size_t cols = std::min(TILE_KEYS, seq_len - kb);
+            Gemm::gemm(rows, cols, dk, q + qb * ld, ld, 1, k + kb * ld, 1, ld, tile, cols);
+
+            // Fold this tile into the running max and sum; the tile becomes
+            // exp(scale * s - new_max)
+            for (size_t i = 0; i < rows; ++i) {
+                T* s = tile + i * cols;
+                const T new_max = std::max(row_max[i], scale * VectorMath::reduce_max(s, cols));
+                rescale[i] = std::exp(row_max[i] - new_max);
+                row_sum[i] = row_sum[i] * rescale[i] + VectorMath::exp_sum(s, s, cols, scale, -new_max);
+                row_max[i] = new_max;
+            }
+
+            Gemm::gemm(rows, dk, cols, tile, cols, 1, v + kb * ld, ld, 1, partial, dk);
+            for (size_t i = 0; i < rows; ++i) {
+                T* o = out + (qb + i) * out_ld;
+                const T* p = partial + i * dk;
+                if (kb == 0) {
+                    std::copy(p, p + dk, o);
+                } else {
+                    for (size_t j = 0; j < dk; ++j) {
+                        o[j] = o[j] * rescale[i] + p[j];
+                    }
+                }
+            }
+        }
+
+        for (size_t i = 0; i < rows; ++i) {
+            T* o = out + (qb + i) * out_ld;
+            const T inv_sum = T(1) / row_sum[i];
+            for (size_t j = 0; j < dk; ++j) {
+                o[j] *= inv_sum;
+            }
+        }
+    }
+}
+
+} // namespace
+
+template <typename T>
+MultiHeadAttentionT<T>::MultiHeadAttentionT(int d_model, int num_heads)
+    : weight_storage(Gemm::Storage::Native), kernel(AttentionKernel::Standard) {
+    initialize(d_model, num_heads);
+}
+
+template <typename T>
+MultiHeadAttentionT<T>::MultiHeadAttentionT()
+    : weight_storage(Gemm::Storage::Native), d_model(0), num_heads(DEFAULT_NUM_HEADS), head_dim(0),
+      kernel(AttentionKernel::Standard) {
+    // Default constructor - will be initialized later
+}
+
+template <typename T>
+void MultiHeadAttentionT<T>::set_dimensions(int d_model, int num_heads) {
+    if (num_heads <= 0 || d_model % num_heads != 0) {
+        throw std::invalid_argument("MultiHeadAttention d_model (" + std::to_string(d_model) +
+                                    ") must be divisible by num_heads (" + std::to_string(num_heads) + ")");
+    }
+    this->d_model = d_model;
+    this->num_heads = num_heads;
+    this->head_dim = d_model / num_heads;
+}
+
+template <typename T>
+void MultiHeadAttentionT<T>::initialize(int d_model, int num_heads) {
+    set_dimensions(d_model, num_heads);
+    in_proj_weight = MatrixT<T>::zeros(3 * d_model, d_model);
+    in_proj_bias = MatrixT<T>::zeros(1, 3 * d_model);
+    out_proj_weight = MatrixT<T>::zeros(d_model, d_model);
+    out_proj_bias = MatrixT<T>::zeros(1, d_model);
+    pack_weights();
+}
+
+template <typename T>
+MatrixT<T> MultiHeadAttentionT<T>::forward(const MatrixT<T>& input, size_t seq_len) {
+    MatrixT<T> output(input.getRows(), input.getCols());
+    run(ConstMatrixViewT<T>(input), seq_len, output.view(), false, nullptr);
+    return output;
+}
+
+template <typename T>
+void MultiHeadAttentionT<T>::forward(const ConstMatrixViewT<T>& input, size_t seq_len,
+                                     const MatrixViewT<T>& output, T* workspace) {
+    run(input, seq_len, output, false, workspace);
+}
+
+template <typename T>
+void MultiHeadAttentionT<T>::forward_residual(const ConstMatrixViewT<T>& input, size_t seq_len,
+                                              const MatrixViewT<T>& residual, T* workspace) {
+    run(input, seq_len, residual, true, workspace);
+}
+
+template <typename T>
+size_t MultiHeadAttentionT<T>::workspace_size(size_t tokens, size_t seq_len) const {
+    if (seq_len == 0) {
+        seq_len = tokens;
+    }
+    const size_t dm = static_cast<size_t>(d_model);
+    const size_t score_elements = kernel == AttentionKernel::Tiled || seq_len == 0
+                                      ? 0
+                                      : tokens * static_cast<size_t>(num_heads) * seq_len;
+    return aligned_size<T>(tokens * 3 * dm) + aligned_size<T>(score_elements) + aligned_size<T>(tokens * dm);
+}
+
+template <typename T>
+void MultiHeadAttentionT<T>::run(const ConstMatrixViewT<T>& input, size_t seq_len, const MatrixViewT<T>& output,
+                                 bool accumulate, T* workspace) {
+    const size_t tokens = input.getRows();
+    const size_t dm = static_cast<size_t>(d_model);
+    if (input.getCols() != dm) {
+        throw std::runtime_error("MultiHeadAttention input feature dimension mismatch. Expected: " +
+                                std::to_string(d_model) + ", Got: " + std::to_string(input.getCols()));
+    }
+    if (output.getRows() != tokens || output.getCols() != dm) {
+        throw std::invalid_argument("MultiHeadAttention output must match the input dimensions");
+    }
+    if (seq_len == 0) {
+        seq_len = tokens;
+    }
+    if (tokens == 0 || tokens % seq_len != 0) {
+        throw std::invalid_argument("MultiHeadAttention input has " + std::to_string(tokens) +
+                                    " tokens, not a multiple of seq_len " + std::to_string(seq_len));
+    }
+    const size_t sequences = tokens / seq_len;
+    const size_t heads = static_cast<size_t>(num_heads);
+    const size_t dk = static_cast<size_t>(head_dim);
+    const size_t qkv_ld = 3 * dm;
+    const bool tiled = kernel == AttentionKernel::Tiled;
+    const size_t score_rows = tiled ? 0 : sequences * heads * seq_len;
+    // Projections 8 * tokens * d_model^2, scores and context 4 * tokens * seq_len * d_model
+    VIT_PROFILE_SCOPE("Layer", "MultiHeadAttention.forward", 8.0 * tokens * dm * dm + 4.0 * tokens * seq_len * dm,
+                      get_packed_bytes() + 2.0 * sizeof(T) * tokens * dm);
+
+    // Scratch comes from the caller's workspace (laid out as workspace_size
+    // describes) or from the member buffers
+    T* qkv_data;
+    T* scores_data;
+    T* context_data;
+    if (workspace) {
+        qkv_data = workspace;
+        scores_data = qkv_data + aligned_size<T>(tokens * qkv_ld);
+        context_data = scores_data + aligned_size<T>(score_rows * seq_len);
+    } else {
+        qkv.resize_for_overwrite(tokens, qkv_ld);
+        scores.resize_for_overwrite(score_rows, seq_len);
+        context.resize_for_overwrite(tokens, dm);
+        qkv_data = qkv.data();
+        scores_data = scores.data();
+        context_data = context.data();
+    }
+
+    // Step 1: one GEMM for Q, K and V of every token, bias in the epilogue
+    Gemm::Epilogue<T> in_epilogue;
+    in_epilogue.bias = in_proj_bias.data();
+    in_proj_quantized.gemm(tokens, input.data(), input.getStride(), in_proj_packed, qkv_data, qkv_ld, in_epilogue);
+
+    // Step 2: scaled dot-product attention per (sequence, head), in parallel
+    const T scale = static_cast<T>(1.0 / std::sqrt(static_cast<double>(dk)));
+
+    ThreadPool::instance().parallel_for(0, sequences * heads, 1, [&](size_t task_begin, size_t task_end) {
+        for (size_t task = task_begin; task < task_end; ++task) {
+            const size_t s = task / heads;
+            const size_t h = task % heads;
+            const T* q = qkv_data + s * seq_len * qkv_ld + h * dk;
+            const T* k = q + dm;
+            const T* v = q + 2 * dm;
+            T* head_context = context_data + s * seq_len * dm + h * dk;
+
+            if (tiled) {
+                tiled_head_attention(q, k, v, qkv_ld, seq_len, dk, scale, head_context, dm);
+                continue;
+            }
+
+            T* probs = scores_data + task * seq_len * seq_len;
+
+            // Q_h (seq_len x dk) * K_h^T: K_h read column-wise through its strides
+            Gemm::gemm(seq_len, seq_len, dk, q, qkv_ld, 1, k, 1, qkv_ld, probs, seq_len);
+
+            for (size_t i = 0; i < seq_len; ++i) {
+                T* row = probs + i * seq_len;
+                VectorMath::softmax(row, row, seq_len, scale);
+            }
+
+            // probs (seq_len x seq_len) * V_h into this head's context columns
+            Gemm::gemm(seq_len, dk, seq_len, probs, seq_len, 1, v, qkv_ld, 1, head_context, dm);
+        }
+    });
+
+    // Step 3: output projection, accumulated into the residual stream when asked
+    Gemm::Epilogue<T> out_epilogue;
+    out_epilogue.bias = out_proj_bias.data();
+    out_epilogue.accumulate = accumulate;
+    out_proj_quantized.gemm(tokens, context_data, dm, out_proj_packed, output.data(), output.getStride(),
+                            out_epilogue);
+}
+
+template <typename T>
+void MultiHeadAttentionT<T>::reserve_thread_scratch() const {
+    if (head_dim > 0) {
+        tile_scratch<T>(static_cast<size_t>(head_dim));
+    }
+}
+
+template <typename T>
+void MultiHeadAttentionT<T>::pack_weights() {
+    // forward computes x * W^T for both projections
+    in_proj_packed = MatrixOps::pack_rhs_transposed(in_proj_weight, weight_storage);
+    out_proj_packed = MatrixOps::pack_rhs_transposed(out_proj_weight, weight_storage);
+}
+
+template <typename T>
+void MultiHeadAttentionT<T>::set_weight_storage(Gemm::Storage storage) {
+    weight_storage = storage;
+    pack_weights();
+}
+
+template <typename T>
+std::string MultiHeadAttentionT<T>::tensor_name(int layer_idx, const std::string& param) {
+    return "transformer_layers/transformer_" + std::to_string(layer_idx) + "_attn_" + param;
+}
+
+template <typename T>
+void MultiHeadAttentionT<T>::collect_linears(int layer_idx, std::vector<typename QuantizedLinearT<T>::Slot>& slots) {
+    slots.push_back({tensor_name(layer_idx, "in_proj_weight"), &in_proj_weight, &in_proj_quantized, &in_proj_packed});
+    slots.push_back({tensor_name(layer_idx, "out_proj_weight"), &out_proj_weight, &out_proj_quantized, &out_proj_packed});
+}
+
+template <typename T>
+void MultiHeadAttentionT<T>::collect_linears(int layer_idx, std::vector<typename QuantizedLinearT<T>::ConstSlot>& slots) const {
+    slots.push_back({tensor_name(layer_idx, "in_proj_weight"), &in_proj_weight, &in_proj_quantized, &in_proj_packed});
+    slots.push_back({tensor_name(layer_idx, "out_proj_weight"), &out_proj_weight, &out_proj_quantized, &out_proj_packed});
+}
+
+template <typename T>
+void MultiHeadAttentionT<T>::set_weights(MatrixT<T> in_weight, MatrixT<T> in_bias, MatrixT<T> out_weight,
+                                         MatrixT<T> out_bias, bool pack) {
+    in_bias = MatrixOps::as_row_vector(std::move(in_bias));
+    out_bias = MatrixOps::as_row_vector(std::move(out_bias));
+
+    // d_model comes from the output projection; everything else must agree
+    const size_t dm = out_weight.getRows();
+    if (out_weight.getCols() != dm || in_weight.getRows() != 3 * dm || in_weight.getCols() != dm ||
+        in_bias.size() != 3 * dm || out_bias.size() != dm) {
+        throw std::runtime_error("MultiHeadAttention weight shapes are inconsistent: in_proj " +
+                                 std::to_string(in_weight.getRows()) + "x" + std::to_string(in_weight.getCols()) +
+                                 ", out_proj " + std::to_string(out_weight.getRows()) + "x" +
+                                 std::to_string(out_weight.getCols()));
+    }
+    set_dimensions(static_cast<int>(dm), num_heads);
+
+    in_proj_weight = std::move(in_weight);
+    in_proj_bias = std::move(in_bias);
+    out_proj_weight = std::move(out_weight);
+    out_proj_bias = std::move(out_bias);
+    if (pack) {
+        pack_weights();
+    }
+}
+
+template <typename T>
+void MultiHeadAttentionT<T>::load_weights(const std::string& base_path, int layer_idx) {
+    try {
+        std::string prefix = base_path + "/";
+        in_proj_quantized.clear();
+        out_proj_quantized.clear();
+        set_weights(FileIO::load_matrix_from_csv<T>(prefix + tensor_name(layer_idx, "in_proj_weight") + ".csv", true),
+                    FileIO::load_matrix_from_csv<T>(prefix + tensor_name(layer_idx, "in_proj_bias") + ".csv", true),
+                    FileIO::load_matrix_from_csv<T>(prefix + tensor_name(layer_idx, "out_proj_weight") + ".csv", true),
+                    FileIO::load_matrix_from_csv<T>(prefix + tensor_name(layer_idx, "out_proj_bias") + ".csv", true));
+
+        std::cout << "MultiHeadAttention weights loaded successfully for layer " << layer_idx << std::endl;
+        std::cout << "d_model: " << d_model << ", Heads: " << num_heads << ", Head dim: " << head_dim << std::endl;
+
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Failed to load MultiHeadAttention weights: " + std::string(e.what()));
+    }
+}
+
+template <typename T>
+void MultiHeadAttentionT<T>::load_weights(const WeightFile& weights, int layer_idx, bool pack) {
+    try {
+        // Projection weights may be stored quantised
+        set_weights(in_proj_quantized.load_weight(weights, tensor_name(layer_idx, "in_proj_weight")),
+                    weights.get<T>(tensor_name(layer_idx, "in_proj_bias")),
+                    out_proj_quantized.load_weight(weights, tensor_name(layer_idx, "out_proj_weight")),
+                    weights.get<T>(tensor_name(layer_idx, "out_proj_bias")), pack);
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Failed to load MultiHeadAttention weights: " + std::string(e.what()));
+    }
+}
+
+template class MultiHeadAttentionT<float>;
+template class MultiHeadAttentionT<double>;
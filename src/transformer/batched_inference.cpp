@@ -0,0 +1,257 @@
+//
+// Created by JAYAN on 31/07/2025.
+//
+
+#include "../../include/transformer/batched_inference.h"
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+double milliseconds(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+// Bucket b covers [2^(b-1), 2^b) microseconds
+size_t latency_bucket(double latency_ms, size_t buckets) {
+    const double micros = latency_ms * 1000.0;
+    if (micros < 1.0) {
+        return 0;
+    }
+    const size_t bucket = static_cast<size_t>(std::floor(std::log2(micros))) + 1;
+    return std::min(bucket, buckets - 1);
+}
+
+} // namespace
+
+template <typename T>
+double BatchedInferenceT<T>::Stats::latency_percentile_ms(double p) const {
+    if (requests == 0) {
+        return 0.0;
+    }
+    const double target = std::clamp(p, 0.0, 100.0) / 100.0 * requests;
+    size_t seen = 0;
+    for (size_t b = 0; b < latency_buckets.size(); ++b) {
+        seen += latency_buckets[b];
+        if (seen >= target && seen > 0) {
+            return std::ldexp(1.0, static_cast<int>(b)) / 1000.0;
+        }
+    }
+    return std::ldexp(1.0, static_cast<int>(latency_buckets.size() - 1)) / 1000.0;
+}
+
+template <typename T>
+void BatchedInferenceT<T>::Stats::print(std::ostream& os) const {
+    os << "requests " << requests << ", batches " << batches << ", mean batch " << std::fixed
+       << std::setprecision(1) << mean_batch_size() << ", " << images_per_second() << " images/s\n";
+    os << std::setprecision(3) << "latency ms: mean " << mean_latency_ms() << " (queue " << mean_queue_ms()
+       << "), p50 <= " << latency_percentile_ms(50) << ", p95 <= " << latency_percentile_ms(95) << ", p99 <= "
+       << latency_percentile_ms(99) << "\n";
+
+    size_t largest = 0;
+    for (size_t count : batch_sizes) {
+        largest = std::max(largest, count);
+    }
+    os << "batch size histogram:\n";
+    for (size_t n = 1; n < batch_sizes.size(); ++n) {
+        if (batch_sizes[n] == 0) {
+            continue;
+        }
+        const size_t bar = largest ? (batch_sizes[n] * 40 + largest - 1) / largest : 0;
+        os << std::setw(6) << n << " | " << std::string(bar, '#') << " " << batch_sizes[n] << "\n";
+    }
+    os.unsetf(std::ios::floatfield);
+    os << std::setprecision(6);
+}
+
+template <typename T>
+BatchedInferenceT<T>::BatchedInferenceT(VisionTransformerT<T>& model, const BatchingOptions& options)
+    : model(model), options(options), num_patches(model.get_embedding().get_num_patches()),
+      patch_dim(model.get_embedding().get_patch_dim()), stopping(false), stats_start(Clock::now()) {
+    check_options(options);
+    if (model.get_num_classes() == 0) {
+        throw std::invalid_argument("BatchedInference needs a model with loaded weights");
+    }
+    worker = std::thread([this] { run(); });
+}
+
+template <typename T>
+BatchedInferenceT<T>::~BatchedInferenceT() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    ready_cv.notify_all();
+    space_cv.notify_all();
+    worker.join();
+}
+
+template <typename T>
+void BatchedInferenceT<T>::check_options(const BatchingOptions& options) {
+    if (options.max_batch == 0 || options.max_queue == 0) {
+        throw std::invalid_argument("BatchingOptions max_batch and max_queue must be positive");
+    }
+    if (!(options.max_delay_ms >= 0.0)) {
+        throw std::invalid_argument("BatchingOptions max_delay_ms must not be negative");
+    }
+}
+
+template <typename T>
+std::future<typename BatchedInferenceT<T>::Result> BatchedInferenceT<T>::submit(const ConstMatrixViewT<T>& patches) {
+    if (patches.getRows() != num_patches || patches.getCols() != patch_dim) {
+        throw std::invalid_argument("BatchedInference expects one image as " + std::to_string(num_patches) + "x" +
+                                    std::to_string(patch_dim) + " patches, got " +
+                                    std::to_string(patches.getRows()) + "x" + std::to_string(patches.getCols()));
+    }
+
+    Request request{MatrixT<T>(patches), std::promise<Result>(), Clock::now()};
+    std::future<Result> future = request.promise.get_future();
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        space_cv.wait(lock, [&] { return stopping || queue.size() < options.max_queue; });
+        if (stopping) {
+            throw std::runtime_error("BatchedInference is shutting down");
+        }
+        request.submitted = Clock::now();
+        queue.push_back(std::move(request));
+    }
+    ready_cv.notify_one();
+    return future;
+}
+
+template <typename T>
+void BatchedInferenceT<T>::run() {
+    std::vector<Request> batch;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        ready_cv.wait(lock, [&] { return stopping || !queue.empty(); });
+        if (queue.empty()) {
+            break; // Stopping with nothing left to serve
+        }
+
+        // Give the oldest request up to max_delay_ms to gather company
+        const auto delay = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double, std::milli>(options.max_delay_ms));
+        ready_cv.wait_until(lock, queue.front().submitted + delay,
+                            [&] { return stopping || queue.size() >= options.max_batch; });
+
+        const size_t count = std::min(queue.size(), options.max_batch);
+        batch.clear();
+        for (size_t i = 0; i < count; ++i) {
+            batch.push_back(std::move(queue.front()));
+            queue.pop_front();
+        }
+        space_cv.notify_all();
+
+        // set_options may change options while the batch runs unlocked
+        const BatchingOptions current = options;
+        lock.unlock();
+        run_batch(batch, current);
+        lock.lock();
+    }
+}
+
+template <typename T>
+void BatchedInferenceT<T>::run_batch(std::vector<Request>& batch, const BatchingOptions& options) {
+    const size_t count = batch.size();
+    const auto started = Clock::now();
+    const size_t classes = static_cast<size_t>(model.get_num_classes());
+
+    try {
+        if (model.get_max_batch() < count) {
+            model.reserve(std::max(count, options.max_batch));
+        }
+        if (batch_patches.getRows() < count * num_patches) {
+            batch_patches.resize_for_overwrite(model.get_max_batch() * num_patches, patch_dim);
+            batch_logits.resize_for_overwrite(model.get_max_batch(), classes);
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            batch_patches.block(i * num_patches, 0, num_patches, patch_dim).assign(batch[i].patches);
+        }
+        model.forward(batch_patches.block(0, 0, count * num_patches, patch_dim),
+                      batch_logits.block(0, 0, count, classes));
+    } catch (...) {
+        const std::exception_ptr error = std::current_exception();
+        for (Request& request : batch) {
+            request.promise.set_exception(error);
+        }
+        return;
+    }
+
+    // Statistics first, so they already include this batch once its
+    // futures are ready
+    const auto finished = Clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.requests += count;
+        stats.batches += 1;
+        if (stats.batch_sizes.size() <= count) {
+            stats.batch_sizes.resize(count + 1, 0);
+        }
+        stats.batch_sizes[count] += 1;
+        for (const Request& request : batch) {
+            const double latency = milliseconds(finished - request.submitted);
+            stats.total_latency_ms += latency;
+            stats.total_queue_ms += milliseconds(started - request.submitted);
+            ++stats.latency_buckets[latency_bucket(latency, Stats::LATENCY_BUCKETS)];
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        Result result;
+        result.logits = MatrixT<T>(batch_logits.block(i, 0, 1, classes));
+        const T* row = result.logits.data();
+        result.predicted = static_cast<int>(std::max_element(row, row + classes) - row);
+        result.batch_size = count;
+        result.queue_ms = milliseconds(started - batch[i].submitted);
+        result.latency_ms = milliseconds(finished - batch[i].submitted);
+        batch[i].promise.set_value(std::move(result));
+    }
+}
+
+template <typename T>
+void BatchedInferenceT<T>::set_options(const BatchingOptions& new_options) {
+    check_options(new_options);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        options = new_options;
+    }
+    // A smaller batch or a larger queue may already be satisfied
+    ready_cv.notify_all();
+    space_cv.notify_all();
+}
+
+template <typename T>
+BatchingOptions BatchedInferenceT<T>::get_options() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return options;
+}
+
+template <typename T>
+typename BatchedInferenceT<T>::Stats BatchedInferenceT<T>::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    Stats snapshot = stats;
+    snapshot.elapsed_seconds = std::chrono::duration<double>(Clock::now() - stats_start).count();
+    return snapshot;
+}
+
+template <typename T>
+void BatchedInferenceT<T>::reset_stats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    stats = Stats();
+    stats_start = Clock::now();
+}
+
+template <typename T>
+size_t BatchedInferenceT<T>::pending() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return queue.size();
+}
+
+template class BatchedInferenceT<float>;
+template class BatchedInferenceT<double>;
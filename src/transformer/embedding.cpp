@@ -4,128 +4,186 @@
 
 #include "../../include/transformer/embedding.h"
 #include "../../include/matrix/matrix_ops.h"
+#include "../../include/utils/profiler.h"
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
 
-PatchEmbedding::PatchEmbedding(int num_patches, int features) 
-    : num_patches(num_patches), features(features), seq_len(num_patches + 1) {
-    // Initialize matrices with appropriate dimensions
-    proj_weight = Matrix::zeros(features, num_patches);
-    proj_bias = Matrix::zeros(1, features);
-    pos_embed = Matrix::zeros(seq_len, features);
-    cls_token = Matrix::zeros(1, features);
+template <typename T>
+PatchEmbeddingT<T>::PatchEmbeddingT(int patch_dim, int features, int num_patches)
+    : weight_storage(Gemm::Storage::Native) {
+    initialize(patch_dim, features, num_patches);
 }
 
-PatchEmbedding::PatchEmbedding() : num_patches(0), features(0), seq_len(0) {
+template <typename T>
+PatchEmbeddingT<T>::PatchEmbeddingT()
+    : weight_storage(Gemm::Storage::Native), num_patches(0), patch_dim(0), features(0), seq_len(0) {
     // Default constructor - will be initialized later
 }
 
-void PatchEmbedding::initialize(int num_patches, int features) {
+template <typename T>
+void PatchEmbeddingT<T>::initialize(int patch_dim, int features, int num_patches) {
     this->num_patches = num_patches;
+    this->patch_dim = patch_dim;
     this->features = features;
     this->seq_len = num_patches + 1;
     
-    proj_weight = Matrix::zeros(features, num_patches);
-    proj_bias = Matrix::zeros(1, features);
-    pos_embed = Matrix::zeros(seq_len, features);
-    cls_token = Matrix::zeros(1, features);
+    proj_weight = MatrixT<T>::zeros(features, patch_dim);
+    proj_bias = MatrixT<T>::zeros(1, features);
+    pos_embed = MatrixT<T>::zeros(seq_len, features);
+    cls_token = MatrixT<T>::zeros(1, features);
+    cls_pos = MatrixT<T>::zeros(1, features);
+    proj_quantized.clear();
+    pack_weights();
 }
 
-Matrix PatchEmbedding::forward(const Matrix& image_patches) {
-    if (image_patches.getCols() != num_patches) {
+template <typename T>
+MatrixT<T> PatchEmbeddingT<T>::forward(const MatrixT<T>& image_patches) {
+    const size_t images = num_patches > 0 ? image_patches.getRows() / num_patches : 0;
+    MatrixT<T> output(images * seq_len, features);
+    forward(ConstMatrixViewT<T>(image_patches), output.view());
+    return output;
+}
+
+template <typename T>
+void PatchEmbeddingT<T>::forward(const ConstMatrixViewT<T>& image_patches, const MatrixViewT<T>& output) {
+    if (image_patches.getCols() != static_cast<size_t>(patch_dim)) {
         throw std::runtime_error("PatchEmbedding input patch dimension mismatch. Expected: " + 
-                                std::to_string(num_patches) + ", Got: " + std::to_string(image_patches.getCols()));
+                                std::to_string(patch_dim) + ", Got: " + std::to_string(image_patches.getCols()));
     }
-    
-    // Step 1: Project patches to embedding space
-    // patches: (batch_size, num_patches) -> (batch_size, features)
-    Matrix embedded = MatrixOps::matmul(image_patches, MatrixOps::transpose(proj_weight));
-    
-    // Add bias (broadcasting)
-    for (int i = 0; i < embedded.getRows(); ++i) {
-        for (int j = 0; j < embedded.getCols(); ++j) {
-            embedded(i, j) += proj_bias(0, j);
-        }
+    const size_t patches = static_cast<size_t>(num_patches);
+    if (patches == 0 || image_patches.getRows() % patches != 0) {
+        throw std::invalid_argument("PatchEmbedding input has " + std::to_string(image_patches.getRows()) +
+                                    " patches, not a multiple of " + std::to_string(num_patches) + " per image");
     }
+    const size_t images = image_patches.getRows() / patches;
+    const size_t dim = static_cast<size_t>(features);
+    if (output.getRows() != images * seq_len || output.getCols() != dim) {
+        throw std::invalid_argument("PatchEmbedding output must be (images * seq_len, features)");
+    }
+    VIT_PROFILE_SCOPE("Layer", "PatchEmbedding.forward", 2.0 * images * patches * patch_dim * dim,
+                      proj_weight_packed.bytes() + sizeof(T) * images * (patches * patch_dim + seq_len * dim));
     
-    // Step 2: Add class token
-    Matrix with_cls = add_class_token(embedded);
+    Gemm::Epilogue<T> epilogue;
+    epilogue.bias = proj_bias.data();
     
-    // Step 3: Add positional embeddings
-    Matrix final_embedding = add_positional_embeddings(with_cls);
+    // One projection GEMM for the patches of every image, bias in its
+    // epilogue, into the last images * patches rows of output
+    const size_t first = images * seq_len - images * patches;
+    proj_quantized.gemm(images * patches, image_patches.row_ptr(0), image_patches.getStride(), proj_weight_packed,
+                        output.row_ptr(first), output.getStride(), epilogue);
     
-    return final_embedding;
-}
-
-Matrix PatchEmbedding::add_class_token(const Matrix& embedded_patches) {
-    int batch_size = embedded_patches.getRows();
-    Matrix with_cls(batch_size, seq_len * features);
-    
-    // Add class token to the beginning of each sequence
-    for (int b = 0; b < batch_size; ++b) {
-        // Copy class token to positions 0 to features-1
-        for (int f = 0; f < features; ++f) {
-            with_cls(b, f) = cls_token(0, f);
-        }
-        
-        // Copy embedded patches to positions features to seq_len*features-1
-        for (int f = 0; f < features; ++f) {
-            with_cls(b, features + f) = embedded_patches(b, f);
+    // Move each image's rows up to tokens 1..num_patches, adding the
+    // positional embeddings, then write token 0 (class token plus its
+    // positional embedding). Rows only move up and images go in order, so a
+    // row is always read before anything is written over it.
+    for (size_t image = 0; image < images; ++image) {
+        for (size_t p = 0; p < patches; ++p) {
+            const T* src = output.row_ptr(first + image * patches + p);
+            const T* pos = pos_embed.row_ptr(1 + p);
+            T* dst = output.row_ptr(image * seq_len + 1 + p);
+            for (size_t j = 0; j < dim; ++j) {
+                dst[j] = src[j] + pos[j];
+            }
         }
+        std::copy(cls_pos.data(), cls_pos.data() + dim, output.row_ptr(image * seq_len));
     }
-    
-    return with_cls;
 }
 
-Matrix PatchEmbedding::add_positional_embeddings(const Matrix& embedded_with_cls) {
-    Matrix result = embedded_with_cls;
-    int batch_size = result.getRows();
+template <typename T>
+void PatchEmbeddingT<T>::pack_weights() {
+    // forward computes patches * proj_weight^T; pack the transposed operand once
+    proj_weight_packed = MatrixOps::pack_rhs_transposed(proj_weight, weight_storage);
+}
+
+template <typename T>
+void PatchEmbeddingT<T>::set_weight_storage(Gemm::Storage storage) {
+    weight_storage = storage;
+    pack_weights();
+}
+
+template <typename T>
+void PatchEmbeddingT<T>::collect_linears(std::vector<typename QuantizedLinearT<T>::Slot>& slots) {
+    slots.push_back({"other/input_layer_weight", &proj_weight, &proj_quantized, &proj_weight_packed});
+}
+
+template <typename T>
+void PatchEmbeddingT<T>::collect_linears(std::vector<typename QuantizedLinearT<T>::ConstSlot>& slots) const {
+    slots.push_back({"other/input_layer_weight", &proj_weight, &proj_quantized, &proj_weight_packed});
+}
+
+template <typename T>
+void PatchEmbeddingT<T>::set_weights(MatrixT<T> weight, MatrixT<T> bias, MatrixT<T> pos, MatrixT<T> cls,
+                                     bool pack) {
+    // proj_bias and cls_token may come as (n, 1) columns; the rows hold the
+    // same elements, so no copy is needed
+    bias.reshape(1, bias.size());
+    cls.reshape(1, cls.size());
     
-    // Add positional embeddings (broadcasting across batch dimension)
-    // Simplified: just add a small positional bias (skip for now to avoid dimension issues)
-    // TODO: Implement proper positional embedding handling
-    for (int b = 0; b < batch_size; ++b) {
-        for (int f = 0; f < std::min(features, (int)result.getCols()); ++f) {
-            // Add a small positional bias for now
-            result(b, f) += 0.01 * f; // Simple position-dependent bias
-        }
+    const size_t dim = weight.getRows();
+    if (bias.size() != dim || cls.size() != dim || pos.getCols() != dim || pos.getRows() < 2) {
+        throw std::runtime_error("PatchEmbedding weight shapes are inconsistent: input_layer " +
+                                 std::to_string(weight.getRows()) + "x" + std::to_string(weight.getCols()) +
+                                 ", pos_embedding " + std::to_string(pos.getRows()) + "x" +
+                                 std::to_string(pos.getCols()));
     }
     
-    return result;
+    proj_weight = std::move(weight);
+    proj_bias = std::move(bias);
+    pos_embed = std::move(pos);
+    cls_token = std::move(cls);
+    
+    // Update dimensions based on loaded weights
+    features = static_cast<int>(dim);
+    patch_dim = static_cast<int>(proj_weight.getCols());
+    seq_len = static_cast<int>(pos_embed.getRows());
+    num_patches = seq_len - 1; // One positional embedding per patch plus the class token
+    
+    cls_pos.resize_for_overwrite(1, dim);
+    const T* pos0 = pos_embed.row_ptr(0);
+    for (size_t j = 0; j < dim; ++j) {
+        cls_pos.data()[j] = cls_token.data()[j] + pos0[j];
+    }
+    if (pack) {
+        pack_weights();
+    }
 }
 
-void PatchEmbedding::load_weights(const std::string& base_path) {
+template <typename T>
+void PatchEmbeddingT<T>::load_weights(const std::string& base_path) {
     try {
-        // Load projection weights and bias
+        // Projection weights and bias, positional embeddings, class token
         std::string proj_weight_path = base_path + "/other/input_layer_weight.csv";
         std::string proj_bias_path = base_path + "/other/input_layer_bias.csv";
-        
-        proj_weight = FileIO::load_matrix_from_csv(proj_weight_path, true);
-        proj_bias = FileIO::load_matrix_from_csv(proj_bias_path, true);
-        
-        // Ensure proj_bias is a row vector
-        if (proj_bias.getRows() > 1) {
-            proj_bias = MatrixOps::transpose(proj_bias);
-        }
-        
-        // Load positional embeddings
         std::string pos_embed_path = base_path + "/position_embedding/pos_embedding.csv";
-        pos_embed = FileIO::load_matrix_from_csv(pos_embed_path, true);
-        
-        // Load class token
         std::string cls_token_path = base_path + "/class_token/cls_token.csv";
-        cls_token = FileIO::load_matrix_from_csv(cls_token_path, true);
         
-        // Update dimensions based on loaded weights
-        features = proj_weight.getRows();
-        num_patches = proj_weight.getCols();
-        seq_len = num_patches + 1; // Simple calculation: patches + class token
+        proj_quantized.clear();
+        set_weights(FileIO::load_matrix_from_csv<T>(proj_weight_path, true),
+                    FileIO::load_matrix_from_csv<T>(proj_bias_path, true),
+                    FileIO::load_matrix_from_csv<T>(pos_embed_path, true),
+                    FileIO::load_matrix_from_csv<T>(cls_token_path, true));
         
         std::cout << "PatchEmbedding weights loaded successfully!" << std::endl;
-        std::cout << "Features: " << features << ", Patches: " << num_patches 
+        std::cout << "Features: " << features << ", Patches: " << num_patches << " x " << patch_dim
                   << ", Sequence Length: " << seq_len << std::endl;
         
     } catch (const std::exception& e) {
         throw std::runtime_error("Failed to load PatchEmbedding weights: " + std::string(e.what()));
     }
-}
\ No newline at end of file
+}
+
+template <typename T>
+void PatchEmbeddingT<T>::load_weights(const WeightFile& weights, bool pack) {
+    try {
+        set_weights(proj_quantized.load_weight(weights, "other/input_layer_weight"),
+                    weights.get<T>("other/input_layer_bias"),
+                    weights.get<T>("position_embedding/pos_embedding"),
+                    weights.get<T>("class_token/cls_token"), pack);
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Failed to load PatchEmbedding weights: " + std::string(e.what()));
+    }
+}
+
+template class PatchEmbeddingT<float>;
+template class PatchEmbeddingT<double>;
@@ -4,70 +4,118 @@
 
 #include "../../include/transformer/layer_norm.h"
 #include "../../include/matrix/activation_functions.h"
-#include "../../include/matrix/matrix_ops.h"
+#include "../../include/utils/profiler.h"
 #include <iostream>
 #include <stdexcept>
 
-LayerNorm::LayerNorm(int features, double eps) : features(features), epsilon(eps) {
+namespace {
+
+// Profiler work counts: about 8 flops per element (mean, variance, scale,
+// shift); input and output rows plus gamma and beta
+double norm_flops(size_t rows, int features) {
+    return 8.0 * rows * features;
+}
+
+template <typename T>
+double norm_bytes(size_t rows, int features) {
+    return double(sizeof(T)) * (2.0 * rows + 2.0) * features;
+}
+
+} // namespace
+
+template <typename T>
+LayerNormT<T>::LayerNormT(int features, double eps) : features(features), epsilon(eps) {
     // Initialize gamma to ones and beta to zeros
-    gamma = Matrix::ones(1, features);
-    beta = Matrix::zeros(1, features);
+    gamma = MatrixT<T>::ones(1, features);
+    beta = MatrixT<T>::zeros(1, features);
 }
 
-LayerNorm::LayerNorm() : features(0), epsilon(1e-5) {
+template <typename T>
+LayerNormT<T>::LayerNormT() : features(0), epsilon(1e-5) {
     // Default constructor - will be initialized later
 }
 
-void LayerNorm::initialize(int features, double eps) {
+template <typename T>
+void LayerNormT<T>::initialize(int features, double eps) {
     this->features = features;
     this->epsilon = eps;
-    gamma = Matrix::ones(1, features);
-    beta = Matrix::zeros(1, features);
+    gamma = MatrixT<T>::ones(1, features);
+    beta = MatrixT<T>::zeros(1, features);
 }
 
-Matrix LayerNorm::forward(const Matrix& input) {
+template <typename T>
+MatrixT<T> LayerNormT<T>::forward(const MatrixT<T>& input) {
     if (input.getCols() != features) {
         throw std::runtime_error("LayerNorm input feature dimension mismatch. Expected: " + 
                                 std::to_string(features) + ", Got: " + std::to_string(input.getCols()));
     }
-    
+    VIT_PROFILE_SCOPE("Layer", "LayerNorm.forward", norm_flops(input.getRows(), features),
+                      norm_bytes<T>(input.getRows(), features));
+
     // Use the existing layerNorm function from activation_functions
     return ActivationFunctions::layerNorm(input, gamma, beta, epsilon, 1);
 }
 
-void LayerNorm::load_weights(const std::string& base_path, int layer_idx, const std::string& norm_type) {
+template <typename T>
+void LayerNormT<T>::forward_inplace(MatrixT<T>& x) {
+    if (x.getCols() != static_cast<size_t>(features)) {
+        throw std::runtime_error("LayerNorm input feature dimension mismatch. Expected: " + 
+                                std::to_string(features) + ", Got: " + std::to_string(x.getCols()));
+    }
+    VIT_PROFILE_SCOPE("Layer", "LayerNorm.forward", norm_flops(x.getRows(), features),
+                      norm_bytes<T>(x.getRows(), features));
+
+    ActivationFunctions::layerNormInPlace(x, gamma, beta, epsilon);
+}
+
+template <typename T>
+void LayerNormT<T>::forward(const ConstMatrixViewT<T>& input, const MatrixViewT<T>& output) {
+    if (input.getCols() != static_cast<size_t>(features)) {
+        throw std::runtime_error("LayerNorm input feature dimension mismatch. Expected: " + 
+                                std::to_string(features) + ", Got: " + std::to_string(input.getCols()));
+    }
+    VIT_PROFILE_SCOPE("Layer", "LayerNorm.forward", norm_flops(input.getRows(), features),
+                      norm_bytes<T>(input.getRows(), features));
+
+    ActivationFunctions::layerNormRows(input, gamma, beta, epsilon, output);
+}
+
+template <typename T>
+std::string LayerNormT<T>::tensor_name(int layer_idx, const std::string& norm_type, const std::string& param) {
+    if (layer_idx == -1) {
+        // Final layer norm (not implemented in current structure, but prepared for future)
+        return "norm_" + param;
+    }
+    // Transformer layer norm
+    return "transformer_layers/transformer_" + std::to_string(layer_idx) + "_" + norm_type + "_" + param;
+}
+
+template <typename T>
+void LayerNormT<T>::set_weights(MatrixT<T> weight_matrix, MatrixT<T> bias_matrix) {
+    // Column vectors (the CSV export) hold the same elements as the rows the
+    // kernel reads, so reshape in place; weight file tensors stay borrowed
+    weight_matrix.reshape(1, weight_matrix.size());
+    bias_matrix.reshape(1, bias_matrix.size());
+    if (bias_matrix.size() != weight_matrix.size()) {
+        throw std::runtime_error("LayerNorm weight and bias sizes differ: " + std::to_string(weight_matrix.size()) +
+                                 " vs " + std::to_string(bias_matrix.size()));
+    }
+    
+    // Set the dimensions
+    features = weight_matrix.getCols();
+    gamma = std::move(weight_matrix);
+    beta = std::move(bias_matrix);
+}
+
+template <typename T>
+void LayerNormT<T>::load_weights(const std::string& base_path, int layer_idx, const std::string& norm_type) {
     try {
-        std::string weight_path, bias_path;
-        
-        if (layer_idx == -1) {
-            // Final layer norm (not implemented in current structure, but prepared for future)
-            weight_path = base_path + "/norm_weight.csv";
-            bias_path = base_path + "/norm_bias.csv";
-        } else {
-            // Transformer layer norm
-            weight_path = base_path + "/transformer_layers/transformer_" + std::to_string(layer_idx) + 
-                         "_" + norm_type + "_weight.csv";
-            bias_path = base_path + "/transformer_layers/transformer_" + std::to_string(layer_idx) + 
-                       "_" + norm_type + "_bias.csv";
-        }
+        std::string weight_path = base_path + "/" + tensor_name(layer_idx, norm_type, "weight") + ".csv";
+        std::string bias_path = base_path + "/" + tensor_name(layer_idx, norm_type, "bias") + ".csv";
         
         // Load weights as matrices (CSV files have headers)
-        Matrix weight_matrix = FileIO::load_matrix_from_csv(weight_path, true);
-        Matrix bias_matrix = FileIO::load_matrix_from_csv(bias_path, true);
-        
-        // Ensure they are row vectors
-        if (weight_matrix.getRows() > 1) {
-            // If loaded as column vector, transpose
-            weight_matrix = MatrixOps::transpose(weight_matrix);
-        }
-        if (bias_matrix.getRows() > 1) {
-            bias_matrix = MatrixOps::transpose(bias_matrix);
-        }
-        
-        // Set the dimensions
-        features = weight_matrix.getCols();
-        gamma = weight_matrix;
-        beta = bias_matrix;
+        set_weights(FileIO::load_matrix_from_csv<T>(weight_path, true),
+                    FileIO::load_matrix_from_csv<T>(bias_path, true));
         
         std::cout << "LayerNorm weights loaded successfully for layer " << layer_idx 
                   << " " << norm_type << std::endl;
@@ -76,4 +124,17 @@ void LayerNorm::load_weights(const std::string& base_path, int layer_idx, const
     } catch (const std::exception& e) {
         throw std::runtime_error("Failed to load LayerNorm weights: " + std::string(e.what()));
     }
-}
\ No newline at end of file
+}
+
+template <typename T>
+void LayerNormT<T>::load_weights(const WeightFile& weights, int layer_idx, const std::string& norm_type) {
+    try {
+        set_weights(weights.get<T>(tensor_name(layer_idx, norm_type, "weight")),
+                    weights.get<T>(tensor_name(layer_idx, norm_type, "bias")));
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Failed to load LayerNorm weights: " + std::string(e.what()));
+    }
+}
+
+template class LayerNormT<float>;
+template class LayerNormT<double>;
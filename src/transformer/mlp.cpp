@@ -0,0 +1,182 @@
+//
+// Created by JAYAN on 27/07/2025.
+//
+
+#include "../../include/transformer/mlp.h"
+#include "../../include/matrix/matrix_ops.h"
+#include "../../include/utils/profiler.h"
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+
+Gemm::Activation gemm_activation(ActivationFunctions::GeluMode mode) {
+    return mode == ActivationFunctions::GeluMode::Erf ? Gemm::Activation::GeluErf : Gemm::Activation::GeluTanh;
+}
+
+} // namespace
+
+template <typename T>
+MLPT<T>::MLPT(int d_model, int hidden_dim, ActivationFunctions::GeluMode gelu_mode)
+    : weight_storage(Gemm::Storage::Native), gelu_mode(gelu_mode) {
+    initialize(d_model, hidden_dim);
+}
+
+template <typename T>
+MLPT<T>::MLPT()
+    : weight_storage(Gemm::Storage::Native), d_model(0), hidden_dim(0), gelu_mode(ActivationFunctions::GeluMode::Erf) {
+    // Default constructor - will be initialized later
+}
+
+template <typename T>
+void MLPT<T>::initialize(int d_model, int hidden_dim) {
+    this->d_model = d_model;
+    this->hidden_dim = hidden_dim;
+    fc1_weight = MatrixT<T>::zeros(hidden_dim, d_model);
+    fc1_bias = MatrixT<T>::zeros(1, hidden_dim);
+    fc2_weight = MatrixT<T>::zeros(d_model, hidden_dim);
+    fc2_bias = MatrixT<T>::zeros(1, d_model);
+    fc1_quantized.clear();
+    fc2_quantized.clear();
+    pack_weights();
+}
+
+template <typename T>
+MatrixT<T> MLPT<T>::forward(const MatrixT<T>& input) {
+    MatrixT<T> output(input.getRows(), input.getCols());
+    run(ConstMatrixViewT<T>(input), output.view(), false, nullptr);
+    return output;
+}
+
+template <typename T>
+void MLPT<T>::forward(const ConstMatrixViewT<T>& input, const MatrixViewT<T>& output, T* workspace) {
+    run(input, output, false, workspace);
+}
+
+template <typename T>
+void MLPT<T>::forward_residual(const ConstMatrixViewT<T>& input, const MatrixViewT<T>& residual, T* workspace) {
+    run(input, residual, true, workspace);
+}
+
+template <typename T>
+void MLPT<T>::run(const ConstMatrixViewT<T>& input, const MatrixViewT<T>& output, bool accumulate, T* workspace) {
+    const size_t tokens = input.getRows();
+    if (input.getCols() != static_cast<size_t>(d_model)) {
+        throw std::runtime_error("MLP input feature dimension mismatch. Expected: " +
+                                std::to_string(d_model) + ", Got: " + std::to_string(input.getCols()));
+    }
+    if (output.getRows() != tokens || output.getCols() != static_cast<size_t>(d_model)) {
+        throw std::invalid_argument("MLP output must match the input dimensions");
+    }
+    VIT_PROFILE_SCOPE("Layer", "MLP.forward", 4.0 * tokens * d_model * hidden_dim,
+                      get_packed_bytes() + 2.0 * sizeof(T) * tokens * d_model);
+
+    T* hidden_data = workspace;
+    if (!hidden_data) {
+        hidden.resize_for_overwrite(tokens, hidden_dim);
+        hidden_data = hidden.data();
+    }
+
+    // hidden = GELU(input * fc1^T + b1), bias and GELU applied per finished tile
+    Gemm::Epilogue<T> fc1_epilogue;
+    fc1_epilogue.bias = fc1_bias.data();
+    fc1_epilogue.activation = gemm_activation(gelu_mode);
+    fc1_quantized.gemm(tokens, input.data(), input.getStride(), fc1_packed, hidden_data, hidden_dim, fc1_epilogue);
+
+    // output (+)= hidden * fc2^T + b2
+    Gemm::Epilogue<T> fc2_epilogue;
+    fc2_epilogue.bias = fc2_bias.data();
+    fc2_epilogue.accumulate = accumulate;
+    fc2_quantized.gemm(tokens, hidden_data, hidden_dim, fc2_packed, output.data(), output.getStride(),
+                       fc2_epilogue);
+}
+
+template <typename T>
+void MLPT<T>::pack_weights() {
+    // Both layers compute x * W^T
+    fc1_packed = MatrixOps::pack_rhs_transposed(fc1_weight, weight_storage);
+    fc2_packed = MatrixOps::pack_rhs_transposed(fc2_weight, weight_storage);
+}
+
+template <typename T>
+void MLPT<T>::set_weight_storage(Gemm::Storage storage) {
+    weight_storage = storage;
+    pack_weights();
+}
+
+template <typename T>
+std::string MLPT<T>::tensor_name(int layer_idx, int linear_idx, const std::string& param) {
+    return "transformer_layers/transformer_" + std::to_string(layer_idx) + "_linear_" +
+           std::to_string(linear_idx) + "_" + param;
+}
+
+template <typename T>
+void MLPT<T>::collect_linears(int layer_idx, std::vector<typename QuantizedLinearT<T>::Slot>& slots) {
+    slots.push_back({tensor_name(layer_idx, 0, "weight"), &fc1_weight, &fc1_quantized, &fc1_packed});
+    slots.push_back({tensor_name(layer_idx, 3, "weight"), &fc2_weight, &fc2_quantized, &fc2_packed});
+}
+
+template <typename T>
+void MLPT<T>::collect_linears(int layer_idx, std::vector<typename QuantizedLinearT<T>::ConstSlot>& slots) const {
+    slots.push_back({tensor_name(layer_idx, 0, "weight"), &fc1_weight, &fc1_quantized, &fc1_packed});
+    slots.push_back({tensor_name(layer_idx, 3, "weight"), &fc2_weight, &fc2_quantized, &fc2_packed});
+}
+
+template <typename T>
+void MLPT<T>::set_weights(MatrixT<T> w1, MatrixT<T> b1, MatrixT<T> w2, MatrixT<T> b2, bool pack) {
+    b1 = MatrixOps::as_row_vector(std::move(b1));
+    b2 = MatrixOps::as_row_vector(std::move(b2));
+
+    const size_t dm = w1.getCols();
+    const size_t hd = w1.getRows();
+    if (w2.getRows() != dm || w2.getCols() != hd || b1.size() != hd || b2.size() != dm) {
+        throw std::runtime_error("MLP weight shapes are inconsistent: linear_0 " + std::to_string(w1.getRows()) +
+                                 "x" + std::to_string(w1.getCols()) + ", linear_3 " +
+                                 std::to_string(w2.getRows()) + "x" + std::to_string(w2.getCols()));
+    }
+
+    d_model = static_cast<int>(dm);
+    hidden_dim = static_cast<int>(hd);
+    fc1_weight = std::move(w1);
+    fc1_bias = std::move(b1);
+    fc2_weight = std::move(w2);
+    fc2_bias = std::move(b2);
+    if (pack) {
+        pack_weights();
+    }
+}
+
+template <typename T>
+void MLPT<T>::load_weights(const std::string& base_path, int layer_idx) {
+    try {
+        std::string prefix = base_path + "/";
+        fc1_quantized.clear();
+        fc2_quantized.clear();
+        set_weights(FileIO::load_matrix_from_csv<T>(prefix + tensor_name(layer_idx, 0, "weight") + ".csv", true),
+                    FileIO::load_matrix_from_csv<T>(prefix + tensor_name(layer_idx, 0, "bias") + ".csv", true),
+                    FileIO::load_matrix_from_csv<T>(prefix + tensor_name(layer_idx, 3, "weight") + ".csv", true),
+                    FileIO::load_matrix_from_csv<T>(prefix + tensor_name(layer_idx, 3, "bias") + ".csv", true));
+
+        std::cout << "MLP weights loaded successfully for layer " << layer_idx << std::endl;
+        std::cout << "d_model: " << d_model << ", Hidden: " << hidden_dim << std::endl;
+
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Failed to load MLP weights: " + std::string(e.what()));
+    }
+}
+
+template <typename T>
+void MLPT<T>::load_weights(const WeightFile& weights, int layer_idx, bool pack) {
+    try {
+        // Linear weights may be stored quantised
+        set_weights(fc1_quantized.load_weight(weights, tensor_name(layer_idx, 0, "weight")),
+                    weights.get<T>(tensor_name(layer_idx, 0, "bias")),
+                    fc2_quantized.load_weight(weights, tensor_name(layer_idx, 3, "weight")),
+                    weights.get<T>(tensor_name(layer_idx, 3, "bias")), pack);
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Failed to load MLP weights: " + std::string(e.what()));
+    }
+}
+
+template class MLPT<float>;
+template class MLPT<double>;
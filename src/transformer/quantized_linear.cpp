@@ -0,0 +1,125 @@
+//
+// Created by JAYAN on 01/08/2025.
+//
+
+#include "../../include/transformer/quantized_linear.h"
+#include "../../include/utils/workspace.h"
+#include <algorithm>
+#include <stdexcept>
+
+template <typename T>
+QuantizedLinearT<T>::QuantizedLinearT()
+    : state(State::Float), observed_min(0.0f), observed_max(0.0f), observed_rows(0) {}
+
+template <typename T>
+void QuantizedLinearT<T>::gemm(size_t m, const T* a, size_t lda, const Gemm::PackedMatrix<T>& float_weights, T* c,
+                               size_t ldc, const Gemm::Epilogue<T>& epilogue) {
+    if (state != State::Quantized) {
+        if (state == State::Calibrating) {
+            observe(m, float_weights.getRows(), a, lda);
+        }
+        Gemm::gemm_packed(m, a, lda, 1, float_weights, c, ldc, epilogue);
+        return;
+    }
+
+    const size_t k = weights.getRows();
+    const size_t ldq = QGemm::padded_depth(k);
+    Workspace& workspace = Workspace::local();
+    Workspace::Scope scope(workspace);
+    uint8_t* quantized = workspace.allocate<uint8_t>(m * ldq);
+    QGemm::quantize_activations(m, k, a, lda, input_params, quantized, ldq);
+    QGemm::gemm(m, quantized, ldq, input_params, weights, c, ldc, epilogue);
+}
+
+template <typename T>
+void QuantizedLinearT<T>::observe(size_t m, size_t k, const T* a, size_t lda) {
+    T low = static_cast<T>(observed_min);
+    T high = static_cast<T>(observed_max);
+    for (size_t i = 0; i < m; ++i) {
+        const T* row = a + i * lda;
+        for (size_t p = 0; p < k; ++p) {
+            low = std::min(low, row[p]);
+            high = std::max(high, row[p]);
+        }
+    }
+    observed_min = static_cast<float>(low);
+    observed_max = static_cast<float>(high);
+    observed_rows += m;
+}
+
+template <typename T>
+void QuantizedLinearT<T>::start_calibration() {
+    state = State::Calibrating;
+    weights = QGemm::PackedWeights();
+    observed_min = 0.0f;
+    observed_max = 0.0f;
+    observed_rows = 0;
+}
+
+template <typename T>
+void QuantizedLinearT<T>::quantize(const MatrixT<T>& weight) {
+    if (state != State::Calibrating || observed_rows == 0) {
+        throw std::runtime_error("QuantizedLinear::quantize needs at least one calibrated forward");
+    }
+    std::vector<int8_t> q;
+    std::vector<float> scales;
+    QGemm::quantize_weights(weight.data(), weight.getRows(), weight.getCols(), q, scales);
+    set_quantized(q.data(), weight.getRows(), weight.getCols(), scales.data(),
+                  QGemm::choose_activation_params(observed_min, observed_max));
+}
+
+template <typename T>
+void QuantizedLinearT<T>::set_quantized(const int8_t* q, size_t n, size_t k, const float* scales,
+                                        const QGemm::ActivationParams& params) {
+    if (!(params.scale > 0.0f) || params.zero_point < 0 || params.zero_point > QGemm::ACTIVATION_MAX) {
+        throw std::invalid_argument("QuantizedLinear input scale must be positive and its zero point in [0, " +
+                                    std::to_string(QGemm::ACTIVATION_MAX) + "]");
+    }
+    weights = QGemm::PackedWeights(n, k, q, scales);
+    input_params = params;
+    state = State::Quantized;
+}
+
+template <typename T>
+void QuantizedLinearT<T>::clear() {
+    state = State::Float;
+    weights = QGemm::PackedWeights();
+    input_params = QGemm::ActivationParams();
+}
+
+template <typename T>
+MatrixT<T> QuantizedLinearT<T>::load_weight(const WeightFile& file, const std::string& name) {
+    const WeightFile::TensorInfo& info = file.info(name);
+    if (info.dtype != WeightFile::DType::Int8) {
+        clear();
+        return file.get<T>(name);
+    }
+
+    const size_t n = info.rows;
+    const size_t k = info.cols;
+    const MatrixF scales = file.get<float>(scale_tensor_name(name));
+    const MatrixF input = file.get<float>(input_tensor_name(name));
+    if (scales.size() != n || input.size() != 2) {
+        throw std::runtime_error("Quantised tensor '" + name + "' has inconsistent scale tensors");
+    }
+    QGemm::ActivationParams params;
+    params.scale = input.data()[0];
+    params.zero_point = static_cast<int32_t>(input.data()[1]);
+
+    const int8_t* q = static_cast<const int8_t*>(file.raw(name));
+    set_quantized(q, n, k, scales.data(), params);
+
+    // The float weight the layer keeps is the dequantised one
+    MatrixT<T> weight(n, k);
+    for (size_t j = 0; j < n; ++j) {
+        T* row = weight.row_ptr(j);
+        const T scale = static_cast<T>(scales.data()[j]);
+        for (size_t p = 0; p < k; ++p) {
+            row[p] = scale * static_cast<T>(q[j * k + p]);
+        }
+    }
+    return weight;
+}
+
+template class QuantizedLinearT<float>;
+template class QuantizedLinearT<double>;
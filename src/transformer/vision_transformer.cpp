@@ -0,0 +1,510 @@
+//
+// Created by JAYAN on 28/07/2025.
+//
+
+#include "../../include/transformer/vision_transformer.h"
+#include "../../include/matrix/matrix_ops.h"
+#include "../../include/utils/file_io.h"
+#include "../../include/utils/profiler.h"
+#include "../../include/utils/thread_pool.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// Activation buffers of one forward, in PlannedBuffer order
+enum Buffer { Residual, Normed, AttentionWorkspace, MlpWorkspace, HeadInput, BUFFER_COUNT };
+
+// Forward stages, as PlannedBuffer steps
+enum Step { Embed, Norm1, Attention, Norm2, Mlp, HeadNorm, Classifier };
+
+// Packed weight cache: the weight file it was built from, as (1, 5) size,
+// modification seconds and nanoseconds, and the high and low halves of its
+// checksum (all exact in a double). Stored under packed_tensor_name, so a
+// cache packed for another storage or kernel layout does not match either.
+const char* const CACHE_SOURCE = "packed_cache/source";
+
+MatrixT<double> source_stamp(const WeightFile& source) {
+    const std::string& path = source.path();
+    const auto since_epoch = std::filesystem::last_write_time(path).time_since_epoch();
+    const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(since_epoch);
+    const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(since_epoch - seconds);
+    const uint64_t checksum = source.checksum();
+    return MatrixT<double>({{static_cast<double>(std::filesystem::file_size(path)),
+                             static_cast<double>(seconds.count()), static_cast<double>(nanoseconds.count()),
+                             static_cast<double>(checksum >> 32), static_cast<double>(checksum & 0xffffffffu)}});
+}
+
+// Cache dtype of panels in storage
+template <typename T>
+WeightFile::DType panel_dtype(Gemm::Storage storage) {
+    switch (storage) {
+        case Gemm::Storage::BFloat16: return WeightFile::DType::BFloat16;
+        case Gemm::Storage::Float16: return WeightFile::DType::Float16;
+        default: return sizeof(T) == sizeof(float) ? WeightFile::DType::Float32 : WeightFile::DType::Float64;
+    }
+}
+
+// Greedy offset assignment, largest buffer first: each buffer goes at the
+// lowest offset clear of every already placed buffer whose lifetime overlaps
+// its own. Returns the arena size in elements.
+template <typename Planned>
+size_t place_buffers(std::vector<Planned>& buffers) {
+    std::vector<size_t> order(buffers.size());
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::stable_sort(order.begin(), order.end(),
+                     [&](size_t a, size_t b) { return buffers[a].elements > buffers[b].elements; });
+
+    size_t arena_size = 0;
+    std::vector<size_t> placed;
+    std::vector<std::pair<size_t, size_t>> taken; // [begin, end) of live neighbours
+    for (size_t index : order) {
+        Planned& buffer = buffers[index];
+        taken.clear();
+        for (size_t other_index : placed) {
+            const Planned& other = buffers[other_index];
+            if (other.first_step <= buffer.last_step && buffer.first_step <= other.last_step) {
+                taken.emplace_back(other.offset, other.offset + other.elements);
+            }
+        }
+        std::sort(taken.begin(), taken.end());
+
+        size_t offset = 0;
+        for (const auto& [begin, end] : taken) {
+            if (offset + buffer.elements <= begin) {
+                break;
+            }
+            offset = std::max(offset, end);
+        }
+        buffer.offset = offset;
+        arena_size = std::max(arena_size, offset + buffer.elements);
+        placed.push_back(index);
+    }
+    return arena_size;
+}
+
+} // namespace
+
+template <typename T>
+VisionTransformerT<T>::VisionTransformerT(size_t max_batch, int num_heads)
+    : num_heads(num_heads), weight_storage(Gemm::Storage::Native), attention_kernel(AttentionKernel::Standard),
+      max_batch(std::max<size_t>(max_batch, 1)) {
+    // Weights and the arena come with load_weights
+}
+
+template <typename T>
+std::string VisionTransformerT<T>::head_tensor_name(int index, const std::string& param) {
+    return "classifier/mlp_head_" + std::to_string(index) + "_" + param;
+}
+
+template <typename T>
+std::string VisionTransformerT<T>::block_probe_name(size_t layer_idx) {
+    return "transformer_layers/transformer_" + std::to_string(layer_idx) + "_attn_in_proj_weight";
+}
+
+template <typename T>
+void VisionTransformerT<T>::load_weights(const std::string& base_path) {
+    try {
+        const std::string prefix = base_path + "/";
+        embedding.load_weights(base_path);
+        head_quantized.clear();
+
+        blocks.clear();
+        for (size_t i = 0; FileIO::file_exists(prefix + block_probe_name(i) + ".csv"); ++i) {
+            EncoderBlock& block = blocks.emplace_back();
+            block.attention.set_weight_storage(weight_storage);
+            block.mlp.set_weight_storage(weight_storage);
+            block.norm_1.load_weights(base_path, static_cast<int>(i), "layer_norm_1");
+            block.attention.set_num_heads(num_heads);
+            block.attention.load_weights(base_path, static_cast<int>(i));
+            block.norm_2.load_weights(base_path, static_cast<int>(i), "layer_norm_2");
+            block.mlp.load_weights(base_path, static_cast<int>(i));
+        }
+
+        set_head_weights(FileIO::load_matrix_from_csv<T>(prefix + head_tensor_name(0, "weight") + ".csv", true),
+                         FileIO::load_matrix_from_csv<T>(prefix + head_tensor_name(0, "bias") + ".csv", true),
+                         FileIO::load_matrix_from_csv<T>(prefix + head_tensor_name(1, "weight") + ".csv", true),
+                         FileIO::load_matrix_from_csv<T>(prefix + head_tensor_name(1, "bias") + ".csv", true));
+        configure_blocks();
+
+        std::cout << "VisionTransformer weights loaded successfully!" << std::endl;
+        std::cout << "Layers: " << blocks.size() << ", d_model: " << get_d_model()
+                  << ", Classes: " << get_num_classes() << ", Arena: " << get_arena_bytes() / 1024 << " KiB"
+                  << std::endl;
+
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Failed to load VisionTransformer weights: " + std::string(e.what()));
+    }
+}
+
+template <typename T>
+void VisionTransformerT<T>::load_weights(const WeightFile& weights) {
+    read_weights(weights, true);
+}
+
+template <typename T>
+size_t VisionTransformerT<T>::load_weights(const WeightFile& weights, const std::string& packed_cache) {
+    std::shared_ptr<WeightFile> cache;
+    if (FileIO::file_exists(packed_cache)) {
+        try {
+            cache = WeightFile::open(packed_cache);
+            const std::string tag = packed_tensor_name(CACHE_SOURCE);
+            if (!cache->contains(tag) || cache->get<double>(tag) != source_stamp(weights)) {
+                cache.reset();
+            }
+        } catch (const std::exception&) {
+            cache.reset();      // Unreadable: rebuilt below
+        }
+    }
+
+    read_weights(weights, false);
+    const std::vector<typename QuantizedLinearT<T>::Slot> slots = get_linears();
+    size_t adopted = 0;
+    for (const auto& slot : slots) {
+        const std::string name = packed_tensor_name(slot.name);
+        if (cache && cache->contains(name) && cache->info(name).dtype == panel_dtype<T>(weight_storage) &&
+            cache->info(name).rows == 1) {
+            try {
+                *slot.packed = Gemm::PackedMatrix<T>::adopt(slot.weight->getCols(), slot.weight->getRows(),
+                                                            weight_storage, cache->raw(name), cache->info(name).cols,
+                                                            cache);
+                ++adopted;
+                continue;
+            } catch (const std::invalid_argument&) {
+                // Panels of another shape: pack below
+            }
+        }
+        *slot.packed = MatrixOps::pack_rhs_transposed(*slot.weight, weight_storage);
+    }
+
+    if (adopted < slots.size()) {
+        // The cache only saves packing time; the weights are loaded either way
+        try {
+            save_packed_weights(packed_cache, weights);
+        } catch (const std::exception& e) {
+            std::cerr << "Warning: packed weight cache not written: " << e.what() << std::endl;
+        }
+    }
+    return adopted;
+}
+
+template <typename T>
+void VisionTransformerT<T>::save_packed_weights(const std::string& path, const WeightFile& source) {
+    const MatrixT<double> stamp = source_stamp(source);
+    std::vector<WeightFile::RawTensor> tensors;
+    tensors.push_back({packed_tensor_name(CACHE_SOURCE), WeightFile::DType::Float64, stamp.getRows(), stamp.getCols(),
+                       stamp.data()});
+    for (const auto& slot : get_linears()) {
+        const Gemm::PackedMatrix<T>& packed = *slot.packed;
+        const void* data = packed.get_storage() == Gemm::Storage::Native
+                               ? static_cast<const void*>(packed.panel_data())
+                               : static_cast<const void*>(packed.half_panel_data());
+        tensors.push_back({packed_tensor_name(slot.name), panel_dtype<T>(packed.get_storage()), 1,
+                           packed.panel_count(), data});
+    }
+
+    // Written aside and renamed over the old cache, whose mapping may still
+    // back the panels being written. The temporary name is unique, so
+    // processes rebuilding the same cache at once do not clobber each other.
+    std::string temporary = path + ".XXXXXX";
+    const int fd = mkstemp(temporary.data());
+    if (fd < 0) {
+        throw std::runtime_error("Cannot create temporary file for " + path + ": " + std::strerror(errno));
+    }
+    // mkstemp creates the file 0600; give the cache the mode a plain create
+    // would, so other users sharing the directory can read it
+    const mode_t mask = umask(0);
+    umask(mask);
+    fchmod(fd, 0644 & ~mask);
+    close(fd);
+    try {
+        WeightFile::write(temporary, tensors);
+        std::filesystem::rename(temporary, path);
+    } catch (...) {
+        std::error_code ignored;
+        std::filesystem::remove(temporary, ignored);
+        throw;
+    }
+}
+
+template <typename T>
+std::string VisionTransformerT<T>::packed_tensor_name(const std::string& weight_name) const {
+    return weight_name + "@" + Gemm::storage_name(weight_storage) + "_" + Gemm::panel_layout<T>();
+}
+
+template <typename T>
+void VisionTransformerT<T>::read_weights(const WeightFile& weights, bool pack) {
+    try {
+        embedding.load_weights(weights, pack);
+
+        blocks.clear();
+        for (size_t i = 0; weights.contains(block_probe_name(i)); ++i) {
+            EncoderBlock& block = blocks.emplace_back();
+            block.attention.set_weight_storage(weight_storage);
+            block.mlp.set_weight_storage(weight_storage);
+            block.norm_1.load_weights(weights, static_cast<int>(i), "layer_norm_1");
+            block.attention.set_num_heads(num_heads);
+            block.attention.load_weights(weights, static_cast<int>(i), pack);
+            block.norm_2.load_weights(weights, static_cast<int>(i), "layer_norm_2");
+            block.mlp.load_weights(weights, static_cast<int>(i), pack);
+        }
+
+        set_head_weights(weights.get<T>(head_tensor_name(0, "weight")), weights.get<T>(head_tensor_name(0, "bias")),
+                         head_quantized.load_weight(weights, head_tensor_name(1, "weight")),
+                         weights.get<T>(head_tensor_name(1, "bias")), pack);
+        configure_blocks();
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Failed to load VisionTransformer weights: " + std::string(e.what()));
+    }
+}
+
+template <typename T>
+void VisionTransformerT<T>::set_head_weights(MatrixT<T> norm_weight, MatrixT<T> norm_bias, MatrixT<T> weight,
+                                             MatrixT<T> bias, bool pack) {
+    bias = MatrixOps::as_row_vector(std::move(bias));
+    const size_t dm = static_cast<size_t>(embedding.get_features());
+    if (weight.getCols() != dm || bias.size() != weight.getRows()) {
+        throw std::runtime_error("VisionTransformer classifier shapes are inconsistent: mlp_head_1 " +
+                                 std::to_string(weight.getRows()) + "x" + std::to_string(weight.getCols()) +
+                                 " for d_model " + std::to_string(dm));
+    }
+
+    head_norm.set_weights(std::move(norm_weight), std::move(norm_bias));
+    head_weight = std::move(weight);
+    head_bias = std::move(bias);
+    if (pack) {
+        head_packed = MatrixOps::pack_rhs_transposed(head_weight, weight_storage);
+    }
+}
+
+template <typename T>
+void VisionTransformerT<T>::set_weight_storage(Gemm::Storage storage) {
+    weight_storage = storage;
+    embedding.set_weight_storage(storage);
+    for (EncoderBlock& block : blocks) {
+        block.attention.set_weight_storage(storage);
+        block.mlp.set_weight_storage(storage);
+    }
+    head_packed = MatrixOps::pack_rhs_transposed(head_weight, storage);
+}
+
+template <typename T>
+size_t VisionTransformerT<T>::get_packed_weight_bytes() const {
+    size_t bytes = embedding.get_packed_bytes() + head_packed.bytes();
+    for (const EncoderBlock& block : blocks) {
+        bytes += block.attention.get_packed_bytes() + block.mlp.get_packed_bytes();
+    }
+    return bytes;
+}
+
+template <typename T>
+void VisionTransformerT<T>::configure_blocks() {
+    if (blocks.empty()) {
+        throw std::runtime_error("no transformer_layers found");
+    }
+    const size_t dm = static_cast<size_t>(embedding.get_features());
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        EncoderBlock& block = blocks[i];
+        if (static_cast<size_t>(block.norm_1.get_features()) != dm ||
+            static_cast<size_t>(block.attention.get_d_model()) != dm ||
+            static_cast<size_t>(block.norm_2.get_features()) != dm ||
+            static_cast<size_t>(block.mlp.get_d_model()) != dm) {
+            throw std::runtime_error("transformer layer " + std::to_string(i) + " does not match d_model " +
+                                     std::to_string(dm));
+        }
+        block.attention.set_kernel(attention_kernel);
+    }
+    plan_memory();
+}
+
+template <typename T>
+void VisionTransformerT<T>::reserve(size_t max_batch) {
+    this->max_batch = std::max<size_t>(max_batch, 1);
+    if (!blocks.empty()) {
+        plan_memory();
+    }
+}
+
+template <typename T>
+void VisionTransformerT<T>::set_attention_kernel(AttentionKernel kernel) {
+    attention_kernel = kernel;
+    for (EncoderBlock& block : blocks) {
+        block.attention.set_kernel(kernel);
+    }
+    if (!blocks.empty()) {
+        plan_memory();
+    }
+}
+
+template <typename T>
+void VisionTransformerT<T>::plan_memory() {
+    // Shape inference for max_batch images
+    const size_t seq_len = static_cast<size_t>(embedding.get_seq_len());
+    const size_t tokens = max_batch * seq_len;
+    const size_t dm = static_cast<size_t>(embedding.get_features());
+
+    size_t attention_scratch = 0;
+    size_t mlp_scratch = 0;
+    for (const EncoderBlock& block : blocks) {
+        attention_scratch = std::max(attention_scratch, block.attention.workspace_size(tokens, seq_len));
+        mlp_scratch = std::max(mlp_scratch, block.mlp.workspace_size(tokens));
+    }
+
+    plan.assign(BUFFER_COUNT, PlannedBuffer());
+    plan[Residual] = {"residual", aligned_size<T>(tokens * dm), Embed, HeadNorm, 0};
+    plan[Normed] = {"normed", aligned_size<T>(tokens * dm), Norm1, Mlp, 0};
+    plan[AttentionWorkspace] = {"attention workspace", attention_scratch, Attention, Attention, 0};
+    plan[MlpWorkspace] = {"mlp workspace", mlp_scratch, Mlp, Mlp, 0};
+    plan[HeadInput] = {"head input", aligned_size<T>(max_batch * dm), HeadNorm, Classifier, 0};
+
+    // One allocation for all of them; resize keeps the storage when it fits
+    arena.resize_for_overwrite(1, place_buffers(plan));
+
+    // Grow every thread's kernel scratch now, so that which worker first
+    // picks up a chunk in forward() cannot decide whether it allocates
+    ThreadPool::instance().run_on_each_thread([this](size_t, size_t) {
+        Gemm::reserve_thread_buffers<T>();
+        if (!blocks.empty()) {
+            blocks.front().attention.reserve_thread_scratch();
+        }
+    });
+}
+
+template <typename T>
+MatrixT<T> VisionTransformerT<T>::forward(const MatrixT<T>& patches) {
+    const size_t num_patches = static_cast<size_t>(embedding.get_num_patches());
+    const size_t images = num_patches > 0 ? patches.getRows() / num_patches : 0;
+    MatrixT<T> logits(images, head_weight.getRows());
+    forward(ConstMatrixViewT<T>(patches), logits.view());
+    return logits;
+}
+
+template <typename T>
+void VisionTransformerT<T>::forward(const ConstMatrixViewT<T>& patches, const MatrixViewT<T>& logits) {
+    if (blocks.empty()) {
+        throw std::runtime_error("VisionTransformer weights not loaded");
+    }
+    const size_t num_patches = static_cast<size_t>(embedding.get_num_patches());
+    const size_t seq_len = static_cast<size_t>(embedding.get_seq_len());
+    const size_t dm = static_cast<size_t>(embedding.get_features());
+    if (patches.getRows() == 0 || patches.getRows() % num_patches != 0) {
+        throw std::invalid_argument("VisionTransformer input has " + std::to_string(patches.getRows()) +
+                                    " patches, not a multiple of " + std::to_string(num_patches) + " per image");
+    }
+    const size_t images = patches.getRows() / num_patches;
+    if (images > max_batch) {
+        throw std::invalid_argument("VisionTransformer batch of " + std::to_string(images) +
+                                    " images exceeds the planned max_batch " + std::to_string(max_batch));
+    }
+    if (logits.getRows() != images || logits.getCols() != head_weight.getRows()) {
+        throw std::invalid_argument("VisionTransformer logits must be (images, num_classes)");
+    }
+
+    VIT_PROFILE_SCOPE("Model", "VisionTransformer.forward", 0, 0);
+
+    const size_t tokens = images * seq_len;
+    T* base = arena.data();
+    MatrixViewT<T> x(base + plan[Residual].offset, tokens, dm, dm);
+    MatrixViewT<T> normed(base + plan[Normed].offset, tokens, dm, dm);
+    T* attention_workspace = base + plan[AttentionWorkspace].offset;
+    T* mlp_workspace = base + plan[MlpWorkspace].offset;
+
+    embedding.forward(patches, x);
+    for (EncoderBlock& block : blocks) {
+        block.norm_1.forward(x, normed);
+        block.attention.forward_residual(normed, seq_len, x, attention_workspace);
+        block.norm_2.forward(x, normed);
+        block.mlp.forward_residual(normed, x, mlp_workspace);
+    }
+
+    // Class token of each image (row 0 of its sequence) through the head
+    VIT_PROFILE_SCOPE("Layer", "Classifier.forward", 2.0 * images * dm * head_weight.getRows(),
+                      head_packed.bytes() + sizeof(T) * images * (dm + head_weight.getRows()));
+    MatrixViewT<T> head_input(base + plan[HeadInput].offset, images, dm, dm);
+    head_norm.forward(ConstMatrixViewT<T>(x.data(), images, dm, seq_len * dm), head_input);
+
+    Gemm::Epilogue<T> epilogue;
+    epilogue.bias = head_bias.data();
+    head_quantized.gemm(images, head_input.data(), dm, head_packed, logits.data(), logits.getStride(), epilogue);
+}
+
+template <typename T>
+std::vector<typename QuantizedLinearT<T>::Slot> VisionTransformerT<T>::get_linears() {
+    std::vector<typename QuantizedLinearT<T>::Slot> slots;
+    embedding.collect_linears(slots);
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        blocks[i].attention.collect_linears(static_cast<int>(i), slots);
+        blocks[i].mlp.collect_linears(static_cast<int>(i), slots);
+    }
+    slots.push_back({head_tensor_name(1, "weight"), &head_weight, &head_quantized, &head_packed});
+    return slots;
+}
+
+template <typename T>
+std::vector<typename QuantizedLinearT<T>::ConstSlot> VisionTransformerT<T>::get_linears() const {
+    std::vector<typename QuantizedLinearT<T>::ConstSlot> slots;
+    embedding.collect_linears(slots);
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        blocks[i].attention.collect_linears(static_cast<int>(i), slots);
+        blocks[i].mlp.collect_linears(static_cast<int>(i), slots);
+    }
+    slots.push_back({head_tensor_name(1, "weight"), &head_weight, &head_quantized, &head_packed});
+    return slots;
+}
+
+template <typename T>
+void VisionTransformerT<T>::start_calibration() {
+    for (auto& slot : get_linears()) {
+        slot.linear->start_calibration();
+    }
+}
+
+template <typename T>
+void VisionTransformerT<T>::calibrate(const ConstMatrixViewT<T>& patches) {
+    if (head_quantized.get_state() != QuantizedLinearT<T>::State::Calibrating) {
+        throw std::runtime_error("VisionTransformer::calibrate needs start_calibration() first");
+    }
+    const size_t num_patches = static_cast<size_t>(embedding.get_num_patches());
+    const size_t images = num_patches > 0 ? patches.getRows() / num_patches : 0;
+    MatrixT<T> logits(std::min(images, max_batch), head_weight.getRows());
+    for (size_t first = 0; first < images; first += max_batch) {
+        const size_t count = std::min(max_batch, images - first);
+        forward(patches.block(first * num_patches, 0, count * num_patches, patches.getCols()),
+                logits.block(0, 0, count, logits.getCols()));
+    }
+}
+
+template <typename T>
+void VisionTransformerT<T>::quantize() {
+    for (auto& slot : get_linears()) {
+        slot.linear->quantize(*slot.weight);
+    }
+}
+
+template <typename T>
+void VisionTransformerT<T>::dequantize() {
+    for (auto& slot : get_linears()) {
+        slot.linear->clear();
+    }
+}
+
+template <typename T>
+size_t VisionTransformerT<T>::get_quantized_count() const {
+    size_t count = 0;
+    for (const auto& slot : get_linears()) {
+        count += slot.linear->is_quantized() ? 1 : 0;
+    }
+    return count;
+}
+
+template class VisionTransformerT<float>;
+template class VisionTransformerT<double>;
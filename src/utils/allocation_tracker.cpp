@@ -0,0 +1,190 @@
+//
+// Created by JAYAN on 08/08/2025.
+//
+
+#include "../../include/utils/allocation_tracker.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+namespace AllocationTracker {
+
+namespace detail {
+    std::atomic<bool> enabled{false};
+}
+
+namespace {
+
+struct Counters {
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> frees{0};
+    std::atomic<uint64_t> allocated_bytes{0};
+    std::atomic<int64_t> live_bytes{0};
+    std::atomic<int64_t> peak_bytes{0};
+    std::array<std::atomic<uint64_t>, HISTOGRAM_BUCKETS> histogram{};
+};
+
+Counters& counters() {
+    static Counters instance;
+    return instance;
+}
+
+// High-water marks of the open scopes: bit s of open is set while slot s
+// belongs to a Scope
+struct ScopeSlots {
+    std::atomic<uint64_t> open{0};
+    std::array<std::atomic<int64_t>, MAX_SCOPES> peak{};
+};
+
+ScopeSlots& scope_slots() {
+    static ScopeSlots instance;
+    return instance;
+}
+
+void raise_peak(std::atomic<int64_t>& peak, int64_t value) {
+    int64_t current = peak.load(std::memory_order_relaxed);
+    while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+std::string format_bytes(double bytes) {
+    char text[32];
+    const double magnitude = std::abs(bytes);
+    if (magnitude >= 1024.0 * 1024.0) {
+        std::snprintf(text, sizeof(text), "%.2f MiB", bytes / (1024.0 * 1024.0));
+    } else if (magnitude >= 1024.0) {
+        std::snprintf(text, sizeof(text), "%.1f KiB", bytes / 1024.0);
+    } else {
+        std::snprintf(text, sizeof(text), "%.0f B", bytes);
+    }
+    return text;
+}
+
+} // namespace
+
+void set_enabled(bool on) {
+    detail::enabled.store(on, std::memory_order_relaxed);
+}
+
+void reset() {
+    Counters& c = counters();
+    c.allocations.store(0, std::memory_order_relaxed);
+    c.frees.store(0, std::memory_order_relaxed);
+    c.allocated_bytes.store(0, std::memory_order_relaxed);
+    c.live_bytes.store(0, std::memory_order_relaxed);
+    c.peak_bytes.store(0, std::memory_order_relaxed);
+    for (auto& count : c.histogram) {
+        count.store(0, std::memory_order_relaxed);
+    }
+}
+
+Stats snapshot() {
+    const Counters& c = counters();
+    Stats stats;
+    stats.allocations = c.allocations.load(std::memory_order_relaxed);
+    stats.frees = c.frees.load(std::memory_order_relaxed);
+    stats.allocated_bytes = c.allocated_bytes.load(std::memory_order_relaxed);
+    stats.live_bytes = c.live_bytes.load(std::memory_order_relaxed);
+    stats.peak_bytes = c.peak_bytes.load(std::memory_order_relaxed);
+    for (size_t b = 0; b < HISTOGRAM_BUCKETS; ++b) {
+        stats.histogram[b] = c.histogram[b].load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+size_t bucket(size_t bytes) {
+    size_t b = 0;
+    while (bytes != 0 && b + 1 < HISTOGRAM_BUCKETS) {
+        bytes >>= 1;
+        ++b;
+    }
+    return b;
+}
+
+void record_allocation(size_t bytes) {
+    Counters& c = counters();
+    c.allocations.fetch_add(1, std::memory_order_relaxed);
+    c.allocated_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    c.histogram[bucket(bytes)].fetch_add(1, std::memory_order_relaxed);
+    const int64_t live = c.live_bytes.fetch_add(static_cast<int64_t>(bytes), std::memory_order_relaxed) +
+                         static_cast<int64_t>(bytes);
+    raise_peak(c.peak_bytes, live);
+
+    ScopeSlots& scopes = scope_slots();
+    uint64_t open = scopes.open.load(std::memory_order_acquire);
+    for (size_t s = 0; open != 0; ++s, open >>= 1) {
+        if (open & 1) {
+            raise_peak(scopes.peak[s], live);
+        }
+    }
+}
+
+void record_free(size_t bytes) {
+    Counters& c = counters();
+    c.frees.fetch_add(1, std::memory_order_relaxed);
+    c.live_bytes.fetch_sub(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+}
+
+Scope::Scope() : slot(MAX_SCOPES) {
+    ScopeSlots& scopes = scope_slots();
+    uint64_t open = scopes.open.load(std::memory_order_relaxed);
+    do {
+        if (open == ~uint64_t(0)) {
+            throw std::runtime_error("More than " + std::to_string(MAX_SCOPES) +
+                                     " AllocationTracker scopes open at once");
+        }
+        slot = 0;
+        while (open & (uint64_t(1) << slot)) {
+            ++slot;
+        }
+    } while (!scopes.open.compare_exchange_weak(open, open | (uint64_t(1) << slot), std::memory_order_acq_rel));
+
+    // Start the mark below any level, then at the current one: allocations
+    // after the slot opened may already have raised it
+    scopes.peak[slot].store(INT64_MIN, std::memory_order_relaxed);
+    start = snapshot();
+    raise_peak(scopes.peak[slot], start.live_bytes);
+}
+
+Scope::~Scope() {
+    scope_slots().open.fetch_and(~(uint64_t(1) << slot), std::memory_order_release);
+}
+
+Stats Scope::stats() const {
+    const Stats now = snapshot();
+    Stats delta;
+    delta.allocations = now.allocations - start.allocations;
+    delta.frees = now.frees - start.frees;
+    delta.allocated_bytes = now.allocated_bytes - start.allocated_bytes;
+    delta.live_bytes = now.live_bytes - start.live_bytes;
+    const int64_t peak = scope_slots().peak[slot].load(std::memory_order_relaxed);
+    delta.peak_bytes = std::max<int64_t>(0, std::max(peak, now.live_bytes) - start.live_bytes);
+    for (size_t b = 0; b < HISTOGRAM_BUCKETS; ++b) {
+        delta.histogram[b] = now.histogram[b] - start.histogram[b];
+    }
+    return delta;
+}
+
+void check_budget(const Stats& stats, uint64_t max_allocations, uint64_t max_bytes, const std::string& what) {
+    if (stats.allocations > max_allocations || stats.allocated_bytes > max_bytes) {
+        throw std::runtime_error(what + " exceeded its allocation budget: " + std::to_string(stats.allocations) +
+                                 " allocations / " + std::to_string(stats.allocated_bytes) + " bytes (budget " +
+                                 std::to_string(max_allocations) + " / " + std::to_string(max_bytes) + ")");
+    }
+}
+
+void print_stats(const Stats& stats, std::ostream& os) {
+    os << "allocations " << stats.allocations << ", frees " << stats.frees << ", allocated "
+       << format_bytes(double(stats.allocated_bytes)) << ", live " << format_bytes(double(stats.live_bytes))
+       << ", peak " << format_bytes(double(stats.peak_bytes)) << "\n";
+    for (size_t b = 1; b < HISTOGRAM_BUCKETS; ++b) {
+        if (stats.histogram[b] != 0) {
+            os << "  [" << format_bytes(double(uint64_t(1) << (b - 1))) << ", "
+               << format_bytes(double(uint64_t(1) << b)) << "): " << stats.histogram[b] << "\n";
+        }
+    }
+}
+
+}
@@ -0,0 +1,61 @@
+//
+// Created by JAYAN on 24/07/2025.
+//
+
+#include "../../include/utils/cpu_features.h"
+#include <cstdlib>
+#include <string>
+
+namespace CpuFeatures {
+
+    IsaLevel supported_isa() {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) return IsaLevel::Avx512;
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return IsaLevel::Avx2;
+#endif
+        return IsaLevel::Scalar;
+    }
+
+    IsaLevel select_isa(const char* env_var) {
+        const IsaLevel supported = supported_isa();
+        if (const char* forced = std::getenv(env_var)) {
+            const std::string name(forced);
+            if (name == "scalar") return IsaLevel::Scalar;
+            if (name == "avx2" && supported >= IsaLevel::Avx2) return IsaLevel::Avx2;
+            if (name == "avx512" && supported >= IsaLevel::Avx512) return IsaLevel::Avx512;
+        }
+        return supported;
+    }
+
+    IsaLevel active_isa() {
+        static const IsaLevel level = select_isa("VIT_ISA");
+        return level;
+    }
+
+    bool supports_avx512_vnni() {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx512vnni") && __builtin_cpu_supports("avx512bw");
+#else
+        return false;
+#endif
+    }
+
+    bool supports_f16c() {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("f16c");
+#else
+        return false;
+#endif
+    }
+
+    const char* isa_name(IsaLevel level) {
+        switch (level) {
+            case IsaLevel::Avx512: return "avx512";
+            case IsaLevel::Avx2: return "avx2";
+            default: return "scalar";
+        }
+    }
+}
@@ -0,0 +1,355 @@
+//
+// Created by JAYAN on 23/07/2025.
+//
+
+#include "../../include/utils/dataset.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+constexpr uint32_t IDX_IMAGES_MAGIC = 0x00000803;  // unsigned byte, 3 dimensions
+constexpr uint32_t IDX_LABELS_MAGIC = 0x00000801;  // unsigned byte, 1 dimension
+
+uint32_t read_big_endian(std::ifstream& file, const std::string& path) {
+    unsigned char bytes[4];
+    if (!file.read(reinterpret_cast<char*>(bytes), 4)) {
+        throw std::runtime_error("Truncated IDX header in " + path);
+    }
+    return (uint32_t(bytes[0]) << 24) | (uint32_t(bytes[1]) << 16) | (uint32_t(bytes[2]) << 8) | uint32_t(bytes[3]);
+}
+
+class IdxSource {
+private:
+    std::ifstream images;
+    std::ifstream labels;
+    std::string images_path;
+    std::string labels_path;
+    size_t count;
+    size_t rows;
+    size_t cols;
+    size_t position;
+    std::vector<unsigned char> raw;     // One read's worth of pixel bytes, reused
+
+public:
+    IdxSource(const std::string& images_path, const std::string& labels_path)
+        : images(images_path, std::ios::binary), images_path(images_path), labels_path(labels_path), position(0) {
+        if (!images.is_open()) {
+            throw std::runtime_error("Cannot open IDX image file: " + images_path);
+        }
+        if (read_big_endian(images, images_path) != IDX_IMAGES_MAGIC) {
+            throw std::runtime_error("Not an IDX image file (bad magic): " + images_path);
+        }
+        count = read_big_endian(images, images_path);
+        rows = read_big_endian(images, images_path);
+        cols = read_big_endian(images, images_path);
+
+        if (!labels_path.empty()) {
+            labels.open(labels_path, std::ios::binary);
+            if (!labels.is_open()) {
+                throw std::runtime_error("Cannot open IDX label file: " + labels_path);
+            }
+            if (read_big_endian(labels, labels_path) != IDX_LABELS_MAGIC) {
+                throw std::runtime_error("Not an IDX label file (bad magic): " + labels_path);
+            }
+            if (read_big_endian(labels, labels_path) != count) {
+                throw std::runtime_error("IDX label count does not match " + images_path);
+            }
+        }
+    }
+
+    size_t image_rows() const { return rows; }
+    size_t image_cols() const { return cols; }
+
+    size_t read(size_t max_images, std::vector<float>& pixels, int* out_labels) {
+        size_t n = std::min(max_images, count - position);
+        if (n == 0) {
+            return 0;
+        }
+
+        size_t bytes = n * rows * cols;
+        raw.resize(std::max(raw.size(), bytes));
+        if (!images.read(reinterpret_cast<char*>(raw.data()), static_cast<std::streamsize>(bytes))) {
+            throw std::runtime_error("Truncated IDX image data in " + images_path);
+        }
+        pixels.resize(std::max(pixels.size(), bytes));
+        std::copy(raw.begin(), raw.begin() + bytes, pixels.begin());
+
+        if (labels.is_open()) {
+            if (!labels.read(reinterpret_cast<char*>(raw.data()), static_cast<std::streamsize>(n))) {
+                throw std::runtime_error("Truncated IDX label data in " + labels_path);
+            }
+            for (size_t i = 0; i < n; ++i) {
+                out_labels[i] = raw[i];
+            }
+        } else {
+            std::fill(out_labels, out_labels + n, -1);
+        }
+
+        position += n;
+        return n;
+    }
+};
+
+class CsvSource {
+private:
+    std::ifstream file;
+    std::string path;
+    std::string line;                   // Reused line buffer
+    size_t rows;
+    size_t cols;
+    bool has_label;
+    size_t line_number;
+
+public:
+    CsvSource(const std::string& path, const DatasetOptions& options)
+        : file(path), path(path), rows(options.image_rows), cols(options.image_cols),
+          has_label(options.has_label), line_number(0) {
+        if (!file.is_open()) {
+            throw std::runtime_error("File not found: " + path);
+        }
+        if (options.has_header && std::getline(file, line)) {
+            line_number++;
+        }
+    }
+
+    size_t image_rows() const { return rows; }
+    size_t image_cols() const { return cols; }
+
+    size_t read(size_t max_images, std::vector<float>& pixels, int* out_labels) {
+        const size_t image_size = rows * cols;
+        const size_t expected = image_size + (has_label ? 1 : 0);
+        pixels.resize(std::max(pixels.size(), max_images * image_size));
+
+        size_t n = 0;
+        while (n < max_images && std::getline(file, line)) {
+            line_number++;
+            if (line.find_first_not_of(" \t\r") == std::string::npos) {
+                continue;
+            }
+
+            float* out = pixels.data() + n * image_size;
+            const char* p = line.data();
+            const char* end = p + line.size();
+            size_t field = 0;
+            while (p <= end) {
+                const char* field_end = std::find(p, end, ',');
+                const char* first = p;
+                const char* last = field_end;
+                while (first < last && (*first == ' ' || *first == '\t')) ++first;
+                while (last > first && (last[-1] == ' ' || last[-1] == '\t' || last[-1] == '\r')) --last;
+                p = field_end + 1;
+
+                if (field < expected) {
+                    double value;
+                    std::from_chars_result parsed = std::from_chars(first, last, value);
+                    if (first == last || parsed.ec != std::errc() || parsed.ptr != last) {
+                        throw std::runtime_error("Invalid number format '" + std::string(first, last) +
+                                                 "' at line " + std::to_string(line_number) + " of " + path);
+                    }
+                    if (has_label && field == 0) {
+                        out_labels[n] = static_cast<int>(value);
+                    } else {
+                        *out++ = static_cast<float>(value);
+                    }
+                }
+                ++field;
+            }
+            if (field != expected) {
+                throw std::runtime_error("Expected " + std::to_string(expected) + " values at line " +
+                                         std::to_string(line_number) + " of " + path + ", got " +
+                                         std::to_string(field));
+            }
+            if (!has_label) {
+                out_labels[n] = -1;
+            }
+            ++n;
+        }
+        return n;
+    }
+};
+
+// Adapts the concrete sources to the reader's Source interface
+template <typename T, typename Impl>
+class SourceAdapter : public DatasetReaderT<T>::Source {
+private:
+    Impl impl;
+
+public:
+    template <typename... Args>
+    explicit SourceAdapter(Args&&... args) : impl(std::forward<Args>(args)...) {}
+
+    size_t image_rows() const override { return impl.image_rows(); }
+    size_t image_cols() const override { return impl.image_cols(); }
+    size_t read(size_t max_images, std::vector<float>& pixels, int* labels) override {
+        return impl.read(max_images, pixels, labels);
+    }
+};
+
+} // namespace
+
+template <typename T>
+std::unique_ptr<DatasetReaderT<T>> DatasetReaderT<T>::open_idx(const std::string& images_path,
+                                                               const std::string& labels_path,
+                                                               const DatasetOptions& options) {
+    return std::make_unique<DatasetReaderT>(
+        std::make_unique<SourceAdapter<T, IdxSource>>(images_path, labels_path), options);
+}
+
+template <typename T>
+std::unique_ptr<DatasetReaderT<T>> DatasetReaderT<T>::open_csv(const std::string& path,
+                                                               const DatasetOptions& options) {
+    return std::make_unique<DatasetReaderT>(std::make_unique<SourceAdapter<T, CsvSource>>(path, options), options);
+}
+
+template <typename T>
+DatasetReaderT<T>::DatasetReaderT(std::unique_ptr<Source> source, const DatasetOptions& options)
+    : source(std::move(source)), options(options), delivered(0), finished(false), stopping(false) {
+    if (options.batch_size == 0) {
+        throw std::invalid_argument("DatasetReader batch_size must be positive");
+    }
+    if (options.stddev == 0.0) {
+        throw std::invalid_argument("DatasetReader stddev must be non-zero");
+    }
+
+    size_t rows = this->source->image_rows();
+    size_t cols = this->source->image_cols();
+    if (options.patch_size == 0) {
+        patch_rows = rows;
+        patch_cols = cols;
+    } else {
+        if (rows % options.patch_size != 0 || cols % options.patch_size != 0) {
+            throw std::invalid_argument("Image size " + std::to_string(rows) + "x" + std::to_string(cols) +
+                                        " is not divisible by patch size " + std::to_string(options.patch_size));
+        }
+        patch_rows = options.patch_size;
+        patch_cols = options.patch_size;
+    }
+    grid_rows = rows / patch_rows;
+    grid_cols = cols / patch_cols;
+
+    this->options.prefetch = std::max<size_t>(1, options.prefetch);
+    producer = std::thread(&DatasetReaderT::produce, this);
+}
+
+template <typename T>
+DatasetReaderT<T>::~DatasetReaderT() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    space_cv.notify_all();
+    producer.join();
+}
+
+template <typename T>
+bool DatasetReaderT<T>::next(ImageBatchT<T>& batch) {
+    std::unique_lock<std::mutex> lock(mutex);
+    ready_cv.wait(lock, [this] { return !ready.empty() || finished; });
+
+    if (ready.empty()) {
+        if (error) {
+            std::exception_ptr pending = error;
+            error = nullptr;
+            std::rethrow_exception(pending);
+        }
+        return false;
+    }
+
+    // Hand the caller's previous buffers back to the producer
+    std::swap(batch, ready.front());
+    spare.push_back(std::move(ready.front()));
+    ready.pop_front();
+    delivered += batch.count;
+    lock.unlock();
+    space_cv.notify_one();
+    return true;
+}
+
+template <typename T>
+void DatasetReaderT<T>::produce() {
+    std::vector<float> pixels;          // Raw pixels for one batch, reused
+    size_t produced = 0;
+
+    try {
+        while (true) {
+            ImageBatchT<T> batch;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                space_cv.wait(lock, [this] { return stopping || ready.size() < options.prefetch; });
+                if (stopping) {
+                    return;
+                }
+                if (!spare.empty()) {
+                    batch = std::move(spare.back());
+                    spare.pop_back();
+                }
+            }
+
+            size_t want = options.batch_size;
+            if (options.limit != 0) {
+                want = std::min(want, options.limit - produced);
+            }
+            batch.labels.resize(options.batch_size);
+            size_t count = want == 0 ? 0 : source->read(want, pixels, batch.labels.data());
+            if (count == 0) {
+                break;
+            }
+
+            batch.labels.resize(count);
+            batch.count = count;
+            batch.first_index = produced;
+            assemble(pixels, count, batch);
+            produced += count;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ready.push_back(std::move(batch));
+            }
+            ready_cv.notify_one();
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        error = std::current_exception();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = true;
+    }
+    ready_cv.notify_all();
+}
+
+template <typename T>
+void DatasetReaderT<T>::assemble(const std::vector<float>& pixels, size_t count, ImageBatchT<T>& batch) const {
+    const size_t image_cols = grid_cols * patch_cols;
+    const size_t image_size = grid_rows * patch_rows * image_cols;
+    const size_t per_image = patches_per_image();
+    const T scale = static_cast<T>(options.pixel_scale / options.stddev);
+    const T shift = static_cast<T>(-options.mean / options.stddev);
+
+    // resize() reuses the recycled buffer when it is large enough
+    batch.patches.resize(count * per_image, patch_dim());
+
+    for (size_t image = 0; image < count; ++image) {
+        const float* in = pixels.data() + image * image_size;
+        for (size_t gr = 0; gr < grid_rows; ++gr) {
+            for (size_t gc = 0; gc < grid_cols; ++gc) {
+                T* out = batch.patches.row_ptr(image * per_image + gr * grid_cols + gc);
+                for (size_t r = 0; r < patch_rows; ++r) {
+                    const float* src = in + (gr * patch_rows + r) * image_cols + gc * patch_cols;
+                    for (size_t c = 0; c < patch_cols; ++c) {
+                        *out++ = static_cast<T>(src[c]) * scale + shift;
+                    }
+                }
+            }
+        }
+    }
+}
+
+template class DatasetReaderT<float>;
+template class DatasetReaderT<double>;
@@ -1,200 +1,345 @@
-//
-// Created by JAYAN on 01/07/2025.
-//
-
-#include "../../include/utils/file_io.h"
-#include <fstream>
-#include <sstream>
-#include <stdexcept>
-#include <iostream>
-
-namespace FileIO {
-
-    std::vector<std::string> split_string(const std::string& str, char delimiter) {
-        std::vector<std::string> tokens;
-        std::stringstream ss(str);
-        std::string token;
-        
-        while (std::getline(ss, token, delimiter)) {
-            // Remove leading/trailing whitespace
-            size_t start = token.find_first_not_of(" \t\r\n");
-            size_t end = token.find_last_not_of(" \t\r\n");
-            
-            if (start != std::string::npos) {
-                token = token.substr(start, end - start + 1);
-                tokens.push_back(token);
-            }
-        }
-        
-        return tokens;
-    }
-
-    bool file_exists(const std::string& filename) {
-        std::ifstream file(filename);
-        return file.good();
-    }
-
-    Matrix load_matrix_from_csv(const std::string& filename, bool has_header) {
-        if (!file_exists(filename)) {
-            throw std::runtime_error("File not found: " + filename);
-        }
-
-        std::ifstream file(filename);
-        if (!file.is_open()) {
-            throw std::runtime_error("Cannot open file: " + filename);
-        }
-
-        std::vector<std::vector<double>> data;
-        std::string line;
-        size_t expected_cols = 0;
-        size_t line_number = 0;
-
-        // Skip header if present
-        if (has_header && std::getline(file, line)) {
-            line_number++;
-        }
-
-        while (std::getline(file, line)) {
-            line_number++;
-            
-            // Skip empty lines
-            if (line.empty() || line.find_first_not_of(" \t\r\n") == std::string::npos) {
-                continue;
-            }
-
-            std::vector<std::string> tokens = split_string(line, ',');
-            
-            if (tokens.empty()) {
-                continue;
-            }
-
-            // Set expected columns from first data row
-            if (data.empty()) {
-                expected_cols = tokens.size();
-            } else if (tokens.size() != expected_cols) {
-                throw std::runtime_error("Inconsistent number of columns at line " + 
-                                       std::to_string(line_number) + ". Expected " + 
-                                       std::to_string(expected_cols) + ", got " + 
-                                       std::to_string(tokens.size()));
-            }
-
-            std::vector<double> row;
-            row.reserve(tokens.size());
-
-            for (const std::string& token : tokens) {
-                try {
-                    double value = std::stod(token);
-                    row.push_back(value);
-                } catch (const std::exception& e) {
-                    throw std::runtime_error("Invalid number format '" + token + 
-                                           "' at line " + std::to_string(line_number));
-                }
-            }
-
-            data.push_back(row);
-        }
-
-        file.close();
-
-        if (data.empty()) {
-            throw std::runtime_error("No data found in file: " + filename);
-        }
-
-        // Create Matrix from data
-        size_t rows = data.size();
-        size_t cols = data[0].size();
-        Matrix result(rows, cols);
-
-        for (size_t i = 0; i < rows; ++i) {
-            for (size_t j = 0; j < cols; ++j) {
-                result(i, j) = data[i][j];
-            }
-        }
-
-        return result;
-    }
-
-    std::vector<double> load_vector_from_csv(const std::string& filename, bool has_header) {
-        if (!file_exists(filename)) {
-            throw std::runtime_error("File not found: " + filename);
-        }
-
-        std::ifstream file(filename);
-        if (!file.is_open()) {
-            throw std::runtime_error("Cannot open file: " + filename);
-        }
-
-        std::vector<double> data;
-        std::string line;
-        size_t line_number = 0;
-
-        // Skip header if present
-        if (has_header && std::getline(file, line)) {
-            line_number++;
-        }
-
-        while (std::getline(file, line)) {
-            line_number++;
-            
-            // Skip empty lines
-            if (line.empty() || line.find_first_not_of(" \t\r\n") == std::string::npos) {
-                continue;
-            }
-
-            std::vector<std::string> tokens = split_string(line, ',');
-            
-            // If multiple columns, take only the first one
-            if (!tokens.empty()) {
-                try {
-                    double value = std::stod(tokens[0]);
-                    data.push_back(value);
-                } catch (const std::exception& e) {
-                    throw std::runtime_error("Invalid number format '" + tokens[0] + 
-                                           "' at line " + std::to_string(line_number));
-                }
-            }
-        }
-
-        file.close();
-
-        if (data.empty()) {
-            throw std::runtime_error("No data found in file: " + filename);
-        }
-
-        return data;
-    }
-
-    void save_matrix_to_csv(const Matrix& matrix, const std::string& filename) {
-        std::ofstream file(filename);
-        if (!file.is_open()) {
-            throw std::runtime_error("Cannot create file: " + filename);
-        }
-
-        for (size_t i = 0; i < matrix.getRows(); ++i) {
-            for (size_t j = 0; j < matrix.getCols(); ++j) {
-                file << matrix(i, j);
-                if (j < matrix.getCols() - 1) {
-                    file << ",";
-                }
-            }
-            file << "\n";
-        }
-
-        file.close();
-    }
-
-    Matrix load_vector_as_matrix(const std::string& filename, bool has_header) {
-        // Load as regular vector first
-        std::vector<double> vector_data = load_vector_from_csv(filename, has_header);
-        
-        // Create a 1xN matrix (row vector)
-        Matrix result(1, vector_data.size());
-        
-        for (size_t i = 0; i < vector_data.size(); ++i) {
-            result(0, i) = vector_data[i];
-        }
-        
-        return result;
-    }
-
+//
+// Created by JAYAN on 01/07/2025.
+//
+
+#include "../../include/utils/file_io.h"
+#include "../../include/utils/thread_pool.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <iostream>
+
+namespace {
+
+// CSV parsing works on the whole file held in memory: lines are located with
+// memchr and numbers parsed in place with std::from_chars (locale-independent,
+// no per-value allocation), writing directly into the result matrix.
+
+constexpr size_t CHUNK_BYTES = 1 << 16;    // Minimum bytes per parse chunk
+
+bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+const char* line_end(const char* p, const char* end) {
+    const void* newline = std::memchr(p, '\n', static_cast<size_t>(end - p));
+    return newline != nullptr ? static_cast<const char*>(newline) : end;
+}
+
+const char* next_line(const char* p, const char* end) {
+    const char* eol = line_end(p, end);
+    return eol == end ? end : eol + 1;
+}
+
+// A line with no non-empty field (whitespace and commas only) carries no
+// data and is skipped, as the split_string-based parser did
+bool is_blank(const char* p, const char* eol) {
+    for (; p != eol; ++p) {
+        if (!is_space(*p) && *p != ',') {
+            return false;
+        }
+    }
+    return true;
+}
+
+// First non-blank line at or after p
+const char* skip_blank_lines(const char* p, const char* end) {
+    while (p != end && is_blank(p, line_end(p, end))) {
+        p = next_line(p, end);
+    }
+    return p;
+}
+
+struct ParseResult {
+    size_t fields;                  // Non-empty fields on the line
+    const char* bad_begin;          // Offending field text, nullptr if the line parsed
+    const char* bad_end;
+};
+
+// Parse the comma-separated fields of [p, eol) and store the first
+// max_fields of them in out. Surrounding whitespace and empty fields are
+// skipped, as split_string does.
+template <typename T>
+ParseResult parse_line(const char* p, const char* eol, T* out, size_t max_fields) {
+    ParseResult result = {0, nullptr, nullptr};
+    while (p < eol) {
+        const char* field_end = static_cast<const char*>(std::memchr(p, ',', static_cast<size_t>(eol - p)));
+        if (field_end == nullptr) {
+            field_end = eol;
+        }
+
+        const char* first = p;
+        const char* last = field_end;
+        while (first < last && is_space(*first)) ++first;
+        while (last > first && is_space(last[-1])) --last;
+        p = field_end + 1;
+
+        if (first == last) {
+            continue;
+        }
+        if (result.fields < max_fields) {
+            // from_chars rejects a leading '+', which stod accepted
+            const char* digits = (*first == '+' && last - first > 1) ? first + 1 : first;
+            double value;
+            std::from_chars_result parsed = std::from_chars(digits, last, value);
+            if (parsed.ec != std::errc() || parsed.ptr != last) {
+                result.bad_begin = first;
+                result.bad_end = last;
+                return result;
+            }
+            out[result.fields] = static_cast<T>(value);
+        }
+        ++result.fields;
+    }
+    return result;
+}
+
+struct Chunk {
+    const char* begin;              // Always the start of a line
+    const char* end;
+    size_t first_line;              // 1-based line number of begin
+    size_t first_row;               // Output row of the first data line
+    size_t lines;                   // Lines in the chunk, blank ones included
+    size_t data_rows;               // Lines with at least one field
+};
+
+std::vector<Chunk> split_chunks(const char* begin, const char* end, size_t first_line) {
+    size_t bytes = static_cast<size_t>(end - begin);
+    size_t target = std::max(CHUNK_BYTES, bytes / (4 * ThreadPool::instance().num_threads()) + 1);
+
+    std::vector<Chunk> chunks;
+    const char* p = begin;
+    while (p != end) {
+        const char* split = static_cast<size_t>(end - p) > target ? next_line(p + target, end) : end;
+        chunks.push_back({p, split, first_line, 0, 0, 0});
+        p = split;
+    }
+    return chunks;
+}
+
+void count_lines(Chunk& chunk) {
+    for (const char* p = chunk.begin; p != chunk.end; p = next_line(p, chunk.end)) {
+        ++chunk.lines;
+        if (!is_blank(p, line_end(p, chunk.end))) {
+            ++chunk.data_rows;
+        }
+    }
+}
+
+// Returns an error message, or an empty string when the chunk parsed cleanly
+template <typename T>
+std::string parse_chunk(const Chunk& chunk, T* data, size_t cols) {
+    size_t line_number = chunk.first_line;
+    T* out = data + chunk.first_row * cols;
+    for (const char* p = chunk.begin; p != chunk.end; p = next_line(p, chunk.end), ++line_number) {
+        const char* eol = line_end(p, chunk.end);
+        if (is_blank(p, eol)) {
+            continue;
+        }
+
+        ParseResult parsed = parse_line(p, eol, out, cols);
+        if (parsed.bad_begin != nullptr) {
+            return "Invalid number format '" + std::string(parsed.bad_begin, parsed.bad_end) +
+                   "' at line " + std::to_string(line_number);
+        }
+        if (parsed.fields != cols) {
+            return "Inconsistent number of columns at line " + std::to_string(line_number) +
+                   ". Expected " + std::to_string(cols) + ", got " + std::to_string(parsed.fields);
+        }
+        out += cols;
+    }
+    return std::string();
+}
+
+std::string read_file(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        throw std::runtime_error("File not found: " + filename);
+    }
+
+    std::string text(static_cast<size_t>(file.tellg()), '\0');
+    file.seekg(0);
+    if (!file.read(&text[0], static_cast<std::streamsize>(text.size()))) {
+        throw std::runtime_error("Cannot read file: " + filename);
+    }
+    return text;
+}
+
+} // namespace
+
+namespace FileIO {
+
+    std::vector<std::string> split_string(const std::string& str, char delimiter) {
+        std::vector<std::string> tokens;
+        std::stringstream ss(str);
+        std::string token;
+        
+        while (std::getline(ss, token, delimiter)) {
+            // Remove leading/trailing whitespace
+            size_t start = token.find_first_not_of(" \t\r\n");
+            size_t end = token.find_last_not_of(" \t\r\n");
+            
+            if (start != std::string::npos) {
+                token = token.substr(start, end - start + 1);
+                tokens.push_back(token);
+            }
+        }
+        
+        return tokens;
+    }
+
+    bool file_exists(const std::string& filename) {
+        std::ifstream file(filename);
+        return file.good();
+    }
+
+    template <typename T>
+    MatrixT<T> load_matrix_from_csv(const std::string& filename, bool has_header) {
+        std::string text = read_file(filename);
+        const char* begin = text.data();
+        const char* end = begin + text.size();
+        size_t first_line = 1;
+
+        // Skip header if present
+        if (has_header) {
+            begin = next_line(begin, end);
+            first_line = 2;
+        }
+
+        // Line-aligned chunks, each parsed by one thread. Small files stay a
+        // single chunk and are parsed inline.
+        std::vector<Chunk> chunks = split_chunks(begin, end, first_line);
+        ThreadPool& pool = ThreadPool::instance();
+
+        // Pass 1: count lines and data rows per chunk, then turn the counts
+        // into each chunk's first line number and first output row
+        pool.parallel_for(0, chunks.size(), 1, [&](size_t c0, size_t c1) {
+            for (size_t c = c0; c < c1; ++c) {
+                count_lines(chunks[c]);
+            }
+        });
+        size_t rows = 0;
+        for (size_t c = 0; c < chunks.size(); ++c) {
+            chunks[c].first_row = rows;
+            rows += chunks[c].data_rows;
+            if (c + 1 < chunks.size()) {
+                chunks[c + 1].first_line = chunks[c].first_line + chunks[c].lines;
+            }
+        }
+        if (rows == 0) {
+            throw std::runtime_error("No data found in file: " + filename);
+        }
+
+        // Expected columns come from the first data row
+        size_t cols = 0;
+        for (const Chunk& chunk : chunks) {
+            if (chunk.data_rows > 0) {
+                const char* line = skip_blank_lines(chunk.begin, chunk.end);
+                cols = parse_line<T>(line, line_end(line, chunk.end), nullptr, 0).fields;
+                break;
+            }
+        }
+
+        // Pass 2: parse straight into the result rows. Errors are kept per
+        // chunk so the earliest offending line is the one reported.
+        MatrixT<T> result(rows, cols);
+        std::vector<std::string> errors(chunks.size());
+        pool.parallel_for(0, chunks.size(), 1, [&](size_t c0, size_t c1) {
+            for (size_t c = c0; c < c1; ++c) {
+                errors[c] = parse_chunk(chunks[c], result.data(), cols);
+            }
+        });
+        for (const std::string& error : errors) {
+            if (!error.empty()) {
+                throw std::runtime_error(error);
+            }
+        }
+
+        return result;
+    }
+
+    std::vector<double> load_vector_from_csv(const std::string& filename, bool has_header) {
+        std::string text = read_file(filename);
+        const char* p = text.data();
+        const char* end = p + text.size();
+        size_t line_number = 1;
+
+        // Skip header if present
+        if (has_header && p != end) {
+            p = next_line(p, end);
+            line_number++;
+        }
+
+        std::vector<double> data;
+        for (; p != end; p = next_line(p, end), ++line_number) {
+            const char* eol = line_end(p, end);
+
+            // If multiple columns, take only the first one
+            double value;
+            ParseResult parsed = parse_line<double>(p, eol, &value, 1);
+            if (parsed.bad_begin != nullptr) {
+                throw std::runtime_error("Invalid number format '" + std::string(parsed.bad_begin, parsed.bad_end) +
+                                         "' at line " + std::to_string(line_number));
+            }
+            if (parsed.fields > 0) {
+                data.push_back(value);
+            }
+        }
+
+        if (data.empty()) {
+            throw std::runtime_error("No data found in file: " + filename);
+        }
+
+        return data;
+    }
+
+    template <typename T>
+    void save_matrix_to_csv(const MatrixT<T>& matrix, const std::string& filename) {
+        std::ofstream file(filename);
+        if (!file.is_open()) {
+            throw std::runtime_error("Cannot create file: " + filename);
+        }
+
+        for (size_t i = 0; i < matrix.getRows(); ++i) {
+            const T* row = matrix.row_ptr(i);
+            for (size_t j = 0; j < matrix.getCols(); ++j) {
+                file << row[j];
+                if (j < matrix.getCols() - 1) {
+                    file << ",";
+                }
+            }
+            file << "\n";
+        }
+
+        file.close();
+    }
+
+    template <typename T>
+    MatrixT<T> load_vector_as_matrix(const std::string& filename, bool has_header) {
+        // Load as regular vector first
+        std::vector<double> vector_data = load_vector_from_csv(filename, has_header);
+        
+        // Create a 1xN matrix (row vector)
+        MatrixT<T> result(1, vector_data.size());
+        
+        for (size_t i = 0; i < vector_data.size(); ++i) {
+            result(0, i) = static_cast<T>(vector_data[i]);
+        }
+        
+        return result;
+    }
+
+#define FILE_IO_INSTANTIATE(T)                                                              \
+    template MatrixT<T> load_matrix_from_csv<T>(const std::string&, bool);                 \
+    template MatrixT<T> load_vector_as_matrix<T>(const std::string&, bool);                \
+    template void save_matrix_to_csv<T>(const MatrixT<T>&, const std::string&);
+
+    FILE_IO_INSTANTIATE(float)
+    FILE_IO_INSTANTIATE(double)
+
+#undef FILE_IO_INSTANTIATE
+
 }
\ No newline at end of file
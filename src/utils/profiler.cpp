@@ -0,0 +1,224 @@
+//
+// Created by JAYAN on 07/08/2025.
+//
+
+#include "../../include/utils/profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+namespace Profiler {
+
+namespace detail {
+    std::atomic<bool> enabled{false};
+}
+
+namespace {
+
+struct Event {
+    const char* category;
+    const char* name;
+    uint64_t start_ns;
+    uint64_t duration_ns;
+    uint64_t self_ns;
+    double flops;
+    double bytes;
+    uint64_t allocations;
+    uint64_t allocated_bytes;
+};
+
+struct ThreadBuffer {
+    uint32_t tid;
+    std::vector<Event> events;
+    uint64_t allocations = 0;       // Running totals for this thread
+    uint64_t allocated_bytes = 0;
+};
+
+// Buffers outlive their threads (the pool may be restarted), so the registry
+// owns them and each thread keeps a raw pointer to its own
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+thread_local ThreadBuffer* local_buffer = nullptr;
+thread_local Scope* current_scope = nullptr;
+
+ThreadBuffer& thread_buffer() {
+    if (local_buffer == nullptr) {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        auto buffer = std::make_unique<ThreadBuffer>();
+        buffer->tid = static_cast<uint32_t>(reg.buffers.size());
+        buffer->events.reserve(4096);
+        local_buffer = buffer.get();
+        reg.buffers.push_back(std::move(buffer));
+    }
+    return *local_buffer;
+}
+
+uint64_t now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - registry().epoch).count());
+}
+
+// Category and name may contain anything a literal can
+std::string json_escape(const char* text) {
+    std::string escaped;
+    for (const char* c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            escaped += '\\';
+        }
+        escaped += *c;
+    }
+    return escaped;
+}
+
+} // namespace
+
+void set_enabled(bool on) {
+    detail::enabled.store(on, std::memory_order_relaxed);
+}
+
+void reset() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (auto& buffer : reg.buffers) {
+        buffer->events.clear();
+    }
+    reg.epoch = std::chrono::steady_clock::now();
+}
+
+void note_allocation(size_t bytes) {
+    ThreadBuffer& buffer = thread_buffer();
+    ++buffer.allocations;
+    buffer.allocated_bytes += bytes;
+}
+
+void Scope::begin(const char* scope_category, const char* scope_name, double scope_flops, double scope_bytes) {
+    ThreadBuffer& buffer = thread_buffer();
+    category = scope_category;
+    name = scope_name;
+    flops = scope_flops;
+    bytes = scope_bytes;
+    child_ns = 0;
+    allocations_start = buffer.allocations;
+    allocated_bytes_start = buffer.allocated_bytes;
+    parent = current_scope;
+    current_scope = this;
+    start_ns = now_ns();
+}
+
+void Scope::end() {
+    const uint64_t end_ns = now_ns();
+    const uint64_t duration = end_ns - start_ns;
+    ThreadBuffer& buffer = thread_buffer();
+    buffer.events.push_back({category, name, start_ns, duration, duration - std::min(child_ns, duration), flops, bytes,
+                             buffer.allocations - allocations_start,
+                             buffer.allocated_bytes - allocated_bytes_start});
+    current_scope = parent;
+    if (parent != nullptr) {
+        parent->child_ns += duration;
+    }
+}
+
+std::vector<Summary> summary() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    std::map<std::pair<std::string, std::string>, Summary> rows;
+    for (const auto& buffer : reg.buffers) {
+        for (const Event& event : buffer->events) {
+            Summary& row = rows[{event.category, event.name}];
+            if (row.calls == 0) {
+                row.category = event.category;
+                row.name = event.name;
+            }
+            ++row.calls;
+            row.total_ns += event.duration_ns;
+            row.self_ns += event.self_ns;
+            row.flops += event.flops;
+            row.bytes += event.bytes;
+            row.allocations += event.allocations;
+            row.allocated_bytes += event.allocated_bytes;
+        }
+    }
+
+    std::vector<Summary> result;
+    result.reserve(rows.size());
+    for (auto& entry : rows) {
+        result.push_back(std::move(entry.second));
+    }
+    std::sort(result.begin(), result.end(),
+              [](const Summary& a, const Summary& b) { return a.self_ns > b.self_ns; });
+    return result;
+}
+
+void print_summary(std::ostream& os) {
+    const std::vector<Summary> rows = summary();
+    double self_total = 0.0;
+    for (const Summary& row : rows) {
+        self_total += row.self_ns;
+    }
+
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-12s %-28s %8s %11s %11s %7s %9s %8s %9s %12s\n", "category", "scope",
+                  "calls", "total ms", "self ms", "self %", "GFLOP/s", "GB/s", "allocs", "alloc bytes");
+    os << line;
+    for (const Summary& row : rows) {
+        // Throughput over the inclusive time: the work counts cover children
+        std::snprintf(line, sizeof(line), "%-12s %-28s %8zu %11.3f %11.3f %6.1f%% %9.2f %8.2f %9llu %12llu\n",
+                      row.category.c_str(), row.name.c_str(), row.calls, row.total_ns / 1e6, row.self_ns / 1e6,
+                      self_total > 0.0 ? 100.0 * row.self_ns / self_total : 0.0,
+                      row.total_ns > 0.0 ? row.flops / row.total_ns : 0.0,
+                      row.total_ns > 0.0 ? row.bytes / row.total_ns : 0.0,
+                      static_cast<unsigned long long>(row.allocations),
+                      static_cast<unsigned long long>(row.allocated_bytes));
+        os << line;
+    }
+}
+
+void write_chrome_trace(std::ostream& os) {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    os << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+    bool first = true;
+    char numbers[256];
+    for (const auto& buffer : reg.buffers) {
+        for (const Event& event : buffer->events) {
+            // Timestamps and durations are in microseconds
+            std::snprintf(numbers, sizeof(numbers),
+                          "\"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f, "
+                          "\"args\": {\"flops\": %.0f, \"bytes\": %.0f, \"allocations\": %llu, "
+                          "\"allocated_bytes\": %llu}",
+                          buffer->tid, event.start_ns / 1e3, event.duration_ns / 1e3, event.flops, event.bytes,
+                          static_cast<unsigned long long>(event.allocations),
+                          static_cast<unsigned long long>(event.allocated_bytes));
+            os << (first ? "  " : ",\n  ") << "{\"name\": \"" << json_escape(event.name) << "\", \"cat\": \""
+               << json_escape(event.category) << "\", " << numbers << "}";
+            first = false;
+        }
+    }
+    os << "\n]}\n";
+}
+
+void write_chrome_trace(const std::string& filename) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot create file: " + filename);
+    }
+    write_chrome_trace(file);
+}
+
+}
@@ -0,0 +1,319 @@
+//
+// Created by JAYAN on 15/07/2025.
+//
+
+#include "../../include/utils/thread_pool.h"
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <string>
+
+// A calling thread's record for one parallel_for, reused by its later calls
+// at the same nesting depth
+struct ThreadPool::Job {
+    const RangeFunction* body = nullptr;
+    size_t end = 0;
+    size_t grain = 1;
+    size_t total_chunks = 0;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> finished_chunks{0};
+    std::atomic<uint64_t> id{0};        // Current job, 0 while the record is being reset
+    std::atomic<size_t> active{0};      // Workers between checking a token and leaving the job
+    uint64_t last_id = 0;
+    std::mutex error_mutex;
+    std::exception_ptr error;
+};
+
+// The calling thread's records, one per nesting depth; handed back to the
+// pool when the thread exits
+struct ThreadPool::JobStack {
+    std::vector<Job*> records;
+    size_t depth = 0;
+
+    ~JobStack() {
+        for (Job* job : records) {
+            ThreadPool::instance().release_job(job);
+        }
+    }
+};
+
+namespace {
+
+size_t default_thread_count() {
+    if (const char* env = std::getenv("VIT_NUM_THREADS")) {
+        try {
+            long value = std::stol(env);
+            if (value >= 1) {
+                return static_cast<size_t>(value);
+            }
+        } catch (const std::exception&) {
+            // Fall through to the hardware default on malformed values
+        }
+    }
+    unsigned hw = std::thread::hardware_concurrency();
+    return hw == 0 ? 1 : hw;
+}
+
+} // namespace
+
+ThreadPool& ThreadPool::instance() {
+    static ThreadPool pool(default_thread_count());
+    return pool;
+}
+
+void ThreadPool::set_num_threads(size_t n) {
+    ThreadPool& pool = instance();
+    pool.stop();
+    pool.start(std::max<size_t>(n, 1));
+}
+
+ThreadPool::ThreadPool(size_t n) : pinned_remaining(0), pending_tokens(0), next_queue(0), stopping(false) {
+    start(n);
+}
+
+ThreadPool::~ThreadPool() {
+    stop();
+}
+
+void ThreadPool::start(size_t n) {
+    stopping = false;
+    queues.clear();
+    for (size_t i = 0; i + 1 < n; ++i) {
+        queues.push_back(std::make_unique<WorkQueue>());
+    }
+    for (size_t i = 0; i + 1 < n; ++i) {
+        workers.emplace_back(&ThreadPool::worker_loop, this, i);
+    }
+}
+
+void ThreadPool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+    pending_tokens = 0;
+}
+
+void ThreadPool::run_chunks(Job& job) {
+    // Claim chunks until the range is exhausted. Chunks are claimed before the
+    // body pointer is touched, so late tokens for a finished job are harmless.
+    while (true) {
+        size_t start = job.next.fetch_add(job.grain);
+        if (start >= job.end) {
+            return;
+        }
+        size_t stop = std::min(start + job.grain, job.end);
+        try {
+            (*job.body)(start, stop);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(job.error_mutex);
+            if (!job.error) {
+                job.error = std::current_exception();
+            }
+        }
+        job.finished_chunks.fetch_add(1, std::memory_order_release);
+    }
+}
+
+bool ThreadPool::take_token(size_t index, Token& token) {
+    // Own queue first (newest token), then steal the oldest from the others
+    for (size_t attempt = 0; attempt < queues.size(); ++attempt) {
+        WorkQueue& queue = *queues[(index + attempt) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.count == 0) {
+            continue;
+        }
+        if (attempt == 0) {
+            token = queue.tokens[(queue.head + queue.count - 1) % QUEUE_CAPACITY];
+        } else {
+            token = queue.tokens[queue.head];
+            queue.head = (queue.head + 1) % QUEUE_CAPACITY;
+        }
+        --queue.count;
+        pending_tokens.fetch_sub(1);
+        return true;
+    }
+    return false;
+}
+
+ThreadPool::Job* ThreadPool::acquire_job() {
+    std::lock_guard<std::mutex> lock(jobs_mutex);
+    if (!free_jobs.empty()) {
+        Job* job = free_jobs.back();
+        free_jobs.pop_back();
+        return job;
+    }
+    jobs.push_back(std::make_unique<Job>());
+    return jobs.back().get();
+}
+
+void ThreadPool::release_job(Job* job) {
+    std::lock_guard<std::mutex> lock(jobs_mutex);
+    free_jobs.push_back(job);
+}
+
+ThreadPool::JobStack& ThreadPool::job_stack() {
+    thread_local JobStack stack;
+    return stack;
+}
+
+bool ThreadPool::run_pinned(size_t index) {
+    WorkQueue& queue = *queues[index];
+    const RangeFunction* body;
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        body = queue.pinned;
+        queue.pinned = nullptr;
+    }
+    if (body == nullptr) {
+        return false;
+    }
+    pending_tokens.fetch_sub(1);
+    try {
+        (*body)(index, index + 1);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(pinned_mutex);
+        if (!pinned_error) {
+            pinned_error = std::current_exception();
+        }
+    }
+    pinned_remaining.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+void ThreadPool::worker_loop(size_t index) {
+    // A worker's chunks may run parallel_for one level down; its record is
+    // made here rather than in the first such call
+    JobStack& stack = job_stack();
+    if (stack.records.empty()) {
+        stack.records.reserve(4);
+        stack.records.push_back(acquire_job());
+    }
+
+    while (true) {
+        if (run_pinned(index)) {
+            continue;
+        }
+        Token token;
+        if (take_token(index, token)) {
+            // Announce, then check the id: parallel_for clears the id and then
+            // waits for active to drain before it touches the record, so a
+            // worker either sees the job it was queued for or leaves
+            Job& job = *token.job;
+            job.active.fetch_add(1);
+            if (job.id.load() == token.id) {
+                run_chunks(job);
+            }
+            job.active.fetch_sub(1, std::memory_order_release);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        wake.wait(lock, [this] { return stopping || pending_tokens.load() > 0; });
+        if (stopping) {
+            return;
+        }
+    }
+}
+
+void ThreadPool::parallel_for(size_t begin, size_t end, size_t grain, const RangeFunction& body) {
+    if (begin >= end) {
+        return;
+    }
+    grain = std::max<size_t>(grain, 1);
+    const size_t count = end - begin;
+
+    if (workers.empty() || count <= grain) {
+        body(begin, end);
+        return;
+    }
+
+    // This thread's record for the current nesting depth (nested calls run
+    // inside run_chunks below, one level deeper)
+    JobStack& stack = job_stack();
+    if (stack.depth == stack.records.size()) {
+        stack.records.push_back(acquire_job());
+    }
+    Job& job = *stack.records[stack.depth];
+
+    // Retire the record's previous job: tokens still queued for it stop
+    // matching, and workers that already matched leave before it is reset
+    job.id.store(0);
+    while (job.active.load() != 0) {
+        std::this_thread::yield();
+    }
+    job.body = &body;
+    job.end = end;
+    job.grain = grain;
+    job.total_chunks = (count + grain - 1) / grain;
+    job.next.store(begin, std::memory_order_relaxed);
+    job.finished_chunks.store(0, std::memory_order_relaxed);
+    job.error = nullptr;
+    const uint64_t id = ++job.last_id;
+    job.id.store(id);
+
+    // One token per helper that can get a chunk; the caller takes one share
+    // itself, and any share whose queue is full
+    const size_t helpers = std::min(workers.size(), job.total_chunks - 1);
+    for (size_t i = 0; i < helpers; ++i) {
+        WorkQueue& queue = *queues[next_queue.fetch_add(1) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.count == QUEUE_CAPACITY) {
+            continue;
+        }
+        queue.tokens[(queue.head + queue.count) % QUEUE_CAPACITY] = {&job, id};
+        ++queue.count;
+        pending_tokens.fetch_add(1);
+    }
+    {
+        // Taking the lock orders the token push before any sleeper re-checks
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+    }
+    wake.notify_all();
+
+    ++stack.depth;
+    run_chunks(job);
+    while (job.finished_chunks.load(std::memory_order_acquire) < job.total_chunks) {
+        std::this_thread::yield();
+    }
+    --stack.depth;
+
+    if (job.error) {
+        std::rethrow_exception(job.error);
+    }
+}
+
+void ThreadPool::run_on_each_thread(const RangeFunction& body) {
+    pinned_error = nullptr;
+    pinned_remaining.store(workers.size());
+    for (auto& queue : queues) {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        queue->pinned = &body;
+        pending_tokens.fetch_add(1);
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+    }
+    wake.notify_all();
+
+    try {
+        body(workers.size(), workers.size() + 1);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(pinned_mutex);
+        if (!pinned_error) {
+            pinned_error = std::current_exception();
+        }
+    }
+    while (pinned_remaining.load(std::memory_order_acquire) != 0) {
+        std::this_thread::yield();
+    }
+
+    if (pinned_error) {
+        std::rethrow_exception(pinned_error);
+    }
+}
@@ -0,0 +1,330 @@
+//
+// Created by JAYAN on 21/07/2025.
+//
+
+#include "../../include/utils/weight_file.h"
+#include "../../include/matrix/half.h"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char MAGIC[4] = {'V', 'I', 'T', 'W'};
+constexpr uint32_t FORMAT_VERSION = 1;
+constexpr size_t DATA_ALIGNMENT = 64;
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t tensor_count;
+    uint64_t directory_offset;
+    uint64_t directory_size;
+    uint64_t data_offset;
+    uint8_t reserved[24];
+};
+static_assert(sizeof(FileHeader) == 64, "WeightFile header must be 64 bytes");
+
+size_t align_up(size_t value) {
+    return (value + DATA_ALIGNMENT - 1) / DATA_ALIGNMENT * DATA_ALIGNMENT;
+}
+
+template <typename T> WeightFile::DType dtype_of();
+template <> WeightFile::DType dtype_of<float>() { return WeightFile::DType::Float32; }
+template <> WeightFile::DType dtype_of<double>() { return WeightFile::DType::Float64; }
+
+size_t dtype_size(WeightFile::DType dtype) {
+    switch (dtype) {
+        case WeightFile::DType::Float32: return sizeof(float);
+        case WeightFile::DType::Float64: return sizeof(double);
+        case WeightFile::DType::Int8: return sizeof(int8_t);
+        case WeightFile::DType::BFloat16:
+        case WeightFile::DType::Float16: return sizeof(uint16_t);
+    }
+    throw std::runtime_error("Unknown tensor dtype " + std::to_string(static_cast<uint32_t>(dtype)));
+}
+
+template <typename V>
+void append(std::vector<char>& out, const V& value) {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(V));
+}
+
+// Bounds-checked cursor over the directory bytes
+class DirectoryReader {
+private:
+    const char* ptr;
+    const char* end;
+    const std::string& path;
+
+public:
+    DirectoryReader(const char* begin, size_t size, const std::string& path)
+        : ptr(begin), end(begin + size), path(path) {}
+
+    template <typename V>
+    V read() {
+        V value;
+        take(&value, sizeof(V));
+        return value;
+    }
+
+    std::string read_string(size_t length) {
+        check(length);      // Before sizing the string from an untrusted length
+        std::string value(length, '\0');
+        take(&value[0], length);
+        return value;
+    }
+
+private:
+    void check(size_t bytes) const {
+        if (static_cast<size_t>(end - ptr) < bytes) {
+            throw std::runtime_error("Truncated tensor directory in weight file: " + path);
+        }
+    }
+
+    void take(void* out, size_t bytes) {
+        check(bytes);
+        std::memcpy(out, ptr, bytes);
+        ptr += bytes;
+    }
+};
+
+template <typename From, typename To>
+void convert(const void* source, size_t count, To* out) {
+    const From* in = static_cast<const From*>(source);
+    for (size_t k = 0; k < count; ++k) {
+        out[k] = static_cast<To>(in[k]);
+    }
+}
+
+// 16-bit floats are stored as raw bits
+template <typename To>
+void convert_16(const void* source, size_t count, float (*widen)(uint16_t), To* out) {
+    const uint16_t* in = static_cast<const uint16_t*>(source);
+    for (size_t k = 0; k < count; ++k) {
+        out[k] = static_cast<To>(widen(in[k]));
+    }
+}
+
+} // namespace
+
+WeightFile::~WeightFile() {
+    if (mapping != nullptr) {
+        munmap(mapping, mapping_size);
+    }
+}
+
+std::shared_ptr<WeightFile> WeightFile::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open weight file: " + path);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot stat weight file: " + path);
+    }
+    size_t file_size = static_cast<size_t>(st.st_size);
+    if (file_size < sizeof(FileHeader)) {
+        ::close(fd);
+        throw std::runtime_error("Weight file too small to hold a header: " + path);
+    }
+
+    // Private writable mapping: clean pages come from (and stay shared through)
+    // the page cache, and borrowed matrices can hand out T* without casting
+    // away const. A write only copies the touched page, never the file.
+    void* mapping = mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Cannot map weight file: " + path);
+    }
+
+    std::shared_ptr<WeightFile> file(new WeightFile());
+    file->file_path = path;
+    file->mapping = mapping;
+    file->mapping_size = file_size;
+
+    const char* base = static_cast<const char*>(mapping);
+    FileHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        throw std::runtime_error("Not a weight file (bad magic): " + path);
+    }
+    if (header.version != FORMAT_VERSION) {
+        throw std::runtime_error("Unsupported weight file version " + std::to_string(header.version) +
+                                 " in " + path);
+    }
+    // Bounds are checked by subtraction: offset + size may wrap on a corrupt file
+    if (header.directory_offset > file_size || header.directory_size > file_size - header.directory_offset) {
+        throw std::runtime_error("Tensor directory out of bounds in weight file: " + path);
+    }
+
+    DirectoryReader reader(base + header.directory_offset, header.directory_size, path);
+    for (uint64_t t = 0; t < header.tensor_count; ++t) {
+        std::string name = reader.read_string(reader.read<uint32_t>());
+        TensorInfo info;
+        info.dtype = static_cast<DType>(reader.read<uint32_t>());
+        info.rows = reader.read<uint64_t>();
+        info.cols = reader.read<uint64_t>();
+        info.offset = reader.read<uint64_t>();
+        info.bytes = reader.read<uint64_t>();
+
+        const size_t element_size = dtype_size(info.dtype);
+        if ((info.cols != 0 && info.rows > SIZE_MAX / info.cols) ||
+            (info.rows * info.cols != 0 && element_size > SIZE_MAX / (info.rows * info.cols)) ||
+            info.bytes != info.rows * info.cols * element_size) {
+            throw std::runtime_error("Tensor '" + name + "' size does not match its shape in " + path);
+        }
+        if (info.offset % DATA_ALIGNMENT != 0 || info.offset > file_size || info.bytes > file_size - info.offset) {
+            throw std::runtime_error("Tensor '" + name + "' data out of bounds in " + path);
+        }
+        if (!file->directory.emplace(name, info).second) {
+            throw std::runtime_error("Duplicate tensor '" + name + "' in " + path);
+        }
+        file->order.push_back(name);
+    }
+
+    return file;
+}
+
+template <typename T>
+void WeightFile::write(const std::string& path, const std::vector<std::pair<std::string, MatrixT<T>>>& tensors) {
+    std::vector<RawTensor> raw_tensors;
+    raw_tensors.reserve(tensors.size());
+    for (const auto& tensor : tensors) {
+        const MatrixT<T>& matrix = tensor.second;
+        raw_tensors.push_back({tensor.first, dtype_of<T>(), matrix.getRows(), matrix.getCols(), matrix.data()});
+    }
+    write(path, raw_tensors);
+}
+
+void WeightFile::write(const std::string& path, const std::vector<RawTensor>& tensors) {
+    // Directory first, so the data offsets are known before anything is written
+    std::vector<char> directory;
+    std::vector<size_t> offsets;
+    size_t directory_size = 0;
+    for (const RawTensor& tensor : tensors) {
+        directory_size += sizeof(uint32_t) + tensor.name.size() + sizeof(uint32_t) + 4 * sizeof(uint64_t);
+    }
+
+    size_t offset = align_up(sizeof(FileHeader) + directory_size);
+    size_t data_offset = offset;
+    for (const RawTensor& tensor : tensors) {
+        uint64_t bytes = tensor.rows * tensor.cols * dtype_size(tensor.dtype);
+        offsets.push_back(offset);
+
+        append(directory, static_cast<uint32_t>(tensor.name.size()));
+        directory.insert(directory.end(), tensor.name.begin(), tensor.name.end());
+        append(directory, static_cast<uint32_t>(tensor.dtype));
+        append(directory, static_cast<uint64_t>(tensor.rows));
+        append(directory, static_cast<uint64_t>(tensor.cols));
+        append(directory, static_cast<uint64_t>(offset));
+        append(directory, bytes);
+        offset = align_up(offset + bytes);
+    }
+
+    FileHeader header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = FORMAT_VERSION;
+    header.tensor_count = tensors.size();
+    header.directory_offset = sizeof(FileHeader);
+    header.directory_size = directory.size();
+    header.data_offset = data_offset;
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot create weight file: " + path);
+    }
+
+    static const char padding[DATA_ALIGNMENT] = {};
+    size_t written = 0;
+    auto pad_to = [&](size_t target) {
+        file.write(padding, static_cast<std::streamsize>(target - written));
+        written = target;
+    };
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(directory.data(), static_cast<std::streamsize>(directory.size()));
+    written = sizeof(header) + directory.size();
+
+    for (size_t t = 0; t < tensors.size(); ++t) {
+        const RawTensor& tensor = tensors[t];
+        const size_t bytes = tensor.rows * tensor.cols * dtype_size(tensor.dtype);
+        pad_to(offsets[t]);
+        file.write(static_cast<const char*>(tensor.data), static_cast<std::streamsize>(bytes));
+        written += bytes;
+    }
+    pad_to(align_up(written));
+
+    if (!file) {
+        throw std::runtime_error("Failed writing weight file: " + path);
+    }
+}
+
+bool WeightFile::contains(const std::string& name) const {
+    return directory.count(name) != 0;
+}
+
+const WeightFile::TensorInfo& WeightFile::info(const std::string& name) const {
+    auto it = directory.find(name);
+    if (it == directory.end()) {
+        throw std::runtime_error("Tensor '" + name + "' not found in weight file: " + file_path);
+    }
+    return it->second;
+}
+
+std::vector<std::string> WeightFile::names() const {
+    return order;
+}
+
+template <typename T>
+MatrixT<T> WeightFile::get(const std::string& name) const {
+    const TensorInfo& tensor = info(name);
+    char* data = static_cast<char*>(mapping) + tensor.offset;
+
+    if (tensor.dtype == dtype_of<T>()) {
+        // Zero-copy: the matrix shares ownership of the mapping
+        return MatrixT<T>::borrow(reinterpret_cast<T*>(data), tensor.rows, tensor.cols, shared_from_this());
+    }
+
+    MatrixT<T> result(tensor.rows, tensor.cols);
+    size_t count = tensor.rows * tensor.cols;
+    switch (tensor.dtype) {
+        case DType::Float32: convert<float>(data, count, result.data()); break;
+        case DType::Float64: convert<double>(data, count, result.data()); break;
+        case DType::Int8: convert<int8_t>(data, count, result.data()); break;
+        case DType::BFloat16: convert_16(data, count, Half::bfloat16_to_float, result.data()); break;
+        case DType::Float16: convert_16(data, count, Half::half_to_float, result.data()); break;
+    }
+    return result;
+}
+
+const void* WeightFile::raw(const std::string& name) const {
+    return static_cast<const char*>(mapping) + info(name).offset;
+}
+
+uint64_t WeightFile::checksum() const {
+    const unsigned char* bytes = static_cast<const unsigned char*>(mapping);
+    uint64_t hash = 0xcbf29ce484222325ull;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= mapping_size; i += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, sizeof(word));
+        hash = (hash ^ word) * 0x100000001b3ull;
+    }
+    for (; i < mapping_size; ++i) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+template MatrixT<float> WeightFile::get<float>(const std::string&) const;
+template MatrixT<double> WeightFile::get<double>(const std::string&) const;
+template void WeightFile::write<float>(const std::string&, const std::vector<std::pair<std::string, MatrixF>>&);
+template void WeightFile::write<double>(const std::string&, const std::vector<std::pair<std::string, Matrix>>&);
@@ -0,0 +1,96 @@
+//
+// Created by JAYAN on 29/07/2025.
+//
+
+#include "../../include/utils/workspace.h"
+#include <algorithm>
+#include <new>
+
+Workspace::Workspace(size_t block_bytes)
+    : current(0), offset(0), block_bytes(std::max<size_t>(block_bytes, ALIGNMENT)), peak(0) {
+    // The first block is allocated on first use
+}
+
+Workspace::~Workspace() {
+    release_blocks();
+}
+
+Workspace& Workspace::local() {
+    thread_local Workspace workspace;
+    return workspace;
+}
+
+void* Workspace::allocate_bytes(size_t bytes) {
+    bytes = (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+
+    // Move on through blocks kept from earlier rounds until one has room
+    while (current < blocks.size() && offset + bytes > blocks[current].size) {
+        ++current;
+        offset = 0;
+    }
+    if (current == blocks.size()) {
+        add_block(bytes);
+    }
+
+    void* result = blocks[current].data + offset;
+    offset += bytes;
+    peak = std::max(peak, bytes_in_use());
+    return result;
+}
+
+void Workspace::add_block(size_t bytes) {
+    const size_t size = std::max(bytes, block_bytes);
+    auto* data = static_cast<std::byte*>(::operator new(size, std::align_val_t(ALIGNMENT)));
+    blocks.push_back({data, size});
+}
+
+void Workspace::release_blocks() {
+    for (const Block& block : blocks) {
+        ::operator delete(block.data, std::align_val_t(ALIGNMENT));
+    }
+    blocks.clear();
+}
+
+void Workspace::reset() {
+    // A round that spilled over several blocks gets one block for all of it
+    if (blocks.size() > 1) {
+        size_t total = 0;
+        for (const Block& block : blocks) {
+            total += block.size;
+        }
+        release_blocks();
+        add_block(total);
+    }
+    current = 0;
+    offset = 0;
+}
+
+size_t Workspace::bytes_in_use() const {
+    size_t used = offset;
+    for (size_t i = 0; i < current && i < blocks.size(); ++i) {
+        used += blocks[i].size;
+    }
+    return used;
+}
+
+size_t Workspace::capacity() const {
+    size_t total = 0;
+    for (const Block& block : blocks) {
+        total += block.size;
+    }
+    return total;
+}
+
+Workspace::Scope::Scope(Workspace& workspace)
+    : workspace(workspace), block(workspace.current), offset(workspace.offset) {}
+
+Workspace::Scope::~Scope() {
+    // A reset() inside the scope may have merged the blocks away
+    if (block < workspace.blocks.size()) {
+        workspace.current = block;
+        workspace.offset = offset;
+    } else {
+        workspace.current = 0;
+        workspace.offset = 0;
+    }
+}
@@ -0,0 +1,148 @@
+//
+// Created by JAYAN on 21/07/2025.
+//
+// Packs the weights_organized/ CSV tree into a single binary weight file.
+// Usage: ./convert_weights [weights_dir] [output_file] [--f64 | --bf16 | --f16]
+//   defaults: weights_organized  weights.vitw  (float32 storage)
+//
+// --bf16 and --f16 store the Linear weight matrices (2-D *_weight tensors) in
+// 16 bits and everything else in float32: about half the file and half the
+// bytes read at load. Pair them with VisionTransformer::set_weight_storage to
+// keep the packed weights in the same format.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../include/matrix/half.h"
+#include "../include/utils/file_io.h"
+#include "../include/utils/weight_file.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Every .csv under root, keyed by its relative path without the extension
+std::vector<std::pair<std::string, fs::path>> collect_tensors(const fs::path& root) {
+    std::vector<std::pair<std::string, fs::path>> files;
+    for (const auto& entry : fs::recursive_directory_iterator(root)) {
+        if (!entry.is_regular_file() || entry.path().extension() != ".csv") {
+            continue;
+        }
+        fs::path relative = fs::relative(entry.path(), root);
+        relative.replace_extension();
+        files.emplace_back(relative.generic_string(), entry.path());
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+template <typename T>
+size_t convert(const std::vector<std::pair<std::string, fs::path>>& files, const std::string& output) {
+    std::vector<std::pair<std::string, MatrixT<T>>> tensors;
+    size_t parameters = 0;
+    for (const auto& file : files) {
+        MatrixT<T> matrix = FileIO::load_matrix_from_csv<T>(file.second.string(), true);
+        std::cout << "  " << file.first << " " << matrix.getRows() << "x" << matrix.getCols() << std::endl;
+        parameters += matrix.size();
+        tensors.emplace_back(file.first, std::move(matrix));
+    }
+    WeightFile::write(output, tensors);
+    return parameters;
+}
+
+bool is_linear_weight(const std::string& name, const MatrixF& matrix) {
+    const std::string suffix = "_weight";
+    return matrix.getRows() > 1 && matrix.getCols() > 1 && name.size() > suffix.size() &&
+           name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Linear weights in dtype (BFloat16 or Float16), the rest in float32
+size_t convert_16(const std::vector<std::pair<std::string, fs::path>>& files, const std::string& output,
+                  WeightFile::DType dtype) {
+    std::vector<MatrixF> matrices;
+    std::vector<std::vector<uint16_t>> narrowed;
+    std::vector<WeightFile::RawTensor> tensors;
+    size_t parameters = 0;
+    matrices.reserve(files.size());
+    narrowed.reserve(files.size());
+    for (const auto& file : files) {
+        const MatrixF& matrix = matrices.emplace_back(FileIO::load_matrix_from_csv<float>(file.second.string(), true));
+        parameters += matrix.size();
+        if (!is_linear_weight(file.first, matrix)) {
+            std::cout << "  " << file.first << " " << matrix.getRows() << "x" << matrix.getCols() << std::endl;
+            tensors.push_back({file.first, WeightFile::DType::Float32, matrix.getRows(), matrix.getCols(),
+                               matrix.data()});
+            continue;
+        }
+        std::vector<uint16_t>& bits = narrowed.emplace_back(matrix.size());
+        for (size_t i = 0; i < matrix.size(); ++i) {
+            bits[i] = dtype == WeightFile::DType::BFloat16 ? Half::float_to_bfloat16(matrix.data()[i])
+                                                           : Half::float_to_half(matrix.data()[i]);
+        }
+        std::cout << "  " << file.first << " " << matrix.getRows() << "x" << matrix.getCols() << " ("
+                  << (dtype == WeightFile::DType::BFloat16 ? "bf16" : "f16") << ")" << std::endl;
+        tensors.push_back({file.first, dtype, matrix.getRows(), matrix.getCols(), bits.data()});
+    }
+    WeightFile::write(output, tensors);
+    return parameters;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string weights_dir = "weights_organized";
+    std::string output = "weights.vitw";
+    bool use_double = false;
+    std::string format = "float32";
+
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--f64") {
+            use_double = true;
+            format = "float64";
+        } else if (arg == "--bf16") {
+            format = "bfloat16";
+        } else if (arg == "--f16") {
+            format = "float16";
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    if (positional.size() > 0) weights_dir = positional[0];
+    if (positional.size() > 1) output = positional[1];
+
+    try {
+        if (!fs::is_directory(weights_dir)) {
+            std::cerr << "✗ No existe el directorio de pesos: " << weights_dir << std::endl;
+            return 1;
+        }
+
+        auto files = collect_tensors(weights_dir);
+        std::cout << "Convirtiendo " << files.size() << " tensores de " << weights_dir << "..." << std::endl;
+
+        auto start = std::chrono::steady_clock::now();
+        size_t parameters = 0;
+        if (format == "bfloat16") {
+            parameters = convert_16(files, output, WeightFile::DType::BFloat16);
+        } else if (format == "float16") {
+            parameters = convert_16(files, output, WeightFile::DType::Float16);
+        } else {
+            parameters = use_double ? convert<double>(files, output) : convert<float>(files, output);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << "✓ " << output << ": " << parameters << " parámetros ("
+                  << format << ", "
+                  << fs::file_size(output) << " bytes) en " << seconds << " s" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "✗ Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,299 @@
+//
+// Created by JAYAN on 01/08/2025.
+//
+// Post-training int8 quantisation of the weights_organized/ CSV tree. Loads
+// the float model, calibrates the input range of every Linear on a sample of
+// MNIST images, writes a weight file with the Linear weights in int8 (the
+// other tensors stay float32) and prints the accuracy delta against the float
+// model on a separate set of images.
+// Usage: ./quantize_weights [weights_dir] [output_file] [--images file] [--labels file]
+//                           [--calibration N] [--eval N] [--heads N]
+//   defaults: weights_organized  weights_int8.vitw  512 calibration images, 1000 evaluation images
+//   --images takes an MNIST IDX image file or a CSV with one labelled image per line
+//   (mnist_test.csv); without it, random images are used and only the float/int8
+//   agreement is reported.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../include/transformer/vision_transformer.h"
+#include "../include/utils/dataset.h"
+#include "../include/utils/file_io.h"
+#include "../include/utils/weight_file.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Every .csv under root, keyed by its relative path without the extension
+std::vector<std::pair<std::string, fs::path>> collect_tensors(const fs::path& root) {
+    std::vector<std::pair<std::string, fs::path>> files;
+    for (const auto& entry : fs::recursive_directory_iterator(root)) {
+        if (!entry.is_regular_file() || entry.path().extension() != ".csv") {
+            continue;
+        }
+        fs::path relative = fs::relative(entry.path(), root);
+        relative.replace_extension();
+        files.emplace_back(relative.generic_string(), entry.path());
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+struct ImageSet {
+    MatrixF patches;            // (count * patches_per_image, patch_dim)
+    std::vector<int> labels;    // -1 without labels
+    size_t count = 0;
+};
+
+// First `count` images of a dataset file, or fewer if it is shorter
+ImageSet read_images(const std::string& images_path, const std::string& labels_path, size_t count) {
+    DatasetOptions options;
+    options.limit = count;
+    std::unique_ptr<DatasetReader> reader = fs::path(images_path).extension() == ".csv"
+        ? DatasetReader::open_csv(images_path, options)
+        : DatasetReader::open_idx(images_path, labels_path, options);
+
+    ImageSet set;
+    set.patches = MatrixF(count * reader->patches_per_image(), reader->patch_dim());
+    ImageBatch batch;
+    while (reader->next(batch)) {
+        const size_t rows = batch.count * reader->patches_per_image();
+        set.patches.block(set.count * reader->patches_per_image(), 0, rows, reader->patch_dim())
+            .assign(batch.patches.block(0, 0, rows, reader->patch_dim()));
+        set.labels.insert(set.labels.end(), batch.labels.begin(), batch.labels.begin() + batch.count);
+        set.count += batch.count;
+    }
+    set.patches = MatrixF(set.patches.block(0, 0, set.count * reader->patches_per_image(), reader->patch_dim()));
+    return set;
+}
+
+ImageSet random_images(size_t count, size_t patches_per_image, size_t patch_dim) {
+    ImageSet set;
+    set.patches = MatrixF::random(count * patches_per_image, patch_dim, 0.0f, 1.0f);
+    set.labels.assign(count, -1);
+    set.count = count;
+    return set;
+}
+
+ConstMatrixViewF images_of(const ImageSet& set, size_t first, size_t count, size_t patches_per_image) {
+    return set.patches.block(first * patches_per_image, 0, count * patches_per_image, set.patches.getCols());
+}
+
+// Logits of every image, max_batch at a time; returns seconds spent
+double run_model(VisionTransformer& model, const ImageSet& set, size_t first, size_t count, MatrixF& logits) {
+    const size_t patches = model.get_embedding().get_num_patches();
+    const size_t batch = model.get_max_batch();
+    logits = MatrixF(count, model.get_num_classes());
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i += batch) {
+        const size_t n = std::min(batch, count - i);
+        model.forward(images_of(set, first + i, n, patches), logits.block(i, 0, n, logits.getCols()));
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+size_t argmax_row(const MatrixF& logits, size_t row) {
+    const float* begin = logits.row_ptr(row);
+    return static_cast<size_t>(std::max_element(begin, begin + logits.getCols()) - begin);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string weights_dir = "weights_organized";
+    std::string output = "weights_int8.vitw";
+    std::string images_path;
+    std::string labels_path;
+    size_t calibration_count = 512;
+    size_t eval_count = 1000;
+    int num_heads = MultiHeadAttention::DEFAULT_NUM_HEADS;
+
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--images" && has_value) {
+            images_path = argv[++i];
+        } else if (arg == "--labels" && has_value) {
+            labels_path = argv[++i];
+        } else if (arg == "--calibration" && has_value) {
+            calibration_count = std::stoul(argv[++i]);
+        } else if (arg == "--eval" && has_value) {
+            eval_count = std::stoul(argv[++i]);
+        } else if (arg == "--heads" && has_value) {
+            num_heads = std::stoi(argv[++i]);
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    if (positional.size() > 0) weights_dir = positional[0];
+    if (positional.size() > 1) output = positional[1];
+
+    try {
+        if (!fs::is_directory(weights_dir)) {
+            std::cerr << "✗ No existe el directorio de pesos: " << weights_dir << std::endl;
+            return 1;
+        }
+        if (calibration_count == 0) {
+            std::cerr << "✗ Se necesita al menos una imagen de calibración" << std::endl;
+            return 1;
+        }
+
+        const size_t max_batch = 64;
+        VisionTransformer reference(max_batch, num_heads);
+        reference.load_weights(weights_dir);
+        VisionTransformer model = reference;
+        const size_t patches = reference.get_embedding().get_num_patches();
+
+        ImageSet images;
+        if (!images_path.empty()) {
+            images = read_images(images_path, labels_path, calibration_count + eval_count);
+            if (images.count <= calibration_count) {
+                std::cerr << "✗ " << images_path << " tiene " << images.count << " imágenes; hacen falta más de "
+                          << calibration_count << " para calibrar y evaluar" << std::endl;
+                return 1;
+            }
+            if (images.patches.getCols() != static_cast<size_t>(reference.get_embedding().get_patch_dim())) {
+                std::cerr << "✗ Las imágenes no tienen el tamaño de parche del modelo" << std::endl;
+                return 1;
+            }
+        } else {
+            std::cout << "Sin --images: se calibra y evalúa con imágenes aleatorias" << std::endl;
+            images = random_images(calibration_count + eval_count, patches,
+                                   reference.get_embedding().get_patch_dim());
+        }
+        eval_count = images.count - calibration_count;
+
+        // Calibración: rango de entrada de cada capa lineal
+        std::cout << "Calibrando con " << calibration_count << " imágenes..." << std::endl;
+        model.start_calibration();
+        model.calibrate(images_of(images, 0, calibration_count, patches));
+        model.quantize();
+
+        std::vector<QuantizedLinear::Slot> slots = model.get_linears();
+        for (const QuantizedLinear::Slot& slot : slots) {
+            const QGemm::ActivationParams& params = slot.linear->get_input_params();
+            std::printf("  %-56s entrada [%8.3f, %8.3f]  escala %.5f  cero %d\n", slot.name.c_str(),
+                        slot.linear->get_observed_min(), slot.linear->get_observed_max(), params.scale,
+                        params.zero_point);
+        }
+
+        // Contenedor: pesos lineales en int8 con sus escalas, el resto en float32
+        std::vector<std::pair<std::string, MatrixF>> float_tensors;
+        for (const auto& file : collect_tensors(weights_dir)) {
+            const bool quantized = std::any_of(slots.begin(), slots.end(),
+                                               [&](const QuantizedLinear::Slot& slot) { return slot.name == file.first; });
+            if (!quantized) {
+                float_tensors.emplace_back(file.first, FileIO::load_matrix_from_csv<float>(file.second.string(), true));
+            }
+        }
+        std::vector<std::vector<int8_t>> int8_values;
+        std::vector<MatrixF> scale_tensors;
+        std::vector<MatrixF> input_tensors;
+        for (const QuantizedLinear::Slot& slot : slots) {
+            const QGemm::PackedWeights& weights = slot.linear->get_weights();
+            int8_values.push_back(weights.unpack());
+            MatrixF scales(weights.getCols(), 1);
+            std::copy(weights.scale_data(), weights.scale_data() + weights.getCols(), scales.data());
+            scale_tensors.push_back(std::move(scales));
+            MatrixF input(1, 2);
+            input(0, 0) = slot.linear->get_input_params().scale;
+            input(0, 1) = static_cast<float>(slot.linear->get_input_params().zero_point);
+            input_tensors.push_back(std::move(input));
+        }
+
+        std::vector<WeightFile::RawTensor> tensors;
+        size_t float_bytes = 0;
+        for (const auto& tensor : float_tensors) {
+            tensors.push_back({tensor.first, WeightFile::DType::Float32, tensor.second.getRows(),
+                               tensor.second.getCols(), tensor.second.data()});
+            float_bytes += tensor.second.size() * sizeof(float);
+        }
+        size_t int8_bytes = 0;
+        for (size_t s = 0; s < slots.size(); ++s) {
+            const QGemm::PackedWeights& weights = slots[s].linear->get_weights();
+            tensors.push_back({slots[s].name, WeightFile::DType::Int8, weights.getCols(), weights.getRows(),
+                               int8_values[s].data()});
+            tensors.push_back({QuantizedLinear::scale_tensor_name(slots[s].name), WeightFile::DType::Float32,
+                               scale_tensors[s].getRows(), 1, scale_tensors[s].data()});
+            tensors.push_back({QuantizedLinear::input_tensor_name(slots[s].name), WeightFile::DType::Float32, 1, 2,
+                               input_tensors[s].data()});
+            int8_bytes += int8_values[s].size();
+            float_bytes += slots[s].weight->size() * sizeof(float);
+        }
+        WeightFile::write(output, tensors);
+
+        // El contenedor escrito debe reproducir el modelo cuantizado
+        VisionTransformer reloaded(max_batch, num_heads);
+        reloaded.load_weights(*WeightFile::open(output));
+
+        MatrixF float_logits;
+        MatrixF int8_logits;
+        MatrixF reloaded_logits;
+        const double float_seconds = run_model(reference, images, calibration_count, eval_count, float_logits);
+        const double int8_seconds = run_model(model, images, calibration_count, eval_count, int8_logits);
+        run_model(reloaded, images, calibration_count, eval_count, reloaded_logits);
+
+        size_t agree = 0;
+        size_t labelled = 0;
+        size_t float_correct = 0;
+        size_t int8_correct = 0;
+        double max_delta = 0.0;
+        double sum_delta = 0.0;
+        double reload_delta = 0.0;
+        for (size_t i = 0; i < eval_count; ++i) {
+            const size_t float_class = argmax_row(float_logits, i);
+            const size_t int8_class = argmax_row(int8_logits, i);
+            agree += float_class == int8_class ? 1 : 0;
+            const int label = images.labels[calibration_count + i];
+            if (label >= 0) {
+                ++labelled;
+                float_correct += float_class == static_cast<size_t>(label) ? 1 : 0;
+                int8_correct += int8_class == static_cast<size_t>(label) ? 1 : 0;
+            }
+            for (size_t c = 0; c < float_logits.getCols(); ++c) {
+                const double delta = std::abs(double(float_logits(i, c)) - int8_logits(i, c));
+                max_delta = std::max(max_delta, delta);
+                sum_delta += delta;
+                reload_delta = std::max(reload_delta, (double)std::abs(reloaded_logits(i, c) - int8_logits(i, c)));
+            }
+        }
+
+        std::cout << "\n=== Informe de precisión (" << eval_count << " imágenes de evaluación, kernel "
+                  << QGemm::kernel_name() << ") ===" << std::endl;
+        std::printf("  Coincidencia top-1 float/int8: %.2f%% (%zu de %zu)\n", 100.0 * agree / eval_count, agree,
+                    eval_count);
+        if (labelled > 0) {
+            const double float_accuracy = 100.0 * float_correct / labelled;
+            const double int8_accuracy = 100.0 * int8_correct / labelled;
+            std::printf("  Precisión float: %.2f%%, int8: %.2f%% (delta %+.2f puntos)\n", float_accuracy,
+                        int8_accuracy, int8_accuracy - float_accuracy);
+        }
+        std::printf("  Error en logits: medio %.5f, máximo %.5f\n", sum_delta / (eval_count * float_logits.getCols()),
+                    max_delta);
+        std::printf("  Velocidad: float %.1f img/s, int8 %.1f img/s (%.2fx)\n", eval_count / float_seconds,
+                    eval_count / int8_seconds, float_seconds / int8_seconds);
+        std::printf("  Pesos: %.1f KiB en float32 → %.1f KiB con capas lineales en int8\n", float_bytes / 1024.0,
+                    (float_bytes - (int8_bytes * sizeof(float)) + int8_bytes) / 1024.0);
+
+        if (reload_delta != 0.0) {
+            std::cerr << "✗ " << output << " no reproduce el modelo cuantizado (error máximo " << reload_delta << ")"
+                      << std::endl;
+            return 1;
+        }
+        std::cout << "✓ " << output << ": " << slots.size() << " capas lineales en int8, "
+                  << fs::file_size(output) << " bytes" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "✗ Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}